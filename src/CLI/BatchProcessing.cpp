@@ -0,0 +1,286 @@
+/**
+ * @file BatchProcessing.cpp
+ * @author Ollie
+ * @brief Batch mode: many CLI runs from a manifest, scheduled within a memory budget
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "BatchProcessing.h"
+#include "CLIHandler.h"
+#include "../DEM_analysis/watershedAnalysis.h"
+#include "../parallel/ThreadPool.h"
+#include "../profiling/TraceRecorder.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+/**
+ * @brief Split a manifest line into arguments, double quotes keep spaces
+ */
+static std::vector<std::string> splitArguments(const std::string& line) {
+    std::vector<std::string> arguments;
+    std::string current;
+    bool quoted = false;
+    bool inArgument = false;
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+            inArgument = true;
+        }
+        else if (!quoted && (c == ' ' || c == '\t' || c == '\r')) {
+            if (inArgument) arguments.push_back(current);
+            current.clear();
+            inArgument = false;
+        }
+        else {
+            current += c;
+            inArgument = true;
+        }
+    }
+    if (inArgument) arguments.push_back(current);
+    return arguments;
+}
+
+/**
+ * @brief Parse manifest lines into jobs
+ */
+bool readManifest(const std::string& filename, std::vector<BatchJob>& jobs) {
+    std::ifstream file(filename.c_str());
+    if (!file.is_open()) {
+        std::cerr << "Error: Failed to open manifest: " << filename << std::endl;
+        return false;
+    }
+
+    bool valid = true;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::vector<std::string> arguments = splitArguments(line);
+        if (arguments.empty() || arguments[0][0] == '#') continue;
+
+        // Same flags as the command line, after a stand in program name
+        std::vector<char*> argv;
+        char program[] = "drainage-analysis";
+        argv.push_back(program);
+        for (std::string& argument : arguments) {
+            argv.push_back(&argument[0]);
+        }
+
+        BatchJob job;
+        job.line = lineNumber;
+        job.arguments = line;
+        if (!parseProcessOptions(static_cast<int>(argv.size()), argv.data(), job.options)) {
+            std::cerr << "Error: Invalid job on manifest line " << lineNumber << ": " << line << std::endl;
+            valid = false;
+            continue;
+        }
+        job.memoryBytes = estimateJobMemory(job.options);
+        jobs.push_back(job);
+    }
+    return valid;
+}
+
+/**
+ * @brief Cell count of the input, from the header or the first line
+ */
+static uint64_t estimateCells(const ProcessOptions& options) {
+    std::ifstream file(options.inputFile.c_str(), std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return 0;
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+
+    if (options.inputFileType == "bin") {
+        int dimensions[2] = {0, 0};
+        file.read(reinterpret_cast<char*>(dimensions), sizeof(dimensions));
+        if (!file || dimensions[0] <= 0 || dimensions[1] <= 0) return 0;
+        return uint64_t(dimensions[0]) * uint64_t(dimensions[1]);
+    }
+
+    // Text rows hold about the same number of characters per value
+    std::string firstLine;
+    std::getline(file, firstLine);
+    uint64_t values = 0;
+    bool inValue = false;
+    for (char c : firstLine) {
+        bool separator = (c == ' ' || c == ',' || c == '\t' || c == '\r');
+        if (!separator && !inValue) values++;
+        inValue = !separator;
+    }
+    if (values == 0) return 0;
+    uint64_t bytesPerValue = std::max<uint64_t>(1, (firstLine.size() + 1) / values);
+    return fileSize / bytesPerValue;
+}
+
+/**
+ * @brief Bytes per cell of the maps a run holds, times cells
+ */
+uint64_t estimateJobMemory(const ProcessOptions& options) {
+    const std::string& process = options.process;
+    bool flow = options.totalFlow || options.watershed || options.streams;
+
+    // Filled DEM
+    uint64_t bytesPerCell = sizeof(double);
+    // Surface maps
+    bool slope = (process == "dinf" || process == "mdf" || process == "slope" || options.watershed);
+    if (slope) bytesPerCell += sizeof(double);
+    if (process == "dinf" || process == "aspect") bytesPerCell += sizeof(double);
+    if (process == "hillshade" || options.hillshade) bytesPerCell += sizeof(double);
+    // D8 directions
+    if (process == "d8") bytesPerCell += sizeof(int);
+    // Flow map, plus as much again for the accumulator's working arrays
+    if (flow) bytesPerCell += 2 * sizeof(double);
+    // Watershed labels and basin labels
+    if (options.watershed) bytesPerCell += 2 * sizeof(int);
+    // Strahler, Shreve, and link maps
+    if (options.streams) bytesPerCell += 3 * sizeof(int);
+    // Overview levels for tiles and previews (a third of the map)
+    if (!options.tilesDirectory.empty() || options.previewSize > 0) bytesPerCell += 3;
+
+    uint64_t cells = estimateCells(options);
+    uint64_t bytes = cells * bytesPerCell;
+    // Watershed maps of one delineation wave
+    if (options.watershed) {
+        bytes += static_cast<uint64_t>(watershedAnalysis<double, int>::getWaveSize(cells)) * cells * sizeof(double);
+    }
+    return bytes;
+}
+
+namespace {
+
+/**
+ * @brief Run a function when leaving scope, including by an exception
+ */
+class SlotGuard {
+public:
+    explicit SlotGuard(std::function<void()> release) : _release(std::move(release)) {}
+    ~SlotGuard() { _release(); }
+    SlotGuard(const SlotGuard&) = delete;
+    SlotGuard& operator=(const SlotGuard&) = delete;
+
+private:
+    std::function<void()> _release;
+};
+
+} // namespace
+
+/**
+ * @brief Schedule jobs on the thread pool within the memory budget
+ */
+bool runBatch(const std::string& manifest, uint64_t memoryMB, int nThreads) {
+    std::vector<BatchJob> jobs;
+    if (!readManifest(manifest, jobs)) {
+        return false;
+    }
+    if (jobs.empty()) {
+        std::cerr << "Error: Manifest has no jobs: " << manifest << std::endl;
+        return false;
+    }
+    uint64_t budget = memoryMB * 1024 * 1024;
+
+    // One product cache per directory, shared by the jobs naming it
+    std::map<std::string, std::unique_ptr<ProductCache>> caches;
+    for (const BatchJob& job : jobs) {
+        const std::string& directory = job.options.cacheDirectory;
+        if (directory.empty() || caches.count(directory)) continue;
+        std::unique_ptr<ProductCache> cache(new ProductCache(directory, job.options.cacheSizeMB));
+        if (!cache->isValid()) cache.reset();
+        caches[directory] = std::move(cache);
+    }
+
+    nThreads = std::max(1, std::min(nThreads, static_cast<int>(jobs.size())));
+
+    std::mutex mutex;
+    std::vector<bool> started(jobs.size(), false);
+    size_t nextJob = 0;     // No job before this is waiting
+    uint64_t inFlight = 0;  // Estimated bytes of running jobs
+    int running = 0;
+    int failed = 0;
+    auto batchStart = std::chrono::steady_clock::now();
+    TaskGroup group;
+
+    // Start waiting jobs that fit as pool tasks, or any job if nothing is running. Called with
+    // mutex held, first here and then by each job as it finishes. Nodes and parallel loops of
+    // the jobs share the same pool, so running several jobs does not oversubscribe the cores
+    std::function<void()> launch = [&]() {
+        while (running < nThreads) {
+            while (nextJob < jobs.size() && started[nextJob]) nextJob++;
+            size_t index = jobs.size();
+            for (size_t i = nextJob; i < jobs.size(); i++) {
+                if (!started[i] && (running == 0 || inFlight + jobs[i].memoryBytes <= budget)) {
+                    index = i;
+                    break;
+                }
+            }
+            if (index == jobs.size()) {
+                return;
+            }
+            BatchJob& job = jobs[index];
+            started[index] = true;
+            inFlight += job.memoryBytes;
+            running++;
+            std::cout << "Job " << job.line << " started (~" << (job.memoryBytes >> 20) << " MB): "
+                      << job.arguments << std::endl;
+
+            group.run([&, index]() {
+                BatchJob& job = jobs[index];
+                auto jobStart = std::chrono::steady_clock::now();
+                bool success = false;
+                auto cacheEntry = caches.find(job.options.cacheDirectory);
+                ProductCache* cache = (cacheEntry == caches.end()) ? nullptr : cacheEntry->second.get();
+
+                // Free the job's slot and start waiting jobs however the job ends
+                SlotGuard slot([&]() {
+                    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - jobStart).count();
+                    std::lock_guard<std::mutex> lock(mutex);
+                    inFlight -= job.memoryBytes;
+                    running--;
+                    if (!success) failed++;
+                    std::cout << "Job " << job.line << (success ? " finished" : " failed") << " in " << seconds << " s"
+                              << std::endl;
+                    launch();
+                });
+
+                // Entries the job uses are kept in the shared cache only while it runs
+                if (cache) cache->beginRun();
+                SlotGuard cacheRun([cache]() {
+                    if (cache) cache->endRun();
+                });
+
+                try {
+                    TraceScope scope("job", "job", "line", job.line, "megabytes", static_cast<int64_t>(job.memoryBytes >> 20));
+                    Pipeline pipeline;
+                    std::vector<std::string> targets;
+                    success = buildProcessPipeline(pipeline, job.options, targets, cache) &&
+                        pipeline.run(targets);
+                }
+                catch (const std::exception& error) {
+                    std::cerr << "Error: Job " << job.line << " threw: " << error.what() << std::endl;
+                }
+                catch (...) {
+                    std::cerr << "Error: Job " << job.line << " threw an unknown exception." << std::endl;
+                }
+            });
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        launch();
+    }
+    group.wait();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+    std::cout << "Batch finished: " << (jobs.size() - failed) << " of " << jobs.size() << " jobs succeeded in "
+              << seconds << " s" << std::endl;
+    return failed == 0;
+}
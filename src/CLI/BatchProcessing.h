@@ -0,0 +1,69 @@
+/**
+ * @file BatchProcessing.h
+ * @author Ollie
+ * @brief Batch mode: many CLI runs from a manifest, scheduled within a memory budget
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef BATCH_PROCESSING_H
+#define BATCH_PROCESSING_H
+
+#include "MapProcessing.h"
+#include "../parallel/parallelFor.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Memory for jobs in flight when no budget is given
+const uint64_t DEFAULT_BATCH_MEMORY_MB = 4096;
+
+/**
+ * @brief One manifest line
+ */
+struct BatchJob {
+    int line = 0;               // Manifest line number, for messages
+    std::string arguments;      // Flags as written in the manifest
+    ProcessOptions options;
+    uint64_t memoryBytes = 0;   // Estimated peak memory
+};
+
+/**
+ * @brief Read a manifest. Each line holds the flags of one run, as given to ./drainage-analysis
+ * (e.g. "-i tile_01.txt -p d8 -fa -img tile_01.png"). Blank lines and lines starting with #
+ * are skipped. Arguments are split on whitespace, double quotes keep spaces in a path.
+ *
+ * @param filename Manifest pathway
+ * @param jobs Output: one job per run
+ * @return true If the manifest opened and every line was valid
+ */
+bool readManifest(const std::string& filename, std::vector<BatchJob>& jobs);
+
+/**
+ * @brief Estimate the peak memory of a run: the DEM cell count (from the .bin header, or
+ * the file size over the bytes per value of the first line) times the bytes per cell of
+ * the maps the options need, plus the full size maps of one watershed wave.
+ *
+ * @param options Run choices
+ * @return uint64_t Bytes, 0 if the input cannot be read
+ */
+uint64_t estimateJobMemory(const ProcessOptions& options);
+
+/**
+ * @brief Run every job in a manifest, up to nThreads at a time, as ThreadPool tasks.
+ * A job starts once the estimated memory of the jobs in flight plus its own fits in the
+ * budget, taking the first waiting job that fits so small jobs are not held up behind large
+ * ones. A job larger than the whole budget runs alone. Jobs naming the same --cache
+ * directory share one product cache, and colourmap tables are baked once for all jobs.
+ * A failed job is reported and the rest carry on.
+ *
+ * @param manifest Manifest pathway
+ * @param memoryMB Memory budget in megabytes
+ * @param nThreads Jobs in flight at most
+ * @return true If every job succeeded
+ */
+bool runBatch(const std::string& manifest, uint64_t memoryMB, int nThreads = getThreadCount());
+
+#endif // BATCH_PROCESSING_H
@@ -9,20 +9,27 @@
  * 
  */
 #include "CLIHandler.h"
+#include "argumentParser.h"
 #include <iostream>
+#include <cstring>
 
 /**
  * @brief Function to compare CLI inputs to see if there are conflicts
  */
-bool validateArguments(char* input_file, char* input_file_type, char* output_file, char* image_file, bool colour, char*& colour_type, bool totalFlow, bool watershed, int nPourPoints, char* process) {
+bool validateArguments(char* input_file, char* input_file_type, char* output_file, char* image_file, char* tiles_directory, bool colour, char*& colour_type, bool totalFlow, bool watershed, int nPourPoints, bool streams, char* process) {
     // No input file
     if (!input_file) {
         std::cerr << "Error: No -i / --input flag provided." << std::endl;
         return false;
     }
-    // No outputs is bad unless watershed
-    if (!watershed && !output_file && !image_file) {
-        std::cerr << "Error: At least one of -o (output file), -img (image file), or -w (watershed) must be specified." << std::endl;
+    // No process
+    if (!process) {
+        std::cerr << "Error: No -p / --process flag provided." << std::endl;
+        return false;
+    }
+    // No outputs is bad unless watershed or streams
+    if (!watershed && !streams && !output_file && !image_file && !tiles_directory) {
+        std::cerr << "Error: At least one of -o (output file), -img (image file), -tiles (tile directory), -w (watershed), or -s (streams) must be specified." << std::endl;
         return false;
     }
     if (watershed) {
@@ -34,10 +41,14 @@ bool validateArguments(char* input_file, char* input_file_type, char* output_fil
             std::cerr << "Error: Watershed process is incompatible with image file (-img)." << std::endl;
             return false;
         }
+        if (tiles_directory) {
+            std::cerr << "Error: Watershed process is incompatible with tile output (-tiles)." << std::endl;
+            return false;
+        }
     }
 
     // Colour and image check
-    if (image_file && !colour) {
+    if ((image_file || tiles_directory) && !colour) {
         std::cout << "No -c flag. Greyscale chosen." << std::endl;
         if (colour_type == nullptr || strlen(colour_type) == 0) {
             colour_type = new char[3];
@@ -54,6 +65,10 @@ bool validateArguments(char* input_file, char* input_file_type, char* output_fil
             std::cerr << "Process " << process << " is not compatible with watershed (-w)." << std::endl;
             return false;
         }
+        if (streams && strcmp(process, "d8") != 0) {
+            std::cerr << "Process " << process << " is not compatible with stream network (-s). Use d8." << std::endl;
+            return false;
+        }
     
     // Watershed / flow accumulation clash
     if (totalFlow && watershed) {
@@ -96,4 +111,80 @@ void printVerboseOutput(char* input_file, char* process, char* output_file, char
             std::cout << "Flow accumulation: Disabled" << std::endl;
         }
     }
-}
\ No newline at end of file
+}
+/**
+ * @brief Parse, check, and gather flags for one run
+ */
+bool parseProcessOptions(int argc, char* argv[], ProcessOptions& options) {
+    // Manually allocate memory for strings and flags
+    char* input_file = nullptr;
+    char* input_file_type = nullptr;
+    char* output_file = nullptr;
+    char* image_file = nullptr;
+    char* tiles_directory = nullptr;
+    int previewSize = 0;
+    bool hillshade = false;
+    HillshadeOptions hillshadeOptions;
+    bool colour = false;
+    char* colour_type = nullptr;
+    bool totalFlow = false;
+    bool watershed = false;
+    int nPourPoints = 0;
+    char* watershed_directory = nullptr;
+    char* watershed_colour = nullptr;
+    bool streams = false;
+    double streamThreshold = 0.0;
+    char* streams_directory = nullptr;
+    char* cache_directory = nullptr;
+    int cacheSizeMB = DEFAULT_CACHE_MB;
+    bool verbose = false;
+    char* process = nullptr;
+
+    // Check all arguments from argv, then check they are valid and do not conflict
+    bool valid = parseArguments(argc, argv, input_file, input_file_type, output_file, image_file, tiles_directory, previewSize, hillshade, hillshadeOptions, colour, colour_type, totalFlow, watershed, nPourPoints, watershed_directory, watershed_colour, streams, streamThreshold, streams_directory, cache_directory, cacheSizeMB, verbose, process) &&
+        validateArguments(input_file, input_file_type, output_file, image_file, tiles_directory, colour, colour_type, totalFlow, watershed, nPourPoints, streams, process);
+
+    if (valid) {
+        // Print verbose output if specified
+        printVerboseOutput(input_file, process, output_file, image_file, colour_type, verbose, watershed, nPourPoints, watershed_directory, watershed_colour, totalFlow);
+
+        // Gather choices for the processing pipeline
+        options = ProcessOptions();
+        options.inputFile = input_file;
+        options.inputFileType = input_file_type;
+        options.process = process ? process : "";
+        if (output_file) options.outputFile = output_file;
+        if (image_file) options.imageFile = image_file;
+        if (tiles_directory) options.tilesDirectory = tiles_directory;
+        options.previewSize = previewSize;
+        if (colour_type) options.colourType = colour_type;
+        options.totalFlow = totalFlow;
+        options.watershed = watershed;
+        if (watershed) {
+            options.nPourPoints = nPourPoints;
+            options.watershedDirectory = watershed_directory;
+            options.watershedColour = watershed_colour;
+        }
+        options.streams = streams;
+        options.streamThreshold = streamThreshold;
+        if (streams_directory) options.streamsDirectory = streams_directory;
+        options.hillshade = hillshade;
+        options.hillshadeOptions = hillshadeOptions;
+        if (cache_directory) options.cacheDirectory = cache_directory;
+        options.cacheSizeMB = cacheSizeMB;
+    }
+
+    // Delete mem.
+    delete[] input_file;
+    delete[] input_file_type;
+    delete[] output_file;
+    delete[] image_file;
+    delete[] tiles_directory;
+    delete[] colour_type;
+    delete[] watershed_directory;
+    delete[] watershed_colour;
+    delete[] process;
+    delete[] streams_directory;
+    delete[] cache_directory;
+    return valid;
+}
@@ -11,6 +11,8 @@
 #ifndef CLI_HANDLING_H
 #define CLI_HANDLING_H
 
+#include "MapProcessing.h"
+
 /**
  * @brief Function to check inputs from CLI against each other
  * 
@@ -18,16 +20,18 @@
  * @param input_file_type type of file to be read (e.g. txt, csv)
  * @param output_file full output file pathway
  * @param image_file full image file pathway
+ * @param tiles_directory tile pyramid output directory (-tiles)
  * @param colour if a colour has been specified for image out
  * @param colour_type colour short code from ../data/colourmaps/
  * @param totalFlow if flow accumulation was selected (-fa)
  * @param watershed if watershed delineation was chosen (-w x x x)
  * @param nPourPoints number of watershed delineation points chosen (-w 1 x x)
+ * @param streams if stream network extraction was chosen (-s x x)
  * @param process type of process chosen (-p)
  * @return true 
  * @return false 
  */
-bool validateArguments(char* input_file, char* input_file_type, char* output_file, char* image_file, bool colour, char*& colour_type, bool totalFlow, bool watershed, int nPourPoints, char* process);
+bool validateArguments(char* input_file, char* input_file_type, char* output_file, char* image_file, char* tiles_directory, bool colour, char*& colour_type, bool totalFlow, bool watershed, int nPourPoints, bool streams, char* process);
 
 /**
  * @brief Function to print verbose output
@@ -46,4 +50,15 @@ bool validateArguments(char* input_file, char* input_file_type, char* output_fil
  */
 void printVerboseOutput(char* input_file, char* process, char* output_file, char* image_file, char* colour_type, bool verbose, bool watershed, int nPourPoints, char* watershed_directory, char* watershed_colour, bool totalFlow);
 
+/**
+ * @brief Parse and check one run's flags (as given to ./drainage-analysis) into options.
+ * Used for the command line and for each line of a batch manifest.
+ *
+ * @param argc Number of arguments, including the program name
+ * @param argv Arguments, argv[0] is skipped
+ * @param options Output: choices for runProcess()
+ * @return true If the flags were valid
+ */
+bool parseProcessOptions(int argc, char* argv[], ProcessOptions& options);
+
 #endif
\ No newline at end of file
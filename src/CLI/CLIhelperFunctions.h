@@ -13,6 +13,9 @@
 
 #include <string>
 
+// Preview image size (pixels) when --preview or export ... preview is given without a size
+const int DEFAULT_PREVIEW_SIZE = 1024;
+
 /**
  * @brief Checks if a filename has a specific file extension.
  * 
@@ -2,211 +2,474 @@
  * @file MapProcessing.cpp
  * @author Ollie
  * @brief Functions for CLI to process DEMs with watershed, slope, aspect, and flow accumulation
- * @version 1.0.0
+ * @version 1.1.0
  * @date 2025-03-16
- * 
+ *
  * @copyright Copyright (c) 2025
- * 
+ *
  */
 #include "MapProcessing.h"
+#include "CLIhelperFunctions.h"
 #include <sstream>
+#include <cstring>
+
+// Channel threshold (cells) for basin trees when -s is not given
+const double DEFAULT_BASIN_THRESHOLD = 100.0;
 
 /**
- * @brief Pulls necessary maps for process types
+ * @brief Write the image, blended over hillshade if one was computed
  */
-void processMap(Map<double>& elevationMap, char* process, Map<int>& D8Map, Map<double>& flowMap, Map<double>& GMap, Map<double>& aspectMap, std::string& flowType) {
-    if (strcmp(process, "d8") == 0) {
-        // Create D8 map for D8 analysis
-        flowType = "d8";
-        D8FlowAnalyser analyser(elevationMap);
-        analyser.analyseFlow();
-        D8Map = analyser.getMap();
-    }
-    else if (strcmp(process, "dinf") == 0){
-        // Create slope and gradient maps for dinf analysis
-        flowType = "dinf";
-        SlopeAnalyser sAnalyser(elevationMap);
-        GMap = sAnalyser.computeSlope("combined");
-        aspectMap = sAnalyser.computeDirection();
-    }
-    else if (strcmp(process, "mdf") == 0){
-        // Create gradient map for MDF analysis
-        flowType = "mdf";
-        SlopeAnalyser sAnalyser(elevationMap);
-        GMap = sAnalyser.computeSlope("combined");
-    }
-    // Create slope map for slope
-    else if (strcmp(process, "slope") == 0) {
-        SlopeAnalyser sAnalyser(elevationMap);
-        GMap = sAnalyser.computeSlope("combined");
-    }
-    // Create aspect map for aspect
-    else if (strcmp(process, "aspect") == 0) {
-        SlopeAnalyser sAnalyser(elevationMap);
-        aspectMap = sAnalyser.computeDirection();
+template <typename T>
+static bool exportImage(const Map<T>& map, const Map<double>& hillshadeMap, const std::string& image_file,
+    const std::string& colour_type, const MapScaler<T>* scaler) {
+    if (hillshadeMap.getWidth() == 0) {
+        return ImageExport<T>::exportMapToImage(map, image_file, colour_type, true, scaler);
     }
-    else {
-        std::cerr << "Error: Unknown process: " << process << std::endl;
+
+    // Shade in the map's own type
+    Map<T> shade(hillshadeMap.getWidth(), hillshadeMap.getHeight());
+    for (int y = 0; y < shade.getHeight(); y++) {
+        const double* row = hillshadeMap.getRow(y);
+        for (int x = 0; x < shade.getWidth(); x++) {
+            shade.setData(x, y, static_cast<T>(row[x]));
+        }
     }
+    return ImageExport<T>::exportBlendedImage(map, shade, image_file, colour_type, true, 0.6, scaler);
 }
 
 /**
- * @brief run flow accumulation for process specified if flow accumulation selected (-fa)
+ * @brief Export a map as an image and/or tile pyramid if selected.
+ * Overview levels are reduced with method, "mode" for categories.
+ * Cells are scaled as they are rendered if scaler is given, the map is left as is.
  */
-void handleFlowAccumulation(Map<double>& elevationMap, Map<int>& D8Map, Map<double>& flowMap, Map<double>& GMap, Map<double>& aspectMap, std::string& flowType, bool totalFlow) {
-    // Given that total flow was selected
-    if (totalFlow) {
-        if (flowType == "d8") {
-            FlowAccumulator<double, int, double> flowAccumulator(elevationMap, nullptr, nullptr, &D8Map);
-            flowMap = flowAccumulator.accumulateFlow(flowType);
+template <typename T>
+static bool exportImages(const Map<T>& map, const Map<double>& hillshadeMap, const ProcessOptions& options,
+    const char* method, const char* name, const MapScaler<T>* scaler = nullptr) {
+    bool success = true;
+    if (!options.imageFile.empty() && options.previewSize > 0) {
+        // Render the finest overview level that fits in previewSize
+        MapPyramid<T> pyramid(map, method, options.previewSize);
+        int levelIndex = pyramid.findLevel(options.previewSize);
+        const Map<T>& level = pyramid.getLevel(levelIndex);
+        if (hillshadeMap.getWidth() == 0) {
+            success = exportImage(level, hillshadeMap, options.imageFile, options.colourType, scaler);
         }
-        else if (flowType == "dinf") {
-            FlowAccumulator<double, int, double> flowAccumulator(elevationMap, &aspectMap, &GMap, nullptr);
-            flowMap = flowAccumulator.accumulateFlow(flowType);
+        else {
+            // Hillshade reduced to the same level
+            MapPyramid<double> shadePyramid(hillshadeMap, "mean", options.previewSize);
+            success = exportImage(level, shadePyramid.getLevel(levelIndex), options.imageFile, options.colourType,
+                scaler);
         }
-        else if (flowType == "mdf") {
-            FlowAccumulator<double, int, double> flowAccumulator(elevationMap, nullptr, &GMap, nullptr);
-            flowMap = flowAccumulator.accumulateFlow(flowType);
+        std::cout << "Saved " << name << " preview (" << level.getWidth() << "x" << level.getHeight()
+                  << ") to: " << options.imageFile << std::endl;
+    }
+    else if (!options.imageFile.empty()) {
+        success = exportImage(map, hillshadeMap, options.imageFile, options.colourType, scaler);
+        std::cout << "Saved " << name << " image to: " << options.imageFile << std::endl;
+    }
+    if (!options.tilesDirectory.empty()) {
+        if (TileExport<T>::exportTiles(map, options.tilesDirectory, options.colourType, true, method, scaler)) {
+            std::cout << "Saved " << name << " tiles to: " << options.tilesDirectory << std::endl;
         }
         else {
-            std::cerr << "Unrecognised process for flow accumulation." << std::endl;
+            success = false;
         }
     }
+    return success;
 }
 
 /**
- * @brief run watershed delineation for process if watershed was selected (-w)
+ * @brief Add -o and -img / -tiles nodes reading a map from node source
  */
-void handleWatershed(Map<double>& elevationMap, Map<int>& D8Map, Map<double>& flowMap,
-    Map<double>& GMap, Map<double>& aspectMap, std::string& flowType, bool watershed,
-    int nPourPoints, char* watershed_directory, char* watershed_colour) {
-        // Given watershed was chosen
-        if (watershed) {
-        if (flowType == "d8") {
-            // Run flow
-            FlowAccumulator<double, int, double> flowAccumulator(elevationMap, nullptr, nullptr, &D8Map);
-            flowMap = flowAccumulator.accumulateFlow(flowType);
-            
-            // Identify pour points
-            std::vector<std::pair<int, int>> pourPoints;
-            watershedAnalysis<double, int> watershedAnalyser(elevationMap, &D8Map, &flowMap, nullptr, nullptr);
-            pourPoints = watershedAnalyser.getPourPoints(nPourPoints, "d8");
-            
-            // Iterate over pour points found
-            int i = 0;
-            for (const auto& p : pourPoints) {
-                Map<double> outputWatershed = watershedAnalyser.calculateWatershed(p, "d8");
-                outputWatershed.applyScaling("log");
-                std::ostringstream oss;
-                oss << watershed_directory << "watershed_" << i << ".bmp";  // Format as "../test/watershed_i"
-                std::string filename = oss.str();
-                ImageExport<double>::exportMapToImage(outputWatershed, filename, watershed_colour, true);
-                i++;
-            }
-        }
-        else if (flowType == "dinf") {
-            // Run flow
-            FlowAccumulator<double, int, double> flowAccumulator(elevationMap, &aspectMap, &GMap, nullptr);
-            flowMap = flowAccumulator.accumulateFlow(flowType);
-
-           // Identify pour points 
-            std::vector<std::pair<int, int>> pourPoints;
-            watershedAnalysis<double, int> watershedAnalyser(elevationMap, nullptr, &flowMap, &GMap, &aspectMap);
-            pourPoints = watershedAnalyser.getPourPoints(nPourPoints, "dinf");
-            
-            // iterate over pour points
-            int i = 0;
-            for (const auto& p : pourPoints) {
-                Map<double> outputWatershed = watershedAnalyser.calculateWatershed(p, "dinf");
-                
-                outputWatershed.applyScaling("log");
-                std::ostringstream oss;
-                oss << watershed_directory << "watershed_" << i << ".bmp";  // Format as "../test/watershed_i"
-                std::string filename = oss.str();
-                ImageExport<double>::exportMapToImage(outputWatershed, filename, watershed_colour, true);
-                i++;
+template <typename T>
+static void addOutputNodes(Pipeline& pipeline, const ProcessOptions& options, const std::string& source,
+    std::function<const Map<T>&(const Pipeline&)> select, const char* method, const char* name, bool logScale,
+    std::vector<std::string>& targets) {
+    if (!options.outputFile.empty()) {
+        pipeline.addNode<bool>("output", {source}, [=](const Pipeline& p, bool& saved) {
+            saved = select(p).saveToFile(options.outputFile, options.inputFileType);
+            if (saved) {
+                std::cout << "Saved " << name << " as ." << options.inputFileType << " file: "
+                          << options.outputFile << std::endl;
             }
+            return saved;
+        });
+        targets.push_back("output");
+    }
 
+    if (!options.imageFile.empty() || !options.tilesDirectory.empty()) {
+        // Shaded images also read the hillshade
+        bool shaded = options.hillshade && options.process != "hillshade";
+        std::vector<std::string> dependencies = {source};
+        if (shaded && source != "surface") {
+            dependencies.push_back("surface");
         }
-        else if (flowType == "mdf") {
-            // Run flow
-            FlowAccumulator<double, int, double> flowAccumulator(elevationMap, nullptr, &GMap, nullptr);
-            flowMap = flowAccumulator.accumulateFlow(flowType);
+        pipeline.addNode<bool>("image", dependencies, [=](const Pipeline& p, bool& exported) {
+            static const Map<double> noShade;
+            const Map<double>& shade = shaded ? p.get<SurfaceMaps>("surface").hillshade : noShade;
+            if (logScale) {
+                MapScaler<T> scaler(select(p), "log");
+                exported = exportImages(select(p), shade, options, method, name, &scaler);
+            }
+            else {
+                exported = exportImages(select(p), shade, options, method, name);
+            }
+            return exported;
+        });
+        targets.push_back("image");
+    }
+}
 
-            // Identify pour points
-            std::vector<std::pair<int, int>> pourPoints;
-            watershedAnalysis<double, int> watershedAnalyser(elevationMap, nullptr, &flowMap, nullptr, nullptr);
-            pourPoints = watershedAnalyser.getPourPoints(nPourPoints, "mdf");
-
-            // iterate over pour points
-            int i = 0;
-            for (const auto& p : pourPoints) {
-                Map<double> outputWatershed = watershedAnalyser.calculateWatershed(p, "mdf");
-                outputWatershed.applyScaling("log");
-                std::ostringstream oss;
-                oss << watershed_directory << "watershed_" << i << ".bmp";  // Format as "../test/watershed_i"
-                std::string filename = oss.str();
-                ImageExport<double>::exportMapToImage(outputWatershed, filename, watershed_colour, true);
-                i++;
+/**
+ * @brief Add a node making one map. With a cache, a cached map is loaded by a node reading
+ * nothing else, and a computed map is stored.
+ */
+template <typename T>
+static void addMapNode(Pipeline& pipeline, const std::string& name, const std::vector<std::string>& dependencies,
+    ProductCache* cache, const std::string& key, Pipeline::Compute<Map<T>> compute) {
+    if (cache && cache->contains<T>(key)) {
+        pipeline.addNode<Map<T>>(name, {}, [=](const Pipeline&, Map<T>& map) {
+            if (!cache->load(key, map)) {
+                std::cerr << "Error: Failed to load " << name << " from cache." << std::endl;
+                return false;
             }
-        }
+            std::cout << "Loaded " << name << " from cache." << std::endl;
+            return true;
+        });
+        return;
     }
+    pipeline.addNode<Map<T>>(name, dependencies, [=](const Pipeline& p, Map<T>& map) {
+        if (!compute(p, map)) return false;
+        if (cache) cache->store(key, map);
+        return true;
+    });
 }
 
 /**
- * @brief Handle outputs for images and files if selected
+ * @brief Nodes for a CLI run
  */
-void handleOutput(Map<double>& flowMap, Map<int>& D8Map, Map<double>& aspectMap, Map<double>& GMap,
-    char* output_file, char* image_file, char* input_file_type, char* colour_type, char* process,
-    bool totalFlow, bool watershed) {
-    // Flow accumulation out
-    if (totalFlow) {
-        if (output_file) {
-            flowMap.saveToFile(output_file, input_file_type);
-            std::cout << "Saved ." << input_file_type << " file as " << output_file << std::endl;
+bool buildProcessPipeline(Pipeline& pipeline, const ProcessOptions& options, std::vector<std::string>& targets,
+    ProductCache* cache) {
+    const std::string& process = options.process;
+    if (process != "d8" && process != "dinf" && process != "mdf" && process != "slope" && process != "aspect" &&
+        process != "hillshade") {
+        std::cerr << "Error: Unknown process: " << process << std::endl;
+        return false;
+    }
+    if (options.streams && process != "d8") {
+        std::cerr << "Stream network extraction requires the d8 process." << std::endl;
+        return false;
+    }
+    const std::string flowType = (process == "d8" || process == "dinf" || process == "mdf") ? process : "";
+
+    // Products the run reads
+    bool needSlope = (process == "dinf" || process == "mdf" || process == "slope" || options.watershed);
+    bool needAspect = (process == "dinf" || process == "aspect");
+    bool needHillshade = (process == "hillshade" || options.hillshade);
+
+    // Products are keyed by the DEM file bytes, sinks are filled after loading
+    std::string source;
+    if (cache) {
+        uint64_t fileHash;
+        if (!ProductCache::hashFile(options.inputFile, fileHash)) {
+            std::cerr << "File: " << options.inputFile << " does not exist." << std::endl;
+            return false;
+        }
+        source = "file:" + ProductCache::toHex(fileHash) + ":" + options.inputFileType + ":filled";
+    }
+
+    // Load and fill the DEM
+    pipeline.addNode<Map<double>>("dem", {}, [=](const Pipeline&, Map<double>& dem) {
+        if (!dem.loadFromFile(options.inputFile, options.inputFileType)) {
+            std::cerr << "File: " << options.inputFile << " does not exist." << std::endl;
+            return false;
+        }
+        dem.fillSinks();
+        return true;
+    });
+
+    // Slope, aspect, and hillshade from one Sobel sweep
+    if (needSlope || needAspect || needHillshade) {
+        const HillshadeOptions& shade = options.hillshadeOptions;
+        std::ostringstream shadeParameters;
+        shadeParameters.precision(17);
+        shadeParameters << shade.azimuth << " " << shade.altitude << " " << shade.zFactor << " "
+                        << shade.multidirectional;
+        std::string slopeKey = ProductCache::makeKey(source, "slope");
+        std::string aspectKey = ProductCache::makeKey(source, "aspect");
+        std::string hillshadeKey = ProductCache::makeKey(source, "hillshade", shadeParameters.str());
+
+        if (cache && (!needSlope || cache->contains<double>(slopeKey)) &&
+            (!needAspect || cache->contains<double>(aspectKey)) &&
+            (!needHillshade || cache->contains<double>(hillshadeKey))) {
+            pipeline.addNode<SurfaceMaps>("surface", {}, [=](const Pipeline&, SurfaceMaps& surface) {
+                if ((needSlope && !cache->load(slopeKey, surface.slope)) ||
+                    (needAspect && !cache->load(aspectKey, surface.aspect)) ||
+                    (needHillshade && !cache->load(hillshadeKey, surface.hillshade))) {
+                    std::cerr << "Error: Failed to load surface maps from cache." << std::endl;
+                    return false;
+                }
+                std::cout << "Loaded surface maps from cache." << std::endl;
+                return true;
+            });
         }
-        if (image_file) {
-            flowMap.applyScaling("log");
-            ImageExport<double>::exportMapToImage(flowMap, image_file, colour_type, true);
-            std::cout << "Saved image file to: " << image_file << std::endl;
+        else {
+            pipeline.addNode<SurfaceMaps>("surface", {"dem"}, [=](const Pipeline& p, SurfaceMaps& surface) {
+                SlopeAnalyser sAnalyser(p.get<Map<double>>("dem"));
+                sAnalyser.computeSurface(needSlope ? &surface.slope : nullptr, needAspect ? &surface.aspect : nullptr,
+                    needHillshade ? &surface.hillshade : nullptr, options.hillshadeOptions);
+                if (cache) {
+                    if (needSlope) cache->store(slopeKey, surface.slope);
+                    if (needAspect) cache->store(aspectKey, surface.aspect);
+                    if (needHillshade) cache->store(hillshadeKey, surface.hillshade);
+                }
+                return true;
+            });
         }
     }
-    // Regular map types out
-    else {
-        if (strcmp(process, "d8") == 0) {
-            if (output_file) {
-                D8Map.saveToFile(output_file, input_file_type);
-                std::cout << "Saved D8 flow map as ." << input_file_type << " file: " << output_file << std::endl;
-            }
-            if (image_file) {
-                ImageExport<int>::exportMapToImage(D8Map, image_file, colour_type, true);
-                std::cout << "Saved D8 flow map image to: " << image_file << std::endl;
-            }
+
+    // D8 directions
+    if (process == "d8") {
+        addMapNode<int>(pipeline, "d8", {"dem"}, cache, ProductCache::makeKey(source, "d8"),
+            [](const Pipeline& p, Map<int>& D8Map) {
+            D8FlowAnalyser analyser(p.get<Map<double>>("dem"));
+            analyser.analyseFlow();
+            D8Map = analyser.getMap();
+            return true;
+        });
+    }
+
+    // Flow accumulation, shared by -fa, -w, and -s
+    if (options.totalFlow || options.watershed || options.streams) {
+        if (flowType.empty()) {
+            std::cerr << "Unrecognised process for flow accumulation." << std::endl;
+            return false;
         }
-        else if (strcmp(process, "dinf") == 0) {
-            if (output_file) {
-                aspectMap.saveToFile(output_file, input_file_type);
-                std::cout << "Saved D∞ aspect map as ." << input_file_type << " file: " << output_file << std::endl;
+        std::string directions = (flowType == "d8") ? "d8" : "surface";
+        addMapNode<double>(pipeline, "flow", {"dem", directions}, cache,
+            ProductCache::makeKey(source, "flow-" + flowType), [=](const Pipeline& p, Map<double>& flowMap) {
+            const Map<double>& elevationMap = p.get<Map<double>>("dem");
+            if (flowType == "d8") {
+                FlowAccumulator<double, int, double> flowAccumulator(elevationMap, nullptr, nullptr,
+                    &p.get<Map<int>>("d8"));
+                flowMap = flowAccumulator.accumulateFlow(flowType);
             }
-            if (image_file) {
-                ImageExport<double>::exportMapToImage(aspectMap, image_file, colour_type, true);
-                std::cout << "Saved D∞ aspect map image to: " << image_file << std::endl;
+            else {
+                const SurfaceMaps& surface = p.get<SurfaceMaps>("surface");
+                FlowAccumulator<double, int, double> flowAccumulator(elevationMap,
+                    (flowType == "dinf") ? &surface.aspect : nullptr, &surface.slope, nullptr);
+                flowMap = flowAccumulator.accumulateFlow(flowType);
             }
+            return true;
+        });
+    }
+
+    // Watershed delineation (-w)
+    if (options.watershed) {
+        std::vector<std::string> dependencies = {"dem", "flow"};
+        if (flowType == "d8") {
+            // Reuse basin tree persisted next to the DEM
+            pipeline.addNode<BasinTree>("basins", {"d8", "flow"}, [=](const Pipeline& p, BasinTree& basinTree) {
+                double threshold = (options.streamThreshold > 0) ? options.streamThreshold : DEFAULT_BASIN_THRESHOLD;
+                // Saved trees are tied to the DEM bytes and tool version
+                uint64_t fileHash;
+                if (!ProductCache::hashFile(options.inputFile, fileHash)) return false;
+                std::string source = ProductCache::makeKey("file:" + ProductCache::toHex(fileHash) + ":" +
+                    options.inputFileType, "basins");
+                loadOrBuildBasinTree(p.get<Map<int>>("d8"), p.get<Map<double>>("flow"), threshold,
+                    options.inputFile + ".basins", source, basinTree);
+                return true;
+            });
+            dependencies.push_back("d8");
+            dependencies.push_back("basins");
         }
-        else if (strcmp(process, "mdf") == 0 && !(watershed)) {
-            std::cerr << "MDF process does not have output without Flow Accumulation (-fa). " << std::endl;
+        else if (flowType == "dinf") {
+            dependencies.push_back("surface");
         }
-        else if (strcmp(process, "slope") == 0) {
-            if (image_file) {
-                ImageExport<double>::exportMapToImage(GMap, image_file, colour_type, true);
-                std::cout << "Saved slope map image to: " << image_file << std::endl;
+
+        pipeline.addNode<Map<int>>("watersheds", dependencies, [=](const Pipeline& p, Map<int>& labels) {
+            const Map<double>& elevationMap = p.get<Map<double>>("dem");
+            const Map<double>& flowMap = p.get<Map<double>>("flow");
+            const Map<int>* D8Map = (flowType == "d8") ? &p.get<Map<int>>("d8") : nullptr;
+            const SurfaceMaps* surface = (flowType == "dinf") ? &p.get<SurfaceMaps>("surface") : nullptr;
+
+            // Identify pour points
+            watershedAnalysis<double, int> watershedAnalyser(elevationMap, D8Map, &flowMap,
+                surface ? &surface->slope : nullptr, surface ? &surface->aspect : nullptr);
+            if (flowType == "d8") {
+                watershedAnalyser.setBasinTree(&p.get<BasinTree>("basins"));
             }
-        }
-        else if (strcmp(process, "aspect") == 0) {
-            if (image_file) {
-                ImageExport<double>::exportMapToImage(aspectMap, image_file, colour_type, true);
-                std::cout << "Saved aspect map image to: " << image_file << std::endl;
+            std::vector<std::pair<int, int>> pourPoints = watershedAnalyser.getPourPoints(options.nPourPoints, flowType);
+
+            // Delineate and export a wave of pour points at a time on the pool, then label in order
+            labels = Map<int>(elevationMap.getWidth(), elevationMap.getHeight(), -1);
+            int nPoints = static_cast<int>(pourPoints.size());
+            int wave = watershedAnalysis<double, int>::getWaveSize(static_cast<uint64_t>(elevationMap.getWidth()) *
+                elevationMap.getHeight());
+            for (int first = 0; first < nPoints; first += wave) {
+                int last = std::min(nPoints, first + wave);
+                std::vector<Map<double>> watersheds(last - first);
+                parallelFor(first, last, wave, [&](int, int i0, int i1) {
+                    for (int i = i0; i < i1; i++) {
+                        Map<double>& outputWatershed = watersheds[i - first];
+                        outputWatershed = watershedAnalyser.calculateWatershed(pourPoints[i], flowType);
+                        MapScaler<double> scaler(outputWatershed, "log");
+                        std::ostringstream oss;
+                        oss << options.watershedDirectory << "watershed_" << i << ".bmp";  // Format as "../test/watershed_i"
+                        ImageExport<double>::exportMapToImage(outputWatershed, oss.str(), options.watershedColour, true,
+                            &scaler);
+                    }
+                });
+                for (int i = first; i < last; i++) {
+                    watershedAnalyser.markWatershed(watersheds[i - first], i, labels);
+                }
             }
+            return true;
+        });
+
+        pipeline.addNode<bool>("watershed_stats", {"dem", "surface", "flow", "watersheds"},
+            [=](const Pipeline& p, bool& saved) {
+            saveWatershedStats(p.get<Map<double>>("dem"), p.get<SurfaceMaps>("surface").slope,
+                p.get<Map<double>>("flow"), p.get<Map<int>>("watersheds"), options.watershedDirectory);
+            saved = true;
+            return true;
+        });
+        targets.push_back("watershed_stats");
+    }
+
+    // Stream network (-s)
+    if (options.streams) {
+        pipeline.addNode<bool>("streams", {"d8", "flow"}, [=](const Pipeline& p, bool& saved) {
+            StreamNetwork<double> network(p.get<Map<double>>("flow"), p.get<Map<int>>("d8"));
+            network.extractStreams(options.streamThreshold);
+
+            const std::string& directory = options.streamsDirectory;
+            const std::string& type = options.inputFileType;
+            network.getStrahlerMap().saveToFile(directory + "streams_strahler." + type, type);
+            network.getShreveMap().saveToFile(directory + "streams_shreve." + type, type);
+            network.saveLinksToCSV(directory + "streams_links.csv");
+
+            std::cout << "Extracted " << network.getLinks().size() << " stream links ("
+                      << network.getJunctions().size() << " junctions, "
+                      << network.getOutlets().size() << " outlets) to: " << directory << std::endl;
+            saved = true;
+            return true;
+        });
+        targets.push_back("streams");
+    }
+
+    // Output for -o, -img, or -tiles
+    if (options.totalFlow) {
+        addOutputNodes<double>(pipeline, options, "flow",
+            [](const Pipeline& p) -> const Map<double>& { return p.get<Map<double>>("flow"); },
+            "max", "flow accumulation", true, targets);
+    }
+    else if (process == "d8") {
+        addOutputNodes<int>(pipeline, options, "d8",
+            [](const Pipeline& p) -> const Map<int>& { return p.get<Map<int>>("d8"); },
+            "mode", "D8 flow map", false, targets);
+    }
+    else if (process == "dinf") {
+        addOutputNodes<double>(pipeline, options, "surface",
+            [](const Pipeline& p) -> const Map<double>& { return p.get<SurfaceMaps>("surface").aspect; },
+            "mean", "D∞ aspect map", false, targets);
+    }
+    else if (process == "mdf" && !options.watershed) {
+        std::cerr << "MDF process does not have output without Flow Accumulation (-fa). " << std::endl;
+    }
+    else if (process == "slope") {
+        addOutputNodes<double>(pipeline, options, "surface",
+            [](const Pipeline& p) -> const Map<double>& { return p.get<SurfaceMaps>("surface").slope; },
+            "mean", "slope map", false, targets);
+    }
+    else if (process == "aspect") {
+        addOutputNodes<double>(pipeline, options, "surface",
+            [](const Pipeline& p) -> const Map<double>& { return p.get<SurfaceMaps>("surface").aspect; },
+            "mean", "aspect map", false, targets);
+    }
+    else if (process == "hillshade") {
+        // Shown plain, not blended over itself
+        addOutputNodes<double>(pipeline, options, "surface",
+            [](const Pipeline& p) -> const Map<double>& { return p.get<SurfaceMaps>("surface").hillshade; },
+            "mean", "hillshade map", false, targets);
+    }
+    return true;
+}
+
+/**
+ * @brief Build and run CLI pipeline
+ */
+bool runProcess(const ProcessOptions& options) {
+    // Carry on uncached if the cache directory is unusable
+    std::unique_ptr<ProductCache> cache;
+    if (!options.cacheDirectory.empty()) {
+        cache.reset(new ProductCache(options.cacheDirectory, options.cacheSizeMB));
+        if (!cache->isValid()) {
+            cache.reset();
         }
     }
-}
\ No newline at end of file
+
+    Pipeline pipeline;
+    std::vector<std::string> targets;
+    if (!buildProcessPipeline(pipeline, options, targets, cache.get())) {
+        return false;
+    }
+    return pipeline.run(targets);
+}
+
+/**
+ * @brief Zonal statistics of watershed labels
+ */
+void saveWatershedStats(const Map<double>& elevationMap, const Map<double>& GMap, const Map<double>& flowMap,
+    const Map<int>& labels, const std::string& watershed_directory) {
+    ZonalStatistics<double> stats(labels, elevationMap);
+    stats.addValueMap("slope", GMap);
+    stats.addValueMap("flow", flowMap);
+    stats.compute();
+
+    std::string filename = watershed_directory + "watershed_stats.csv";
+    if (stats.saveToCSV(filename)) {
+        std::cout << "Saved watershed statistics to: " << filename << std::endl;
+    }
+}
+
+/**
+ * @brief Reuse saved basin tree or build a new one
+ */
+void loadOrBuildBasinTree(const Map<int>& D8Map, const Map<double>& flowMap, double threshold,
+    const std::string& filename, const std::string& source, BasinTree& tree) {
+    if (tree.loadFromFile(filename) && tree.getSource() == source && tree.getThreshold() == threshold &&
+        tree.getLabelMap().getWidth() == D8Map.getWidth() && tree.getLabelMap().getHeight() == D8Map.getHeight()) {
+        return;
+    }
+
+    StreamNetwork<double> network(flowMap, D8Map);
+    network.extractStreams(threshold);
+    tree = BasinTree(D8Map, network.getLinkMap(), network.getLinks(), threshold);
+    tree.setSource(source);
+    tree.saveToFile(filename);
+}
+
+/**
+ * @brief Synthetic DEM to file
+ */
+bool generateTerrainFile(const std::string& filename, int width, int height, const TerrainOptions& options) {
+    TerrainGenerator<double> generator(options);
+    std::string type = getFileExtension(filename.c_str());
+    bool saved = false;
+    if (type == "bin") {
+        saved = generator.generateToFile(filename, width, height);
+    }
+    else if (type == "txt" || type == "csv") {
+        saved = generator.generate(width, height).saveToFile(filename, type);
+    }
+    else {
+        std::cerr << "Error: Invalid output file extension. Supported extensions are .txt, .csv, .bin." << std::endl;
+        return false;
+    }
+    if (saved) {
+        std::cout << "Saved " << width << "x" << height << " terrain (seed " << options.seed << ") to: " << filename
+                  << std::endl;
+    }
+    return saved;
+}
@@ -2,11 +2,11 @@
  * @file MapProcessing.h
  * @author Ollie
  * @brief Function for handling DEMs whilst using CLI UI
- * @version 1.0.0
+ * @version 1.1.0
  * @date 2025-03-16
- * 
+ *
  * @copyright Copyright (c) 2025
- * 
+ *
  */
 #ifndef MAP_PROCESSING_H
 #define MAP_PROCESSING_H
@@ -16,66 +16,119 @@
 #include "../DEM_analysis/D8FlowAnalyser.h"
 #include "../DEM_analysis/FlowAccumulation.h"
 #include "../DEM_analysis/watershedAnalysis.h"
+#include "../DEM_analysis/StreamNetwork.h"
+#include "../DEM_analysis/BasinTree.h"
+#include "../DEM_analysis/ZonalStatistics.h"
 #include "../image_handling/ImageExport.h"
+#include "../image_handling/TileExport.h"
+#include "../map_core/MapPyramid.h"
+#include "../map_core/TerrainGenerator.h"
+#include "../pipeline/Pipeline.h"
+#include "../pipeline/ProductCache.h"
+#include <string>
+#include <vector>
 
 /**
- * @brief Create necessary maps for later analysis processes.
- * 
+ * @brief Everything chosen on the command line for one DEM. Empty strings are outputs not wanted.
+ */
+struct ProcessOptions {
+    std::string inputFile;          // DEM pathway (-i)
+    std::string inputFileType;      // txt, csv, or bin, also used for -o and stream order maps
+    std::string process;            // -p process
+    std::string outputFile;         // -o
+    std::string imageFile;          // -img
+    std::string tilesDirectory;     // -tiles
+    int previewSize = 0;            // --preview, 0 for full resolution
+    std::string colourType = "g1";  // -c
+    bool totalFlow = false;         // -fa
+    bool watershed = false;         // -w
+    int nPourPoints = 0;
+    std::string watershedDirectory;
+    std::string watershedColour = "g1";
+    bool streams = false;           // -s
+    double streamThreshold = 0.0;
+    std::string streamsDirectory;
+    bool hillshade = false;         // -hs
+    HillshadeOptions hillshadeOptions;
+    std::string cacheDirectory;     // --cache, empty for no product cache
+    uint64_t cacheSizeMB = DEFAULT_CACHE_MB;
+};
 
+/**
+ * @brief Surface products of one fused Sobel sweep. Maps not needed are left empty.
  */
-void processMap(Map<double>& elevationMap, char* process, Map<int>& D8Map, Map<double>& flowMap,
-    Map<double>& GMap, Map<double>& aspectMap, std::string& flowType);
+struct SurfaceMaps {
+    Map<double> slope;
+    Map<double> aspect;
+    Map<double> hillshade;
+};
 
 /**
- * @brief Function that runs specific flow accumulaton algorithm for specified prcoess
- * 
- * @param elevationMap Input DEM
- * @param process Process specified by -p flag
- * @param D8Map Container for D8 flow directions map
- * @param flowMap Container for flow accumulation map
- * @param GMap Container for gradient map
- * @param aspectMap Container for aspect map
- * @param flowType container for flow type (mdf, dinf, d8)
+ * @brief Add the nodes for a CLI run to a pipeline.
+ * Nodes: "dem" (loaded and sink filled), "surface" (slope, aspect, and hillshade in one sweep),
+ * "d8", "flow", "basins", "watersheds", "watershed_stats", "streams", "output", and "image".
+ * Only the nodes the options need are added. Flow is accumulated once and shared by
+ * flow output, watersheds, and streams.
+ *
+ * With a cache, "surface", "d8", and "flow" are loaded from it when their key (input file
+ * bytes, algorithm, parameters, and tool version) matches, and stored in it otherwise.
+ * Cached nodes read no other node, so the DEM is not even loaded if nothing else needs it.
+ *
+ * @param pipeline Pipeline to fill
+ * @param options Command line choices
+ * @param targets Output: sink nodes to run
+ * @param cache Product cache, nullptr for none. Must outlive pipeline.run()
+ * @return true If the options make a valid pipeline
  */
-void handleFlowAccumulation(Map<double>& elevationMap, Map<int>& D8Map, Map<double>& flowMap,
-    Map<double>& GMap, Map<double>& aspectMap, std::string& flowType, bool totalFlow);
+bool buildProcessPipeline(Pipeline& pipeline, const ProcessOptions& options, std::vector<std::string>& targets,
+    ProductCache* cache = nullptr);
 
 /**
- * @brief Function that runs watershed delineation for specified process
- * 
+ * @brief Build and run the pipeline for a CLI run, with the product cache in
+ * options.cacheDirectory if one is given
+ *
+ * @param options Command line choices
+ * @return true If every step succeeded
+ */
+bool runProcess(const ProcessOptions& options);
+
+/**
+ * @brief Write per-watershed statistics (area, elevation, slope, flow, hypsometric integral)
+ * to watershed_stats.csv in watershed_directory. Rows are labelled by pour point index.
+ *
  * @param elevationMap Input DEM
- * @param process Process specified by -p flag
- * @param D8Map Container for D8 flow directions map
- * @param flowMap Container for flow accumulation map
- * @param GMap Container for gradient map
- * @param aspectMap Container for aspect map
- * @param flowType container for flow type (mdf, dinf, d8)
- * @param watershed If watershed was selected
- * @param nPourPoints Number of pour points to identify
- * @param watershed_directory Where watershed output images are to be stored
- * @param watershed_colour Colour shortcode for colourmap used in watershed images
+ * @param GMap Gradient map
+ * @param flowMap Flow accumulation map
+ * @param labels Innermost watershed per cell, -1 outside all watersheds
+ * @param watershed_directory Where watershed outputs are stored
+ */
+void saveWatershedStats(const Map<double>& elevationMap, const Map<double>& GMap, const Map<double>& flowMap,
+    const Map<int>& labels, const std::string& watershed_directory);
+
+/**
+ * @brief Load the basin tree saved as filename, or build it from D8 and flow maps and save it.
+ * A saved tree is only reused if it matches the source, map size and channel threshold.
+ *
+ * @param D8Map D8 flow directions map
+ * @param flowMap D8 flow accumulation map
+ * @param threshold Channel threshold for stream links
+ * @param filename Basin tree pathway
+ * @param source Key of the DEM bytes and tool version, see ProductCache::makeKey()
+ * @param tree Container for basin tree
  */
-void handleWatershed(Map<double>& elevationMap, Map<int>& D8Map, Map<double>& flowMap, Map<double>& GMap,
-    Map<double>& aspectMap, std::string& flowType, bool watershed, int nPourPoints, char* watershed_directory,
-    char* watershed_colour);
+void loadOrBuildBasinTree(const Map<int>& D8Map, const Map<double>& flowMap, double threshold,
+    const std::string& filename, const std::string& source, BasinTree& tree);
 
 /**
- * @brief 
- * 
- * @param flowMap Container for flow accumulation map
- * @param D8Map Container for D8 flow directions map
- * @param aspectMap Container for aspect map
- * @param GMap Container for gradient map
- * @param output_file output file full pathway
- * @param image_file image file full pathway
- * @param input_file_type .bmp
- * @param colour_type colourmap for image output
- * @param process process specified (-p flag)
- * @param totalFlow flow accumulation specified (-fa flag)
- * @param watershed watershed delineation specified (-w flag)
+ * @brief Write a synthetic DEM. .bin files are generated in blocks of rows straight to disk,
+ * so they can be larger than memory. .txt and .csv files are generated in memory first.
+ *
+ * @param filename Output pathway, the extension picks the format
+ * @param width Grid width
+ * @param height Grid height
+ * @param options Terrain shape and seed
+ * @return true If written
  */
-void handleOutput(Map<double>& flowMap, Map<int>& D8Map, Map<double>& aspectMap, Map<double>& GMap,
-    char* output_file, char* image_file, char* input_file_type, char* colour_type, char* process,
-    bool totalFlow, bool watershed);
+bool generateTerrainFile(const std::string& filename, int width, int height, const TerrainOptions& options);
 
-#endif // MAP_PROCESSING_H
\ No newline at end of file
+#endif // MAP_PROCESSING_H
@@ -11,6 +11,92 @@
 
  #include "REPL.h"
 
+// Flow map holds D8 accumulation counts and can be updated by edit
+static bool flowIsD8 = false;
+
+// Overview pyramids for export previews, cleared by any command that may change maps
+static MapPyramid<double>* previewPyramid = nullptr;
+static MapPyramid<int>* previewD8Pyramid = nullptr;
+
+// Derived products reused across loads and sessions, nullptr until the 'cache' command
+static ProductCache* productCache = nullptr;
+
+// Basin tree of the D8 maps, built by the d8 watershed and streams modes and kept in step by edit
+static BasinTree* basinTree = nullptr;
+
+// Channel threshold of the tree built for d8 watersheds, as the CLI's -w default
+static const double REPL_BASIN_THRESHOLD = 100.0;
+
+/**
+ * @brief Replace product with the cached map for algorithm, or compute it and store it.
+ * Without a product cache the map is just computed.
+ */
+template <typename T>
+static void cachedProduct(const std::string& source, const std::string& algorithm, Map<T>*& product,
+    const std::function<Map<T>()>& compute) {
+    Map<T> map;
+    std::string key = ProductCache::makeKey(source, algorithm);
+    if (productCache && productCache->load(key, map)) {
+        std::cout << "Loaded " << algorithm << " from cache.\n";
+    }
+    else {
+        map = compute();
+        if (productCache) productCache->store(key, map);
+    }
+    if (product) delete product;
+    product = new Map<T>(std::move(map));
+}
+
+/**
+ * @brief Free cached preview pyramids
+ */
+static void clearPreviewCache() {
+    delete previewPyramid;
+    delete previewD8Pyramid;
+    previewPyramid = nullptr;
+    previewD8Pyramid = nullptr;
+}
+
+/**
+ * @brief Free basin tree, which no longer matches the D8 and flow maps
+ */
+static void clearBasinTree() {
+    delete basinTree;
+    basinTree = nullptr;
+}
+
+/**
+ * @brief Replace basin tree with one built from D8 map and its stream network
+ */
+static void buildBasinTree(const Map<int>& D8Map, const StreamNetwork<double>& network, double threshold) {
+    clearBasinTree();
+    basinTree = new BasinTree(D8Map, network.getLinkMap(), network.getLinks(), threshold);
+}
+
+/**
+ * @brief Export the finest cached overview level that fits in size pixels.
+ * The pyramid is built on first use and reused until maps change.
+ */
+template <typename T>
+static void exportPreview(const Map<T>& map, MapPyramid<T>*& pyramid, const char* method, int size,
+    bool logScale, const char* imageFile, const char* colourType) {
+    if (!pyramid || &pyramid->getSource() != &map || pyramid->getMethod() != method) {
+        delete pyramid;
+        pyramid = new MapPyramid<T>(map, method);
+    }
+    const Map<T>& level = pyramid->getLevel(pyramid->findLevel(size));
+
+    // Scale while rendering so the map and cache are untouched
+    if (logScale) {
+        MapScaler<T> scaler(level, "log");
+        ImageExport<T>::exportMapToImage(level, imageFile, colourType, true, &scaler);
+    }
+    else {
+        ImageExport<T>::exportMapToImage(level, imageFile, colourType, true);
+    }
+    std::cout << "Preview (" << level.getWidth() << "x" << level.getHeight() << ") exported to " << imageFile << "\n";
+}
+
  /**
   * @brief Main loop for REPL UI
   */
@@ -35,20 +121,40 @@ void runREPL() {
         
         char cmd[50];
         sscanf(command, "%s", cmd);
+
+        // Maps may change, previews must be rebuilt
+        if (strcmp(cmd, "export") != 0 && strcmp(cmd, "help") != 0 && strcmp(cmd, "cache") != 0 &&
+            strcmp(cmd, "threads") != 0) {
+            clearPreviewCache();
+        }
         
+        // Products this command uses are kept in the cache only until it ends
+        bool cacheRun = productCache && strcmp(cmd, "cache") != 0 && strcmp(cmd, "quit") != 0;
+        if (cacheRun) productCache->beginRun();
+
         // If else checks for valid operators
         if (strcmp(cmd, "load") == 0) {
+            clearBasinTree();
             loadFile(elevationMap, command);
         }
         else if (strcmp(cmd, "process") == 0) {
             processData(elevationMap, D8Map, flowMap, gradientMap, aspectMap, command);
         }
+        else if (strcmp(cmd, "edit") == 0) {
+            editData(elevationMap, D8Map, flowMap, gradientMap, aspectMap, command);
+        }
         else if (strcmp(cmd, "save") == 0) {
             saveData(flowMap, D8Map, aspectMap, gradientMap, command);
         }
         else if (strcmp(cmd, "export") == 0) {
             exportData(flowMap, D8Map, aspectMap, gradientMap, command);
         }
+        else if (strcmp(cmd, "cache") == 0) {
+            setCache(command);
+        }
+        else if (strcmp(cmd, "threads") == 0) {
+            setThreads(command);
+        }
         else if (strcmp(cmd, "help") == 0) {
             displayHelp();
         }
@@ -59,6 +165,8 @@ void runREPL() {
         else {
             std::cerr << "Error: Unknown command. Type 'help' for a list of commands.\n";
         }
+
+        if (cacheRun) productCache->endRun();
     }
 }
 
@@ -117,40 +225,58 @@ void processData(Map<double>* elevationMap, Map<int>*& D8Map, Map<double>*& flow
         return;
     }
 
+    // Cached products are keyed by the loaded (and edited) DEM cells
+    std::string source;
+    if (productCache) {
+        source = "map:" + ProductCache::toHex(ProductCache::hashMap(*elevationMap));
+    }
+
+    // Basin tree is built on D8 directions, other products leave it valid.
+    // Watershed and streams rebuild it with the directions they make.
+    if (strcmp(processType, "d8") == 0 || strcmp(processType, "d8_flow") == 0) {
+        clearBasinTree();
+    }
+
     // If else for process type
     if (strcmp(processType, "d8") == 0) {
         // Finds D8 direction map
-        D8FlowAnalyser analyser(*elevationMap);
-        analyser.analyseFlow();
-        if (D8Map) delete D8Map;
-        D8Map = new Map<int>(analyser.getMap());
+        cachedProduct<int>(source, "d8", D8Map, [&]() {
+            D8FlowAnalyser analyser(*elevationMap);
+            analyser.analyseFlow();
+            return analyser.getMap();
+        });
         std::cout << "D8 flow analysis completed.\n";
     }
     else if (strcmp(processType, "aspect") == 0) {
         // Finds aspect map
-        SlopeAnalyser sAnalyser(*elevationMap);
-        if (aspectMap) delete aspectMap;
-        aspectMap = new Map<double>(sAnalyser.computeDirection());
+        cachedProduct<double>(source, "aspect", aspectMap, [&]() {
+            SlopeAnalyser sAnalyser(*elevationMap);
+            return sAnalyser.computeDirection();
+        });
         std::cout << "Aspect analysis completed.\n";
     }
     else if (strcmp(processType, "slope") == 0) {
         // Finds gradient map
-        SlopeAnalyser sAnalyser(*elevationMap);
-        if (gradientMap) delete gradientMap;
-        gradientMap = new Map<double>(sAnalyser.computeSlope("combined"));
+        cachedProduct<double>(source, "slope", gradientMap, [&]() {
+            SlopeAnalyser sAnalyser(*elevationMap);
+            return sAnalyser.computeSlope("combined");
+        });
         std::cout << "Slope analysis completed.\n";
     }
     else if (strcmp(processType, "d8_flow") == 0) {
         // Find D8 direction map
-        D8FlowAnalyser analyser(*elevationMap);
-        analyser.analyseFlow();
-        if (D8Map) delete D8Map;
-        D8Map = new Map<int>(analyser.getMap());
+        cachedProduct<int>(source, "d8", D8Map, [&]() {
+            D8FlowAnalyser analyser(*elevationMap);
+            analyser.analyseFlow();
+            return analyser.getMap();
+        });
 
         // Run flow accumulation
-        FlowAccumulator<double, int, double> flowAccumulator(*elevationMap, nullptr, nullptr, D8Map);
-        if (flowMap) delete flowMap;
-        flowMap = new Map<double>(flowAccumulator.accumulateFlow("d8"));
+        cachedProduct<double>(source, "flow-d8", flowMap, [&]() {
+            FlowAccumulator<double, int, double> flowAccumulator(*elevationMap, nullptr, nullptr, D8Map);
+            return flowAccumulator.accumulateFlow("d8");
+        });
+        flowIsD8 = true;
         std::cout << "D8 Flow accumulation completed.\n";
     }
     else if (strcmp(processType, "dinf_flow") == 0) {
@@ -158,42 +284,105 @@ void processData(Map<double>* elevationMap, Map<int>*& D8Map, Map<double>*& flow
 
         // Find slope and gradient maps
         SlopeAnalyser sAnalyser(*elevationMap);
-        if (gradientMap) delete gradientMap;
-        gradientMap = new Map<double>(sAnalyser.computeSlope("combined"));
-
-        if (aspectMap) delete aspectMap;
-        aspectMap = new Map<double>(sAnalyser.computeDirection());
+        cachedProduct<double>(source, "slope", gradientMap, [&]() { return sAnalyser.computeSlope("combined"); });
+        cachedProduct<double>(source, "aspect", aspectMap, [&]() { return sAnalyser.computeDirection(); });
 
         // Run flow accumulation
-        FlowAccumulator<double, int, double> flowAccumulator(*elevationMap, aspectMap, gradientMap, nullptr);
-        if (flowMap) delete flowMap;
-        flowMap = new Map<double>(flowAccumulator.accumulateFlow("dinf"));
+        cachedProduct<double>(source, "flow-dinf", flowMap, [&]() {
+            FlowAccumulator<double, int, double> flowAccumulator(*elevationMap, aspectMap, gradientMap, nullptr);
+            return flowAccumulator.accumulateFlow("dinf");
+        });
+        flowIsD8 = false;
         std::cout << "Dinf Flow accumulation completed.\n";
     }
     else if (strcmp(processType, "mdf_flow") == 0) {
         // Finds MDF flow accumulation map
 
         // Find gradient map
-        SlopeAnalyser sAnalyser(*elevationMap);
-        if (gradientMap) delete gradientMap;
-        gradientMap = new Map<double>(sAnalyser.computeSlope("combined"));
+        cachedProduct<double>(source, "slope", gradientMap, [&]() {
+            SlopeAnalyser sAnalyser(*elevationMap);
+            return sAnalyser.computeSlope("combined");
+        });
 
         // Run flow accumulation
-        FlowAccumulator<double, int, double> flowAccumulator(*elevationMap, nullptr, gradientMap, nullptr);
-        if (flowMap) delete flowMap;
-        flowMap = new Map<double>(flowAccumulator.accumulateFlow("mdf"));
+        cachedProduct<double>(source, "flow-mdf", flowMap, [&]() {
+            FlowAccumulator<double, int, double> flowAccumulator(*elevationMap, nullptr, gradientMap, nullptr);
+            return flowAccumulator.accumulateFlow("mdf");
+        });
+        flowIsD8 = false;
         std::cout << "MDF Flow accumulation completed.\n";
     }
     else if (strcmp(processType, "watershed") == 0) {
         // Run watershed delineation
         handleWatershedAnalysis(elevationMap, D8Map, flowMap, gradientMap, aspectMap);
     }
+    else if (strcmp(processType, "streams") == 0) {
+        // Run stream network extraction
+        handleStreamAnalysis(elevationMap, D8Map, flowMap);
+    }
     else {
         // Failure
         std::cerr << "Error: Unknown process type: " << processType << "\n";
     }
 }
 
+ /**
+  * @brief Edit DEM region and update processed maps incrementally
+  */
+void editData(Map<double>* elevationMap, Map<int>* D8Map, Map<double>*& flowMap, Map<double>* gradientMap, Map<double>* aspectMap, const char* command) {
+    // Scan region and new value
+    int x0, y0, x1, y1;
+    double value;
+    if (sscanf(command, "%*s %d %d %d %d %lf", &x0, &y0, &x1, &y1, &value) != 5) {
+        std::cerr << "Error: Usage - edit <x0> <y0> <x1> <y1> <value>\n";
+        return;
+    }
+
+    // Check DEM is loaded first
+    if (!elevationMap) {
+        std::cerr << "Error: No file loaded. Use 'load' first.\n";
+        return;
+    }
+
+    // Check region
+    if (x0 < 0 || y0 < 0 || x1 < x0 || y1 < y0 || x1 >= elevationMap->getWidth() || y1 >= elevationMap->getHeight()) {
+        std::cerr << "Error: Region is outside of the loaded DEM.\n";
+        return;
+    }
+
+    // Only D8 accumulation can be updated in place
+    if (flowMap && !flowIsD8) {
+        delete flowMap;
+        flowMap = nullptr;
+        std::cout << "Flow map cleared, rerun the flow process.\n";
+    }
+
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            elevationMap->setData(x, y, value);
+        }
+    }
+
+    // Basin tree only matches D8 accumulation
+    if (!flowMap) {
+        clearBasinTree();
+    }
+
+    IncrementalAnalyser<double> analyser(*elevationMap, D8Map, flowMap, gradientMap, aspectMap, basinTree);
+    analyser.update(x0, y0, x1, y1);
+    std::cout << "Edit applied. D8 directions changed: " << analyser.getChangedDirections()
+              << ", flow cells updated: " << analyser.getUpdatedFlowCells();
+    if (basinTree) {
+        if (analyser.basinsRebuilt()) {
+            std::cout << ", basin tree rebuilt";
+        }
+        else {
+            std::cout << ", basin cells relabelled: " << analyser.getRelabelledCells();
+        }
+    }
+    std::cout << "\n";
+}
+
  /**
   * @brief Save processed maps
   */
@@ -241,16 +430,36 @@ void exportData(Map<double>* flowMap, Map<int>* D8Map, Map<double>* aspectMap, M
     // Containers
     char imageFile[128] = "";
     char colourType[10] = "";
+    char option[16] = "";
+    int previewSize = 0;
 
     // Check image file pathway and colour was specified
-    if (sscanf(command, "%*s %127s %9s", imageFile, colourType) < 1) {
-        std::cerr << "Error: Usage - export <image_file> [colour_type]\n";
+    if (sscanf(command, "%*s %127s %9s %15s %d", imageFile, colourType, option, &previewSize) < 1) {
+        std::cerr << "Error: Usage - export <image_file> [colour_type] [preview [size]]\n";
         return;
     }
 
+    // Colour may be left out before preview
+    bool preview = false;
+    if (strcmp(colourType, "preview") == 0) {
+        preview = true;
+        previewSize = atoi(option);
+        colourType[0] = '\0';
+    }
+    else if (strcmp(option, "preview") == 0) {
+        preview = true;
+    }
+    else if (strlen(option) > 0) {
+        std::cerr << "Error: Usage - export <image_file> [colour_type] [preview [size]]\n";
+        return;
+    }
+    if (preview && previewSize <= 0) {
+        previewSize = DEFAULT_PREVIEW_SIZE;
+    }
+
     std::string imageFileType = getFileExtension(imageFile);
-    if (imageFileType.empty() || imageFileType != "bmp") {
-        std::cerr << "Error: The image file does not have a .bmp extension.\n";
+    if (imageFileType != "bmp" && imageFileType != "png") {
+        std::cerr << "Error: The image file does not have a .bmp or .png extension.\n";
         return;
     }
     
@@ -260,10 +469,32 @@ void exportData(Map<double>* flowMap, Map<int>* D8Map, Map<double>* aspectMap, M
         std::cout << "No colour specified. Using 'g1' (greyscale) as default." << std::endl;
     }
     
+    // Previews render a cached overview level, maps are not changed
+    if (preview) {
+        if (flowMap) {
+            exportPreview(*flowMap, previewPyramid, "max", previewSize, true, imageFile, colourType);
+        }
+        else if (D8Map) {
+            exportPreview(*D8Map, previewD8Pyramid, "mode", previewSize, false, imageFile, colourType);
+        }
+        else if (aspectMap) {
+            exportPreview(*aspectMap, previewPyramid, "mean", previewSize, false, imageFile, colourType);
+        }
+        else if (gradientMap) {
+            exportPreview(*gradientMap, previewPyramid, "mean", previewSize, true, imageFile, colourType);
+        }
+        else {
+            std::cerr << "Error: No processed data to export.\n";
+        }
+        return;
+    }
+
+    // Full exports of flow and gradient are log scaled while rendering, so the maps and their
+    // previews stay valid
     // If else for processes to save as image
     if (flowMap) {
-        flowMap->applyScaling("log");
-        ImageExport<double>::exportMapToImage(*flowMap, imageFile, colourType, true);
+        MapScaler<double> scaler(*flowMap, "log");
+        ImageExport<double>::exportMapToImage(*flowMap, imageFile, colourType, true, &scaler);
         std::cout << "Flow map exported to " << imageFile << "\n";
     }
     else if (D8Map) {
@@ -275,8 +506,8 @@ void exportData(Map<double>* flowMap, Map<int>* D8Map, Map<double>* aspectMap, M
         std::cout << "Aspect map exported to " << imageFile << "\n";
     }
     else if (gradientMap) {
-        gradientMap->applyScaling("log");
-        ImageExport<double>::exportMapToImage(*gradientMap, imageFile, colourType, true);
+        MapScaler<double> scaler(*gradientMap, "log");
+        ImageExport<double>::exportMapToImage(*gradientMap, imageFile, colourType, true, &scaler);
         std::cout << "Gradient map exported to " << imageFile << "\n";
     }
     else {
@@ -285,15 +516,65 @@ void exportData(Map<double>* flowMap, Map<int>* D8Map, Map<double>* aspectMap, M
     }
 }
 
+ /**
+  * @brief Open or close the product cache
+  */
+void setCache(const char* command) {
+    char directory[128];
+    unsigned long long sizeMB = DEFAULT_CACHE_MB;
+    int nArgs = sscanf(command, "%*s %127s %llu", directory, &sizeMB);
+    if (nArgs < 1 || sizeMB == 0) {
+        std::cerr << "Error: Usage - cache <directory> [sizeMB] | cache off\n";
+        return;
+    }
+
+    delete productCache;
+    productCache = nullptr;
+    if (strcmp(directory, "off") == 0) {
+        std::cout << "Product cache off.\n";
+        return;
+    }
+
+    productCache = new ProductCache(directory, sizeMB);
+    if (!productCache->isValid()) {
+        delete productCache;
+        productCache = nullptr;
+        return;
+    }
+    std::cout << "Caching processed maps in " << directory << " (" << sizeMB << " MB).\n";
+}
+
+ /**
+  * @brief Set or show the thread pool size
+  */
+void setThreads(const char* command) {
+    int nThreads = -1;
+    int nArgs = sscanf(command, "%*s %d", &nThreads);
+    if (nArgs < 1) {
+        std::cout << "Using " << getThreadCount() << " threads.\n";
+        return;
+    }
+    if (nThreads < 0) {
+        std::cerr << "Error: Usage - threads [n] (0 for all cores)\n";
+        return;
+    }
+    ThreadPool::setThreadCount(nThreads);
+    std::cout << "Using " << getThreadCount() << " threads.\n";
+}
+
  /**
   * @brief Print help
   */
 void displayHelp() {
     std::cout << "Commands:\n"
               << "  load <input_file> - Load a DEM file.\n"
-              << "  process <process_type> - Run a process (e.g., d8, slope, aspect).\n"
+              << "  process <process_type> - Run a process (e.g., d8, slope, aspect, watershed, streams).\n"
+              << "  edit <x0> <y0> <x1> <y1> <value> - Set DEM cells in region to value and update processed maps.\n"
               << "  save <output_file>  - Save processed data to a file.\n"
-              << "  export <image_file> [colour_type] - Export processed data to an image.\n"
+              << "  cache <directory> [sizeMB] | off - Reuse processed maps from earlier sessions (default 1024 MB).\n"
+              << "  threads [n] - Show or set the threads shared by all processes (0 for all cores).\n"
+              << "  export <image_file> [colour_type] [preview [size]] - Export processed data to an image.\n"
+              << "      preview renders a cached overview of at most size pixels (default 1024).\n"
               << "  quit - Exit the program.\n";
 }
 
@@ -302,6 +583,10 @@ void displayHelp() {
   */
 void quitProgram(Map<double>*& elevationMap, Map<int>*& D8Map, Map<double>*& flowMap, Map<double>*& gradientMap, Map<double>*& aspectMap) {
     std::cout << "Exiting..." << std::endl;
+    clearPreviewCache();
+    delete productCache;
+    productCache = nullptr;
+    clearBasinTree();
     delete elevationMap;
     delete D8Map;
     delete flowMap;
@@ -353,6 +638,10 @@ void handleWatershedAnalysis(Map<double>* elevationMap, Map<int>*& D8Map, Map<do
 
     std::cout << "Using colourmap: " << colourmap << std::endl;
 
+    // Watershed maps held at once, each chunk of pour points delineates one at a time
+    int wave = watershedAnalysis<double, int>::getWaveSize(
+        static_cast<uint64_t>(elevationMap->getWidth()) * elevationMap->getHeight());
+
     // if else for watershed types
     if (strcmp(type, "d8") == 0) {
         //Create D8 direction map
@@ -365,28 +654,35 @@ void handleWatershedAnalysis(Map<double>* elevationMap, Map<int>*& D8Map, Map<do
         FlowAccumulator<double, int, double> flowAccumulator(*elevationMap, nullptr, nullptr, D8Map);
         if (flowMap) delete flowMap;
         flowMap = new Map<double>(flowAccumulator.accumulateFlow("d8"));
+        flowIsD8 = true;
+
+        // Basin tree answers watersheds of channel outlets, and edits keep it up to date
+        StreamNetwork<double> network(*flowMap, *D8Map);
+        network.extractStreams(REPL_BASIN_THRESHOLD);
+        buildBasinTree(*D8Map, network, REPL_BASIN_THRESHOLD);
 
         // Find pour points
         std::vector<std::pair<int, int>> pourPoints;
         watershedAnalysis<double, int> watershedAnalyser(*elevationMap, D8Map, flowMap, nullptr, nullptr);
+        watershedAnalyser.setBasinTree(basinTree);
         pourPoints = watershedAnalyser.getPourPoints(nPourPoints, "d8");
 
-        // Iterate over pour points
-        int i = 0;
-        for (const auto& p : pourPoints) {
-            // Run watershed
-            Map<double> outputWatershed = watershedAnalyser.calculateWatershed(p, "d8");
-            outputWatershed.applyScaling("log");
-
-            // Create full file pathway
-            std::ostringstream oss;
-            oss << outputDir << "/watershed_" << i << ".bmp";
-            std::string filename = oss.str();
-
-            // Export as image
-            ImageExport<double>::exportMapToImage(outputWatershed, filename, colourmap, true);
-            i++;
-        }
+        // Iterate over pour points, a share per map of the wave
+        parallelFor(0, static_cast<int>(pourPoints.size()), wave, [&](int, int i0, int i1) {
+            for (int i = i0; i < i1; i++) {
+                // Run watershed
+                Map<double> outputWatershed = watershedAnalyser.calculateWatershed(pourPoints[i], "d8");
+                outputWatershed.applyScaling("log");
+
+                // Create full file pathway
+                std::ostringstream oss;
+                oss << outputDir << "/watershed_" << i << ".bmp";
+                std::string filename = oss.str();
+
+                // Export as image
+                ImageExport<double>::exportMapToImage(outputWatershed, filename, colourmap, true);
+            }
+        });
         std::cout << "Exported watershed images to: " << outputDir << std::endl;
     }
     else if (strcmp(type, "dinf") == 0) {
@@ -402,28 +698,29 @@ void handleWatershedAnalysis(Map<double>* elevationMap, Map<int>*& D8Map, Map<do
         FlowAccumulator<double, int, double> flowAccumulator(*elevationMap, aspectMap, gradientMap, nullptr);
         if (flowMap) delete flowMap;
         flowMap = new Map<double>(flowAccumulator.accumulateFlow("dinf"));
+        flowIsD8 = false;
 
         // Find pour points
         std::vector<std::pair<int, int>> pourPoints;
         watershedAnalysis<double, int> watershedAnalyser(*elevationMap, nullptr, flowMap, gradientMap, aspectMap);
         pourPoints = watershedAnalyser.getPourPoints(nPourPoints, "dinf");
         
-        // Iterate over pour points
-        int i = 0;
-        for (const auto& p : pourPoints) {
-            // Run watershed
-            Map<double> outputWatershed = watershedAnalyser.calculateWatershed(p, "dinf");
-            outputWatershed.applyScaling("log");
-
-            // Create full file pathway
-            std::ostringstream oss;
-            oss << outputDir << "/watershed_" << i << ".bmp";
-            std::string filename = oss.str();
-
-            // Export as image
-            ImageExport<double>::exportMapToImage(outputWatershed, filename, colourmap, true);
-            i++;
-        }
+        // Iterate over pour points, a share per map of the wave
+        parallelFor(0, static_cast<int>(pourPoints.size()), wave, [&](int, int i0, int i1) {
+            for (int i = i0; i < i1; i++) {
+                // Run watershed
+                Map<double> outputWatershed = watershedAnalyser.calculateWatershed(pourPoints[i], "dinf");
+                outputWatershed.applyScaling("log");
+
+                // Create full file pathway
+                std::ostringstream oss;
+                oss << outputDir << "/watershed_" << i << ".bmp";
+                std::string filename = oss.str();
+
+                // Export as image
+                ImageExport<double>::exportMapToImage(outputWatershed, filename, colourmap, true);
+            }
+        });
         std::cout << "Exported watershed images to: " << outputDir << std::endl;
     }
     else if (strcmp(type, "mdf") == 0) {
@@ -436,32 +733,79 @@ void handleWatershedAnalysis(Map<double>* elevationMap, Map<int>*& D8Map, Map<do
         FlowAccumulator<double, int, double> flowAccumulator(*elevationMap, nullptr, gradientMap, nullptr);
         if (flowMap) delete flowMap;
         flowMap = new Map<double>(flowAccumulator.accumulateFlow("mdf"));
+        flowIsD8 = false;
 
         // Find pour points
         std::vector<std::pair<int, int>> pourPoints;
         watershedAnalysis<double, int> watershedAnalyser(*elevationMap, nullptr, flowMap, nullptr, nullptr);
         pourPoints = watershedAnalyser.getPourPoints(nPourPoints, "mdf");
 
-        // Iterate over pour points
-        int i = 0;
-        for (const auto& p : pourPoints) {
-            // Run watershed
-            Map<double> outputWatershed = watershedAnalyser.calculateWatershed(p, "mdf");
-            outputWatershed.applyScaling("log");
-            
-            // Create full file pathway
-            std::ostringstream oss;
-            oss << outputDir << "/watershed_" << i << ".bmp";
-            std::string filename = oss.str();
-
-            // Export as image
-            ImageExport<double>::exportMapToImage(outputWatershed, filename, colourmap, true);
-            i++;
-        }
+        // Iterate over pour points, a share per map of the wave
+        parallelFor(0, static_cast<int>(pourPoints.size()), wave, [&](int, int i0, int i1) {
+            for (int i = i0; i < i1; i++) {
+                // Run watershed
+                Map<double> outputWatershed = watershedAnalyser.calculateWatershed(pourPoints[i], "mdf");
+                outputWatershed.applyScaling("log");
+
+                // Create full file pathway
+                std::ostringstream oss;
+                oss << outputDir << "/watershed_" << i << ".bmp";
+                std::string filename = oss.str();
+
+                // Export as image
+                ImageExport<double>::exportMapToImage(outputWatershed, filename, colourmap, true);
+            }
+        });
         std::cout << "Exported watershed images to: " << outputDir << std::endl;
     }
     else {
         // Failure
         std::cerr << "Invalid flow type specified for watershed analysis. Exiting watershed mode.\n";
     }
+}
+
+ /**
+  * @brief Run stream network extraction
+  */
+void handleStreamAnalysis(Map<double>* elevationMap, Map<int>*& D8Map, Map<double>*& flowMap) {
+    std::cout << "Entering stream network mode" << std::endl;
+
+    // Get channel threshold
+    double threshold;
+    std::cout << "Enter flow accumulation threshold: ";
+    std::cin >> threshold;
+    if (!std::cin || threshold <= 0) {
+        std::cin.clear();
+        std::cin.ignore(256, '\n');
+        std::cerr << "Invalid threshold. Exiting stream network mode.\n";
+        return;
+    }
+
+    // Get output directory
+    std::string outputDir;
+    std::cout << "Enter directory to store stream network: ";
+    std::cin >> outputDir;
+    std::cin.ignore(256, '\n');
+
+    // Create D8 direction map
+    D8FlowAnalyser analyser(*elevationMap);
+    analyser.analyseFlow();
+    if (D8Map) delete D8Map;
+    D8Map = new Map<int>(analyser.getMap());
+
+    // Create flow accumulation map
+    FlowAccumulator<double, int, double> flowAccumulator(*elevationMap, nullptr, nullptr, D8Map);
+    if (flowMap) delete flowMap;
+    flowMap = new Map<double>(flowAccumulator.accumulateFlow("d8"));
+    flowIsD8 = true;
+
+    // Extract and save network
+    StreamNetwork<double> network(*flowMap, *D8Map);
+    network.extractStreams(threshold);
+    buildBasinTree(*D8Map, network, threshold);
+    network.getStrahlerMap().saveToFile(outputDir + "/streams_strahler.txt", "txt");
+    network.getShreveMap().saveToFile(outputDir + "/streams_shreve.txt", "txt");
+    network.saveLinksToCSV(outputDir + "/streams_links.csv");
+
+    std::cout << "Extracted " << network.getLinks().size() << " stream links to: " << outputDir << std::endl;
 }
\ No newline at end of file
@@ -16,13 +16,19 @@
 #include <sstream>
 #include <cstring>
 #include <cstdlib>
+#include <functional>
 #include "../map_core/Map.h"
 #include "../image_handling/BMP.h"
 #include "../DEM_analysis/SobelAnalysis.h"
 #include "../DEM_analysis/D8FlowAnalyser.h"
 #include "../DEM_analysis/FlowAccumulation.h" 
 #include "../DEM_analysis/watershedAnalysis.h"
+#include "../DEM_analysis/StreamNetwork.h"
+#include "../DEM_analysis/IncrementalAnalyser.h"
 #include "../image_handling/ImageExport.h"
+#include "../map_core/MapPyramid.h"
+#include "../parallel/parallelFor.h"
+#include "../pipeline/ProductCache.h"
 #include "../CLI/CLIhelperFunctions.h"
 
 // Function declarations
@@ -43,6 +49,22 @@ void runREPL(void);
  */
 bool loadFile(Map<double>*& elevationMap, const char* command);
 
+/**
+ * @brief Open the product cache in the directory given after "cache", or close it with "cache off".
+ * Processes then load maps cached for the same DEM cells instead of recomputing them.
+ *
+ * @param command Cache directory and optional size limit in megabytes
+ */
+void setCache(const char* command);
+
+/**
+ * @brief Set the number of threads shared by all processes to the count given after "threads",
+ * 0 for all cores, or print the current count if none is given
+ *
+ * @param command Optional thread count
+ */
+void setThreads(const char* command);
+
 /**
  * @brief Process DEM with type specified after "process" command
  * 
@@ -55,6 +77,21 @@ bool loadFile(Map<double>*& elevationMap, const char* command);
  */
 void processData(Map<double>* elevationMap, Map<int>*& D8Map, Map<double>*& flowMap, Map<double>*& gradientMap, Map<double>*& aspectMap, const char* command);
 
+/**
+ * @brief Set DEM cells in a region to a value after "edit" command.
+ * Slope, aspect, D8 directions, and D8 flow accumulation are updated about the region only.
+ * Flow maps from other methods are cleared as they cannot be updated incrementally.
+ * 
+ * @param elevationMap Pointer to elevation map
+ * @param D8Map Pointer to D8 directions map
+ * @param flowMap Pointer to flow accumulation map
+ * @param gradientMap Pointer to gradient map
+ * @param aspectMap Pointer to aspect map
+ * @param command Region and value, space separated as:
+ *  > edit x0 y0 x1 y1 value
+ */
+void editData(Map<double>* elevationMap, Map<int>* D8Map, Map<double>*& flowMap, Map<double>* gradientMap, Map<double>* aspectMap, const char* command);
+
 /**
  * @brief Save processed DEM as a file (e.g. txt, csv)
  * 
@@ -110,4 +147,18 @@ void quitProgram(Map<double>*& elevationMap, Map<int>*& D8Map, Map<double>*& flo
  * @param aspectMap Pointer to aspect map
  */
 void handleWatershedAnalysis(Map<double>* elevationMap, Map<int>*& D8Map, Map<double>*& flowMap, Map<double>*& gradientMap, Map<double>*& aspectMap);
+
+/**
+ * @brief Enter stream network mode.
+ * User will be asked for:
+ * Flow accumulation threshold for channel cells
+ * Output directory for order maps and stream links
+ * 
+ * D8 directions and D8 flow accumulation are recalculated for the loaded DEM.
+ * 
+ * @param elevationMap Pointer to elevation map
+ * @param D8Map Pointer to D8 direction map
+ * @param flowMap Pointer to flow accumulation map
+ */
+void handleStreamAnalysis(Map<double>* elevationMap, Map<int>*& D8Map, Map<double>*& flowMap);
 #endif 
\ No newline at end of file
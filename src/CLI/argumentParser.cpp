@@ -12,6 +12,8 @@
 #include "CLIhelperFunctions.h"
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <vector>
 
 /**
  * @brief Function to print help for user
@@ -23,10 +25,25 @@ void printHelp() {
     std::cout << "-fa <flow_accumulation> : If selected will run flow accumulation analysis" << std::endl;
     std::cout << "-w <watershed> : If selected will run watershed analysis" << std::endl;
     std::cout << "Requires: number of points, out directory, colourmap" << std::endl;
+    std::cout << "-s <streams> : If selected will extract the stream network (d8 only)" << std::endl;
+    std::cout << "Requires: flow accumulation threshold, out directory" << std::endl;
     std::cout << "-o <output_file> : Specify output file (.txt, .csv, .bin)" << std::endl;
-    std::cout << "-img <image_file> : Specify output image (.bmp)" << std::endl;
+    std::cout << "-img <image_file> : Specify output image (.bmp or .png)" << std::endl;
+    std::cout << "-tiles <tiles_directory> : Export image as z/x/y PNG tiles for web viewers" << std::endl;
+    std::cout << "--preview [size] : Render -img from an overview level of at most size pixels (default 1024)" << std::endl;
+    std::cout << "-hs [azimuth altitude [zfactor]] | [multi [zfactor]] : Blend -img over a hillshade of the DEM" << std::endl;
+    std::cout << "--cache <directory> [sizeMB] : Reuse slope, aspect, D8, and flow maps from earlier runs (default 1024 MB)" << std::endl;
     std::cout << "-c <colour> : Specify colour palette for image output" << std::endl;
     std::cout << "-v, --verbose : Enable verbose output" << std::endl;
+    std::cout << "--batch <manifest> [memoryMB] : Run one job per manifest line (flags as above)" << std::endl;
+    std::cout << "-gen <output_file> <width> <height> [seed [pits [flats]]] : Write a synthetic fractal DEM" << std::endl;
+    std::cout << "--shard <input.bin> <output_prefix> <shards> [address] : Fill, D8 and flow accumulation split across worker processes" << std::endl;
+    std::cout << "    Writes <output_prefix>_filled.bin, _d8.bin and _flow.bin. Without an address, starts local workers;" << std::endl;
+    std::cout << "    with unix:<path> or tcp:<host>:<port>, waits there for workers started on any machine with:" << std::endl;
+    std::cout << "--shard-worker <address> : Work on one strip for the --shard coordinator at address" << std::endl;
+    std::cout << "--trace <trace.json> : Save begin/end events of stages, kernels, tiles, and threads for chrome://tracing or Perfetto" << std::endl;
+    std::cout << "--threads <n> : Threads shared by all analysis steps (default: all cores)" << std::endl;
+    std::cout << "--profile [report.json] : Print time, throughput, and peak memory per stage, and save a JSON report (default profile.json)" << std::endl;
 }
 
 /**
@@ -37,6 +54,10 @@ bool parseArguments(int argc, char* argv[],
                      char*& input_file_type,
                      char*& output_file, 
                      char*& image_file,
+                     char*& tiles_directory,
+                     int& previewSize,
+                     bool& hillshade,
+                     HillshadeOptions& hillshadeOptions,
                      bool& colour,
                      char*& colour_type, 
                      bool& totalFlow,
@@ -44,6 +65,11 @@ bool parseArguments(int argc, char* argv[],
                      int& nPourPoints,
                      char*& watershed_directory,
                      char*& watershed_colour,
+                     bool& streams,
+                     double& streamThreshold,
+                     char*& streams_directory,
+                     char*& cache_directory,
+                     int& cacheSizeMB,
                      bool& verbose, 
                      char*& process) {
     // Check minimum number of arguments
@@ -172,6 +198,29 @@ bool parseArguments(int argc, char* argv[],
                 return false;
             }
         }
+        // Check if stream network was selected
+        else if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--streams") == 0) {
+            streams = true;
+
+            // Threshold and directory must follow -s
+            if (i + 2 < argc) {
+                char* end = nullptr;
+                streamThreshold = std::strtod(argv[i + 1], &end);
+                if (end == argv[i + 1] || *end != '\0' || streamThreshold <= 0) {
+                    std::cerr << "Error: -s flag requires a positive flow accumulation threshold." << std::endl;
+                    return false;
+                }
+                i++; // Skip to next argument
+
+                streams_directory = new char[strlen(argv[i + 1]) + 1];
+                strcpy(streams_directory, argv[i + 1]);
+                i++; // Skip to next argument
+            }
+            else {
+                std::cerr << "Error: -s flag requires 2 arguments: <Threshold> <Directory>" << std::endl;
+                return false;
+            }
+        }
         
         // Check output
         else if (strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) {
@@ -181,7 +230,8 @@ bool parseArguments(int argc, char* argv[],
                 if (!(has_extension(output_file, "txt") || has_extension(output_file, "csv") || has_extension(output_file, "bin"))) {
                     std::cerr << "Error: Invalid output file extension. Supported extensions are .txt, .csv, .bin." << std::endl;
                     delete[] output_file;
-                    return 1;
+                    output_file = nullptr; // Prevent open pointer
+                    return false;
                 }
                 i++;  // Skip the next argument (output filename)
             } else {
@@ -194,8 +244,8 @@ bool parseArguments(int argc, char* argv[],
             if (i + 1 < argc) {
                 image_file = new char[strlen(argv[i + 1]) + 1];
                 strcpy(image_file, argv[i + 1]);
-                if (!has_extension(image_file, "bmp")) {
-                    std::cerr << "Error: Image file must have a .bmp extension." << std::endl;
+                if (!has_extension(image_file, "bmp") && !has_extension(image_file, "png")) {
+                    std::cerr << "Error: Image file must have a .bmp or .png extension." << std::endl;
                     return false;
                 }
                 i++;  // Skip the next argument (image filename)
@@ -205,6 +255,94 @@ bool parseArguments(int argc, char* argv[],
                 return false;
             }
         }
+        // Check if tile pyramid out was selected
+        else if (strcmp(argv[i], "-tiles") == 0 || strcmp(argv[i], "--tiles") == 0) {
+            if (i + 1 < argc) {
+                tiles_directory = new char[strlen(argv[i + 1]) + 1];
+                strcpy(tiles_directory, argv[i + 1]);
+                i++;  // Skip the next argument (tiles directory)
+            }
+            else {
+                std::cerr << "Error: -tiles flag requires an output directory." << std::endl;
+                return false;
+            }
+        }
+        // Check if a quick preview image was selected
+        else if (strcmp(argv[i], "-pv") == 0 || strcmp(argv[i], "--preview") == 0) {
+            previewSize = DEFAULT_PREVIEW_SIZE;
+            // Size is optional
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                previewSize = std::atoi(argv[i + 1]);
+                if (previewSize <= 0) {
+                    std::cerr << "Error: --preview size must be a positive number of pixels." << std::endl;
+                    return false;
+                }
+                i++;  // Skip the next argument (size)
+            }
+        }
+        // Check if hillshade blending was selected
+        else if (strcmp(argv[i], "-hs") == 0 || strcmp(argv[i], "--hillshade") == 0) {
+            hillshade = true;
+
+            // Sun is optional: "multi" or azimuth and altitude, then an optional z factor
+            std::vector<double> values;
+            if (i + 1 < argc && strcmp(argv[i + 1], "multi") == 0) {
+                hillshadeOptions.multidirectional = true;
+                i++;  // Skip "multi"
+            }
+            while (i + 1 < argc && values.size() < 3 && argv[i + 1][0] != '-') {
+                char* end = nullptr;
+                double value = std::strtod(argv[i + 1], &end);
+                if (end == argv[i + 1] || *end != '\0') {
+                    std::cerr << "Error: -hs flag requires numeric azimuth, altitude, and z factor." << std::endl;
+                    return false;
+                }
+                values.push_back(value);
+                i++;  // Skip the value
+            }
+
+            if (hillshadeOptions.multidirectional) {
+                if (values.size() > 1) {
+                    std::cerr << "Error: -hs multi only takes a z factor." << std::endl;
+                    return false;
+                }
+                if (values.size() == 1) hillshadeOptions.zFactor = values[0];
+            }
+            else if (values.size() == 1) {
+                std::cerr << "Error: -hs flag requires both azimuth and altitude." << std::endl;
+                return false;
+            }
+            else if (values.size() >= 2) {
+                hillshadeOptions.azimuth = values[0];
+                hillshadeOptions.altitude = values[1];
+                if (values.size() == 3) hillshadeOptions.zFactor = values[2];
+            }
+            if (hillshadeOptions.zFactor <= 0) {
+                std::cerr << "Error: -hs z factor must be positive." << std::endl;
+                return false;
+            }
+        }
+        // Check if a product cache was selected
+        else if (strcmp(argv[i], "--cache") == 0) {
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                cache_directory = new char[strlen(argv[i + 1]) + 1];
+                strcpy(cache_directory, argv[i + 1]);
+                i++;  // Skip the next argument (cache directory)
+            }
+            else {
+                std::cerr << "Error: --cache flag requires a cache directory." << std::endl;
+                return false;
+            }
+            // Size limit is optional
+            if (i + 1 < argc && isValidInteger(argv[i + 1])) {
+                cacheSizeMB = std::atoi(argv[i + 1]);
+                if (cacheSizeMB <= 0) {
+                    std::cerr << "Error: --cache size must be a positive number of megabytes." << std::endl;
+                    return false;
+                }
+                i++;  // Skip the next argument (size)
+            }
+        }
         else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--colour") == 0) {
             if (i + 1 < argc && argv[i + 1][0] != '-') {  // Check if the next argument is not another flag
                 colour_type = new char[strlen(argv[i + 1]) + 1];
@@ -226,3 +364,100 @@ bool parseArguments(int argc, char* argv[],
 
     return true;
 }
+
+/**
+ * @brief Remove --profile [report.json] from the arguments
+ */
+void extractProfileFlag(int& argc, char* argv[], bool& profile, std::string& report_file) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--profile") != 0) continue;
+        profile = true;
+        int consumed = 1;
+        if (i + 1 < argc && has_extension(argv[i + 1], "json")) {
+            report_file = argv[i + 1];
+            consumed = 2;
+        }
+        // Shift the rest down so other parsers never see the flag
+        for (int j = i; j + consumed < argc; j++) {
+            argv[j] = argv[j + consumed];
+        }
+        argc -= consumed;
+        argv[argc] = nullptr;
+        i--;
+    }
+}
+
+/**
+ * @brief Remove --trace <trace.json> from the arguments
+ */
+bool extractTraceFlag(int& argc, char* argv[], std::string& trace_file) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") != 0) continue;
+        if (i + 1 >= argc || !has_extension(argv[i + 1], "json")) {
+            std::cerr << "Error: --trace flag requires a .json output file." << std::endl;
+            return false;
+        }
+        trace_file = argv[i + 1];
+        for (int j = i; j + 2 < argc; j++) {
+            argv[j] = argv[j + 2];
+        }
+        argc -= 2;
+        argv[argc] = nullptr;
+        i--;
+    }
+    return true;
+}
+
+/**
+ * @brief Remove --threads <n> from the arguments
+ */
+bool extractThreadsFlag(int& argc, char* argv[], int& threads) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") != 0) continue;
+        if (i + 1 >= argc || !isValidInteger(argv[i + 1]) || std::atoi(argv[i + 1]) < 1) {
+            std::cerr << "Error: --threads flag requires a positive number of threads." << std::endl;
+            return false;
+        }
+        threads = std::atoi(argv[i + 1]);
+        for (int j = i; j + 2 < argc; j++) {
+            argv[j] = argv[j + 2];
+        }
+        argc -= 2;
+        argv[argc] = nullptr;
+        i--;
+    }
+    return true;
+}
+
+/**
+ * @brief Terrain generation arguments
+ */
+bool parseGenerateArguments(int argc, char* argv[], std::string& output_file, int& width, int& height,
+    TerrainOptions& options) {
+    if (argc < 5 || argc > 8) {
+        std::cerr << "Error: -gen flag requires <output_file> <width> <height> [seed [pits [flats]]]" << std::endl;
+        return false;
+    }
+    for (int i = 3; i < argc; i++) {
+        if (!isValidInteger(argv[i])) {
+            std::cerr << "Error: -gen sizes, seed, pits, and flats must be non-negative integers." << std::endl;
+            return false;
+        }
+    }
+
+    output_file = argv[2];
+    if (!has_extension(argv[2], "bin") && !has_extension(argv[2], "txt") && !has_extension(argv[2], "csv")) {
+        std::cerr << "Error: Invalid output file extension. Supported extensions are .txt, .csv, .bin." << std::endl;
+        return false;
+    }
+    width = std::atoi(argv[3]);
+    height = std::atoi(argv[4]);
+    if (width <= 0 || height <= 0) {
+        std::cerr << "Error: -gen width and height must be positive." << std::endl;
+        return false;
+    }
+    if (argc > 5) options.seed = std::strtoull(argv[5], nullptr, 10);
+    if (argc > 6) options.nPits = std::atoi(argv[6]);
+    if (argc > 7) options.nFlats = std::atoi(argv[7]);
+    return true;
+}
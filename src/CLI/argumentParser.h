@@ -12,6 +12,8 @@
 #define ARGUMENTPARSER_H
 
 #include <string>
+#include "../DEM_analysis/SobelAnalysis.h"
+#include "../map_core/TerrainGenerator.h"
 
 /**
  * @brief Method that checks user inputs for CLI
@@ -22,11 +24,22 @@
  * @param input_file_type File extension of input file
  * @param output_file Output file argument
  * @param image_file File extension of output file
+ * @param tiles_directory Directory for tile pyramid output
+ * @param previewSize Preview image size in pixels, 0 for full resolution
+ * @param hillshade Bool for blending -img over a hillshade of the DEM
+ * @param hillshadeOptions Sun position and z factor for hillshade
  * @param colour Bool for if colour was chosen
  * @param colour_type User colour choice 
  * @param totalFlow Bool for flow accumulation algorithms
  * @param watershed Bool for watershed delineation algorithms
  * @param nPourPoints Number of pour points specified by user
+ * @param watershed_directory Directory for watershed images
+ * @param watershed_colour Colourmap for watershed images
+ * @param streams Bool for stream network extraction
+ * @param streamThreshold Flow accumulation threshold for channel cells
+ * @param streams_directory Directory for stream network outputs
+ * @param cache_directory Directory for the derived product cache
+ * @param cacheSizeMB Product cache size limit in megabytes
  * @param verbose Verbose mode for CLI
  * @param process Process specified by user
  * @return true If arguments given by user were valid
@@ -37,6 +50,10 @@ bool parseArguments(int argc, char* argv[],
                      char*& input_file_type,
                      char*& output_file, 
                      char*& image_file,
+                     char*& tiles_directory,
+                     int& previewSize,
+                     bool& hillshade,
+                     HillshadeOptions& hillshadeOptions,
                      bool& colour,
                      char*& colour_type, 
                      bool& totalFlow,
@@ -44,9 +61,59 @@ bool parseArguments(int argc, char* argv[],
                      int& nPourPoints,
                      char*& watershed_directory,
                      char*& watershed_colour,
+                     bool& streams,
+                     double& streamThreshold,
+                     char*& streams_directory,
+                     char*& cache_directory,
+                     int& cacheSizeMB,
                      bool& verbose, 
                      char*& process);
 
+/**
+ * @brief Find and remove "--profile [report.json]" anywhere in the arguments, so it can be
+ * given with any mode
+ *
+ * @param argc Number of arguments, reduced by the arguments removed
+ * @param argv Array of arguments, later arguments shifted down over the flag
+ * @param profile Output: true if the flag was given
+ * @param report_file Output: JSON report pathway, left as given if none follows the flag
+ */
+void extractProfileFlag(int& argc, char* argv[], bool& profile, std::string& report_file);
+
+/**
+ * @brief Find and remove "--trace <trace.json>" anywhere in the arguments
+ *
+ * @param argc Number of arguments, reduced by the arguments removed
+ * @param argv Array of arguments, later arguments shifted down over the flag
+ * @param trace_file Output: trace pathway, left empty if the flag was not given
+ * @return true If arguments given by user were valid
+ */
+bool extractTraceFlag(int& argc, char* argv[], std::string& trace_file);
+
+/**
+ * @brief Find and remove "--threads <n>" anywhere in the arguments
+ *
+ * @param argc Number of arguments, reduced by the arguments removed
+ * @param argv Array of arguments, later arguments shifted down over the flag
+ * @param threads Output: thread count, left as given if the flag was not given
+ * @return true If arguments given by user were valid
+ */
+bool extractThreadsFlag(int& argc, char* argv[], int& threads);
+
+/**
+ * @brief Parse "-gen <output_file> <width> <height> [seed [pits [flats]]]"
+ *
+ * @param argc Number of arguments given with ./drainage-analysis
+ * @param argv Array of arguments, argv[1] is -gen / --generate
+ * @param output_file Output: terrain pathway (.bin, .txt, or .csv)
+ * @param width Output: grid width
+ * @param height Output: grid height
+ * @param options Output: seed and number of pits and flats, other options left as given
+ * @return true If arguments given by user were valid
+ */
+bool parseGenerateArguments(int argc, char* argv[], std::string& output_file, int& width, int& height,
+    TerrainOptions& options);
+
 /**
  * @brief Quick print help function
  */
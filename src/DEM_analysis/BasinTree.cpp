@@ -0,0 +1,574 @@
+/**
+ * @file BasinTree.cpp
+ * @author Ollie
+ * @brief Nested basin hierarchy built from D8 receivers and stream links
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "BasinTree.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <climits>
+#include <unordered_set>
+#include <utility>
+
+/**
+ * @brief Construct empty BasinTree
+ */
+BasinTree::BasinTree() : _width(0), _height(0), _threshold(0.0), _cellArea(1.0) {
+}
+
+/**
+ * @brief Construct BasinTree from stream links
+ */
+BasinTree::BasinTree(const Map<int>& D8, const Map<int>& linkMap, const std::vector<StreamLink>& links,
+                     double threshold, double cellArea)
+    : _width(D8.getWidth()), _height(D8.getHeight()), _threshold(threshold), _cellArea(cellArea) {
+
+    // One node per link, parent is downstream link
+    _nodes.resize(links.size());
+    for (const auto& link : links) {
+        BasinNode& node = _nodes[link.id];
+        node.id = link.id;
+        node.parent = link.downstreamLink;
+        node.outletCell = link.outletCell;
+    }
+
+    labelCells(D8, linkMap);
+    finalise();
+}
+
+// Label markers used while following receivers
+static const int UNVISITED = -2;
+static const int ON_PATH = -3;
+
+/**
+ * @brief Label cells with the first link met travelling downstream
+ */
+void BasinTree::labelCells(const Map<int>& D8, const Map<int>& linkMap) {
+    const int n = _width * _height;
+
+    _labelMap = Map<int>(_width, _height);
+    for (int cell = 0; cell < n; cell++) {
+        int link = linkMap.getData(cell % _width, cell / _width);
+        _labelMap.setData(cell % _width, cell / _width, (link >= 0) ? link : UNVISITED);
+    }
+
+    std::vector<int> path;
+    for (int start = 0; start < n; start++) {
+        resolveLabel(D8, start, path);
+    }
+}
+
+/**
+ * @brief Follow receivers until a labelled cell, then label the whole path
+ */
+void BasinTree::resolveLabel(const Map<int>& D8, int start, std::vector<int>& path) {
+    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    if (_labelMap.getData(start % _width, start / _width) != UNVISITED) return;
+
+    int cell = start;
+    int result = -1;
+    while (true) {
+        int x = cell % _width;
+        int y = cell / _width;
+        int label = _labelMap.getData(x, y);
+        if (label == ON_PATH) {
+            result = -1; // D8 cycle on flats, drains nowhere
+            break;
+        }
+        if (label != UNVISITED) {
+            result = label;
+            break;
+        }
+        _labelMap.setData(x, y, ON_PATH);
+        path.push_back(cell);
+
+        int direction = D8.getData(x, y);
+        if (direction < 0 || direction > 7) {
+            break; // Pit, drains nowhere
+        }
+        int nx = x + dx[direction];
+        int ny = y + dy[direction];
+        if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) {
+            break; // Leaves map without meeting a channel
+        }
+        cell = ny * _width + nx;
+    }
+
+    for (int c : path) {
+        _labelMap.setData(c % _width, c / _width, result);
+    }
+    path.clear();
+}
+
+/**
+ * @brief Relabel cells upstream of changed receivers and patch node statistics
+ */
+int BasinTree::relabelUpstream(const Map<int>& D8, const std::vector<int>& cells) {
+    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    if (D8.getWidth() != _width || D8.getHeight() != _height) {
+        std::cerr << "Error: D8 map does not match basin tree size." << std::endl;
+        return 0;
+    }
+
+    // Gather changed cells and all of their donors, recursively
+    std::unordered_set<int> seen;
+    std::vector<std::pair<int, int>> upstream; // (cell, old label)
+    std::vector<int> stack;
+    for (int cell : cells) {
+        if (cell >= 0 && cell < _width * _height && seen.insert(cell).second) {
+            stack.push_back(cell);
+        }
+    }
+    while (!stack.empty()) {
+        int cell = stack.back();
+        stack.pop_back();
+        int x = cell % _width;
+        int y = cell / _width;
+        upstream.push_back({cell, _labelMap.getData(x, y)});
+
+        for (int direction = 0; direction < 8; direction++) {
+            int nx = x + dx[direction];
+            int ny = y + dy[direction];
+            if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) continue;
+            // Neighbour is a donor if it points back at (x, y)
+            int back = D8.getData(nx, ny);
+            if (back >= 0 && back <= 7 && nx + dx[back] == x && ny + dy[back] == y) {
+                int donor = ny * _width + nx;
+                if (seen.insert(donor).second) {
+                    stack.push_back(donor);
+                }
+            }
+        }
+    }
+
+    // Clear and re-resolve labels against the untouched cells downstream
+    for (const auto& [cell, label] : upstream) {
+        _labelMap.setData(cell % _width, cell / _width, UNVISITED);
+    }
+    std::vector<int> path;
+    for (const auto& [cell, label] : upstream) {
+        resolveLabel(D8, cell, path);
+    }
+
+    // Move cells between nodes
+    int relabelled = 0;
+    std::unordered_set<int> shrunk;
+    std::unordered_set<int> touched;
+    for (const auto& [cell, oldLabel] : upstream) {
+        int x = cell % _width;
+        int y = cell / _width;
+        int newLabel = _labelMap.getData(x, y);
+        if (newLabel == oldLabel) continue;
+        relabelled++;
+
+        if (oldLabel >= 0) {
+            _nodes[oldLabel].localCells--;
+            for (int id = oldLabel; id >= 0; id = _nodes[id].parent) {
+                _nodes[id].totalCells--;
+            }
+            shrunk.insert(oldLabel);
+            touched.insert(oldLabel);
+        }
+        if (newLabel >= 0) {
+            BasinNode& node = _nodes[newLabel];
+            node.localCells++;
+            node.localMinX = std::min(node.localMinX, x);
+            node.localMinY = std::min(node.localMinY, y);
+            node.localMaxX = std::max(node.localMaxX, x);
+            node.localMaxY = std::max(node.localMaxY, y);
+            for (int id = newLabel; id >= 0; id = _nodes[id].parent) {
+                _nodes[id].totalCells++;
+            }
+            touched.insert(newLabel);
+        }
+    }
+
+    // Local boxes that lost cells are rescanned within their old extent
+    for (int id : shrunk) {
+        BasinNode& node = _nodes[id];
+        int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+        for (int y = node.localMinY; y <= node.localMaxY; y++) {
+            for (int x = node.localMinX; x <= node.localMaxX; x++) {
+                if (_labelMap.getData(x, y) != id) continue;
+                minX = std::min(minX, x);
+                minY = std::min(minY, y);
+                maxX = std::max(maxX, x);
+                maxY = std::max(maxY, y);
+            }
+        }
+        node.localMinX = minX;
+        node.localMinY = minY;
+        node.localMaxX = maxX;
+        node.localMaxY = maxY;
+    }
+
+    // Nested boxes of touched nodes and their parents, children before parents
+    std::unordered_set<int> affected;
+    for (int start : touched) {
+        for (int id = start; id >= 0 && affected.insert(id).second; id = _nodes[id].parent) {}
+    }
+    std::vector<int> order(affected.begin(), affected.end());
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return _nodes[a].tin > _nodes[b].tin; });
+    for (int id : order) {
+        nestBoundingBox(_nodes[id]);
+    }
+    return relabelled;
+}
+
+/**
+ * @brief Label cells with the outlet met travelling downstream
+ */
+int BasinTree::labelOutletBasins(const RasterView<const int>& D8, const RasterView<int>& labels,
+                                 std::vector<int64_t>& path) {
+    if (!D8.isValid() || !labels.isValid() || labels.width != D8.width || labels.height != D8.height) {
+        std::cerr << "Error: D8 and label rasters must be valid and the same size." << std::endl;
+        return -1;
+    }
+    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+    const int width = D8.width;
+    const int height = D8.height;
+
+    for (int y = 0; y < height; y++) {
+        std::fill(labels.getRow(y), labels.getRow(y) + width, UNVISITED);
+    }
+
+    int nBasins = 0;
+    path.clear();
+    for (int startY = 0; startY < height; startY++) {
+        for (int startX = 0; startX < width; startX++) {
+            if (labels.getData(startX, startY) != UNVISITED) continue;
+
+            int x = startX;
+            int y = startY;
+            int result = -1;
+            while (true) {
+                int label = labels.getData(x, y);
+                if (label == ON_PATH) {
+                    result = nBasins++; // D8 cycle on flats, drains into itself
+                    break;
+                }
+                if (label != UNVISITED) {
+                    result = label;
+                    break;
+                }
+                labels.setData(x, y, ON_PATH);
+                path.push_back(static_cast<int64_t>(y) * width + x);
+
+                int direction = D8.getData(x, y);
+                if (direction < 0 || direction > 7) {
+                    result = nBasins++; // Pit
+                    break;
+                }
+                int nx = x + dx[direction];
+                int ny = y + dy[direction];
+                if (nx < 0 || ny < 0 || nx >= width || ny >= height) {
+                    result = nBasins++; // Leaves the grid
+                    break;
+                }
+                x = nx;
+                y = ny;
+            }
+
+            for (int64_t cell : path) {
+                labels.setData(static_cast<int>(cell % width), static_cast<int>(cell / width), result);
+            }
+            path.clear();
+        }
+    }
+    return nBasins;
+}
+
+/**
+ * @brief Derive tree structure and nested statistics
+ */
+void BasinTree::finalise(void) {
+    _roots.clear();
+    _outletToNode.clear();
+    for (auto& node : _nodes) {
+        node.children.clear();
+        node.localCells = 0;
+        node.localMinX = INT_MAX;
+        node.localMinY = INT_MAX;
+        node.localMaxX = INT_MIN;
+        node.localMaxY = INT_MIN;
+        node.tin = -1;
+        node.tout = -1;
+    }
+    for (auto& node : _nodes) {
+        if (node.parent >= 0) {
+            _nodes[node.parent].children.push_back(node.id);
+        }
+        else {
+            _roots.push_back(node.id);
+        }
+        _outletToNode[node.outletCell] = node.id;
+    }
+
+    // Local areas and bounding boxes from labels
+    for (int y = 0; y < _height; y++) {
+        for (int x = 0; x < _width; x++) {
+            int label = _labelMap.getData(x, y);
+            if (label < 0) continue;
+            BasinNode& node = _nodes[label];
+            node.localCells++;
+            node.localMinX = std::min(node.localMinX, x);
+            node.localMinY = std::min(node.localMinY, y);
+            node.localMaxX = std::max(node.localMaxX, x);
+            node.localMaxY = std::max(node.localMaxY, y);
+        }
+    }
+
+    // Iterative preorder walk from every root
+    std::vector<int> order;
+    order.reserve(_nodes.size());
+    std::vector<int> stack;
+    for (int root : _roots) {
+        stack.push_back(root);
+        while (!stack.empty()) {
+            int id = stack.back();
+            stack.pop_back();
+            _nodes[id].tin = order.size();
+            order.push_back(id);
+            for (int child : _nodes[id].children) {
+                stack.push_back(child);
+            }
+        }
+    }
+
+    // Reverse preorder visits children before parents
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        BasinNode& node = _nodes[*it];
+        node.totalCells = node.localCells;
+        node.tout = node.tin + 1;
+        for (int child : node.children) {
+            const BasinNode& c = _nodes[child];
+            node.totalCells += c.totalCells;
+            node.tout = std::max(node.tout, c.tout);
+        }
+        nestBoundingBox(node);
+    }
+}
+
+/**
+ * @brief Nested box from the local box and the children's nested boxes
+ */
+void BasinTree::nestBoundingBox(BasinNode& node) {
+    node.minX = node.localMinX;
+    node.minY = node.localMinY;
+    node.maxX = node.localMaxX;
+    node.maxY = node.localMaxY;
+    for (int child : node.children) {
+        const BasinNode& c = _nodes[child];
+        node.minX = std::min(node.minX, c.minX);
+        node.minY = std::min(node.minY, c.minY);
+        node.maxX = std::max(node.maxX, c.maxX);
+        node.maxY = std::max(node.maxY, c.maxY);
+    }
+}
+
+/**
+ * @brief Return label at (x, y)
+ */
+int BasinTree::getBasinAt(int x, int y) const {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) {
+        return -1;
+    }
+    return _labelMap.getData(x, y);
+}
+
+/**
+ * @brief Preorder range check for nested basin membership
+ */
+bool BasinTree::isInBasin(int x, int y, int node) const {
+    int label = getBasinAt(x, y);
+    if (label < 0 || node < 0 || node >= static_cast<int>(_nodes.size())) {
+        return false;
+    }
+    int tin = _nodes[label].tin;
+    return _nodes[node].tin <= tin && tin < _nodes[node].tout;
+}
+
+/**
+ * @brief Lookup of basin by outlet cell
+ */
+int BasinTree::getBasinWithOutlet(int x, int y) const {
+    auto it = _outletToNode.find(y * _width + x);
+    if (it == _outletToNode.end()) {
+        return -1;
+    }
+    return it->second;
+}
+
+/**
+ * @brief Sub-basins above an area threshold
+ */
+std::vector<int> BasinTree::getSubBasins(int node, double minArea) const {
+    std::vector<int> result;
+    if (node < 0 || node >= static_cast<int>(_nodes.size())) {
+        return result;
+    }
+
+    std::vector<int> stack(_nodes[node].children.rbegin(), _nodes[node].children.rend());
+    while (!stack.empty()) {
+        int id = stack.back();
+        stack.pop_back();
+        if (getArea(id) <= minArea) {
+            continue; // Every sub-basin of id is smaller still
+        }
+        result.push_back(id);
+        const auto& children = _nodes[id].children;
+        stack.insert(stack.end(), children.rbegin(), children.rend());
+    }
+    return result;
+}
+
+/**
+ * @brief Nested area of node
+ */
+double BasinTree::getArea(int node) const {
+    return _nodes[node].totalCells * _cellArea;
+}
+
+/**
+ * @brief Return node
+ */
+const BasinNode& BasinTree::getNode(int node) const {
+    return _nodes[node];
+}
+
+/**
+ * @brief Return number of nodes
+ */
+int BasinTree::getNodeCount(void) const {
+    return _nodes.size();
+}
+
+/**
+ * @brief Return root nodes
+ */
+const std::vector<int>& BasinTree::getRoots(void) const {
+    return _roots;
+}
+
+/**
+ * @brief Return label map
+ */
+const Map<int>& BasinTree::getLabelMap(void) const {
+    return _labelMap;
+}
+
+/**
+ * @brief Return channel threshold
+ */
+double BasinTree::getThreshold(void) const {
+    return _threshold;
+}
+
+/**
+ * @brief Return cell area
+ */
+double BasinTree::getCellArea(void) const {
+    return _cellArea;
+}
+
+/**
+ * @brief Source setter
+ */
+void BasinTree::setSource(const std::string& source) {
+    _source = source;
+}
+
+/**
+ * @brief Source getter
+ */
+const std::string& BasinTree::getSource(void) const {
+    return _source;
+}
+
+/**
+ * @brief Save nodes as text and labels as binary Map
+ */
+bool BasinTree::saveToFile(const std::string& filename) const {
+    std::ofstream file(filename.c_str());
+
+    // Check successful opening
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    // Header: width height threshold cellArea nodes [source]
+    file.precision(17);
+    file << _width << " " << _height << " " << _threshold << " " << _cellArea << " " << _nodes.size();
+    if (!_source.empty()) file << " " << _source;
+    file << std::endl;
+    for (const auto& node : _nodes) {
+        file << node.id << " " << node.parent << " " << node.outletCell << std::endl;
+    }
+    return _labelMap.saveToFile(filename + ".labels.bin", "bin");
+}
+
+/**
+ * @brief Load nodes and labels, then rebuild derived data
+ */
+bool BasinTree::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename.c_str());
+
+    // Check successful opening
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // Files written before the source tag have none
+    size_t nNodes = 0;
+    std::string header;
+    std::getline(file, header);
+    std::istringstream headerStream(header);
+    if (!(headerStream >> _width >> _height >> _threshold >> _cellArea >> nNodes)) {
+        std::cerr << "Invalid basin tree file: " << filename << std::endl;
+        return false;
+    }
+    if (!(headerStream >> _source)) _source.clear();
+
+    _nodes.assign(nNodes, BasinNode());
+    for (size_t i = 0; i < nNodes; i++) {
+        BasinNode node;
+        if (!(file >> node.id >> node.parent >> node.outletCell) ||
+            node.id < 0 || node.id >= static_cast<int>(nNodes) || node.parent >= static_cast<int>(nNodes)) {
+            std::cerr << "Invalid basin tree node in: " << filename << std::endl;
+            return false;
+        }
+        _nodes[node.id] = node;
+    }
+
+    Map<int> labels;
+    if (!labels.loadFromFile(filename + ".labels.bin", "bin") ||
+        labels.getWidth() != _width || labels.getHeight() != _height) {
+        std::cerr << "Invalid basin labels for: " << filename << std::endl;
+        return false;
+    }
+    for (int y = 0; y < _height; y++) {
+        for (int x = 0; x < _width; x++) {
+            if (labels.getData(x, y) >= static_cast<int>(nNodes)) {
+                std::cerr << "Invalid basin labels for: " << filename << std::endl;
+                return false;
+            }
+        }
+    }
+    _labelMap = labels;
+
+    finalise();
+    return true;
+}
@@ -0,0 +1,224 @@
+/**
+ * @file BasinTree.h
+ * @author Ollie
+ * @brief Nested basin hierarchy built from D8 receivers and stream links
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef BASINTREE_H
+#define BASINTREE_H
+
+#include "../map_core/Map.h"
+#include "StreamNetwork.h"
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Node of the basin hierarchy. One node per stream link.
+ * Cells are stored as linear indexes (y * width + x).
+ */
+struct BasinNode {
+    int id;              // Same as StreamLink::id
+    int parent;          // Downstream basin, -1 for network outlets
+    int outletCell;      // Outlet cell of the stream link
+    int localCells;      // Cells draining directly into the link
+    int totalCells;      // Cells in the nested basin (node and all sub-basins)
+    int minX, minY, maxX, maxY; // Bounding box of nested basin
+    int localMinX, localMinY, localMaxX, localMaxY; // Bounding box of local cells
+    int tin, tout;       // Preorder range of sub-tree
+    std::vector<int> children;
+};
+
+/**
+ * @brief Hierarchical basin tree.
+ * Every cell is labelled with the first stream link found on its D8 path downstream.
+ * Links form a tree through their downstream links, so the nested basin of a link is
+ * its sub-tree. Sub-trees are stored as preorder ranges which gives:
+ * - point-in-basin queries in O(1)
+ * - sub-basin enumeration in O(k) for k returned basins
+ * - outlet to basin lookup in O(1)
+ *
+ * @see StreamNetwork.h
+ */
+class BasinTree {
+public:
+    /**
+     * @brief Create empty BasinTree. Use loadFromFile() to fill.
+     */
+    BasinTree();
+
+    /**
+     * @brief Build a new BasinTree object
+     *
+     * @param D8 D8 directions map
+     * @param linkMap Link id per cell from StreamNetwork::getLinkMap()
+     * @param links Links from StreamNetwork::getLinks()
+     * @param threshold Channel threshold used for the stream network. Stored for reuse checks
+     * @param cellArea Area of a single cell in output units (e.g. km²)
+     */
+    BasinTree(const Map<int>& D8, const Map<int>& linkMap, const std::vector<StreamLink>& links,
+              double threshold, double cellArea = 1.0);
+
+    /**
+     * @brief Basin that cell (x, y) drains into first
+     *
+     * @param x Coord in row
+     * @param y Coord in column
+     * @return int Node id, -1 if cell does not drain into a channel
+     */
+    int getBasinAt(int x, int y) const;
+
+    /**
+     * @brief Check if cell (x, y) lies within the nested basin of node
+     *
+     * @param x Coord in row
+     * @param y Coord in column
+     * @param node Node id
+     * @return true
+     * @return false
+     */
+    bool isInBasin(int x, int y, int node) const;
+
+    /**
+     * @brief Find the basin whose outlet is cell (x, y)
+     *
+     * @param x Coord in row
+     * @param y Coord in column
+     * @return int Node id, -1 if (x, y) is not a basin outlet
+     */
+    int getBasinWithOutlet(int x, int y) const;
+
+    /**
+     * @brief All sub-basins of node with a nested area greater than minArea.
+     * Nested area only grows downstream, so the search stops at the first basin
+     * that is too small.
+     *
+     * @param node Node id
+     * @param minArea Minimum area in cellArea units
+     * @return std::vector<int> Node ids in preorder
+     */
+    std::vector<int> getSubBasins(int node, double minArea) const;
+
+    /// @return Nested area of node in cellArea units
+    double getArea(int node) const;
+
+    /// @return Node with given id
+    const BasinNode& getNode(int node) const;
+
+    /// @return Number of nodes in tree
+    int getNodeCount(void) const;
+
+    /// @return Ids of nodes without a parent (network outlets)
+    const std::vector<int>& getRoots(void) const;
+
+    /// @return Map<int> of basin label (node id) per cell
+    const Map<int>& getLabelMap(void) const;
+
+    /// @return Channel threshold the tree was built with
+    double getThreshold(void) const;
+
+    /// @return Area of a single cell
+    double getCellArea(void) const;
+
+    /**
+     * @brief Tag the source the tree was built from (e.g. a hash of the DEM and tool version).
+     * Saved with the tree so a stale file can be detected.
+     *
+     * @param source Token without whitespace, empty if unknown
+     */
+    void setSource(const std::string& source);
+
+    /// @return Source tag set with setSource(), empty if unknown
+    const std::string& getSource(void) const;
+
+    /**
+     * @brief Update labels after D8 receivers of some non-channel cells changed.
+     * Only the changed cells and the cells upstream of them are relabelled, and node
+     * areas and bounding boxes are patched along the parents of the old and new labels.
+     * The stream links themselves must be unchanged, otherwise build a new tree.
+     *
+     * @param D8 Updated D8 directions map
+     * @param cells Linear indexes of cells whose D8 direction changed
+     * @return int Number of cells that moved to a different basin
+     */
+    int relabelUpstream(const Map<int>& D8, const std::vector<int>& cells);
+
+    /**
+     * @brief Save tree next to rasters.
+     * Nodes are written to filename as text and labels to filename + ".labels.bin"
+     *
+     * @param filename Full file pathway
+     * @return true
+     * @return false
+     */
+    bool saveToFile(const std::string& filename) const;
+
+    /**
+     * @brief Load tree saved by saveToFile()
+     *
+     * @param filename Full file pathway
+     * @return true
+     * @return false
+     */
+    bool loadFromFile(const std::string& filename);
+
+    /**
+     * @brief Label every cell with the basin of the outlet its D8 path ends at: a cell without
+     * a direction, a cell flowing off the grid, or a D8 cycle on a flat. Needs no stream
+     * network and reads and writes caller-owned memory in place.
+     *
+     * @param D8 D8 directions
+     * @param labels Output: basin id per cell, numbered from 0 in the order a row-major scan
+     * first reaches each outlet
+     * @param path Scratch buffer for cells on the current path, kept between calls
+     * @return int Number of basins, -1 if the rasters are invalid or differ in size
+     */
+    static int labelOutletBasins(const RasterView<const int>& D8, const RasterView<int>& labels,
+                                 std::vector<int64_t>& path);
+
+private:
+    int _width, _height;
+    double _threshold;
+    double _cellArea;
+    std::string _source;
+    Map<int> _labelMap;
+    std::vector<BasinNode> _nodes;
+    std::vector<int> _roots;
+    std::unordered_map<int, int> _outletToNode;
+
+    /**
+     * @brief Label every cell with the first link downstream of it
+     *
+     * @param D8 D8 directions map
+     * @param linkMap Link id per cell
+     */
+    void labelCells(const Map<int>& D8, const Map<int>& linkMap);
+
+    /**
+     * @brief Label an unvisited cell and every unvisited cell on its path downstream
+     *
+     * @param D8 D8 directions map
+     * @param start Linear index of first cell
+     * @param path Scratch buffer for cells on the current path
+     */
+    void resolveLabel(const Map<int>& D8, int start, std::vector<int>& path);
+
+    /**
+     * @brief Derive children, preorder ranges, nested areas, and bounding boxes
+     * from node parents and _labelMap
+     */
+    void finalise(void);
+
+    /**
+     * @brief Set the nested bounding box of node from its local box and its
+     * children's nested boxes, which must be up to date
+     */
+    void nestBoundingBox(BasinNode& node);
+};
+
+#endif
@@ -11,13 +11,30 @@
  */
 
 #include "D8FlowAnalyser.h"
+#include "../parallel/StencilExecutor.h"
+#include "../profiling/Profiler.h"
+#include <cstdint>
 #include <iostream>
+#include <limits>
+
+/**
+ * @brief Coin flip for a tie between equal neighbours, fixed per cell and direction so
+ * results do not depend on thread count or on the order cells are visited
+ */
+static bool tieBreak(int x, int y, int dir) {
+    uint32_t h = static_cast<uint32_t>(x) * 0x9E3779B1u ^ static_cast<uint32_t>(y) * 0x85EBCA77u ^
+        static_cast<uint32_t>(dir) * 0xC2B2AE3Du;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return (h & 1u) == 0;
+}
 
 /**
  * @brief Construct a new D8FlowAnalyser<T>::D8FlowAnalyser object
  */
 template <typename T>
-D8FlowAnalyser<T>::D8FlowAnalyser(Map<T>& map) : _elevationData(map){
+D8FlowAnalyser<T>::D8FlowAnalyser(const Map<T>& map) : _elevationData(map){
     _height = map.getHeight();
     _width = map.getWidth();
     if (_height == 0 || _width == 0) {
@@ -33,12 +50,69 @@ D8FlowAnalyser<T>::D8FlowAnalyser(Map<T>& map) : _elevationData(map){
  */
 template <typename T>
 void D8FlowAnalyser<T>::analyseFlow(void) {
-    /// Iteration over every cell in _flowDirections
-    for (int y = 0; y < _height; y++) {
-        for (int x = 0; x < _width; x++) {
-            analyseFlowAt(x, y);
-        }
+    MapTileSource<T> source(_elevationData);
+    MapTileSink<int> sink(_flowDirections);
+    analyseFlow(source, sink);
+}
+
+/**
+ * @brief Halo value that is never lower than or equal to a cell, so edges need no checks.
+ * NaN compares false; int maps fall back to the largest value.
+ */
+template <typename T>
+static T outsideElevation(void) {
+    if (std::numeric_limits<T>::has_quiet_NaN) {
+        return std::numeric_limits<T>::quiet_NaN();
     }
+    return std::numeric_limits<T>::max();
+}
+
+/**
+ * @brief Tiled D8 directions, tiles split between pool threads
+ */
+template <typename T>
+bool D8FlowAnalyser<T>::analyseFlow(const TileSource<T>& elevation, TileSink<int>& directions, int y0, int y1) {
+    if (y1 < 0) y1 = elevation.getHeight();
+    ProfileScope scope("d8_directions", "kernel", static_cast<uint64_t>(elevation.getWidth()) * (y1 - y0));
+
+    // @param dx, dy Arrays of int where index in both correspond to D8 directions
+    const int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    const int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    StencilOptions<T> stencil;
+    stencil.halo = 1;
+    stencil.policy = HaloPolicy::NODATA;
+    stencil.nodata = outsideElevation<T>();
+
+    return runStencil(elevation, 0, y0, elevation.getWidth(), y1, stencil, [&](const StencilTile<T>& tile) {
+        TileWriter<int> out(directions, tile);
+        for (int j = 0; j < tile.height(); j++) {
+            // Rows above, at, and below, indexed by dy + 1
+            const T* rows[3] = {tile.row(j - 1), tile.row(j), tile.row(j + 1)};
+            int* outRow = out.row(j);
+            int y = tile.y0 + j;
+
+            for (int i = 0; i < tile.width(); i++) {
+                // Same search as flowDirectionAt(), ties broken on grid coordinates
+                T lowestValue = rows[1][i];
+                int bestDirection = -1;
+                for (int dir = 0; dir < 8; dir++) {
+                    T neighbourValue = rows[dy[dir] + 1][i + dx[dir]];
+                    if (neighbourValue < lowestValue) {
+                        lowestValue = neighbourValue;
+                        bestDirection = dir;
+                    }
+                    else if (neighbourValue == lowestValue) {
+                        if (tieBreak(tile.x0 + i, y, dir)) {
+                            bestDirection = dir;
+                        }
+                    }
+                }
+                outRow[i] = bestDirection;
+            }
+        }
+        return out.flush();
+    });
 }
 
 /**
@@ -51,10 +125,10 @@ Map<int> D8FlowAnalyser<T>::getMap(void) {
 }
 
 /**
- * @brief Search 3x3 grid about given cell (x, y) for the direction of its lowest elevation neighbour
+ * @brief Direction of lowest elevation neighbour of cell (x, y)
  */
 template <typename T>
-void D8FlowAnalyser<T>::analyseFlowAt(int x, int y) {
+int D8FlowAnalyser<T>::flowDirectionAt(int x, int y) {
     // @param currentValue Avoids multiple table lookups
     T currentValue = _elevationData.getData(x, y);
 
@@ -62,8 +136,6 @@ void D8FlowAnalyser<T>::analyseFlowAt(int x, int y) {
     int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
     int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
 
-    // @param bestX, bestY Init best coords with current coords
-    int bestX = x, bestY = y;
     // @param lowestValue Init with current cell value for lowest elevation checks
     T lowestValue = currentValue;
     // @param bestDirection Init bestDirection with -1. Used for no lowest direction found as default
@@ -82,30 +154,17 @@ void D8FlowAnalyser<T>::analyseFlowAt(int x, int y) {
             if (neighbourValue < lowestValue) {
                 // Update vars if found
                 lowestValue = neighbourValue;
-                bestX = nx;
-                bestY = ny;
                 bestDirection = dir;
             }
             else if (neighbourValue == lowestValue) {
                 // Randomness if two elevations of equal height are discovered
-                if (rand() % 2 == 0) {
-                    bestX = nx;
-                    bestY = ny;
+                if (tieBreak(x, y, dir)) {
                     bestDirection = dir;
                 }
             }
         }
     }
-    if (bestDirection != -1) {
-        // Set direction to direction indice of lowest elevation neighbour
-        _flowDirections.setData(x, y, bestDirection);
-    }
-    else {
-        // Failure direction set to -1
-        _flowDirections.setData(x, y, -1);
-    }
-    
-    
+    return bestDirection;
 }
 
 /// Init template class for different numeric types
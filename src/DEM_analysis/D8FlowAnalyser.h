@@ -14,6 +14,7 @@
 #define D8FLOWANALYSER_H
 
 #include "../map_core/Map.h"
+#include "../map_core/MapTiles.h"
 
 /**
  * @brief Class definition for D8FlowAnalyser.
@@ -35,25 +36,40 @@ public:
      * @param map
      * Reference to existing elevation (DEM) map (2D array)
      */
-    D8FlowAnalyser(Map<T>& map);
+    D8FlowAnalyser(const Map<T>& map);
     
     /// @brief analyseFlow at every point in _elevationMap
     void analyseFlow(void);
 
+    /**
+     * @brief D8 directions between a tile source and sink, e.g. .bin files too large to load.
+     * Matches analyseFlow(): neighbours beyond the edge are never chosen.
+     * 
+     * @param elevation Elevation grid
+     * @param directions Output D8 directions, -1 where no neighbour is lower or equal
+     * @param y0 First row to analyse, e.g. of one shard's strip
+     * @param y1 One past the last row, -1 for the grid height
+     * @return true If every tile was read and written
+     */
+    static bool analyseFlow(const TileSource<T>& elevation, TileSink<int>& directions, int y0 = 0, int y1 = -1);
+
     /// @return Map (2D array) of D8 directions (or empty if .analyseFlow() not called)
     Map<int> getMap(void);
 
+    /**
+     * @brief D8 direction of the lowest elevation neighbour of cell (x, y).
+     * Does not modify the stored direction map.
+     * 
+     * @param x Coord in row
+     * @param y Coord in column
+     * @return int D8 direction (0-7), -1 if no neighbour is lower or equal
+     */
+    int flowDirectionAt(int x, int y);
+
 private:
     int _width, _height;
-    Map<T> _elevationData;
+    const Map<T>& _elevationData;
     Map<int> _flowDirections;
-    
-    /// @brief Lowest elevation neighbour search function for 3x3 about cell declared by x, y.
-    /// @param x Coord in row
-    /// @param y Coord in column
-    void analyseFlowAt(int x, int y);
-
-    
 };
 
 #endif
\ No newline at end of file
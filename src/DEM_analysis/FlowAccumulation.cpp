@@ -9,9 +9,39 @@
  * 
  */
 #include "FlowAccumulation.h"
+#include "../parallel/parallelFor.h"
+#include "../profiling/Profiler.h"
 #include <iostream>
 #include <set>
+#include <tuple>
 #include <utility>
+#include <algorithm>
+
+/**
+ * @brief Every cell as (elevation, x, y), by descending elevation then row-major position.
+ * Gathered and sorted on the thread pool; the total order keeps the result independent of
+ * the thread count. Reuses the capacity of cells.
+ */
+template <typename elevationT, typename Grid>
+static void cellsByElevation(const Grid& elevation, std::vector<std::tuple<elevationT, int, int>>& cells) {
+    int width = elevation.getWidth();
+    int height = elevation.getHeight();
+    cells.resize(static_cast<size_t>(width) * height);
+    parallelFor(0, height, getThreadCount(), [&](int, int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            const elevationT* row = elevation.getRow(y);
+            for (int x = 0; x < width; x++) {
+                cells[static_cast<size_t>(y) * width + x] = std::make_tuple(row[x], x, y);
+            }
+        }
+    });
+
+    parallelSort(cells, [](const auto& a, const auto& b) {
+        if (std::get<0>(a) != std::get<0>(b)) return std::get<0>(a) > std::get<0>(b);  // descending
+        if (std::get<2>(a) != std::get<2>(b)) return std::get<2>(a) < std::get<2>(b);
+        return std::get<1>(a) < std::get<1>(b);
+    });
+}
 
 /**
  * @brief Construct a new Flow Accumulator<elevationT, D8T, DinfT>:: Flow Accumulator object
@@ -33,6 +63,8 @@ FlowAccumulator<elevationT, D8T, DinfT>::FlowAccumulator(const Map<elevationT>&
  */
 template <typename elevationT, typename D8T, typename DinfT>
 Map<elevationT> FlowAccumulator<elevationT, D8T, DinfT>::accumulateFlow(const std::string& method) {
+    ProfileScope scope("flow_accumulation", "kernel", static_cast<uint64_t>(_width) * _height);
+
     // If else for flow method chosen
     if (method == "d8") {
         if (!_D8Map) {
@@ -64,66 +96,108 @@ Map<elevationT> FlowAccumulator<elevationT, D8T, DinfT>::accumulateFlow(const st
 }
 
 /**
- * @brief D8 flow accumulation algorithm
+ * @brief D8 flow accumulation seeded with inflow
  */
 template <typename elevationT, typename D8T, typename DinfT>
-void FlowAccumulator<elevationT, D8T, DinfT>::accumulateD8(Map<elevationT>& _flowMap) {
+Map<elevationT> FlowAccumulator<elevationT, D8T, DinfT>::accumulateD8From(const Map<elevationT>& inflow,
+                                                                          Map<elevationT>* outflow) {
+    ProfileScope scope("flow_accumulation", "kernel", static_cast<uint64_t>(_width) * _height);
+    if (!_D8Map) {
+        std::cerr << "Error: D8 map is null. Cannot perform D8 flow accumulation." << std::endl;
+        return _flowMap;
+    }
+    if (inflow.getWidth() != _width || inflow.getHeight() != _height) {
+        std::cerr << "Error: inflow map must be the size of the DEM." << std::endl;
+        return _flowMap;
+    }
+    _flowMap = inflow;
+    accumulateD8(_flowMap, outflow);
+    return _flowMap;
+}
+
+/**
+ * @brief D8 accumulation into flow, which holds any inflow. Grids are Maps or RasterViews.
+ * cells is scratch for the elevation order.
+ */
+template <typename elevationT, typename ElevationGrid, typename D8Grid, typename FlowGrid>
+static void accumulateD8In(const ElevationGrid& elevationMap, const D8Grid& D8Map, FlowGrid& flowMap,
+    Map<elevationT>* outflow, std::vector<std::tuple<elevationT, int, int>>& cells) {
     // D8 directions where index in dx/dy correspond to D8 number
     int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
     int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+    int width = elevationMap.getWidth();
+    int height = elevationMap.getHeight();
 
-    // Gather all cells by x, y coords and their elevatations in vector<tuple>
-    std::vector<std::tuple<elevationT, int, int>> cells;
-    for (int y = 0; y < _height; y++) {
-        for (int x = 0; x < _width; x++) {
-            elevationT elevation = _elevationMap.getData(x, y);
-            cells.emplace_back(elevation, x, y);
-        }
-    }
-
-    // Sort cells by elevation
-    std::sort(cells.begin(), cells.end(), [](const auto& a, const auto& b) {
-        return std::get<0>(a) > std::get<0>(b); // descending elevation
-    });
+    // Gather all cells with their elevations, sorted by descending elevation
+    cellsByElevation<elevationT>(elevationMap, cells);
+    if (outflow) *outflow = Map<elevationT>(width, height);
 
     // Iterate over all cells
     for (const auto& [elevation, x, y] : cells) {
-        _flowMap.setData(x, y, _flowMap.getData(x, y) + 1.0); // Adding 1 to each cell visited
+        flowMap.setData(x, y, flowMap.getData(x, y) + 1.0); // Adding 1 to each cell visited
         
-        D8T direction = _D8Map->getData(x, y);  // Get direction from D8Map
+        auto direction = D8Map.getData(x, y);  // Get direction from D8Map
         if (direction == -1) {
             continue; // Skip no direction (ends loop)
         }
+        if (outflow) {
+            outflow->setData(x, y, flowMap.getData(x, y));
+        }
 
         // New directions
-        int nx = x + dx[direction];
-        int ny = y + dy[direction];
+        int nx = x + dx[static_cast<int>(direction)];
+        int ny = y + dy[static_cast<int>(direction)];
 
         // Out of bounds check
-        if (nx >= 0 && nx < _width && ny >= 0 && ny < _height) {
-            _flowMap.setData(nx, ny, _flowMap.getData(nx, ny) + _flowMap.getData(x, y));
+        if (nx >= 0 && nx < width && ny >= 0 && ny < height) {
+            flowMap.setData(nx, ny, flowMap.getData(nx, ny) + flowMap.getData(x, y));
         }
     }
 }
 
 /**
- * @brief Dinf Flow Algorithm (Tarboton 1997)
+ * @brief D8 flow accumulation algorithm
  */
 template <typename elevationT, typename D8T, typename DinfT>
-void FlowAccumulator<elevationT, D8T, DinfT>::accumulateDinf(Map<elevationT>& _flowMap) {    
-    // Gather cells
+void FlowAccumulator<elevationT, D8T, DinfT>::accumulateD8(Map<elevationT>& _flowMap, Map<elevationT>* outflow) {
     std::vector<std::tuple<elevationT, int, int>> cells;
-    for (int y = 0; y < _height; y++) {
-        for (int x = 0; x < _width; x++) {
-            elevationT elevation = _elevationMap.getData(x, y);
-            cells.emplace_back(elevation, x, y);
-        }
+    accumulateD8In<elevationT>(_elevationMap, *_D8Map, _flowMap, outflow, cells);
+}
+
+/**
+ * @brief D8 flow accumulation over caller-owned rasters
+ */
+template <typename elevationT, typename D8T, typename DinfT>
+bool FlowAccumulator<elevationT, D8T, DinfT>::accumulateD8(const RasterView<const elevationT>& elevation,
+                                                           const RasterView<const D8T>& D8,
+                                                           const RasterView<elevationT>& flow,
+                                                           std::vector<std::tuple<elevationT, int, int>>* scratch) {
+    if (!elevation.isValid() || !D8.isValid() || !flow.isValid()) {
+        std::cerr << "Error: Invalid raster for D8 flow accumulation." << std::endl;
+        return false;
     }
+    if (D8.width != elevation.width || D8.height != elevation.height ||
+        flow.width != elevation.width || flow.height != elevation.height) {
+        std::cerr << "Error: Elevation, D8 and flow rasters must be the same size." << std::endl;
+        return false;
+    }
+    ProfileScope scope("flow_accumulation", "kernel", static_cast<uint64_t>(elevation.width) * elevation.height);
+    for (int y = 0; y < flow.height; y++) {
+        std::fill(flow.getRow(y), flow.getRow(y) + flow.width, elevationT(0));
+    }
+    std::vector<std::tuple<elevationT, int, int>> cells;
+    accumulateD8In<elevationT>(elevation, D8, flow, nullptr, scratch ? *scratch : cells);
+    return true;
+}
 
-    // Sort by elevation
-    std::sort(cells.begin(), cells.end(), [](const auto& a, const auto& b) {
-        return std::get<0>(a) > std::get<0>(b); // descending
-    });
+/**
+ * @brief Dinf Flow Algorithm (Tarboton 1997)
+ */
+template <typename elevationT, typename D8T, typename DinfT>
+void FlowAccumulator<elevationT, D8T, DinfT>::accumulateDinf(Map<elevationT>& _flowMap) {    
+    // Gather all cells with their elevations, sorted by descending elevation
+    std::vector<std::tuple<elevationT, int, int>> cells;
+    cellsByElevation<elevationT>(_elevationMap, cells);
 
     // Create a temporary map to store updates
     Map<elevationT> tempFlowMap = _flowMap;
@@ -250,19 +324,9 @@ void FlowAccumulator<elevationT, D8T, DinfT>::accumulateMDF(Map<elevationT>& _fl
     int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
     int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
 
-    // Gather cells
+    // Gather all cells with their elevations, sorted by descending elevation
     std::vector<std::tuple<elevationT, int, int>> cells;
-    for (int y = 0; y < _height; y++) {
-        for (int x = 0; x < _width; x++) {
-            elevationT elevation = _elevationMap.getData(x, y);
-            cells.emplace_back(elevation, x, y);
-        }
-    }
-
-    // Sort by elevation
-    std::sort(cells.begin(), cells.end(), [](const auto& a, const auto& b) {
-        return std::get<0>(a) > std::get<0>(b); // descending
-    });
+    cellsByElevation<elevationT>(_elevationMap, cells);
 
     // Iterate over descending elevation cells
     for (const auto& [elevation, x, y] : cells) {
@@ -15,6 +15,9 @@
 #include "SobelAnalysis.h"
 #include <cmath>
 #include <vector>
+#include <array>
+#include <tuple>
+#include <string>
 
 /**
  * @brief Class that determines flow accumulation over a DEM across multiple algortithms
@@ -53,6 +56,33 @@ public:
      */
     Map<elevationT> accumulateFlow(const std::string& method);
 
+    /**
+     * @brief D8 flow accumulation with flow already entering cells from beyond the map, e.g.
+     * from the shards either side of a strip. A cell's inflow is counted before it passes
+     * flow on, as flow from an upstream cell would be.
+     * 
+     * @param inflow Flow entering each cell, same size as the DEM
+     * @param outflow Output: flow each cell passes downstream, including off the map edge
+     * (0 where it has no direction), nullptr to skip
+     * @return Map<elevationT> Flow accumulation map
+     */
+    Map<elevationT> accumulateD8From(const Map<elevationT>& inflow, Map<elevationT>* outflow = nullptr);
+
+    /**
+     * @brief D8 flow accumulation over caller-owned memory, without copying it into Maps.
+     * Same result as accumulateFlow("d8").
+     * 
+     * @param elevation DEM, usually with sinks filled
+     * @param D8 Directions from D8FlowAnalyser, -1 where there is none
+     * @param flow Output: flow accumulation
+     * @param scratch Buffer for the elevation order, kept between calls to avoid reallocating.
+     * nullptr to use a temporary
+     * @return true If the rasters were valid and the same size
+     */
+    static bool accumulateD8(const RasterView<const elevationT>& elevation, const RasterView<const D8T>& D8,
+                             const RasterView<elevationT>& flow,
+                             std::vector<std::tuple<elevationT, int, int>>* scratch = nullptr);
+
 private:
     //
     const Map<elevationT>& _elevationMap;
@@ -71,9 +101,10 @@ private:
      * @see D8FLowAnalyser.h
      * @param _flowMap 
      * Reference to _flowMap
-     * 
+     * @param outflow
+     * Output: flow passed on by each cell, nullptr to skip
      */
-    void accumulateD8(Map<elevationT>& _flowMap);
+    void accumulateD8(Map<elevationT>& _flowMap, Map<elevationT>* outflow = nullptr);
 
     /**
      * @brief Dinf flow accumulation method
@@ -0,0 +1,340 @@
+/**
+ * @file IncrementalAnalyser.cpp
+ * @author Ollie
+ * @brief Incremental update of derived maps after a local DEM edit
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "IncrementalAnalyser.h"
+#include "StreamNetwork.h"
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+
+/**
+ * @brief Construct a new Incremental Analyser<T>:: Incremental Analyser object
+ */
+template <typename T>
+IncrementalAnalyser<T>::IncrementalAnalyser(Map<T>& elevation, Map<int>* D8, Map<T>* flow,
+                                            Map<T>* slope, Map<T>* aspect, BasinTree* basins)
+    : _elevationMap(elevation), _D8Map(D8), _flowMap(flow), _slopeMap(slope), _aspectMap(aspect),
+    _basinTree(basins), _width(elevation.getWidth()), _height(elevation.getHeight()), _fillSinks(false),
+    _slopeAnalyser(elevation), _d8Analyser(elevation),
+    _changedDirections(0), _updatedFlowCells(0), _relabelledCells(0), _basinsRebuilt(false) {
+
+    // Derived maps must match DEM
+    auto matches = [&](int width, int height) { return width == _width && height == _height; };
+    if ((_D8Map && !matches(_D8Map->getWidth(), _D8Map->getHeight())) ||
+        (_flowMap && !matches(_flowMap->getWidth(), _flowMap->getHeight())) ||
+        (_slopeMap && !matches(_slopeMap->getWidth(), _slopeMap->getHeight())) ||
+        (_aspectMap && !matches(_aspectMap->getWidth(), _aspectMap->getHeight()))) {
+        std::cerr << "Error: Maps for IncrementalAnalyser must be the same size as the DEM." << std::endl;
+    }
+    if (_flowMap && !_D8Map) {
+        std::cerr << "Warning: Flow map cannot be updated without a D8 map." << std::endl;
+    }
+    if (_basinTree && (!_D8Map || !_flowMap)) {
+        std::cerr << "Warning: Basin tree cannot be updated without D8 and flow maps." << std::endl;
+    }
+}
+
+/**
+ * @brief Set sink filling
+ */
+template <typename T>
+void IncrementalAnalyser<T>::setFillSinks(bool fill) {
+    _fillSinks = fill;
+}
+
+/**
+ * @brief Update all given maps about edited region
+ */
+template <typename T>
+bool IncrementalAnalyser<T>::update(int x0, int y0, int x1, int y1) {
+    _changedDirections = 0;
+    _updatedFlowCells = 0;
+    _relabelledCells = 0;
+    _basinsRebuilt = false;
+
+    if (x0 > x1 || y0 > y1 || x1 < 0 || y1 < 0 || x0 >= _width || y0 >= _height) {
+        std::cerr << "Error: Edited region is outside of map." << std::endl;
+        return false;
+    }
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, _width - 1);
+    y1 = std::min(y1, _height - 1);
+
+    // Filling can raise cells outside the region, which grows it
+    if (_fillSinks) {
+        _elevationMap.fillSinks(x0, y0, x1, y1);
+    }
+
+    // Every 3x3 stencil touching the region
+    int hx0 = std::max(0, x0 - 1);
+    int hy0 = std::max(0, y0 - 1);
+    int hx1 = std::min(_width - 1, x1 + 1);
+    int hy1 = std::min(_height - 1, y1 + 1);
+
+    for (int y = hy0; y <= hy1; y++) {
+        for (int x = hx0; x <= hx1; x++) {
+            if (_slopeMap) _slopeMap->setData(x, y, _slopeAnalyser.slopeAt(x, y));
+            if (_aspectMap) _aspectMap->setData(x, y, _slopeAnalyser.directionAt(x, y));
+        }
+    }
+
+    if (!_D8Map) {
+        return true;
+    }
+
+    // Update directions, collecting old and new receivers of changed cells. Edited cells are
+    // seeds too: their elevation decides where they fall in the accumulation order
+    std::vector<int> changed;
+    std::vector<int> seeds;
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            seeds.push_back(y * _width + x);
+        }
+    }
+    for (int y = hy0; y <= hy1; y++) {
+        for (int x = hx0; x <= hx1; x++) {
+            int oldDirection = _D8Map->getData(x, y);
+            int newDirection = updatedDirection(x, y);
+            if (newDirection == oldDirection) continue;
+
+            _D8Map->setData(x, y, newDirection);
+            changed.push_back(y * _width + x);
+            int oldReceiver = getReceiver(x, y, oldDirection);
+            int newReceiver = getReceiver(x, y, newDirection);
+            if (oldReceiver != -1) seeds.push_back(oldReceiver);
+            if (newReceiver != -1) seeds.push_back(newReceiver);
+        }
+    }
+    _changedDirections = changed.size();
+
+    if (_flowMap) {
+        updateFlow(seeds, changed);
+    }
+    return true;
+}
+
+/**
+ * @brief D8 direction, keeping the old one on ties
+ */
+template <typename T>
+int IncrementalAnalyser<T>::updatedDirection(int x, int y) {
+    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    int direction = _d8Analyser.flowDirectionAt(x, y);
+    int oldDirection = _D8Map->getData(x, y);
+    if (direction == -1 || oldDirection < 0 || oldDirection > 7 || oldDirection == direction) {
+        return direction;
+    }
+
+    int ox = x + dx[oldDirection];
+    int oy = y + dy[oldDirection];
+    if (ox < 0 || oy < 0 || ox >= _width || oy >= _height) {
+        return direction;
+    }
+    T lowest = _elevationMap.getData(x + dx[direction], y + dy[direction]);
+    return (_elevationMap.getData(ox, oy) == lowest) ? oldDirection : direction;
+}
+
+/**
+ * @brief Receiver from direction
+ */
+template <typename T>
+int IncrementalAnalyser<T>::getReceiver(int x, int y, int direction) const {
+    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    if (direction < 0 || direction > 7) {
+        return -1;
+    }
+    int nx = x + dx[direction];
+    int ny = y + dy[direction];
+    if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) {
+        return -1;
+    }
+    return ny * _width + nx;
+}
+
+/**
+ * @brief Recompute flow on affected paths in accumulation order, then update basins
+ */
+template <typename T>
+void IncrementalAnalyser<T>::updateFlow(const std::vector<int>& seeds, const std::vector<int>& changed) {
+    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    auto receiverOf = [&](int cell) {
+        int x = cell % _width;
+        int y = cell / _width;
+        return getReceiver(x, y, _D8Map->getData(x, y));
+    };
+    auto elevationOf = [&](int cell) { return _elevationMap.getData(cell % _width, cell / _width); };
+
+    // Same order as FlowAccumulator: descending elevation, then row-major. A cell passes on
+    // what it holds when visited, so flow from a donor visited after it (on a flat, or
+    // round a D8 cycle) stops there
+    auto visitedBefore = [&](int a, int b) {
+        T elevationA = elevationOf(a);
+        T elevationB = elevationOf(b);
+        if (elevationA != elevationB) return elevationA > elevationB;
+        return a < b;
+    };
+    auto forEachDonor = [&](int cell, auto&& visit) {
+        int x = cell % _width;
+        int y = cell / _width;
+        for (int direction = 0; direction < 8; direction++) {
+            int nx = x + dx[direction];
+            int ny = y + dy[direction];
+            if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) continue;
+            int donor = ny * _width + nx;
+            if (receiverOf(donor) == cell) visit(donor);
+        }
+    };
+
+    // Affected cells are every cell downstream of a seed. Walks stop at visited cells
+    std::unordered_map<int, int> index;
+    std::vector<int> affected;
+    for (int seed : seeds) {
+        for (int cell = seed; cell != -1 && index.find(cell) == index.end(); cell = receiverOf(cell)) {
+            index[cell] = affected.size();
+            affected.push_back(cell);
+        }
+    }
+
+    // Flow an unaffected cell passed on: its stored flow less what late donors added after.
+    // Late donors are unaffected too, and always later in the order, so this terminates
+    std::unordered_map<int, T> passedOn;
+    std::vector<int> stack;
+    auto unaffectedPassed = [&](int start) {
+        stack.push_back(start);
+        while (!stack.empty()) {
+            int cell = stack.back();
+            if (passedOn.count(cell)) {
+                stack.pop_back();
+                continue;
+            }
+            bool ready = true;
+            T passed = _flowMap->getData(cell % _width, cell / _width);
+            forEachDonor(cell, [&](int donor) {
+                if (visitedBefore(donor, cell)) return;
+                auto it = passedOn.find(donor);
+                if (it == passedOn.end()) {
+                    stack.push_back(donor);
+                    ready = false;
+                }
+                else {
+                    passed -= it->second;
+                }
+            });
+            if (ready) {
+                passedOn[cell] = passed;
+                stack.pop_back();
+            }
+        }
+        return passedOn[start];
+    };
+
+    // Replay the accumulation over affected cells in order. Each passes on itself plus
+    // donors visited before it, and holds that plus donors visited after it
+    std::vector<int> order(affected.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return visitedBefore(affected[a], affected[b]); });
+
+    std::vector<T> passed(affected.size());
+    std::vector<T> oldFlow(affected.size());
+    for (int i : order) {
+        int cell = affected[i];
+        T flow = 1;
+        forEachDonor(cell, [&](int donor) {
+            if (!visitedBefore(donor, cell)) return;
+            auto it = index.find(donor);
+            flow += (it != index.end()) ? passed[it->second] : unaffectedPassed(donor);
+        });
+        passed[i] = flow;
+    }
+    for (int i : order) {
+        int cell = affected[i];
+        T flow = passed[i];
+        forEachDonor(cell, [&](int donor) {
+            if (visitedBefore(donor, cell)) return;
+            auto it = index.find(donor);
+            flow += (it != index.end()) ? passed[it->second] : unaffectedPassed(donor);
+        });
+        oldFlow[i] = _flowMap->getData(cell % _width, cell / _width);
+        _flowMap->setData(cell % _width, cell / _width, flow);
+    }
+    _updatedFlowCells = affected.size();
+
+    if (!_basinTree) {
+        return;
+    }
+
+    // Links are unchanged unless a channel appeared, vanished, or was redirected
+    double threshold = _basinTree->getThreshold();
+    bool rebuild = false;
+    for (size_t i = 0; i < affected.size() && !rebuild; i++) {
+        int cell = affected[i];
+        bool wasChannel = oldFlow[i] >= threshold;
+        bool isChannel = _flowMap->getData(cell % _width, cell / _width) >= threshold;
+        rebuild = (wasChannel != isChannel);
+    }
+    for (size_t i = 0; i < changed.size() && !rebuild; i++) {
+        rebuild = _flowMap->getData(changed[i] % _width, changed[i] / _width) >= threshold;
+    }
+
+    if (rebuild) {
+        StreamNetwork<T> network(*_flowMap, *_D8Map);
+        network.extractStreams(threshold);
+        *_basinTree = BasinTree(*_D8Map, network.getLinkMap(), network.getLinks(), threshold,
+                                _basinTree->getCellArea());
+        _basinsRebuilt = true;
+    }
+    else {
+        _relabelledCells = _basinTree->relabelUpstream(*_D8Map, changed);
+    }
+}
+
+/**
+ * @brief Return number of changed directions
+ */
+template <typename T>
+int IncrementalAnalyser<T>::getChangedDirections(void) const {
+    return _changedDirections;
+}
+
+/**
+ * @brief Return number of recomputed flow cells
+ */
+template <typename T>
+int IncrementalAnalyser<T>::getUpdatedFlowCells(void) const {
+    return _updatedFlowCells;
+}
+
+/**
+ * @brief Return number of relabelled cells
+ */
+template <typename T>
+int IncrementalAnalyser<T>::getRelabelledCells(void) const {
+    return _relabelledCells;
+}
+
+/**
+ * @brief Return if basin tree was rebuilt
+ */
+template <typename T>
+bool IncrementalAnalyser<T>::basinsRebuilt(void) const {
+    return _basinsRebuilt;
+}
+
+// Instantiation
+template class IncrementalAnalyser<double>;
+template class IncrementalAnalyser<float>;
+template class IncrementalAnalyser<int>;
@@ -0,0 +1,137 @@
+/**
+ * @file IncrementalAnalyser.h
+ * @author Ollie
+ * @brief Incremental update of derived maps after a local DEM edit
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef INCREMENTALANALYSER_H
+#define INCREMENTALANALYSER_H
+
+#include "../map_core/Map.h"
+#include "SobelAnalysis.h"
+#include "D8FlowAnalyser.h"
+#include "BasinTree.h"
+#include <vector>
+
+/**
+ * @brief Class that keeps derived maps in step with an elevation map that is edited in place.
+ * After cells in a rectangle are changed:
+ * - sinks are optionally refilled about the rectangle only
+ * - slope, aspect, and D8 directions are recomputed within the rectangle and a 1 cell halo
+ * - D8 flow accumulation is recomputed only on the paths downstream of edited cells and of
+ *   the old and new receivers of cells whose direction changed. The paths are replayed in
+ *   FlowAccumulator's order, so flats and D8 cycles give the same flow as a full recompute
+ * - basin labels are moved for cells upstream of changed receivers, or the basin tree is
+ *   rebuilt if the channel network itself changed
+ *
+ * Maps that are not given (nullptr) are skipped. Flow and basin updates require the D8 map,
+ * and basin updates require the D8 flow map.
+ * Only D8 flow accumulation can be updated, Dinf and MDF maps must be recomputed in full.
+ *
+ * @see D8FlowAnalyser.h
+ * @see BasinTree.h
+ * @tparam T Numeric types: double, float, int
+ */
+template <typename T>
+class IncrementalAnalyser {
+public:
+    /**
+     * @brief Construct a new Incremental Analyser object
+     *
+     * @param elevation Reference to elevation map (DEM) that is edited
+     * @param D8 Pointer to D8 directions map of elevation
+     * @param flow Pointer to D8 flow accumulation map
+     * @param slope Pointer to combined gradient map
+     * @param aspect Pointer to aspect map
+     * @param basins Pointer to basin tree built from D8 and flow
+     */
+    IncrementalAnalyser(Map<T>& elevation,
+                        Map<int>* D8 = nullptr,
+                        Map<T>* flow = nullptr,
+                        Map<T>* slope = nullptr,
+                        Map<T>* aspect = nullptr,
+                        BasinTree* basins = nullptr);
+
+    /**
+     * @brief Refill sinks about edited region before updating. Off by default.
+     *
+     * @param fill
+     */
+    void setFillSinks(bool fill);
+
+    /**
+     * @brief Update derived maps after cells from (x0, y0) to (x1, y1) were edited
+     *
+     * @param x0 Lowest row index of edited region
+     * @param y0 Lowest column index of edited region
+     * @param x1 Highest row index of edited region
+     * @param y1 Highest column index of edited region
+     * @return true
+     * @return false If region is invalid
+     */
+    bool update(int x0, int y0, int x1, int y1);
+
+    /// @return Number of cells whose D8 direction changed in last update
+    int getChangedDirections(void) const;
+
+    /// @return Number of cells whose flow accumulation was recomputed in last update
+    int getUpdatedFlowCells(void) const;
+
+    /// @return Number of cells moved to another basin in last update
+    int getRelabelledCells(void) const;
+
+    /// @return true if last update rebuilt the basin tree
+    bool basinsRebuilt(void) const;
+
+private:
+    Map<T>& _elevationMap;
+    Map<int>* _D8Map;
+    Map<T>* _flowMap;
+    Map<T>* _slopeMap;
+    Map<T>* _aspectMap;
+    BasinTree* _basinTree;
+    int _width, _height;
+    bool _fillSinks;
+
+    SlopeAnalyser<T> _slopeAnalyser;
+    D8FlowAnalyser<T> _d8Analyser;
+
+    int _changedDirections;
+    int _updatedFlowCells;
+    int _relabelledCells;
+    bool _basinsRebuilt;
+
+    /**
+     * @brief New D8 direction of a cell. The old direction is kept while it is
+     * still one of the lowest neighbours, so ties are not re-rolled about every edit.
+     *
+     * @param x Coord in row
+     * @param y Coord in column
+     * @return int D8 direction (0-7), -1 if none
+     */
+    int updatedDirection(int x, int y);
+
+    /**
+     * @brief Receiver of a cell in a given direction
+     *
+     * @param x Coord in row
+     * @param y Coord in column
+     * @param direction D8 direction
+     * @return int Linear index of receiver, -1 if none or off map
+     */
+    int getReceiver(int x, int y, int direction) const;
+
+    /**
+     * @brief Recompute flow accumulation on every path downstream of seeds
+     *
+     * @param seeds Linear indexes of edited cells and old and new receivers of changed cells
+     * @param changed Linear indexes of cells whose direction changed
+     */
+    void updateFlow(const std::vector<int>& seeds, const std::vector<int>& changed);
+};
+
+#endif
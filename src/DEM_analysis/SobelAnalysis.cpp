@@ -10,10 +10,26 @@
  */
 
 #include "SobelAnalysis.h"
+#include "../parallel/StencilExecutor.h"
+#include "../profiling/Profiler.h"
 
 #include <iostream>
 #include <cmath>
+#include <memory>
 #include <stdexcept>
+#include <algorithm>
+
+// Same kernels as _sobelX and _sobelY, for the static tiled sweep
+static const int sobelKernelX[3][3] = {
+    {-1,  0,  1},
+    {-2,  0,  2},
+    {-1,  0,  1}
+};
+static const int sobelKernelY[3][3] = {
+    {-1, -2, -1},
+    { 0,  0,  0},
+    { 1,  2,  1}
+};
 
 /**
  * @brief Construct a new Slope Analyser< T>:: Slope Analyser object
@@ -56,39 +72,185 @@ Map<T> SlopeAnalyser<T>::computeSlope(const std::string& type) {
 template <typename T>
 Map<T> SlopeAnalyser<T>::computeSlopeCombined(void) {
     // Create gradient map
-    Map<T> slopeMap(_width, _height);
-    
-    // iterate for cell in _elevationMap
-    for (int y = 0; y < _height; y++) {
-        for (int x = 0; x < _width; x++) {
-            int Gx = 0, Gy = 0;
-            // Iteratre for positions in sobel kernel
-            for (int dy = -1; dy <= 1; dy++) {
-                for (int dx = -1; dx <= 1; dx++) {
-                    int nx = x + dx;
-                    int ny = y + dy;
+    Map<T> slopeMap;
+    computeSurface(&slopeMap, nullptr, nullptr);
+    return slopeMap;
+}
 
-                    // Kernel edge case check. Reflecting values for similar gradient.
-                    if (nx < 0) nx = -nx;
-                    if (ny < 0) ny = -ny;
-                    if (nx >= _width) nx = 2 * _width - nx - 2;
-                    if (ny >= _height) ny = 2 * _height - ny - 2;
+/**
+ * @brief Create hillshade map
+ */
+template <typename T>
+Map<T> SlopeAnalyser<T>::computeHillshade(const HillshadeOptions& options) {
+    Map<T> hillshadeMap;
+    computeSurface(nullptr, nullptr, &hillshadeMap, options);
+    return hillshadeMap;
+}
 
-                    T elevationValue = _elevationMap.getData(nx, ny);
+/**
+ * @brief Fused parallel sweep for slope, aspect, and hillshade
+ */
+template <typename T>
+void SlopeAnalyser<T>::computeSurface(Map<T>* slopeMap, Map<T>* aspectMap, Map<T>* hillshadeMap,
+    const HillshadeOptions& options) {
+    // Outputs
+    if (slopeMap) *slopeMap = Map<T>(_width, _height);
+    if (aspectMap) *aspectMap = Map<T>(_width, _height);
+    if (hillshadeMap) *hillshadeMap = Map<T>(_width, _height);
+    if (_width == 0 || _height == 0) return;
 
-                    Gx += _sobelX[dy + 1][dx + 1] * elevationValue;
-                    Gy += _sobelY[dy + 1][dx + 1] * elevationValue;
+    MapTileSource<T> source(_elevationMap);
+    std::unique_ptr<MapTileSink<T>> slopeSink, aspectSink, hillshadeSink;
+    if (slopeMap) slopeSink.reset(new MapTileSink<T>(*slopeMap));
+    if (aspectMap) aspectSink.reset(new MapTileSink<T>(*aspectMap));
+    if (hillshadeMap) hillshadeSink.reset(new MapTileSink<T>(*hillshadeMap));
+    computeSurface(source, slopeSink.get(), aspectSink.get(), hillshadeSink.get(), options);
+}
+
+/**
+ * @brief Fused tiled sweep for slope, aspect, and hillshade
+ */
+template <typename T>
+bool SlopeAnalyser<T>::computeSurface(const TileSource<T>& elevation, TileSink<T>* slope, TileSink<T>* aspect,
+    TileSink<T>* hillshade, const HillshadeOptions& options) {
+    int width = elevation.getWidth();
+    int height = elevation.getHeight();
+    ProfileScope scope("sobel_surface", "kernel", static_cast<uint64_t>(width) * height);
+
+    // Sun directions, a single one unless multidirectional
+    const double degToRad = M_PI / 180.0;
+    std::vector<double> azimuths;
+    if (options.multidirectional) {
+        azimuths = {225.0, 270.0, 315.0, 360.0};
+    } else {
+        azimuths = {options.azimuth};
+    }
+    std::vector<double> sinAzimuth, cosAzimuth;
+    for (double azimuth : azimuths) {
+        sinAzimuth.push_back(std::sin(azimuth * degToRad));
+        cosAzimuth.push_back(std::cos(azimuth * degToRad));
+    }
+    const double sinAltitude = std::sin(options.altitude * degToRad);
+    const double cosAltitude = std::cos(options.altitude * degToRad);
+    // Sobel sums are 8 times the gradient per cell
+    const double scale = options.zFactor / 8.0;
+
+    // Reflected edges, as in sobelAt()
+    StencilOptions<T> stencil;
+    stencil.halo = 1;
+    stencil.policy = HaloPolicy::REFLECT;
+
+    return runStencil(elevation, stencil, [&](const StencilTile<T>& tile) {
+        std::unique_ptr<TileWriter<T>> slopeOut, aspectOut, hillshadeOut;
+        if (slope) slopeOut.reset(new TileWriter<T>(*slope, tile));
+        if (aspect) aspectOut.reset(new TileWriter<T>(*aspect, tile));
+        if (hillshade) hillshadeOut.reset(new TileWriter<T>(*hillshade, tile));
+
+        for (int j = 0; j < tile.height(); j++) {
+            const T* rows[3] = {tile.row(j - 1), tile.row(j), tile.row(j + 1)};
+            T* slopeRow = slopeOut ? slopeOut->row(j) : nullptr;
+            T* aspectRow = aspectOut ? aspectOut->row(j) : nullptr;
+            T* hillshadeRow = hillshadeOut ? hillshadeOut->row(j) : nullptr;
+
+            for (int i = 0; i < tile.width(); i++) {
+                // Integer sums as in sobelAt(), exact sums for hillshade
+                int Gx = 0, Gy = 0;
+                double gx = 0.0, gy = 0.0;
+                for (int dy = 0; dy < 3; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        T elevationValue = rows[dy][i + dx];
+
+                        Gx += sobelKernelX[dy][dx + 1] * elevationValue;
+                        Gy += sobelKernelY[dy][dx + 1] * elevationValue;
+                        gx += sobelKernelX[dy][dx + 1] * static_cast<double>(elevationValue);
+                        gy += sobelKernelY[dy][dx + 1] * static_cast<double>(elevationValue);
+                    }
                 }
-            }
 
-            T slope = 0;
-            if (Gx != 0 || Gy != 0) {
-                slope = std::sqrt(static_cast<T>(Gx * Gx + Gy * Gy));
+                if (slopeRow) {
+                    slopeRow[i] = slopeFromSobel(Gx, Gy);
+                }
+                if (aspectRow) {
+                    aspectRow[i] = directionFromSobel(Gx, Gy);
+                }
+                if (hillshadeRow) {
+                    // Rise to the east and north (rows run south)
+                    double p = gx * scale;
+                    double q = -gy * scale;
+                    double norm = std::sqrt(1.0 + p * p + q * q);
+                    double shade = 0.0;
+                    if (azimuths.size() == 1) {
+                        shade = (sinAltitude - (p * sinAzimuth[0] + q * cosAzimuth[0]) * cosAltitude) / norm;
+                    } else {
+                        // Weight each sun by sin^2 of its angle to the downslope direction (weights sum to 2)
+                        double downslope = std::atan2(-p, -q);
+                        for (size_t k = 0; k < azimuths.size(); k++) {
+                            double single = (sinAltitude - (p * sinAzimuth[k] + q * cosAzimuth[k]) * cosAltitude) / norm;
+                            double weight = std::sin(downslope - azimuths[k] * degToRad);
+                            shade += weight * weight * std::max(single, 0.0);
+                        }
+                        shade *= 0.5;
+                    }
+                    hillshadeRow[i] = static_cast<T>(255.0 * std::max(shade, 0.0));
+                }
             }
-            slopeMap.setData(x, y, slope);
+        }
+
+        bool written = true;
+        if (slopeOut) written = slopeOut->flush() && written;
+        if (aspectOut) written = aspectOut->flush() && written;
+        if (hillshadeOut) written = hillshadeOut->flush() && written;
+        return written;
+    });
+}
+
+/**
+ * @brief Sobel kernels about cell (x, y)
+ */
+template <typename T>
+void SlopeAnalyser<T>::sobelAt(int x, int y, int& Gx, int& Gy) const {
+    Gx = 0;
+    Gy = 0;
+    // Iteratre for positions in sobel kernel
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            int nx = x + dx;
+            int ny = y + dy;
+
+            // Kernel edge case check. Reflecting values for similar gradient.
+            if (nx < 0) nx = -nx;
+            if (ny < 0) ny = -ny;
+            if (nx >= _width) nx = 2 * _width - nx - 2;
+            if (ny >= _height) ny = 2 * _height - ny - 2;
+
+            T elevationValue = _elevationMap.getData(nx, ny);
+
+            Gx += _sobelX[dy + 1][dx + 1] * elevationValue;
+            Gy += _sobelY[dy + 1][dx + 1] * elevationValue;
         }
     }
-    return slopeMap;
+}
+
+/**
+ * @brief Overall gradient magnitude at cell (x, y)
+ */
+template <typename T>
+T SlopeAnalyser<T>::slopeAt(int x, int y) const {
+    int Gx, Gy;
+    sobelAt(x, y, Gx, Gy);
+    return slopeFromSobel(Gx, Gy);
+}
+
+/**
+ * @brief Gradient magnitude from Sobel sums
+ */
+template <typename T>
+T SlopeAnalyser<T>::slopeFromSobel(int Gx, int Gy) {
+    T slope = 0;
+    if (Gx != 0 || Gy != 0) {
+        slope = std::sqrt(static_cast<T>(Gx * Gx + Gy * Gy));
+    }
+    return slope;
 }
 
 /**
@@ -175,56 +337,47 @@ Map<T> SlopeAnalyser<T>::computeSlopeGy(void) {
  */
 template <typename T>
 Map<T> SlopeAnalyser<T>::computeDirection(void) {
-    T elevationValue;
-    Map<T> dirMap(_width, _height);
-    
-    // Threshold for small gradients (to avoid assigning 0 slope in flat areas)
-    const T threshold = static_cast<T>(0.01); 
-
-    // Iterate over cells in _elevationMap
-    for (int y = 0; y < _height; y++) {
-        for (int x = 0; x < _width; x++) {
-            int Gx = 0, Gy = 0;
-
-            // Apply Sobel kernel for the 3x3 grid around the current cell
-            for (int dy = -1; dy <= 1; dy++) {
-                for (int dx = -1; dx <= 1; dx++) {
-                    int nx = x + dx;
-                    int ny = y + dy;
+    Map<T> dirMap;
+    computeSurface(nullptr, &dirMap, nullptr);
+    return dirMap;
+}
 
-                    // Kernel edge case check. Reflecting values for similar gradient.
-                    if (nx < 0) nx = -nx;
-                    if (ny < 0) ny = -ny;
-                    if (nx >= _width) nx = 2 * _width - nx - 2;
-                    if (ny >= _height) ny = 2 * _height - ny - 2;
+/**
+ * @brief Aspect at cell (x, y)
+ */
+template <typename T>
+T SlopeAnalyser<T>::directionAt(int x, int y) const {
+    // Apply Sobel kernel for the 3x3 grid around the current cell
+    int Gx, Gy;
+    sobelAt(x, y, Gx, Gy);
+    return directionFromSobel(Gx, Gy);
+}
 
-                    elevationValue = _elevationMap.getData(nx, ny);
-                    Gx += _sobelX[dy + 1][dx + 1] * elevationValue;
-                    Gy += _sobelY[dy + 1][dx + 1] * elevationValue;
-                }
-            }
+/**
+ * @brief Aspect from Sobel sums
+ */
+template <typename T>
+T SlopeAnalyser<T>::directionFromSobel(int Gx, int Gy) {
+    // Threshold for small gradients (to avoid assigning 0 slope in flat areas)
+    const T threshold = static_cast<T>(0.01); 
 
-            // Compute the gradient magnitude
-            T gradientMagnitude = std::sqrt(static_cast<T>(Gx * Gx + Gy * Gy));
-            
-            // If the gradient is small, consider this a flat area (no slope)
-            if (gradientMagnitude < threshold) {
-                dirMap.setData(x, y, static_cast<T>(-1)); // No slope (flat area)
-            } else {
-                // Compute the angle of the gradient
-                T angleRad = std::atan2(static_cast<T>(Gy), static_cast<T>(Gx));
-                T angleDeg = angleRad * static_cast<T>(180.0 / M_PI);
-                
-                if (angleDeg < 0) {
-                    angleDeg += 360;
-                }
-                angleDeg = fmod(angleDeg, 360);
+    // Compute the gradient magnitude
+    T gradientMagnitude = std::sqrt(static_cast<T>(Gx * Gx + Gy * Gy));
+    
+    // If the gradient is small, consider this a flat area (no slope)
+    if (gradientMagnitude < threshold) {
+        return static_cast<T>(-1); // No slope (flat area)
+    }
 
-                dirMap.setData(x, y, angleDeg);
-            }
-        }
+    // Compute the angle of the gradient
+    T angleRad = std::atan2(static_cast<T>(Gy), static_cast<T>(Gx));
+    T angleDeg = angleRad * static_cast<T>(180.0 / M_PI);
+    
+    if (angleDeg < 0) {
+        angleDeg += 360;
     }
-    return dirMap;
+    angleDeg = fmod(angleDeg, 360);
+    return angleDeg;
 }
 
 // Instantiation
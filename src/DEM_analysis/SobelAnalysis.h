@@ -12,6 +12,17 @@
 #define SLOPE_ANALYSIS_H
 
 #include "../map_core/Map.h"
+#include "../map_core/MapTiles.h"
+
+/**
+ * @brief Sun position and scaling for hillshade
+ */
+struct HillshadeOptions {
+    double azimuth = 315.0;        // Degrees clockwise from north (up)
+    double altitude = 45.0;        // Degrees above the horizon
+    double zFactor = 1.0;          // Elevation units per cell spacing, e.g. 0.02 for metres on 50 m cells
+    bool multidirectional = false; // Blend sun from 225, 270, 315, and 360 degrees, weighted by aspect
+};
 
 /**
  * @brief SlopeAnalyser class that allows determination of gradient and aspect maps from a given
@@ -49,6 +60,59 @@ public:
      */
     Map<T> computeDirection(void);
 
+    /**
+     * @brief Create a hillshade map from _elevationMap
+     * 
+     * @param options Sun position and z factor
+     * @return Map<T> Illumination from 0 (shadow) to 255 (facing the sun)
+     */
+    Map<T> computeHillshade(const HillshadeOptions& options = HillshadeOptions());
+
+    /**
+     * @brief Fused sweep: each 3x3 neighbourhood is read once and every requested product
+     * is written from the same Sobel sums. Tiles run in parallel.
+     * Slope and aspect match computeSlope("combined") and computeDirection().
+     * 
+     * @param slopeMap Output gradient magnitude, nullptr to skip
+     * @param aspectMap Output aspect, nullptr to skip
+     * @param hillshadeMap Output hillshade, nullptr to skip
+     * @param options Hillshade sun position and z factor
+     */
+    void computeSurface(Map<T>* slopeMap, Map<T>* aspectMap, Map<T>* hillshadeMap,
+        const HillshadeOptions& options = HillshadeOptions());
+
+    /**
+     * @brief Fused sweep between tile sources and sinks, e.g. .bin files too large to load.
+     * Edges are reflected through the tile halo, as in computeSurface() on Maps.
+     * 
+     * @param elevation Elevation grid
+     * @param slope Output gradient magnitude, nullptr to skip
+     * @param aspect Output aspect, nullptr to skip
+     * @param hillshade Output hillshade, nullptr to skip
+     * @param options Hillshade sun position and z factor
+     * @return true If every tile was read and written
+     */
+    static bool computeSurface(const TileSource<T>& elevation, TileSink<T>* slope, TileSink<T>* aspect,
+        TileSink<T>* hillshade, const HillshadeOptions& options = HillshadeOptions());
+
+    /**
+     * @brief Overall gradient magnitude at a single cell, as in computeSlope("combined")
+     * 
+     * @param x Coord in row
+     * @param y Coord in column
+     * @return T 
+     */
+    T slopeAt(int x, int y) const;
+
+    /**
+     * @brief Aspect at a single cell, as in computeDirection()
+     * 
+     * @param x Coord in row
+     * @param y Coord in column
+     * @return T Aspect in degrees, -1 for flat cells
+     */
+    T directionAt(int x, int y) const;
+
 private:
     // Stored elevation map from constructor
     const Map<T>& _elevationMap;
@@ -65,6 +129,26 @@ private:
         { 1,  2,  1}
     };
 
+    /**
+     * @brief Apply sobel kernels about a cell with reflected edges
+     * 
+     * @param x Coord in row
+     * @param y Coord in column
+     * @param Gx Output gradient in x direction
+     * @param Gy Output gradient in y direction
+     */
+    void sobelAt(int x, int y, int& Gx, int& Gy) const;
+
+    /**
+     * @brief Gradient magnitude from Sobel sums
+     */
+    static T slopeFromSobel(int Gx, int Gy);
+
+    /**
+     * @brief Aspect from Sobel sums, -1 for flat cells
+     */
+    static T directionFromSobel(int Gx, int Gy);
+
     /**
      * @brief Overall magnitude gradient map algorithm
      * @return Map<T> 
@@ -0,0 +1,297 @@
+/**
+ * @file StreamNetwork.cpp
+ * @author Ollie
+ * @brief Stream network extraction with Strahler and Shreve ordering
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "StreamNetwork.h"
+#include <iostream>
+#include <fstream>
+
+/**
+ * @brief Construct a new Stream Network<elevationT>:: Stream Network object
+ */
+template <typename elevationT>
+StreamNetwork<elevationT>::StreamNetwork(const Map<elevationT>& flow, const Map<int>& D8)
+    : _flowMap(flow), _D8Map(D8), _width(flow.getWidth()), _height(flow.getHeight()),
+    _strahlerMap(flow.getWidth(), flow.getHeight()), _shreveMap(flow.getWidth(), flow.getHeight()),
+    _linkMap(flow.getWidth(), flow.getHeight()) {
+
+    if (D8.getWidth() != _width || D8.getHeight() != _height) {
+        std::cerr << "Error: Flow and D8 maps for StreamNetwork must be the same size." << std::endl;
+    }
+}
+
+/**
+ * @brief Threshold channels then run a single topological pass for orders and links
+ */
+template <typename elevationT>
+void StreamNetwork<elevationT>::extractStreams(double threshold) {
+    const int n = _width * _height;
+    _strahlerMap = Map<int>(_width, _height);
+    _shreveMap = Map<int>(_width, _height);
+    _links.clear();
+    _junctions.clear();
+    _outlets.clear();
+
+    // Channel mask and receivers
+    std::vector<char> isStream(n, 0);
+    std::vector<int> receiver(n, -1);
+    for (int y = 0; y < _height; y++) {
+        for (int x = 0; x < _width; x++) {
+            if (_flowMap.getData(x, y) >= threshold) {
+                isStream[y * _width + x] = 1;
+            }
+        }
+    }
+
+    // Count channel donors of every channel cell
+    std::vector<int> donors(n, 0);
+    for (int y = 0; y < _height; y++) {
+        for (int x = 0; x < _width; x++) {
+            int cell = y * _width + x;
+            if (!isStream[cell]) continue;
+            int r = getReceiver(x, y);
+            if (r != -1 && isStream[r]) {
+                receiver[cell] = r;
+                donors[r]++;
+            }
+        }
+    }
+    std::vector<int> remaining = donors;
+
+    // Per cell ordering state, filled in from upstream
+    std::vector<int> maxOrder(n, 0);
+    std::vector<int> maxOrderCount(n, 0);
+    std::vector<int> magnitude(n, 0);
+    std::vector<int> linkOf(n, -1);
+
+    // Channel heads (sources) start the pass
+    std::vector<int> queue;
+    queue.reserve(n);
+    for (int cell = 0; cell < n; cell++) {
+        if (isStream[cell] && donors[cell] == 0) {
+            queue.push_back(cell);
+        }
+    }
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        int cell = queue[head];
+        int x = cell % _width;
+        int y = cell / _width;
+
+        // Finalise orders from donors
+        int strahler, shreve;
+        if (donors[cell] == 0) {
+            strahler = 1;
+            shreve = 1;
+        }
+        else {
+            strahler = (maxOrderCount[cell] >= 2) ? maxOrder[cell] + 1 : maxOrder[cell];
+            shreve = magnitude[cell];
+        }
+        _strahlerMap.setData(x, y, strahler);
+        _shreveMap.setData(x, y, shreve);
+
+        // Sources and junctions start a new link, otherwise continue the donor's link
+        if (donors[cell] != 1) {
+            if (donors[cell] >= 2) {
+                _junctions.push_back(cell);
+            }
+            linkOf[cell] = _links.size();
+            _links.push_back({static_cast<int>(_links.size()), cell, cell, 0, strahler, shreve, -1});
+        }
+        StreamLink& link = _links[linkOf[cell]];
+        link.outletCell = cell;
+        link.length++;
+
+        // Push state to receiver
+        int r = receiver[cell];
+        if (r == -1) {
+            _outlets.push_back(link.id);
+            continue;
+        }
+        if (strahler > maxOrder[r]) {
+            maxOrder[r] = strahler;
+            maxOrderCount[r] = 1;
+        }
+        else if (strahler == maxOrder[r]) {
+            maxOrderCount[r]++;
+        }
+        magnitude[r] += shreve;
+        if (donors[r] == 1) {
+            linkOf[r] = link.id;
+        }
+        if (--remaining[r] == 0) {
+            queue.push_back(r);
+        }
+    }
+
+    // Channel cells on a D8 cycle (flats) keep a donor inside the cycle, so the pass never
+    // reaches them. A cycle drains nowhere: close it as one outlet link ordered from the
+    // channels flowing into it, whose state was already pushed to the cycle cells
+    std::vector<int> cycle;
+    for (int start = 0; start < n; start++) {
+        if (!isStream[start] || remaining[start] == 0) continue;
+
+        cycle.clear();
+        int cell = start;
+        do {
+            cycle.push_back(cell);
+            remaining[cell] = 0;
+            cell = receiver[cell];
+        } while (cell != start && cell != -1);
+
+        int order = 0;
+        int orderCount = 0;
+        int inflow = 0;
+        int externalDonors = 0;
+        for (int c : cycle) {
+            if (maxOrder[c] > order) {
+                order = maxOrder[c];
+                orderCount = maxOrderCount[c];
+            }
+            else if (maxOrder[c] == order) {
+                orderCount += maxOrderCount[c];
+            }
+            inflow += magnitude[c];
+            externalDonors += donors[c] - 1;
+        }
+        int strahler = (externalDonors == 0) ? 1 : ((orderCount >= 2) ? order + 1 : order);
+        int shreve = (externalDonors == 0) ? 1 : inflow;
+
+        if (externalDonors >= 2) {
+            _junctions.push_back(start);
+        }
+        int id = static_cast<int>(_links.size());
+        _links.push_back({id, start, cycle.back(), static_cast<int>(cycle.size()), strahler, shreve, -1});
+        _outlets.push_back(id);
+        for (int c : cycle) {
+            linkOf[c] = id;
+            _strahlerMap.setData(c % _width, c / _width, strahler);
+            _shreveMap.setData(c % _width, c / _width, shreve);
+        }
+    }
+
+    // Links ending above a junction drain into the link starting there. A cycle's link ends
+    // above its own head
+    for (auto& link : _links) {
+        int r = receiver[link.outletCell];
+        if (r != -1 && linkOf[r] != -1 && linkOf[r] != link.id) {
+            link.downstreamLink = linkOf[r];
+        }
+    }
+
+    _linkMap = Map<int>(_width, _height);
+    for (int cell = 0; cell < n; cell++) {
+        _linkMap.setData(cell % _width, cell / _width, linkOf[cell]);
+    }
+}
+
+/**
+ * @brief Return Strahler order map
+ */
+template <typename elevationT>
+Map<int> StreamNetwork<elevationT>::getStrahlerMap(void) const {
+    return _strahlerMap;
+}
+
+/**
+ * @brief Return Shreve magnitude map
+ */
+template <typename elevationT>
+Map<int> StreamNetwork<elevationT>::getShreveMap(void) const {
+    return _shreveMap;
+}
+
+/**
+ * @brief Return link id map
+ */
+template <typename elevationT>
+Map<int> StreamNetwork<elevationT>::getLinkMap(void) const {
+    return _linkMap;
+}
+
+/**
+ * @brief Return links of segment graph
+ */
+template <typename elevationT>
+const std::vector<StreamLink>& StreamNetwork<elevationT>::getLinks(void) const {
+    return _links;
+}
+
+/**
+ * @brief Return junction cells
+ */
+template <typename elevationT>
+const std::vector<int>& StreamNetwork<elevationT>::getJunctions(void) const {
+    return _junctions;
+}
+
+/**
+ * @brief Return outlet link ids
+ */
+template <typename elevationT>
+const std::vector<int>& StreamNetwork<elevationT>::getOutlets(void) const {
+    return _outlets;
+}
+
+/**
+ * @brief Save links as csv table
+ */
+template <typename elevationT>
+bool StreamNetwork<elevationT>::saveLinksToCSV(const std::string& filename) const {
+    std::ofstream file(filename.c_str());
+
+    // Check successful opening
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    // Links with no links draining into them start at a channel head
+    std::vector<bool> hasUpstream(_links.size(), false);
+    for (const auto& link : _links) {
+        if (link.downstreamLink >= 0) hasUpstream[link.downstreamLink] = true;
+    }
+
+    file << "id,head_x,head_y,outlet_x,outlet_y,length,strahler,shreve,downstream_link,head_type" << std::endl;
+    for (const auto& link : _links) {
+        bool isSource = !hasUpstream[link.id];
+        file << link.id << ","
+             << link.headCell % _width << "," << link.headCell / _width << ","
+             << link.outletCell % _width << "," << link.outletCell / _width << ","
+             << link.length << "," << link.strahler << "," << link.shreve << ","
+             << link.downstreamLink << "," << (isSource ? "source" : "junction") << std::endl;
+    }
+    return true;
+}
+
+/**
+ * @brief Receiver of cell (x, y) from D8 directions
+ */
+template <typename elevationT>
+int StreamNetwork<elevationT>::getReceiver(int x, int y) const {
+    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    int direction = _D8Map.getData(x, y);
+    if (direction < 0 || direction > 7) {
+        return -1;
+    }
+    int nx = x + dx[direction];
+    int ny = y + dy[direction];
+    if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) {
+        return -1;
+    }
+    return ny * _width + nx;
+}
+
+// Instantiation
+template class StreamNetwork<double>;
+template class StreamNetwork<float>;
+template class StreamNetwork<int>;
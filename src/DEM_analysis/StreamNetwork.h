@@ -0,0 +1,113 @@
+/**
+ * @file StreamNetwork.h
+ * @author Ollie
+ * @brief Stream network extraction with Strahler and Shreve ordering
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef STREAMNETWORK_H
+#define STREAMNETWORK_H
+
+#include "../map_core/Map.h"
+#include <vector>
+#include <string>
+
+/**
+ * @brief Channel segment between a source or junction and the next junction or outlet.
+ * Cells are stored as linear indexes (y * width + x).
+ */
+struct StreamLink {
+    int id;
+    int headCell;       // Upstream-most cell (source or junction)
+    int outletCell;     // Downstream-most cell of link
+    int length;         // Number of cells in link
+    int strahler;
+    int shreve;
+    int downstreamLink; // -1 if link is a network outlet
+};
+
+/**
+ * @brief Class that extracts channel networks from a flow accumulation map and D8 directions.
+ * Cells with accumulation above a threshold are considered channels. Strahler and Shreve
+ * orders, and the link (segment) graph, are computed in a single topological pass over
+ * the D8 receivers from channel heads downstream: O(n) for n cells. Channels on a D8 cycle
+ * (receivers pointing at each other on a flat) form one outlet link, ordered from the channels
+ * flowing into the cycle.
+ *
+ * @see FlowAccumulation.h
+ * @see D8FlowAnalyser.h
+ * @tparam elevationT Numeric types: double, float, int
+ */
+template <typename elevationT>
+class StreamNetwork {
+public:
+    /**
+     * @brief Construct a new Stream Network object
+     *
+     * @param flow Reference to D8 flow accumulation map
+     * @param D8 Reference to D8 directions map
+     */
+    StreamNetwork(const Map<elevationT>& flow, const Map<int>& D8);
+
+    /**
+     * @brief Threshold accumulation and order the resulting network
+     *
+     * @param threshold Minimum accumulation (cells) for a cell to be a channel
+     */
+    void extractStreams(double threshold);
+
+    /// @return Map<int> of Strahler order per cell, 0 for non-channel cells
+    Map<int> getStrahlerMap(void) const;
+
+    /// @return Map<int> of Shreve magnitude per cell, 0 for non-channel cells
+    Map<int> getShreveMap(void) const;
+
+    /// @return Map<int> of link id per cell, -1 for non-channel cells
+    Map<int> getLinkMap(void) const;
+
+    /// @return Links of the segment graph, indexed by StreamLink::id
+    const std::vector<StreamLink>& getLinks(void) const;
+
+    /// @return Linear indexes of junction cells (two or more channels join)
+    const std::vector<int>& getJunctions(void) const;
+
+    /// @return Ids of links that leave the network (edge, pit, or off-map flow)
+    const std::vector<int>& getOutlets(void) const;
+
+    /**
+     * @brief Save segment graph as a csv file, one row per link.
+     * Columns: id, head_x, head_y, outlet_x, outlet_y, length, strahler, shreve,
+     * downstream_link, head_type (source if no link drains into it, otherwise junction)
+     *
+     * @param filename Full file pathway with .csv extension
+     * @return true
+     * @return false
+     */
+    bool saveLinksToCSV(const std::string& filename) const;
+
+private:
+    const Map<elevationT>& _flowMap;
+    const Map<int>& _D8Map;
+    int _width, _height;
+
+    Map<int> _strahlerMap;
+    Map<int> _shreveMap;
+    Map<int> _linkMap;
+    std::vector<StreamLink> _links;
+    std::vector<int> _junctions;
+    std::vector<int> _outlets;
+
+    /**
+     * @brief Downstream receiver of a cell from _D8Map
+     *
+     * @param x Coord in row
+     * @param y Coord in column
+     * @return int Linear index of receiver, -1 if none or off map
+     */
+    int getReceiver(int x, int y) const;
+};
+
+#endif
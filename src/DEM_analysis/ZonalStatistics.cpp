@@ -0,0 +1,184 @@
+/**
+ * @file ZonalStatistics.cpp
+ * @author Ollie
+ * @brief Per-zone (basin) statistics of value maps from a label raster
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "ZonalStatistics.h"
+#include "../parallel/parallelFor.h"
+#include <iostream>
+#include <fstream>
+#include <limits>
+#include <algorithm>
+
+/**
+ * @brief Running sums of one value map over one zone
+ */
+struct ZoneAccumulator {
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+};
+
+/**
+ * @brief Construct a new Zonal Statistics<T>:: Zonal Statistics object
+ */
+template <typename T>
+ZonalStatistics<T>::ZonalStatistics(const Map<int>& labels, const Map<T>& elevation, double cellArea)
+    : _labels(labels), _width(labels.getWidth()), _height(labels.getHeight()), _cellArea(cellArea) {
+
+    if (!addValueMap("elevation", elevation)) {
+        std::cerr << "Error: Labels and elevation map for ZonalStatistics must be the same size." << std::endl;
+    }
+}
+
+/**
+ * @brief Add value map
+ */
+template <typename T>
+bool ZonalStatistics<T>::addValueMap(const std::string& name, const Map<T>& map) {
+    if (map.getWidth() != _width || map.getHeight() != _height) {
+        std::cerr << "Error: Value map '" << name << "' does not match label map size." << std::endl;
+        return false;
+    }
+    _names.push_back(name);
+    _maps.push_back(&map);
+    return true;
+}
+
+/**
+ * @brief Single parallel pass with per-thread accumulators
+ */
+template <typename T>
+const std::vector<ZoneStats>& ZonalStatistics<T>::compute(void) {
+    _zones.clear();
+    const int nThreads = getThreadCount();
+    const int nMaps = _maps.size();
+
+    // Distinct labels, so accumulators grow with the zones present rather than the largest
+    // label (e.g. sparse link ids)
+    std::vector<std::vector<int>> threadLabels(nThreads);
+    parallelFor(0, _height, nThreads, [&](int t, int y0, int y1) {
+        std::vector<int>& found = threadLabels[t];
+        for (int y = y0; y < y1; y++) {
+            for (int x = 0; x < _width; x++) {
+                int label = _labels.getData(x, y);
+                // Neighbouring cells mostly share a zone
+                if (label >= 0 && (found.empty() || found.back() != label)) found.push_back(label);
+            }
+        }
+        std::sort(found.begin(), found.end());
+        found.erase(std::unique(found.begin(), found.end()), found.end());
+    });
+    std::vector<int> zoneLabels;
+    for (const std::vector<int>& found : threadLabels) {
+        zoneLabels.insert(zoneLabels.end(), found.begin(), found.end());
+    }
+    std::sort(zoneLabels.begin(), zoneLabels.end());
+    zoneLabels.erase(std::unique(zoneLabels.begin(), zoneLabels.end()), zoneLabels.end());
+    int nZones = static_cast<int>(zoneLabels.size());
+    if (nZones == 0 || nMaps == 0) {
+        return _zones;
+    }
+
+    // Accumulators laid out [zone][map] per thread, zones in ascending label order
+    std::vector<std::vector<int>> counts(nThreads);
+    std::vector<std::vector<ZoneAccumulator>> sums(nThreads);
+    parallelFor(0, _height, nThreads, [&](int t, int y0, int y1) {
+        std::vector<int>& count = counts[t];
+        std::vector<ZoneAccumulator>& acc = sums[t];
+        count.assign(nZones, 0);
+        acc.assign(static_cast<size_t>(nZones) * nMaps, ZoneAccumulator());
+
+        int lastLabel = -1;
+        int z = -1;
+        for (int y = y0; y < y1; y++) {
+            for (int x = 0; x < _width; x++) {
+                int label = _labels.getData(x, y);
+                if (label < 0) continue;
+                if (label != lastLabel) {
+                    z = static_cast<int>(std::lower_bound(zoneLabels.begin(), zoneLabels.end(), label) - zoneLabels.begin());
+                    lastLabel = label;
+                }
+                count[z]++;
+                ZoneAccumulator* zone = &acc[static_cast<size_t>(z) * nMaps];
+                for (int m = 0; m < nMaps; m++) {
+                    double value = _maps[m]->getData(x, y);
+                    zone[m].sum += value;
+                    zone[m].min = std::min(zone[m].min, value);
+                    zone[m].max = std::max(zone[m].max, value);
+                }
+            }
+        }
+    });
+
+    // Merge threads into first, skipping threads that got no rows
+    std::vector<int>& count = counts[0];
+    std::vector<ZoneAccumulator>& acc = sums[0];
+    for (int t = 1; t < nThreads; t++) {
+        if (counts[t].empty()) continue;
+        for (int z = 0; z < nZones; z++) {
+            count[z] += counts[t][z];
+        }
+        for (size_t i = 0; i < acc.size(); i++) {
+            acc[i].sum += sums[t][i].sum;
+            acc[i].min = std::min(acc[i].min, sums[t][i].min);
+            acc[i].max = std::max(acc[i].max, sums[t][i].max);
+        }
+    }
+
+    for (int z = 0; z < nZones; z++) {
+        if (count[z] == 0) continue;
+        ZoneStats zone;
+        zone.label = zoneLabels[z];
+        zone.cells = count[z];
+        zone.area = count[z] * _cellArea;
+        for (int m = 0; m < nMaps; m++) {
+            const ZoneAccumulator& a = acc[static_cast<size_t>(z) * nMaps + m];
+            zone.values.push_back({a.sum / count[z], a.min, a.max});
+        }
+        const ZoneValueStats& elevation = zone.values[0];
+        double relief = elevation.max - elevation.min;
+        zone.hypsometricIntegral = (relief > 0) ? (elevation.mean - elevation.min) / relief : 0.0;
+        _zones.push_back(zone);
+    }
+    return _zones;
+}
+
+/**
+ * @brief Save zones as csv table
+ */
+template <typename T>
+bool ZonalStatistics<T>::saveToCSV(const std::string& filename) const {
+    std::ofstream file(filename.c_str());
+
+    // Check successful opening
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    file << "label,cells,area,hypsometric_integral";
+    for (const auto& name : _names) {
+        file << "," << name << "_mean," << name << "_min," << name << "_max";
+    }
+    file << std::endl;
+
+    for (const auto& zone : _zones) {
+        file << zone.label << "," << zone.cells << "," << zone.area << "," << zone.hypsometricIntegral;
+        for (const auto& value : zone.values) {
+            file << "," << value.mean << "," << value.min << "," << value.max;
+        }
+        file << std::endl;
+    }
+    return true;
+}
+
+// Instantiation
+template class ZonalStatistics<double>;
+template class ZonalStatistics<float>;
+template class ZonalStatistics<int>;
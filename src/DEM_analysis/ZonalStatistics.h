@@ -0,0 +1,100 @@
+/**
+ * @file ZonalStatistics.h
+ * @author Ollie
+ * @brief Per-zone (basin) statistics of value maps from a label raster
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef ZONALSTATISTICS_H
+#define ZONALSTATISTICS_H
+
+#include "../map_core/Map.h"
+#include <vector>
+#include <string>
+
+/**
+ * @brief Summary of a single value map over one zone
+ */
+struct ZoneValueStats {
+    double mean;
+    double min;
+    double max;
+};
+
+/**
+ * @brief Statistics of one zone. values are in the order value maps were added.
+ */
+struct ZoneStats {
+    int label;
+    int cells;
+    double area;
+    double hypsometricIntegral; // (mean - min) / (max - min) of elevation, 0 if flat
+    std::vector<ZoneValueStats> values;
+};
+
+/**
+ * @brief Class that computes statistics for every zone of a label raster in one pass.
+ * Cells with a negative label belong to no zone. The first value map is the elevation
+ * map, which is also used for the hypsometric integral. Any number of other maps (slope,
+ * flow accumulation, ...) can be added and are summarised by mean, min, and max.
+ *
+ * Rows are split across threads, each with its own accumulators, which are merged at
+ * the end: O(n * m / threads) for n cells and m value maps. Accumulators are kept for the
+ * distinct labels present, so labels may be sparse (e.g. stream link ids).
+ *
+ * @see parallelFor.h
+ * @tparam T Numeric types: double, float, int
+ */
+template <typename T>
+class ZonalStatistics {
+public:
+    /**
+     * @brief Construct a new Zonal Statistics object
+     *
+     * @param labels Zone label per cell, -1 for no zone
+     * @param elevation Elevation map (DEM)
+     * @param cellArea Area of a single cell in output units
+     */
+    ZonalStatistics(const Map<int>& labels, const Map<T>& elevation, double cellArea = 1.0);
+
+    /**
+     * @brief Add another map to summarise. Must match label raster size.
+     *
+     * @param name Column prefix in output table (e.g. "slope")
+     * @param map Reference to value map, kept until compute()
+     * @return true
+     * @return false If map size does not match
+     */
+    bool addValueMap(const std::string& name, const Map<T>& map);
+
+    /**
+     * @brief Compute statistics of every zone
+     *
+     * @return const std::vector<ZoneStats>& Zones with at least one cell, by ascending label
+     */
+    const std::vector<ZoneStats>& compute(void);
+
+    /**
+     * @brief Save statistics as csv table, one row per zone.
+     * Columns: label, cells, area, hypsometric_integral, then <name>_mean, <name>_min,
+     * <name>_max for elevation and each added map
+     *
+     * @param filename Full file pathway with .csv extension
+     * @return true
+     * @return false
+     */
+    bool saveToCSV(const std::string& filename) const;
+
+private:
+    const Map<int>& _labels;
+    int _width, _height;
+    double _cellArea;
+    std::vector<std::string> _names;
+    std::vector<const Map<T>*> _maps;
+    std::vector<ZoneStats> _zones;
+};
+
+#endif
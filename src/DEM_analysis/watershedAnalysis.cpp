@@ -9,9 +9,15 @@
  * 
  */
 #include "watershedAnalysis.h"
+#include "../parallel/parallelFor.h"
+#include "../profiling/Profiler.h"
 #include <queue>
 #include <stack>
+#include <unordered_map>
+#include <algorithm>
 #include <iostream>
+#include <functional>
+#include <cmath>
 
 /**
  * @brief Construct watershedAnalysis class for watershed delineation
@@ -32,20 +38,38 @@ watershedAnalysis<elevationT, D8T>::watershedAnalysis(
  * @brief Delegation method for pour points identification
  */
 template<typename elevationT, typename D8T>
-std::vector<std::pair<int, int>> watershedAnalysis<elevationT, D8T>::getPourPoints(int nPoints, const std::string method) {
+std::vector<std::pair<int, int>> watershedAnalysis<elevationT, D8T>::getPourPoints(int nPoints, const std::string method, int clusterRadius) {
+    ProfileScope scope("pour_points", "kernel", static_cast<uint64_t>(_width) * _height);
+
+    // Oversample candidates so enough remain once near-duplicates are merged
+    const int CANDIDATE_FACTOR = 8;
+    int nCandidates = (clusterRadius > 0) ? nPoints * CANDIDATE_FACTOR : nPoints;
+
+    std::vector<std::pair<int, int>> candidates;
     if (method == "d8") {
-        return D8PourPoints(nPoints);
+        candidates = D8PourPoints(nCandidates);
     }
     else if (method == "dinf") {
-        return DinfPourPoints(nPoints);
+        candidates = DinfPourPoints(nCandidates);
     }
     else if (method == "mdf") {
-        return MDFPourPoints(nPoints);
+        candidates = MDFPourPoints(nCandidates);
     }
     else {
         std::cerr << "Error: Unsupported method." << std::endl;
         return std::vector<std::pair<int ,int>>();
     }
+
+    if (clusterRadius <= 0) {
+        return candidates;
+    }
+
+    // Keep the nPoints distinct outlets with the largest flow (list is ascending)
+    std::vector<std::pair<int, int>> outlets = clusterPourPoints(candidates, clusterRadius);
+    if (static_cast<int>(outlets.size()) > nPoints) {
+        outlets.erase(outlets.begin(), outlets.end() - nPoints);
+    }
+    return outlets;
 }
 
 /**
@@ -53,6 +77,7 @@ std::vector<std::pair<int, int>> watershedAnalysis<elevationT, D8T>::getPourPoin
  */
 template<typename elevationT, typename D8T>
 Map<elevationT> watershedAnalysis<elevationT, D8T>::calculateWatershed(std::pair<int, int> Point, const std::string method) {
+    ProfileScope scope("watershed_delineation", "kernel", static_cast<uint64_t>(_width) * _height);
     if (method == "d8") {
         return D8watershed(Point);
     }
@@ -68,6 +93,90 @@ Map<elevationT> watershedAnalysis<elevationT, D8T>::calculateWatershed(std::pair
     }
 }
 
+/**
+ * @brief Label unlabelled cells of watershed
+ */
+template<typename elevationT, typename D8T>
+void watershedAnalysis<elevationT, D8T>::markWatershed(const Map<elevationT>& watershed, int label, Map<int>& labels) const {
+    for (int y = 0; y < _height; y++) {
+        for (int x = 0; x < _width; x++) {
+            if (watershed.getData(x, y) != 0 && labels.getData(x, y) < 0) {
+                labels.setData(x, y, label);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Label raster of watersheds of every point
+ */
+template<typename elevationT, typename D8T>
+Map<int> watershedAnalysis<elevationT, D8T>::labelWatersheds(const std::vector<std::pair<int, int>>& points, const std::string method) {
+    Map<int> labels(_width, _height, -1);
+
+    // Delineate a wave of points at a time on the pool, then label in point order so earlier
+    // points keep shared cells. Waves bound the full size watershed maps held at once
+    int wave = getWaveSize(static_cast<uint64_t>(_width) * _height);
+    for (size_t first = 0; first < points.size(); first += wave) {
+        size_t last = std::min(points.size(), first + wave);
+        std::vector<Map<elevationT>> watersheds(last - first);
+        parallelFor(0, static_cast<int>(last - first), wave, [&](int, int i0, int i1) {
+            for (int i = i0; i < i1; i++) {
+                watersheds[i] = calculateWatershed(points[first + i], method);
+            }
+        });
+        for (size_t i = first; i < last; i++) {
+            markWatershed(watersheds[i - first], i, labels);
+        }
+    }
+    return labels;
+}
+
+/**
+ * @brief Threads limited by the memory of their watershed maps
+ */
+template<typename elevationT, typename D8T>
+int watershedAnalysis<elevationT, D8T>::getWaveSize(uint64_t cells) {
+    uint64_t mapBytes = std::max<uint64_t>(1, cells) * sizeof(elevationT);
+    uint64_t fit = std::max<uint64_t>(1, WATERSHED_WAVE_MB * 1024 * 1024 / mapBytes);
+    return static_cast<int>(std::min<uint64_t>(getThreadCount(), fit));
+}
+
+/**
+ * @brief Set basin tree used by D8 queries
+ */
+template<typename elevationT, typename D8T>
+void watershedAnalysis<elevationT, D8T>::setBasinTree(const BasinTree* tree) {
+    _basinTree = tree;
+}
+
+/**
+ * @brief Sub-basin enumeration through basin tree
+ */
+template<typename elevationT, typename D8T>
+std::vector<std::pair<int, int>> watershedAnalysis<elevationT, D8T>::getSubBasins(std::pair<int, int> Point, double minArea) {
+    std::vector<std::pair<int, int>> outlets;
+    if (!_basinTree) {
+        std::cerr << "Error: Sub-basin queries require a basin tree." << std::endl;
+        return outlets;
+    }
+
+    // Basin whose outlet is Point, otherwise the basin Point drains into
+    int node = _basinTree->getBasinWithOutlet(Point.first, Point.second);
+    if (node == -1) {
+        node = _basinTree->getBasinAt(Point.first, Point.second);
+    }
+    if (node == -1) {
+        return outlets;
+    }
+
+    for (int id : _basinTree->getSubBasins(node, minArea)) {
+        int cell = _basinTree->getNode(id).outletCell;
+        outlets.push_back({cell % _width, cell / _width});
+    }
+    return outlets;
+}
+
 /**
  * @brief D8 Pour point identification method
 Previous implementation of identifying pour points used sorting.
@@ -85,64 +194,100 @@ struct PointWithFlow {
 
     // overloaded operators as originals had unexpected behaviours
     // Do not remove
+    // Equal flows rank the earlier cell (row-major) higher, so the top N found by parallel
+    // scans does not depend on how rows were split
     bool operator>(const PointWithFlow& other) const {
-        return flowValue > other.flowValue;
+        return other < *this;
     }
     bool operator<(const PointWithFlow& other) const {
-        return flowValue < other.flowValue;
+        if (flowValue != other.flowValue) return flowValue < other.flowValue;
+        if (y != other.y) return y > other.y;
+        return x > other.x;
     }
 };
 
-template<typename elevationT, typename D8T>
-std::vector<std::pair<int, int>> watershedAnalysis<elevationT, D8T>::D8PourPoints(int nPoints) {
-    // D8 directions from index (0-7)
-    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
-    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
-    std::vector<std::pair<int, int>> Points;
-
-    // Create priority queue (min-heap based on flow value) of ascending flow accumulation
-    std::priority_queue<PointWithFlow, std::vector<PointWithFlow>, std::greater<PointWithFlow>> minHeap;
-
-    // iterate cells in Maps
-    for (int y = 0; y < _height; y++) {
-        for (int x = 0; x < _width; x++) {
-            int flowDir = _D8Map->getData(x, y);
-            bool isPourPoint = false;
-
-            if (flowDir == -1) {
-                isPourPoint = true;  // No forward flow direction -> pour point
-            }
-            else {
-                int nx = x + dx[flowDir];
-                int ny = y + dy[flowDir];
-
-                // Out of bounds check
-                if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) {
-                    isPourPoint = true;  // Flow out of map boundary -> pour point
-                }
-            }
-
-            if (isPourPoint) {
-                double flowValue = _flowMap->getData(x, y);
+/**
+ * @brief The nPoints cells passing isPourPoint(x, y) with the largest flow, ascending by flow.
+ * Row chunks are scanned on the pool, each keeping its own top nPoints in a min-heap, and the
+ * chunk results are merged in row order.
+ */
+template<typename elevationT, typename Test>
+static std::vector<std::pair<int, int>> topPourPoints(const Map<elevationT>& flow, int nPoints, Test isPourPoint) {
+    int width = flow.getWidth();
+    int height = flow.getHeight();
+    size_t keep = static_cast<size_t>(std::max(0, nPoints));
+
+    // Ascending top points of rows [y0, y1)
+    auto scanRows = [&](int y0, int y1) {
+        // Create priority queue (min-heap based on flow value) of ascending flow accumulation
+        std::priority_queue<PointWithFlow, std::vector<PointWithFlow>, std::greater<PointWithFlow>> minHeap;
+        for (int y = y0; y < y1; y++) {
+            for (int x = 0; x < width; x++) {
+                if (!isPourPoint(x, y)) continue;
                 // Push current point into queue
-                minHeap.push({x, y, flowValue});
+                minHeap.push({x, y, static_cast<double>(flow.getData(x, y))});
 
                 // Keep only nPoints with the largest flow values
-                if (minHeap.size() > nPoints) {
+                if (minHeap.size() > keep) {
                     minHeap.pop();  // Remove the smallest flow value
                 }
             }
         }
-    }
-    // Extract top nPoints from the heap (in terms of flow value)
-    while (!minHeap.empty()) {
-        PointWithFlow p = minHeap.top();
+        std::vector<PointWithFlow> top;
+        while (!minHeap.empty()) {
+            top.push_back(minHeap.top());
+            minHeap.pop();
+        }
+        return top;
+    };
+    // Two ascending lists to the largest keep of both, still ascending
+    auto mergeTop = [keep](const std::vector<PointWithFlow>& a, const std::vector<PointWithFlow>& b) {
+        std::vector<PointWithFlow> merged(a.size() + b.size());
+        std::merge(a.begin(), a.end(), b.begin(), b.end(), merged.begin());
+        if (merged.size() > keep) {
+            merged.erase(merged.begin(), merged.end() - keep);
+        }
+        return merged;
+    };
+
+    std::vector<PointWithFlow> top = parallelReduce(0, height, getThreadCount(), std::vector<PointWithFlow>(),
+                                                    scanRows, mergeTop);
+
+    // Extract top nPoints (in terms of flow value)
+    std::vector<std::pair<int, int>> Points;
+    for (const PointWithFlow& p : top) {
         Points.push_back({p.x, p.y});
-        minHeap.pop();
     }
     return Points;
 }
 
+template<typename elevationT, typename D8T>
+std::vector<std::pair<int, int>> watershedAnalysis<elevationT, D8T>::D8PourPoints(int nPoints) {
+    // D8 directions from index (0-7)
+    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    // No forward flow direction, or flow out of the map boundary
+    return topPourPoints(*_flowMap, nPoints, [&](int x, int y) {
+        int flowDir = _D8Map->getData(x, y);
+        bool isPourPoint = false;
+
+        if (flowDir == -1) {
+            isPourPoint = true;  // No forward flow direction -> pour point
+        }
+        else {
+            int nx = x + dx[flowDir];
+            int ny = y + dy[flowDir];
+
+            // Out of bounds check
+            if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) {
+                isPourPoint = true;  // Flow out of map boundary -> pour point
+            }
+        }
+        return isPourPoint;
+    });
+}
+
 /**
  * @brief Dinf pour points algorithm
  */
@@ -154,72 +299,47 @@ std::vector<std::pair<int, int>> watershedAnalysis<elevationT, D8T>::DinfPourPoi
     // D8 directions from index (0-7)
     int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
     int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
-    std::vector<std::pair<int, int>> Points;
 
-    // Create priority queue (min-heap based on flow value) of ascending flow accumulation
-    std::priority_queue<PointWithFlow, std::vector<PointWithFlow>, std::greater<PointWithFlow>> minHeap;
+    return topPourPoints(*_flowMap, nPoints, [&](int x, int y) {
+        // vars for condition checking
+        bool allHigherElevation = true;
+        bool hasFlowingNeighbor = false;
+        double currentElevation = _elevationMap.getData(x, y);
 
-    // Iterate through all cells
-    for (int y = 0; y < _height; y++) {
-        for (int x = 0; x < _width; x++) {
-            // vars for condition checking
-            bool allHigherElevation = true;
-            bool hasFlowingNeighbor = false;
-            double currentElevation = _elevationMap.getData(x, y);
-
-            // Check all 8 neighbors
-            for (int i = 0; i < 8; i++) {
-                int nx = x + dx[i];
-                int ny = y + dy[i];
-
-                // Out of bounds check
-                if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) {
-                    continue;
-                }
+        // Check all 8 neighbors
+        for (int i = 0; i < 8; i++) {
+            int nx = x + dx[i];
+            int ny = y + dy[i];
 
-                double neighbourElevation = _elevationMap.getData(nx, ny);
-                double neighbourAspect = _aspectMap->getData(nx, ny);
-
-                // Elevation check
-                if (neighbourElevation < currentElevation) {
-                    allHigherElevation = false;
-                }
+            // Out of bounds check
+            if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) {
+                continue;
+            }
 
-                // Get directions that the neighbor cell's aspect points to
-                std::pair<std::array<int, 2>, std::array<int, 2>> neighbourDirections = getNearestTwoDirections(neighbourAspect);
-                std::array<int, 2> dir1 = neighbourDirections.first;
-                std::array<int, 2> dir2 = neighbourDirections.second;
+            double neighbourElevation = _elevationMap.getData(nx, ny);
+            double neighbourAspect = _aspectMap->getData(nx, ny);
 
-                // Check if this neighbor flows into the current cell
-                if ((nx + dir1[0] == x && ny + dir1[1] == y) ||
-                    (nx + dir2[0] == x && ny + dir2[1] == y)) {
-                    hasFlowingNeighbor = true;
-                }
+            // Elevation check
+            if (neighbourElevation < currentElevation) {
+                allHigherElevation = false;
             }
 
-            /* at least one neighbour that flows into current cell and all
-             neighbours are taller */
-            if (allHigherElevation && hasFlowingNeighbor) {
-                double flowValue = _flowMap->getData(x, y);
-                // Push current point into queue
-                minHeap.push({x, y, flowValue});
+            // Get directions that the neighbor cell's aspect points to
+            std::pair<std::array<int, 2>, std::array<int, 2>> neighbourDirections = getNearestTwoDirections(neighbourAspect);
+            std::array<int, 2> dir1 = neighbourDirections.first;
+            std::array<int, 2> dir2 = neighbourDirections.second;
 
-                // Keep only nPoints with the largest flow values
-                if (minHeap.size() > nPoints) {
-                    minHeap.pop();  // Remove the smallest flow value
-                }
+            // Check if this neighbor flows into the current cell
+            if ((nx + dir1[0] == x && ny + dir1[1] == y) ||
+                (nx + dir2[0] == x && ny + dir2[1] == y)) {
+                hasFlowingNeighbor = true;
             }
         }
-    }
 
-    // Extract top nPoints from the heap (in terms of flow value)
-    while (!minHeap.empty()) {
-        PointWithFlow p = minHeap.top();
-        Points.push_back({p.x, p.y});
-        minHeap.pop();
-    }
-
-    return Points;
+        /* at least one neighbour that flows into current cell and all
+         neighbours are taller */
+        return allHigherElevation && hasFlowingNeighbor;
+    });
 }
 
 
@@ -234,65 +354,197 @@ std::vector<std::pair<int, int>> watershedAnalysis<elevationT, D8T>::MDFPourPoin
     // D8 directions (N, NE, E, SE, S, SW, W, NW)
     int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
     int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
-    std::vector<std::pair<int, int>> Points;
 
-    // Min-heap based on flow value (ascending order)
-    std::priority_queue<PointWithFlow, std::vector<PointWithFlow>, std::greater<PointWithFlow>> minHeap;
+    return topPourPoints(*_flowMap, nPoints, [&](int x, int y) {
+        elevationT currentElevation = _elevationMap.getData(x, y);
+        bool allHigher = true;
+        bool hasTallerNeighbor = false;
 
-    // Iterate over every cell in the map
-    for (int y = 0; y < _height; y++) {
-        for (int x = 0; x < _width; x++) {
-            elevationT currentElevation = _elevationMap.getData(x, y);
-            bool allHigher = true;
-            bool hasTallerNeighbor = false;
-
-            // Check all 8 neighbors
-            for (int dir = 0; dir < 8; dir++) {
-                int nx = x + dx[dir];
-                int ny = y + dy[dir];
-
-                // Out of bounds check
-                if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) {
-                    continue;
-                }
+        // Check all 8 neighbors
+        for (int dir = 0; dir < 8; dir++) {
+            int nx = x + dx[dir];
+            int ny = y + dy[dir];
+
+            // Out of bounds check
+            if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) {
+                continue;
+            }
 
-                elevationT neighborElevation = _elevationMap.getData(nx, ny);
+            elevationT neighborElevation = _elevationMap.getData(nx, ny);
 
-                // Elevation checks
-                if (neighborElevation < currentElevation) {
-                    allHigher = false;
-                    break; // No longer pour point, can skip
-                }
+            // Elevation checks
+            if (neighborElevation < currentElevation) {
+                allHigher = false;
+                break; // No longer pour point, can skip
+            }
 
-                // One strictly taller neighbour
-                if (neighborElevation > currentElevation) {
-                    hasTallerNeighbor = true;
-                }
+            // One strictly taller neighbour
+            if (neighborElevation > currentElevation) {
+                hasTallerNeighbor = true;
             }
+        }
 
-            // Check elevation conditions
-            if (allHigher && hasTallerNeighbor) {
-                double flowValue = _flowMap->getData(x, y);
-                minHeap.push({x, y, flowValue});
+        // Check elevation conditions
+        return allHigher && hasTallerNeighbor;
+    });
+}
 
-                // Keep only the top nPoints with the largest flow values
-                if (minHeap.size() > nPoints) {
-                    minHeap.pop();  // Remove the smallest flow value
+
+namespace {
+
+/**
+ * @brief Disjoint set over candidate indices. Path halving and union by size.
+ */
+struct UnionFind {
+    std::vector<int> parent, size;
+
+    UnionFind(int n) : parent(n), size(n, 1) {
+        for (int i = 0; i < n; i++) parent[i] = i;
+    }
+
+    int find(int i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    void unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return;
+        if (size[a] < size[b]) std::swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+    }
+};
+
+} // namespace
+
+/**
+ * @brief Snap candidate pour points and merge those sharing a downstream path
+ */
+template<typename elevationT, typename D8T>
+std::vector<std::pair<int, int>> watershedAnalysis<elevationT, D8T>::clusterPourPoints(
+    const std::vector<std::pair<int, int>>& candidates, int clusterRadius) {
+    int n = candidates.size();
+    std::vector<int> snapped(n);
+
+    // Snap each candidate to highest flow cell within radius
+    for (int i = 0; i < n; i++) {
+        int cx = candidates[i].first;
+        int cy = candidates[i].second;
+        int bestX = cx, bestY = cy;
+        double bestFlow = _flowMap->getData(cx, cy);
+
+        for (int y = std::max(0, cy - clusterRadius); y <= std::min(_height - 1, cy + clusterRadius); y++) {
+            for (int x = std::max(0, cx - clusterRadius); x <= std::min(_width - 1, cx + clusterRadius); x++) {
+                double flowValue = _flowMap->getData(x, y);
+                if (flowValue > bestFlow) {
+                    bestFlow = flowValue;
+                    bestX = x;
+                    bestY = y;
                 }
             }
         }
+        snapped[i] = bestY * _width + bestX;
     }
 
-    // Extract top nPoints from the heap (in terms of flow value)
-    while (!minHeap.empty()) {
-        PointWithFlow p = minHeap.top();
-        Points.push_back({p.x, p.y});
-        minHeap.pop();
+    // Claim every snapped cell first so paths running into another outlet merge with it
+    UnionFind sets(n);
+    std::unordered_map<int, int> owner;
+    for (int i = 0; i < n; i++) {
+        auto [it, inserted] = owner.emplace(snapped[i], i);
+        if (!inserted) {
+            sets.unite(i, it->second);
+        }
+    }
+
+    // Walk receivers a short distance downstream, merging where paths meet
+    for (int i = 0; i < n; i++) {
+        int cell = snapped[i];
+        for (int step = 0; step < clusterRadius; step++) {
+            cell = getReceiver(cell % _width, cell / _width);
+            if (cell == -1) break;
+
+            auto [it, inserted] = owner.emplace(cell, i);
+            if (!inserted) {
+                sets.unite(i, it->second);
+                break; // Remainder of path already claimed
+            }
+        }
     }
 
+    // Highest flow snapped cell represents each group
+    std::unordered_map<int, int> bestOfSet;
+    for (int i = 0; i < n; i++) {
+        int root = sets.find(i);
+        auto [it, inserted] = bestOfSet.emplace(root, snapped[i]);
+        if (!inserted) {
+            int current = it->second;
+            if (_flowMap->getData(snapped[i] % _width, snapped[i] / _width) >
+                _flowMap->getData(current % _width, current / _width)) {
+                it->second = snapped[i];
+            }
+        }
+    }
+
+    std::vector<PointWithFlow> outlets;
+    for (const auto& [root, cell] : bestOfSet) {
+        int x = cell % _width;
+        int y = cell / _width;
+        outlets.push_back({x, y, static_cast<double>(_flowMap->getData(x, y))});
+    }
+    // Ascending flow to match the order of the pour point methods
+    std::sort(outlets.begin(), outlets.end());
+
+    std::vector<std::pair<int, int>> Points;
+    for (const auto& p : outlets) {
+        Points.push_back({p.x, p.y});
+    }
     return Points;
 }
 
+/**
+ * @brief Receiver lookup from D8 map, or steepest descent when no D8 map is provided
+ */
+template<typename elevationT, typename D8T>
+int watershedAnalysis<elevationT, D8T>::getReceiver(int x, int y) const {
+    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    int direction = -1;
+    if (_D8Map) {
+        direction = static_cast<int>(_D8Map->getData(x, y));
+    }
+    else {
+        // Steepest lower neighbour
+        elevationT lowestValue = _elevationMap.getData(x, y);
+        for (int dir = 0; dir < 8; dir++) {
+            int nx = x + dx[dir];
+            int ny = y + dy[dir];
+            if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) {
+                continue;
+            }
+            elevationT neighbourValue = _elevationMap.getData(nx, ny);
+            if (neighbourValue < lowestValue) {
+                lowestValue = neighbourValue;
+                direction = dir;
+            }
+        }
+    }
+
+    if (direction < 0 || direction > 7) {
+        return -1;
+    }
+    int nx = x + dx[direction];
+    int ny = y + dy[direction];
+    if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) {
+        return -1; // Flows off map
+    }
+    return ny * _width + nx;
+}
 
 /**
  * @brief D8 watershed delineation method
@@ -311,6 +563,22 @@ Map<elevationT> watershedAnalysis<elevationT, D8T>::D8watershed(std::pair<int, i
     // Set the flow value for the starting point
     visited.setData(currentX, currentY, _flowMap->getData(currentX, currentY));
 
+    // Basin outlets can be read straight from the basin tree
+    if (_basinTree) {
+        int node = _basinTree->getBasinWithOutlet(currentX, currentY);
+        if (node != -1) {
+            const BasinNode& basin = _basinTree->getNode(node);
+            for (int y = basin.minY; y <= basin.maxY; y++) {
+                for (int x = basin.minX; x <= basin.maxX; x++) {
+                    if (_basinTree->isInBasin(x, y, node)) {
+                        visited.setData(x, y, _flowMap->getData(x, y));
+                    }
+                }
+            }
+            return visited;
+        }
+    }
+
     // Helper recursive function
     std::function<void(int, int)> visitUpstream = [&](int x, int y) {
         elevationT currentFlow = _flowMap->getData(currentX, currentY); // Flow of the current cell
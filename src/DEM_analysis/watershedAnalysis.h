@@ -12,7 +12,14 @@
 #define WATERSHEDANALYSIS_H
 
 #include "../map_core/Map.h"
+#include "BasinTree.h"
 #include <vector>
+#include <array>
+#include <string>
+#include <cstdint>
+
+/// Memory for the full size watershed maps delineated at once
+const uint64_t WATERSHED_WAVE_MB = 512;
 
 /**
  * @brief watershed delineation class for Map object.
@@ -54,13 +61,29 @@ public:
      * or are at edge.
      * MDF method looks for cells of the highest flow with neighbours that are of 
      * greater elevation.
-     * @bug It is known that pour points occur in regions of local low elevation / gradient
-     * changes. Future development on this would look to combine pour points in similar 
-     * neighbour hoods to create more realistic watersheds.
+     *
+     * Pour points tend to occur in groups in regions of local low elevation / gradient
+     * changes. A larger pool of candidates is therefore found and passed through
+     * clusterPourPoints() so that only distinct outlets are returned.
+     * @param clusterRadius Radius (in cells) used for snapping and merging candidates.
+     * 0 disables clustering.
      *
      * @return std::vector<std::pair<int, int>> 
      */
-    std::vector<std::pair<int, int>> getPourPoints(int nPoints, const std::string method);
+    std::vector<std::pair<int, int>> getPourPoints(int nPoints, const std::string method, int clusterRadius = 3);
+
+    /**
+     * @brief Reduce candidate pour points to distinct outlets.
+     * Each candidate is snapped to the highest flow cell within clusterRadius. Candidates are
+     * then merged (union-find) if they snap to the same cell or if their downstream paths meet
+     * within clusterRadius steps of the receiver graph.
+     * The highest flow cell of each merged group is kept as its outlet.
+     * 
+     * @param candidates Candidate pour points as std::pair<x, y>
+     * @param clusterRadius Snapping radius and downstream search length in cells
+     * @return std::vector<std::pair<int, int>> Distinct outlets in ascending flow order
+     */
+    std::vector<std::pair<int, int>> clusterPourPoints(const std::vector<std::pair<int, int>>& candidates, int clusterRadius);
 
     /**
      * @brief Delegation method for watershed identification.
@@ -71,6 +94,54 @@ public:
      */
     Map<elevationT> calculateWatershed(std::pair<int, int> Point, const std::string method);
 
+    /**
+     * @brief Label cells of a watershed map that have no label yet.
+     * Marking watersheds in ascending flow order (as returned by getPourPoints()) gives
+     * each cell the innermost watershed that contains it.
+     * 
+     * @param watershed Map from calculateWatershed(), non-zero cells are in the watershed
+     * @param label Label to give cells
+     * @param labels Label raster, -1 for unlabelled cells
+     */
+    void markWatershed(const Map<elevationT>& watershed, int label, Map<int>& labels) const;
+
+    /**
+     * @brief Label raster of several watersheds, for zonal statistics.
+     * 
+     * @param points Pour points in ascending flow order. Label is the index in points
+     * @param method Accepts: "mdf", "d8", "dinf"
+     * @return Map<int> Innermost watershed per cell, -1 outside all watersheds
+     */
+    Map<int> labelWatersheds(const std::vector<std::pair<int, int>>& points, const std::string method);
+
+    /**
+     * @brief Watersheds to delineate at once. Each needs a full size map, so a wave is the
+     * pool's threads cut to the maps that fit in WATERSHED_WAVE_MB, and at least one.
+     * 
+     * @param cells Cells of the grid
+     * @return int Watershed maps held at once
+     */
+    static int getWaveSize(uint64_t cells);
+
+    /**
+     * @brief Use a precomputed basin hierarchy for D8 queries.
+     * D8 watersheds of basin outlets are then read from the tree instead of being
+     * traced upstream.
+     * 
+     * @param tree Pointer to BasinTree built from the same D8 map. nullptr to disable
+     */
+    void setBasinTree(const BasinTree* tree);
+
+    /**
+     * @brief Outlets of sub-basins within the basin at Point that drain more than minArea.
+     * Requires setBasinTree().
+     * 
+     * @param Point Outlet or cell inside the basin as std::pair<x, y>
+     * @param minArea Minimum nested area in BasinTree cell area units
+     * @return std::vector<std::pair<int, int>> Sub-basin outlets, empty if no tree is set
+     */
+    std::vector<std::pair<int, int>> getSubBasins(std::pair<int, int> Point, double minArea);
+
 private:
     int _height, _width;
     const Map<elevationT>& _elevationMap;
@@ -78,6 +149,7 @@ private:
     const Map<elevationT>* _flowMap;
     const Map<elevationT>* _slopeMap;
     const Map<elevationT>* _aspectMap;
+    const BasinTree* _basinTree = nullptr;
 
     /**
      * @brief Identification of pour points via D8 algorithm
@@ -103,6 +175,16 @@ private:
      */
     std::vector<std::pair<int, int>> MDFPourPoints(int nPoints);
 
+    /**
+     * @brief Downstream receiver of a cell.
+     * Uses _D8Map if available, otherwise the steepest lower neighbour in _elevationMap.
+     * 
+     * @param x Coord in row
+     * @param y Coord in column
+     * @return int Linear index (y * _width + x) of receiver, -1 if the cell has no receiver
+     */
+    int getReceiver(int x, int y) const;
+
     /**
      * @brief D8 Watershed delineation algorithm.
      * From an identified pour point, this algorithm will travel up every cell that has a D8
@@ -0,0 +1,135 @@
+/**
+ * @file Terrain.cpp
+ * @author Ollie
+ * @brief Public C++ API of the terrain library: analysis on caller-owned rasters
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "Terrain.h"
+#include "../map_core/Map.h"
+#include "../map_core/MapTiles.h"
+#include "../DEM_analysis/D8FlowAnalyser.h"
+#include "../DEM_analysis/FlowAccumulation.h"
+#include "../image_handling/ImageExport.h"
+#include "../parallel/ThreadPool.h"
+#include <iostream>
+#include <vector>
+
+/**
+ * @brief True if output is valid and the size of input
+ */
+template <typename T, typename U>
+static bool sameSize(const RasterView<T>& input, const RasterView<U>& output, const char* name) {
+    if (!output.isValid() || output.width != input.width || output.height != input.height) {
+        std::cerr << "Error: " << name << " raster must be valid and the size of the input." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+namespace terrain {
+
+/**
+ * @brief Resize the shared pool
+ */
+void setThreadCount(int nThreads) {
+    ThreadPool::setThreadCount(nThreads);
+}
+
+/**
+ * @brief Fill in place
+ */
+template <typename T>
+bool fillSinks(const RasterView<T>& dem) {
+    return Map<T>::fillSinks(dem);
+}
+
+/**
+ * @brief Sobel surface between caller rasters
+ */
+template <typename T>
+bool computeSurface(const RasterView<const T>& dem, const RasterView<T>* slope, const RasterView<T>* aspect,
+    const RasterView<T>* hillshade, const HillshadeOptions& options) {
+    if (!dem.isValid()) {
+        std::cerr << "Error: Invalid elevation raster." << std::endl;
+        return false;
+    }
+    if ((slope && !sameSize(dem, *slope, "Slope")) || (aspect && !sameSize(dem, *aspect, "Aspect")) ||
+        (hillshade && !sameSize(dem, *hillshade, "Hillshade"))) {
+        return false;
+    }
+    RasterTileSource<T> source(dem);
+    RasterTileSink<T> slopeSink(slope ? *slope : RasterView<T>());
+    RasterTileSink<T> aspectSink(aspect ? *aspect : RasterView<T>());
+    RasterTileSink<T> hillshadeSink(hillshade ? *hillshade : RasterView<T>());
+    return SlopeAnalyser<T>::computeSurface(source, slope ? &slopeSink : nullptr, aspect ? &aspectSink : nullptr,
+        hillshade ? &hillshadeSink : nullptr, options);
+}
+
+/**
+ * @brief D8 between caller rasters
+ */
+template <typename T>
+bool flowDirections(const RasterView<const T>& dem, const RasterView<int>& directions) {
+    if (!dem.isValid()) {
+        std::cerr << "Error: Invalid elevation raster." << std::endl;
+        return false;
+    }
+    if (!sameSize(dem, directions, "Direction")) return false;
+    RasterTileSource<T> source(dem);
+    RasterTileSink<int> sink(directions);
+    return D8FlowAnalyser<T>::analyseFlow(source, sink);
+}
+
+/**
+ * @brief D8 accumulation between caller rasters
+ */
+template <typename T>
+bool accumulateFlow(const RasterView<const T>& dem, const RasterView<const int>& directions,
+    const RasterView<T>& flow) {
+    return FlowAccumulator<T, int, T>::accumulateD8(dem, directions, flow);
+}
+
+/**
+ * @brief Colour caller values into caller RGB rows
+ */
+template <typename T>
+bool renderRGB(const RasterView<const T>& values, const uint8_t* palette, int colours, bool continuous,
+    const RasterView<uint8_t>& rgb) {
+    if (!palette || colours < 1) {
+        std::cerr << "Error: Palette must have at least one colour." << std::endl;
+        return false;
+    }
+    std::vector<RGBTRIPLE> colourmap(colours);
+    for (size_t i = 0; i < colourmap.size(); i++) {
+        colourmap[i].rgbtRed = palette[3 * i];
+        colourmap[i].rgbtGreen = palette[3 * i + 1];
+        colourmap[i].rgbtBlue = palette[3 * i + 2];
+    }
+    return ImageExport<T>::renderRGB(values, buildColourLUT(colourmap, continuous), rgb);
+}
+
+// Explicit template instantiation
+template bool fillSinks<int>(const RasterView<int>&);
+template bool fillSinks<float>(const RasterView<float>&);
+template bool fillSinks<double>(const RasterView<double>&);
+template bool computeSurface<int>(const RasterView<const int>&, const RasterView<int>*, const RasterView<int>*,
+    const RasterView<int>*, const HillshadeOptions&);
+template bool computeSurface<float>(const RasterView<const float>&, const RasterView<float>*, const RasterView<float>*,
+    const RasterView<float>*, const HillshadeOptions&);
+template bool computeSurface<double>(const RasterView<const double>&, const RasterView<double>*, const RasterView<double>*,
+    const RasterView<double>*, const HillshadeOptions&);
+template bool flowDirections<int>(const RasterView<const int>&, const RasterView<int>&);
+template bool flowDirections<float>(const RasterView<const float>&, const RasterView<int>&);
+template bool flowDirections<double>(const RasterView<const double>&, const RasterView<int>&);
+template bool accumulateFlow<int>(const RasterView<const int>&, const RasterView<const int>&, const RasterView<int>&);
+template bool accumulateFlow<float>(const RasterView<const float>&, const RasterView<const int>&, const RasterView<float>&);
+template bool accumulateFlow<double>(const RasterView<const double>&, const RasterView<const int>&, const RasterView<double>&);
+template bool renderRGB<int>(const RasterView<const int>&, const uint8_t*, int, bool, const RasterView<uint8_t>&);
+template bool renderRGB<float>(const RasterView<const float>&, const uint8_t*, int, bool, const RasterView<uint8_t>&);
+template bool renderRGB<double>(const RasterView<const double>&, const uint8_t*, int, bool, const RasterView<uint8_t>&);
+
+} // namespace terrain
@@ -0,0 +1,102 @@
+/**
+ * @file Terrain.h
+ * @author Ollie
+ * @brief Public C++ API of the terrain library: analysis on caller-owned rasters
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include "../map_core/RasterView.h"
+#include "../DEM_analysis/SobelAnalysis.h"
+#include <cstdint>
+
+/**
+ * @brief Entry points for programs that link the terrain library instead of running
+ * drainage-analysis. Every function reads and writes the caller's memory in place through
+ * RasterView (pointer, size and row stride), so there is no file I/O and no copy into a Map.
+ * Outputs must be the size of the input. Each function returns false, with the reason on
+ * std::cerr, if a raster is invalid or the sizes differ.
+ *
+ * Instantiated for int, float and double elevations. Work runs on the process's shared
+ * thread pool (see setThreadCount()).
+ *
+ * Example:
+ * @code
+ * std::vector<float> dem = ...;               // height rows of width cells
+ * std::vector<int> d8(dem.size());
+ * std::vector<float> flow(dem.size());
+ * RasterView<float> demView(dem.data(), width, height);
+ * terrain::fillSinks(demView);
+ * terrain::flowDirections<float>(demView, RasterView<int>(d8.data(), width, height));
+ * terrain::accumulateFlow<float>(demView, RasterView<const int>(d8.data(), width, height),
+ *                                RasterView<float>(flow.data(), width, height));
+ * @endcode
+ */
+namespace terrain {
+
+/**
+ * @brief Threads used by every function. Only call while no analysis is running.
+ *
+ * @param nThreads Threads, 0 for the hardware concurrency
+ */
+void setThreadCount(int nThreads);
+
+/**
+ * @brief Raise sinks in place, as drainage-analysis does before D8
+ *
+ * @param dem Elevations, changed in place
+ */
+template <typename T>
+bool fillSinks(const RasterView<T>& dem);
+
+/**
+ * @brief Slope, aspect and hillshade in one pass over dem
+ *
+ * @param slope Output gradient magnitude, nullptr to skip
+ * @param aspect Output aspect in degrees, nullptr to skip
+ * @param hillshade Output hillshade, 0 to 255, nullptr to skip
+ * @param options Hillshade sun position and z factor
+ */
+template <typename T>
+bool computeSurface(const RasterView<const T>& dem, const RasterView<T>* slope, const RasterView<T>* aspect,
+    const RasterView<T>* hillshade, const HillshadeOptions& options = HillshadeOptions());
+
+/**
+ * @brief D8 flow direction of every cell
+ *
+ * @param directions Output: 0 to 7 as in D8FlowAnalyser, -1 where no neighbour is lower or equal
+ */
+template <typename T>
+bool flowDirections(const RasterView<const T>& dem, const RasterView<int>& directions);
+
+/**
+ * @brief D8 flow accumulation: cells draining through each cell, including itself
+ *
+ * @param directions Directions from flowDirections()
+ * @param flow Output accumulation
+ */
+template <typename T>
+bool accumulateFlow(const RasterView<const T>& dem, const RasterView<const int>& directions,
+    const RasterView<T>& flow);
+
+/**
+ * @brief Colour values over their range with a palette, as the -img output does with a colourmap.
+ * The palette is the caller's, so nothing is read from disk.
+ *
+ * @param palette Red, green, blue bytes of each colour, lowest value first
+ * @param colours Number of colours in palette, at least 1
+ * @param continuous Interpolate between colours, otherwise discrete bands
+ * @param rgb Output: red, green, blue bytes per cell, so rgb.width is 3 * values.width
+ */
+template <typename T>
+bool renderRGB(const RasterView<const T>& values, const uint8_t* palette, int colours, bool continuous,
+    const RasterView<uint8_t>& rgb);
+
+} // namespace terrain
+
+#endif // TERRAIN_H
@@ -0,0 +1,355 @@
+/**
+ * @file TerrainC.cpp
+ * @author Ollie
+ * @brief C interface of the terrain library for other runtimes (Python, Rust, ...)
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "TerrainC.h"
+#include "Terrain.h"
+#include "../map_core/Map.h"
+#include "../DEM_analysis/FlowAccumulation.h"
+#include "../DEM_analysis/BasinTree.h"
+#include "../parallel/ThreadPool.h"
+#include <climits>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Reusable state of one caller
+ */
+struct terrain_context {
+    std::mutex mutex;        // One call at a time
+    std::string lastError;
+
+    // Scratch kept between calls
+    std::vector<int64_t> basinPath;
+    std::vector<std::tuple<int, int, int>> intCells;
+    std::vector<std::tuple<float, int, int>> floatCells;
+    std::vector<std::tuple<double, int, int>> doubleCells;
+
+    /// @return Elevation order scratch for T
+    std::vector<std::tuple<int, int, int>>& cells(int) { return intCells; }
+    std::vector<std::tuple<float, int, int>>& cells(float) { return floatCells; }
+    std::vector<std::tuple<double, int, int>>& cells(double) { return doubleCells; }
+};
+
+// Calls hold this shared, resizing the pool holds it exclusively
+static std::shared_mutex poolMutex;
+
+/**
+ * @brief Record message on ctx and return status
+ */
+static terrain_status fail(terrain_context* ctx, terrain_status status, const std::string& message) {
+    ctx->lastError = message;
+    return status;
+}
+
+/// @return dtype holding T
+template <typename T> static terrain_dtype dtypeOf(void);
+template <> terrain_dtype dtypeOf<int>(void) { return TERRAIN_INT32; }
+template <> terrain_dtype dtypeOf<float>(void) { return TERRAIN_FLOAT32; }
+template <> terrain_dtype dtypeOf<double>(void) { return TERRAIN_FLOAT64; }
+template <> terrain_dtype dtypeOf<uint8_t>(void) { return TERRAIN_UINT8; }
+
+/// @return Name of dtype for messages
+static const char* dtypeName(terrain_dtype dtype) {
+    switch (dtype) {
+        case TERRAIN_INT32: return "int32";
+        case TERRAIN_FLOAT32: return "float32";
+        case TERRAIN_FLOAT64: return "float64";
+        case TERRAIN_UINT8: return "uint8";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Check raster holds T in a layout RasterView can address and view it in place
+ */
+template <typename T>
+static terrain_status viewOf(terrain_context* ctx, const terrain_raster* raster, const char* name, RasterView<T>& view) {
+    using Cell = typename std::remove_const<T>::type;
+    const int64_t cellSize = static_cast<int64_t>(sizeof(Cell));
+
+    if (!raster || !raster->data) {
+        return fail(ctx, TERRAIN_ERROR_INVALID_ARGUMENT, std::string(name) + " raster is null.");
+    }
+    if (raster->dtype != dtypeOf<Cell>()) {
+        return fail(ctx, TERRAIN_ERROR_UNSUPPORTED_DTYPE, std::string(name) + " raster must be " +
+            dtypeName(dtypeOf<Cell>()) + ", not " + dtypeName(raster->dtype) + ".");
+    }
+    if (raster->width <= 0 || raster->height <= 0 || raster->width > INT_MAX || raster->height > INT_MAX) {
+        return fail(ctx, TERRAIN_ERROR_INVALID_ARGUMENT, std::string(name) + " raster must have 1 to INT_MAX rows and columns.");
+    }
+    if (raster->cell_stride != 0 && raster->cell_stride != cellSize) {
+        return fail(ctx, TERRAIN_ERROR_UNSUPPORTED_LAYOUT, std::string(name) + " raster must have adjacent cells in each row.");
+    }
+    int64_t rowStride = raster->row_stride != 0 ? raster->row_stride : raster->width * cellSize;
+    if (rowStride < raster->width * cellSize || rowStride % cellSize != 0 ||
+        reinterpret_cast<uintptr_t>(raster->data) % alignof(Cell) != 0) {
+        return fail(ctx, TERRAIN_ERROR_UNSUPPORTED_LAYOUT, std::string(name) +
+            " raster rows must be aligned, in order, and at least a row of cells apart.");
+    }
+    view = RasterView<T>(static_cast<T*>(raster->data), static_cast<int>(raster->width),
+        static_cast<int>(raster->height), rowStride / cellSize);
+    return TERRAIN_OK;
+}
+
+/**
+ * @brief Fail unless output is the size of input
+ */
+template <typename T, typename U>
+static terrain_status checkSize(terrain_context* ctx, const RasterView<T>& input, const RasterView<U>& output,
+    const char* name) {
+    if (output.width != input.width || output.height != input.height) {
+        return fail(ctx, TERRAIN_ERROR_SIZE_MISMATCH, std::string(name) + " raster must be " +
+            std::to_string(input.width) + " x " + std::to_string(input.height) + ".");
+    }
+    return TERRAIN_OK;
+}
+
+/**
+ * @brief Run call(T()) with T the cell type of raster, one of int, float and double
+ */
+template <typename Call>
+static terrain_status byElevationType(terrain_context* ctx, const terrain_raster* raster, const char* name, Call&& call) {
+    if (!raster) return fail(ctx, TERRAIN_ERROR_INVALID_ARGUMENT, std::string(name) + " raster is null.");
+    switch (raster->dtype) {
+        case TERRAIN_INT32: return call(int());
+        case TERRAIN_FLOAT32: return call(float());
+        case TERRAIN_FLOAT64: return call(double());
+        default: break;
+    }
+    return fail(ctx, TERRAIN_ERROR_UNSUPPORTED_DTYPE, std::string(name) + " raster must be int32, float32 or float64.");
+}
+
+/**
+ * @brief Run body holding ctx and the pool, turning exceptions into status codes so none cross
+ * the C boundary
+ */
+template <typename Body>
+static terrain_status guarded(terrain_context* ctx, Body&& body) {
+    if (!ctx) return TERRAIN_ERROR_INVALID_ARGUMENT;
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    std::shared_lock<std::shared_mutex> poolLock(poolMutex);
+    ctx->lastError.clear();
+    try {
+        return body();
+    } catch (const std::bad_alloc&) {
+        return fail(ctx, TERRAIN_ERROR_OUT_OF_MEMORY, "Out of memory.");
+    } catch (const std::exception& e) {
+        return fail(ctx, TERRAIN_ERROR_INTERNAL, e.what());
+    } catch (...) {
+        return fail(ctx, TERRAIN_ERROR_INTERNAL, "Unknown error.");
+    }
+}
+
+extern "C" {
+
+int terrain_abi_version(void) {
+    return TERRAIN_ABI_VERSION;
+}
+
+const char* terrain_status_string(terrain_status status) {
+    switch (status) {
+        case TERRAIN_OK: return "ok";
+        case TERRAIN_ERROR_INVALID_ARGUMENT: return "invalid argument";
+        case TERRAIN_ERROR_UNSUPPORTED_DTYPE: return "unsupported dtype";
+        case TERRAIN_ERROR_UNSUPPORTED_LAYOUT: return "unsupported layout";
+        case TERRAIN_ERROR_SIZE_MISMATCH: return "size mismatch";
+        case TERRAIN_ERROR_COLOURMAP: return "colourmap unavailable";
+        case TERRAIN_ERROR_OUT_OF_MEMORY: return "out of memory";
+        case TERRAIN_ERROR_INTERNAL: return "internal error";
+    }
+    return "unknown status";
+}
+
+terrain_status terrain_context_create(terrain_context** out) {
+    if (!out) return TERRAIN_ERROR_INVALID_ARGUMENT;
+    *out = new (std::nothrow) terrain_context();
+    return *out ? TERRAIN_OK : TERRAIN_ERROR_OUT_OF_MEMORY;
+}
+
+void terrain_context_destroy(terrain_context* ctx) {
+    delete ctx;
+}
+
+terrain_status terrain_context_release_scratch(terrain_context* ctx) {
+    if (!ctx) return TERRAIN_ERROR_INVALID_ARGUMENT;
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    std::vector<int64_t>().swap(ctx->basinPath);
+    std::vector<std::tuple<int, int, int>>().swap(ctx->intCells);
+    std::vector<std::tuple<float, int, int>>().swap(ctx->floatCells);
+    std::vector<std::tuple<double, int, int>>().swap(ctx->doubleCells);
+    return TERRAIN_OK;
+}
+
+const char* terrain_context_last_error(const terrain_context* ctx) {
+    return ctx ? ctx->lastError.c_str() : "Context is null.";
+}
+
+terrain_status terrain_set_thread_count(int threads) {
+    if (threads < 0) return TERRAIN_ERROR_INVALID_ARGUMENT;
+    std::unique_lock<std::shared_mutex> poolLock(poolMutex);
+    try {
+        terrain::setThreadCount(threads);
+    } catch (const std::bad_alloc&) {
+        return TERRAIN_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        return TERRAIN_ERROR_INTERNAL;
+    }
+    return TERRAIN_OK;
+}
+
+int terrain_get_thread_count(void) {
+    std::shared_lock<std::shared_mutex> poolLock(poolMutex);
+    return ThreadPool::instance().getThreadCount();
+}
+
+terrain_hillshade_options terrain_hillshade_defaults(void) {
+    HillshadeOptions defaults;
+    return {defaults.azimuth, defaults.altitude, defaults.zFactor, defaults.multidirectional ? 1 : 0};
+}
+
+terrain_status terrain_fill_sinks(terrain_context* ctx, const terrain_raster* dem) {
+    return guarded(ctx, [&]() {
+        return byElevationType(ctx, dem, "Elevation", [&](auto zero) {
+            using T = decltype(zero);
+            RasterView<T> demView;
+            terrain_status status = viewOf(ctx, dem, "Elevation", demView);
+            if (status != TERRAIN_OK) return status;
+            if (!terrain::fillSinks(demView)) return fail(ctx, TERRAIN_ERROR_INTERNAL, "Sink filling failed.");
+            return TERRAIN_OK;
+        });
+    });
+}
+
+terrain_status terrain_surface(terrain_context* ctx, const terrain_raster* dem, const terrain_raster* slope,
+    const terrain_raster* aspect, const terrain_raster* hillshade, const terrain_hillshade_options* options) {
+    return guarded(ctx, [&]() {
+        return byElevationType(ctx, dem, "Elevation", [&](auto zero) {
+            using T = decltype(zero);
+            RasterView<const T> demView;
+            terrain_status status = viewOf(ctx, dem, "Elevation", demView);
+            if (status != TERRAIN_OK) return status;
+
+            // Each output is optional
+            RasterView<T> outputs[3];
+            const terrain_raster* rasters[3] = {slope, aspect, hillshade};
+            const char* names[3] = {"Slope", "Aspect", "Hillshade"};
+            for (int i = 0; i < 3; i++) {
+                if (!rasters[i]) continue;
+                status = viewOf(ctx, rasters[i], names[i], outputs[i]);
+                if (status == TERRAIN_OK) status = checkSize(ctx, demView, outputs[i], names[i]);
+                if (status != TERRAIN_OK) return status;
+            }
+
+            HillshadeOptions sun;
+            if (options) {
+                sun.azimuth = options->azimuth;
+                sun.altitude = options->altitude;
+                sun.zFactor = options->z_factor;
+                sun.multidirectional = options->multidirectional != 0;
+            }
+            if (!terrain::computeSurface<T>(demView, slope ? &outputs[0] : nullptr, aspect ? &outputs[1] : nullptr,
+                    hillshade ? &outputs[2] : nullptr, sun)) {
+                return fail(ctx, TERRAIN_ERROR_INTERNAL, "Surface analysis failed.");
+            }
+            return TERRAIN_OK;
+        });
+    });
+}
+
+terrain_status terrain_d8(terrain_context* ctx, const terrain_raster* dem, const terrain_raster* directions) {
+    return guarded(ctx, [&]() {
+        return byElevationType(ctx, dem, "Elevation", [&](auto zero) {
+            using T = decltype(zero);
+            RasterView<const T> demView;
+            RasterView<int> directionView;
+            terrain_status status = viewOf(ctx, dem, "Elevation", demView);
+            if (status == TERRAIN_OK) status = viewOf(ctx, directions, "Direction", directionView);
+            if (status == TERRAIN_OK) status = checkSize(ctx, demView, directionView, "Direction");
+            if (status != TERRAIN_OK) return status;
+            if (!terrain::flowDirections<T>(demView, directionView)) {
+                return fail(ctx, TERRAIN_ERROR_INTERNAL, "D8 analysis failed.");
+            }
+            return TERRAIN_OK;
+        });
+    });
+}
+
+terrain_status terrain_accumulate(terrain_context* ctx, const terrain_raster* dem, const terrain_raster* directions,
+    const terrain_raster* flow) {
+    return guarded(ctx, [&]() {
+        return byElevationType(ctx, dem, "Elevation", [&](auto zero) {
+            using T = decltype(zero);
+            RasterView<const T> demView;
+            RasterView<const int> directionView;
+            RasterView<T> flowView;
+            terrain_status status = viewOf(ctx, dem, "Elevation", demView);
+            if (status == TERRAIN_OK) status = viewOf(ctx, directions, "Direction", directionView);
+            if (status == TERRAIN_OK) status = viewOf(ctx, flow, "Flow", flowView);
+            if (status == TERRAIN_OK) status = checkSize(ctx, demView, directionView, "Direction");
+            if (status == TERRAIN_OK) status = checkSize(ctx, demView, flowView, "Flow");
+            if (status != TERRAIN_OK) return status;
+            if (!FlowAccumulator<T, int, T>::accumulateD8(demView, directionView, flowView, &ctx->cells(zero))) {
+                return fail(ctx, TERRAIN_ERROR_INTERNAL, "Flow accumulation failed.");
+            }
+            return TERRAIN_OK;
+        });
+    });
+}
+
+terrain_status terrain_label_basins(terrain_context* ctx, const terrain_raster* directions,
+    const terrain_raster* labels, int64_t* basins) {
+    return guarded(ctx, [&]() {
+        RasterView<const int> directionView;
+        RasterView<int> labelView;
+        terrain_status status = viewOf(ctx, directions, "Direction", directionView);
+        if (status == TERRAIN_OK) status = viewOf(ctx, labels, "Label", labelView);
+        if (status == TERRAIN_OK) status = checkSize(ctx, directionView, labelView, "Label");
+        if (status != TERRAIN_OK) return status;
+
+        int nBasins = BasinTree::labelOutletBasins(directionView, labelView, ctx->basinPath);
+        if (nBasins < 0) return fail(ctx, TERRAIN_ERROR_INTERNAL, "Basin labelling failed.");
+        if (basins) *basins = nBasins;
+        return TERRAIN_OK;
+    });
+}
+
+terrain_status terrain_render(terrain_context* ctx, const terrain_raster* values, const uint8_t* palette,
+    int64_t colours, int continuous, const terrain_raster* rgb) {
+    return guarded(ctx, [&]() {
+        if (!palette || colours < 1 || colours > INT_MAX) {
+            return fail(ctx, TERRAIN_ERROR_COLOURMAP, "Palette must have 1 to INT_MAX colours.");
+        }
+        return byElevationType(ctx, values, "Value", [&](auto zero) {
+            using T = decltype(zero);
+            RasterView<const T> valueView;
+            RasterView<uint8_t> rgbView;
+            terrain_status status = viewOf(ctx, values, "Value", valueView);
+            if (status == TERRAIN_OK) status = viewOf(ctx, rgb, "RGB", rgbView);
+            if (status != TERRAIN_OK) return status;
+            if (rgbView.width != 3LL * valueView.width || rgbView.height != valueView.height) {
+                return fail(ctx, TERRAIN_ERROR_SIZE_MISMATCH, "RGB raster must be " + std::to_string(3LL * valueView.width) +
+                    " x " + std::to_string(valueView.height) + " bytes.");
+            }
+            if (!terrain::renderRGB<T>(valueView, palette, static_cast<int>(colours), continuous != 0, rgbView)) {
+                return fail(ctx, TERRAIN_ERROR_INTERNAL, "Rendering failed.");
+            }
+            return TERRAIN_OK;
+        });
+    });
+}
+
+} // extern "C"
@@ -0,0 +1,197 @@
+/**
+ * @file TerrainC.h
+ * @author Ollie
+ * @brief C interface of the terrain library for other runtimes (Python, Rust, ...)
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef TERRAIN_C_H
+#define TERRAIN_C_H
+
+#include <stdint.h>
+
+/**
+ * Plain C over the algorithms in Terrain.h. Rasters are described by terrain_raster (pointer,
+ * cell type, size and byte strides), so a numpy array or ndarray is read and written where it
+ * lives without a copy. Every function returns a terrain_status; the message for the last
+ * failure on a context is available from terrain_context_last_error(). Nothing is printed
+ * except by a colourmap that cannot be read.
+ *
+ * A terrain_context holds the reusable state of one caller: scratch buffers kept between calls
+ * and the last error. Calls on one context run one at a time, so a context may be shared
+ * between threads; calls on different contexts run concurrently on the process's thread pool.
+ *
+ * Example from Python with ctypes, for a C-contiguous float64 array dem:
+ * @code
+ * raster = terrain_raster(dem.ctypes.data, TERRAIN_FLOAT64, w, h, dem.strides[0], dem.strides[1])
+ * status = lib.terrain_fill_sinks(ctx, byref(raster))
+ * @endcode
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Changes whenever a struct or signature in this file changes
+#define TERRAIN_ABI_VERSION 2
+
+/**
+ * @brief Result of every call
+ */
+typedef enum terrain_status {
+    TERRAIN_OK = 0,
+    TERRAIN_ERROR_INVALID_ARGUMENT = 1,   // Null pointer, empty raster or size over INT_MAX
+    TERRAIN_ERROR_UNSUPPORTED_DTYPE = 2,  // Cell type not accepted by this argument
+    TERRAIN_ERROR_UNSUPPORTED_LAYOUT = 3, // Cells of a row not adjacent, negative or unaligned stride
+    TERRAIN_ERROR_SIZE_MISMATCH = 4,      // Output not the size of the input
+    TERRAIN_ERROR_COLOURMAP = 5,          // Palette null or empty
+    TERRAIN_ERROR_OUT_OF_MEMORY = 6,
+    TERRAIN_ERROR_INTERNAL = 7
+} terrain_status;
+
+/**
+ * @brief Cell type of a raster
+ */
+typedef enum terrain_dtype {
+    TERRAIN_INT32 = 0,
+    TERRAIN_FLOAT32 = 1,
+    TERRAIN_FLOAT64 = 2,
+    TERRAIN_UINT8 = 3   // Only for render output
+} terrain_dtype;
+
+/**
+ * @brief 2D array in caller memory: cell (x, y) starts at data + y * row_stride + x * cell_stride
+ * bytes. Rows may be padded (row_stride larger than a row) but the cells of a row must be
+ * adjacent, as in any C-contiguous array or a slice of rows and columns of one.
+ */
+typedef struct terrain_raster {
+    void* data;
+    terrain_dtype dtype;
+    int64_t width;        // Cells per row
+    int64_t height;       // Rows
+    int64_t row_stride;   // Bytes between row starts, 0 for packed rows (numpy strides[0])
+    int64_t cell_stride;  // Bytes between cells of a row, 0 for the cell size (numpy strides[1])
+} terrain_raster;
+
+/**
+ * @brief Sun position for terrain_surface(), as HillshadeOptions
+ */
+typedef struct terrain_hillshade_options {
+    double azimuth;        // Degrees clockwise from north (up)
+    double altitude;       // Degrees above the horizon
+    double z_factor;       // Elevation units per cell spacing
+    int multidirectional;  // Non-zero to blend sun from 225, 270, 315 and 360 degrees
+} terrain_hillshade_options;
+
+/// Reusable state of one caller
+typedef struct terrain_context terrain_context;
+
+/// @return TERRAIN_ABI_VERSION the library was built with
+int terrain_abi_version(void);
+
+/// @return Static description of status
+const char* terrain_status_string(terrain_status status);
+
+/**
+ * @brief New context
+ *
+ * @param out Receives the context, free with terrain_context_destroy()
+ */
+terrain_status terrain_context_create(terrain_context** out);
+
+/// @brief Free context and its scratch buffers. Null is ignored.
+void terrain_context_destroy(terrain_context* ctx);
+
+/**
+ * @brief Free scratch buffers kept between calls, e.g. after a very large raster
+ */
+terrain_status terrain_context_release_scratch(terrain_context* ctx);
+
+/**
+ * @return Message of the last failed call on ctx, empty after a success. Valid until the next
+ * call on ctx
+ */
+const char* terrain_context_last_error(const terrain_context* ctx);
+
+/**
+ * @brief Threads of the process's pool, shared by all contexts. Waits for running calls to
+ * finish first.
+ *
+ * @param threads Threads, 0 for the hardware concurrency
+ */
+terrain_status terrain_set_thread_count(int threads);
+
+/// @return Threads of the process's pool
+int terrain_get_thread_count(void);
+
+/// @return Defaults of HillshadeOptions
+terrain_hillshade_options terrain_hillshade_defaults(void);
+
+/**
+ * @brief Raise sinks in place
+ *
+ * @param dem int32, float32 or float64 elevations, changed in place
+ */
+terrain_status terrain_fill_sinks(terrain_context* ctx, const terrain_raster* dem);
+
+/**
+ * @brief Slope, aspect and hillshade in one pass. Outputs have the type of dem.
+ *
+ * @param slope Output gradient magnitude, null to skip
+ * @param aspect Output aspect in degrees, null to skip
+ * @param hillshade Output hillshade, 0 to 255, null to skip
+ * @param options Sun position, null for terrain_hillshade_defaults()
+ */
+terrain_status terrain_surface(terrain_context* ctx, const terrain_raster* dem, const terrain_raster* slope,
+    const terrain_raster* aspect, const terrain_raster* hillshade, const terrain_hillshade_options* options);
+
+/**
+ * @brief D8 flow direction of every cell
+ *
+ * @param directions int32 output: 0 to 7 from east clockwise, -1 where no neighbour is lower or equal
+ */
+terrain_status terrain_d8(terrain_context* ctx, const terrain_raster* dem, const terrain_raster* directions);
+
+/**
+ * @brief D8 flow accumulation: cells draining through each cell, including itself
+ *
+ * @param directions int32 directions from terrain_d8()
+ * @param flow Output of the type of dem
+ */
+terrain_status terrain_accumulate(terrain_context* ctx, const terrain_raster* dem, const terrain_raster* directions,
+    const terrain_raster* flow);
+
+/**
+ * @brief Label each cell with the basin of the outlet its D8 path ends at (a pit, the edge of
+ * the grid, or a cycle on a flat)
+ *
+ * @param directions int32 directions from terrain_d8()
+ * @param labels int32 output, basins numbered from 0
+ * @param basins Receives the number of basins, may be null
+ */
+terrain_status terrain_label_basins(terrain_context* ctx, const terrain_raster* directions,
+    const terrain_raster* labels, int64_t* basins);
+
+/**
+ * @brief Colour values over their range with a palette, as the -img output does with a colourmap.
+ * The palette is the caller's, so the result does not depend on the working directory.
+ *
+ * @param values int32, float32 or float64 values
+ * @param palette Red, green, blue bytes of each colour, lowest value first, e.g. an (n, 3) uint8
+ * numpy array. Files in data/colourmaps/ list blue, green, red per line, so reverse their columns
+ * @param colours Number of colours in palette, 1 to INT_MAX
+ * @param continuous Non-zero to interpolate between colours, otherwise discrete bands
+ * @param rgb uint8 output of red, green, blue bytes per cell, so width is 3 * values->width.
+ * An (h, w, 3) C-contiguous numpy array is passed with width 3 * w and cell_stride 1
+ */
+terrain_status terrain_render(terrain_context* ctx, const terrain_raster* values, const uint8_t* palette,
+    int64_t colours, int continuous, const terrain_raster* rgb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TERRAIN_C_H
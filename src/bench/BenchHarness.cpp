@@ -0,0 +1,105 @@
+/**
+ * @file BenchHarness.cpp
+ * @author Ollie
+ * @brief Timing harness for kernel micro-benchmarks with JSON output
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "BenchHarness.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+
+/**
+ * @brief Nearest rank percentile of sorted samples
+ */
+static double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+/**
+ * @brief Cells per second at the median
+ */
+double BenchResult::cellsPerSecond(void) const {
+    return (median > 0) ? static_cast<double>(width) * height / median : 0.0;
+}
+
+/**
+ * @brief Construct a new Bench Harness:: Bench Harness object
+ */
+BenchHarness::BenchHarness(int warmup, int repetitions)
+    : _warmup(std::max(0, warmup)), _repetitions(std::max(1, repetitions)) {}
+
+/**
+ * @brief Warm up, time, and summarise a kernel
+ */
+const BenchResult& BenchHarness::measure(const std::string& kernel, int width, int height,
+    const std::function<void()>& setup, const std::function<void()>& run) {
+    for (int i = 0; i < _warmup; i++) {
+        if (setup) setup();
+        run();
+    }
+
+    std::vector<double> samples;
+    samples.reserve(_repetitions);
+    for (int i = 0; i < _repetitions; i++) {
+        if (setup) setup();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        samples.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result;
+    result.kernel = kernel;
+    result.width = width;
+    result.height = height;
+    result.repetitions = _repetitions;
+    result.min = samples.front();
+    result.p10 = percentile(samples, 0.1);
+    result.median = percentile(samples, 0.5);
+    result.p90 = percentile(samples, 0.9);
+    result.max = samples.back();
+    double total = 0;
+    for (double sample : samples) total += sample;
+    result.mean = total / samples.size();
+
+    _results.push_back(result);
+    return _results.back();
+}
+
+/**
+ * @brief Results getter
+ */
+const std::vector<BenchResult>& BenchHarness::getResults(void) const {
+    return _results;
+}
+
+/**
+ * @brief JSON document of all results
+ */
+void BenchHarness::writeJSON(std::ostream& out, const std::string& toolVersion, int threads) const {
+    out << std::setprecision(9);
+    out << "{\n";
+    out << "  \"tool_version\": \"" << toolVersion << "\",\n";
+    out << "  \"threads\": " << threads << ",\n";
+    out << "  \"warmup\": " << _warmup << ",\n";
+    out << "  \"repetitions\": " << _repetitions << ",\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < _results.size(); i++) {
+        const BenchResult& r = _results[i];
+        out << (i ? ",\n" : "\n");
+        out << "    {\"kernel\": \"" << r.kernel << "\", \"width\": " << r.width << ", \"height\": " << r.height
+            << ", \"cells\": " << static_cast<long long>(r.width) * r.height
+            << ", \"repetitions\": " << r.repetitions
+            << ", \"seconds\": {\"min\": " << r.min << ", \"p10\": " << r.p10 << ", \"median\": " << r.median
+            << ", \"p90\": " << r.p90 << ", \"max\": " << r.max << ", \"mean\": " << r.mean << "}"
+            << ", \"cells_per_second\": " << r.cellsPerSecond() << "}";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,91 @@
+/**
+ * @file BenchHarness.h
+ * @author Ollie
+ * @brief Timing harness for kernel micro-benchmarks with JSON output
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Timings of one kernel on one grid size, in seconds
+ */
+struct BenchResult {
+    std::string kernel;
+    int width = 0;
+    int height = 0;
+    int repetitions = 0;
+    double min = 0;
+    double p10 = 0;
+    double median = 0;
+    double p90 = 0;
+    double max = 0;
+    double mean = 0;
+
+    /// @return double Cells processed per second at the median time
+    double cellsPerSecond(void) const;
+};
+
+/**
+ * @brief Runs kernels with warm-up and repetitions and keeps their timing statistics.
+ * Each repetition calls setup (untimed), then run (timed), so kernels that change their
+ * input (e.g. fillSinks) start from the same state every time.
+ *
+ * Example:
+ * @code
+ * BenchHarness harness(1, 5);
+ * harness.measure("slope", 512, 512, nullptr, [&]() { slope = analyser.computeSlope("combined"); });
+ * harness.writeJSON(std::cout);
+ * @endcode
+ */
+class BenchHarness {
+public:
+    /**
+     * @brief Construct a new Bench Harness object
+     *
+     * @param warmup Untimed runs before timing
+     * @param repetitions Timed runs
+     */
+    BenchHarness(int warmup, int repetitions);
+
+    /**
+     * @brief Time a kernel and keep its result
+     *
+     * @param kernel Kernel name
+     * @param width Grid width
+     * @param height Grid height
+     * @param setup Untimed preparation before every run, may be empty
+     * @param run Work to time
+     * @return const BenchResult& Statistics of the timed runs
+     */
+    const BenchResult& measure(const std::string& kernel, int width, int height,
+        const std::function<void()>& setup, const std::function<void()>& run);
+
+    /// @return const std::vector<BenchResult>& Results in measuring order
+    const std::vector<BenchResult>& getResults(void) const;
+
+    /**
+     * @brief Write all results as a JSON document
+     *
+     * @param out Stream to write to
+     * @param toolVersion Version string recorded with the results
+     * @param threads Worker threads used by parallel kernels
+     */
+    void writeJSON(std::ostream& out, const std::string& toolVersion, int threads) const;
+
+private:
+    int _warmup;
+    int _repetitions;
+    std::vector<BenchResult> _results;
+};
+
+#endif // BENCH_HARNESS_H
@@ -0,0 +1,205 @@
+/**
+ * @file drainageBench.cpp
+ * @author Ollie
+ * @brief drainage-bench: times each analysis kernel over several grid sizes
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "BenchHarness.h"
+#include "../map_core/Map.h"
+#include "../map_core/MapScaler.h"
+#include "../map_core/TerrainGenerator.h"
+#include "../DEM_analysis/SobelAnalysis.h"
+#include "../DEM_analysis/D8FlowAnalyser.h"
+#include "../DEM_analysis/FlowAccumulation.h"
+#include "../DEM_analysis/watershedAnalysis.h"
+#include "../image_handling/ImageExport.h"
+#include "../parallel/parallelFor.h"
+#include "../pipeline/ProductCache.h"  // TOOL_VERSION
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/**
+ * @brief Print usage
+ */
+static void printBenchHelp() {
+    std::cout << "Usage: ./drainage-bench [flags]" << std::endl;
+    std::cout << "--sizes <n,n,...> : Square grid sizes to time (default 256,512,1024)" << std::endl;
+    std::cout << "--warmup <n> : Untimed runs per kernel (default 1)" << std::endl;
+    std::cout << "--repetitions <n> : Timed runs per kernel (default 5)" << std::endl;
+    std::cout << "--filter <text> : Only kernels whose name contains text" << std::endl;
+    std::cout << "-o <file.json> : Write JSON results to file instead of stdout" << std::endl;
+}
+
+/**
+ * @brief Terrain of the kernels: generator defaults on a tilted plane. The tilt keeps large
+ * closed basins rare, whose filling time grows much faster than the grid.
+ */
+static TerrainOptions benchTerrainOptions() {
+    TerrainOptions options;
+    options.tilt = 1.0;
+    return options;
+}
+
+/**
+ * @brief Split "256,512" into sizes
+ */
+static bool parseSizes(const char* text, std::vector<int>& sizes) {
+    sizes.clear();
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int size = std::atoi(item.c_str());
+        if (size < 8) {
+            std::cerr << "Error: --sizes needs grid sizes of at least 8." << std::endl;
+            return false;
+        }
+        sizes.push_back(size);
+    }
+    return !sizes.empty();
+}
+
+/**
+ * @brief Time every kernel on every size and print JSON
+ */
+int main(int argc, char* argv[]) {
+    std::vector<int> sizes = {256, 512, 1024};
+    int warmup = 1;
+    int repetitions = 5;
+    std::string filter;
+    std::string outputFile;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            printBenchHelp();
+            return 0;
+        }
+        else if (strcmp(argv[i], "--sizes") == 0 && hasValue) {
+            if (!parseSizes(argv[++i], sizes)) return 1;
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && hasValue) {
+            warmup = std::atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--repetitions") == 0 && hasValue) {
+            repetitions = std::atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "-o") == 0 && hasValue) {
+            outputFile = argv[++i];
+        }
+        else {
+            std::cerr << "Error: Unknown or incomplete flag: " << argv[i] << std::endl;
+            printBenchHelp();
+            return 1;
+        }
+    }
+
+    // Scratch files for load and export kernels
+    std::filesystem::path scratch = std::filesystem::temp_directory_path() / "drainage-bench";
+    std::filesystem::create_directories(scratch);
+
+    BenchHarness harness(warmup, repetitions);
+    bool exportFailed = false;
+    for (int size : sizes) {
+        // Inputs shared by the kernels, made once per size and untimed
+        Map<double> raw = TerrainGenerator<double>(benchTerrainOptions()).generate(size, size);
+        Map<double> dem = raw;
+        dem.fillSinks();
+        SlopeAnalyser<double> sAnalyser(dem);
+        Map<double> slope = sAnalyser.computeSlope("combined");
+        Map<double> aspect = sAnalyser.computeDirection();
+        D8FlowAnalyser<double> d8Analyser(dem);
+        d8Analyser.analyseFlow();
+        Map<int> d8 = d8Analyser.getMap();
+        Map<double> flow = FlowAccumulator<double, int, double>(dem, nullptr, nullptr, &d8).accumulateFlow("d8");
+        std::string txtFile = (scratch / ("dem_" + std::to_string(size) + ".txt")).string();
+        std::string binFile = (scratch / ("dem_" + std::to_string(size) + ".bin")).string();
+        raw.saveToFile(txtFile, "txt");
+        raw.saveToFile(binFile, "bin");
+
+        // Products land here so the timed work cannot be optimised away
+        Map<double> outDouble;
+        Map<int> outInt;
+        std::vector<std::pair<int, int>> points;
+        Map<double> filled;
+
+        auto time = [&](const std::string& kernel, const std::function<void()>& setup,
+            const std::function<void()>& run) {
+            if (!filter.empty() && kernel.find(filter) == std::string::npos) return;
+            const BenchResult& result = harness.measure(kernel, size, size, setup, run);
+            std::cerr << kernel << " " << size << "x" << size << ": median " << result.median * 1e3 << " ms, "
+                      << result.cellsPerSecond() / 1e6 << " Mcells/s" << std::endl;
+        };
+
+        time("generate", nullptr, [&]() { outDouble = TerrainGenerator<double>().generate(size, size); });
+        time("load_txt", nullptr, [&]() { outDouble = Map<double>(); outDouble.loadFromFile(txtFile, "txt"); });
+        time("load_bin", nullptr, [&]() { outDouble = Map<double>(); outDouble.loadFromFile(binFile, "bin"); });
+        time("fill_sinks", [&]() { filled = raw; }, [&]() { filled.fillSinks(); });
+        time("slope", nullptr, [&]() { outDouble = sAnalyser.computeSlope("combined"); });
+        time("aspect", nullptr, [&]() { outDouble = sAnalyser.computeDirection(); });
+        time("hillshade", nullptr, [&]() { outDouble = sAnalyser.computeHillshade(); });
+        time("d8", nullptr, [&]() {
+            D8FlowAnalyser<double> analyser(dem);
+            analyser.analyseFlow();
+            outInt = analyser.getMap();
+        });
+        time("flow_d8", nullptr, [&]() {
+            outDouble = FlowAccumulator<double, int, double>(dem, nullptr, nullptr, &d8).accumulateFlow("d8");
+        });
+        time("flow_dinf", nullptr, [&]() {
+            outDouble = FlowAccumulator<double, int, double>(dem, &aspect, &slope, nullptr).accumulateFlow("dinf");
+        });
+        time("flow_mdf", nullptr, [&]() {
+            outDouble = FlowAccumulator<double, int, double>(dem, nullptr, &slope, nullptr).accumulateFlow("mdf");
+        });
+
+        watershedAnalysis<double, int> watersheds(dem, &d8, &flow, &slope, &aspect);
+        time("pour_points_d8", nullptr, [&]() { points = watersheds.getPourPoints(5, "d8"); });
+        points = watersheds.getPourPoints(1, "d8");
+        if (!points.empty()) {
+            time("delineation_d8", nullptr, [&]() { outDouble = watersheds.calculateWatershed(points[0], "d8"); });
+        }
+
+        MapScaler<double> scaler(flow, "log");
+        std::string pngFile = (scratch / "flow.png").string();
+        std::string bmpFile = (scratch / "flow.bmp").string();
+        // A failed export (e.g. colourmap not found from this directory) would time nothing
+        auto timeExport = [&](const std::string& kernel, const std::string& file) {
+            if (!filter.empty() && kernel.find(filter) == std::string::npos) return;
+            if (!ImageExport<double>::exportMapToImage(flow, file, "g1", true, &scaler)) {
+                std::cerr << "Error: " << kernel << " failed, skipped. Run from a directory with ../data/colourmaps/."
+                          << std::endl;
+                exportFailed = true;
+                return;
+            }
+            time(kernel, nullptr, [&]() { ImageExport<double>::exportMapToImage(flow, file, "g1", true, &scaler); });
+        };
+        timeExport("export_png", pngFile);
+        timeExport("export_bmp", bmpFile);
+    }
+
+    if (outputFile.empty()) {
+        harness.writeJSON(std::cout, TOOL_VERSION, getThreadCount());
+    }
+    else {
+        std::ofstream file(outputFile.c_str());
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file for writing: " << outputFile << std::endl;
+            return 1;
+        }
+        harness.writeJSON(file, TOOL_VERSION, getThreadCount());
+        std::cerr << "Saved results to: " << outputFile << std::endl;
+    }
+    return exportFailed ? 1 : 0;
+}
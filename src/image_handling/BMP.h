@@ -15,6 +15,8 @@
 #include <fstream>
 #include <iostream>
 #include <vector>
+#include <cstring>
+#include <cstdint>
 
 #pragma pack(push, 1)
 
@@ -64,104 +66,135 @@ struct RGBTRIPLE {
 #pragma pack(pop)
 
 
-class BMP {
-public:
-    BITMAPFILEHEADER FileHeader;
-    BITMAPINFOHEADER InfoHeader;
-    RGBTRIPLE rgb;
-    std::vector<RGBTRIPLE> data;
+/**
+ * @brief Fill file and info headers for a 24-bit BMP of given size
+ * 
+ * @param width 
+ * @param height 
+ * @param FileHeader 
+ * @param InfoHeader 
+ */
+inline void createBMPHeaders(int32_t width, int32_t height, BITMAPFILEHEADER& FileHeader, BITMAPINFOHEADER& InfoHeader) {
+    uint32_t rowSize = (width * 3 + 3) & ~3; // Row size (padded to 4 bytes)
+    uint32_t imageSize = rowSize * height;
+
+    // File Header (14 bytes)
+    FileHeader.bfType = 0x4D42;  // "BM" in ASCII
+    FileHeader.bfSize = 54 + imageSize; // Total file size
+    FileHeader.bfReserved1 = 0;
+    FileHeader.bfReserved2 = 0;
+    FileHeader.bfOffBits = 54; // Pixel data starts after headers
+
+    // Info Header (40 bytes)
+    InfoHeader.biSize = 40; // Header size
+    InfoHeader.biWidth = width;
+    InfoHeader.biHeight = height;
+    InfoHeader.biPlanes = 1;
+    InfoHeader.biBitCount = 24; // 24-bit BMP
+    InfoHeader.biCompression = 0; // No compression
+    InfoHeader.biSizeImage = imageSize; // Image data size
+    InfoHeader.biXPelsPerMeter = 2835; // 72 DPI (2835 pixels per meter)
+    InfoHeader.biYPelsPerMeter = 2835; // 72 DPI
+    InfoHeader.biClrUsed = 0; // No color palette for 24-bit
+    InfoHeader.biClrImportant = 0;
+}
 
+/**
+ * @brief Streaming 24-bit BMP writer.
+ * Rows are given top down (row 0 of the map first) in blocks of any size. Each block is
+ * padded and written with a single stream write at its place in the file (BMP rows are
+ * stored bottom up), so only one block is ever held in memory.
+ */
+class BMPWriter {
+public:
     /**
-     * @brief Construct a new BMP object
+     * @brief Open file and write headers
      * 
-     * @param width
+     * @param filename Full file pathways and .bmp extension
+     * @param width 
      * @param height 
      */
-    BMP(int32_t width, int32_t height) {
-        int rowSize = (width * 3 + 3) & ~3; // Row size (padded to 4 bytes)
-        int imageSize = rowSize * height;
-
-        // File Header (14 bytes)
-        FileHeader.bfType = 0x4D42;  // "BM" in ASCII
-        FileHeader.bfSize = 54 + imageSize; // Total file size
-        FileHeader.bfReserved1 = 0;
-        FileHeader.bfReserved2 = 0;
-        FileHeader.bfOffBits = 54; // Pixel data starts after headers
-
-        // Info Header (40 bytes)
-        InfoHeader.biSize = 40; // Header size
-        InfoHeader.biWidth = width;
-        InfoHeader.biHeight = height;
-        InfoHeader.biPlanes = 1;
-        InfoHeader.biBitCount = 24; // 24-bit BMP
-        InfoHeader.biCompression = 0; // No compression
-        InfoHeader.biSizeImage = imageSize; // Image data size
-        InfoHeader.biXPelsPerMeter = 2835; // 72 DPI (2835 pixels per meter)
-        InfoHeader.biYPelsPerMeter = 2835; // 72 DPI
-        InfoHeader.biClrUsed = 0; // No color palette for 24-bit
-        InfoHeader.biClrImportant = 0;
-
-        data.resize(width * height);  // Resize the vector to hold all pixels
-        for (auto& pixel : data) {
-            pixel = {0, 0, 0}; // Fill with black pixels (BGR format)
+    BMPWriter(const char* filename, int32_t width, int32_t height)
+        : _width(width), _height(height), _nextRow(0) {
+        _rowSize = (width * 3 + 3) & ~3;
+        _outFile.open(filename, std::ios::binary);
+
+        // Check is open
+        if (!_outFile.is_open()) {
+            std::cerr << "Could not open image file: " << filename << std::endl;
+            return;
         }
+
+        BITMAPFILEHEADER FileHeader;
+        BITMAPINFOHEADER InfoHeader;
+        createBMPHeaders(width, height, FileHeader, InfoHeader);
+        _outFile.write(reinterpret_cast<char*>(&FileHeader), sizeof(FileHeader));
+        _outFile.write(reinterpret_cast<char*>(&InfoHeader), sizeof(InfoHeader));
+    }
+
+    /// @return true if file opened
+    bool isOpen(void) const {
+        return _outFile.is_open();
     }
 
     /**
-     * @brief Write a new .bmp file.
+     * @brief Number of rows per block that fits in blockBytes of padded output
      * 
-     * @param filename Full file pathways and .bmp extension
+     * @param blockBytes Target block size
+     * @return int At least 1
      */
-    void write(const char* filename) {
-        // Open file
-        std::ofstream outFile(filename, std::ios::binary);
+    int rowsPerBlock(size_t blockBytes = 4 << 20) const {
+        size_t rows = blockBytes / _rowSize;
+        return (rows == 0) ? 1 : static_cast<int>(rows);
+    }
 
-        // Check is open
-        if (!outFile.is_open()) {
-            std::cerr << "Could not open image file: " << filename << std::endl;
-            return;
+    /**
+     * @brief Write the next nRows rows, top down
+     * 
+     * @param rows nRows * width pixels, rows packed without padding
+     * @param nRows Number of rows in block
+     * @return true 
+     * @return false If file is not open or more rows than height were given
+     */
+    bool writeRows(const RGBTRIPLE* rows, int nRows) {
+        if (!_outFile.is_open() || nRows <= 0 || _nextRow + nRows > _height) {
+            std::cerr << "Error: Invalid rows for image writer." << std::endl;
+            return false;
         }
 
-        // Write file headers
-        outFile.write(reinterpret_cast<char*>(&FileHeader), sizeof(FileHeader));
-        outFile.write(reinterpret_cast<char*>(&InfoHeader), sizeof(InfoHeader));
-
-        // Work out padding for 4 byte increments
-        int rowSize = (InfoHeader.biWidth * 3 + 3) & ~3;
-        int padding = rowSize - InfoHeader.biWidth * 3;
-
-        BYTE paddingBytes[3] = {0, 0, 0};
-
-        // Iterate over pixel information to write to
-        for (int i = 0; i < InfoHeader.biHeight; i++) {
-            for (int j = 0; j < InfoHeader.biWidth; j++) {
-                RGBTRIPLE pixel = data[(i * InfoHeader.biWidth) + j];
-                outFile.write(reinterpret_cast<char*>(&pixel), sizeof(pixel));
-            }
-            if (padding > 0) {
-                outFile.write(reinterpret_cast<char*>(paddingBytes), padding);
-            }
+        // Reverse rows into a padded block
+        _block.assign(static_cast<size_t>(nRows) * _rowSize, 0);
+        for (int i = 0; i < nRows; i++) {
+            std::memcpy(&_block[static_cast<size_t>(nRows - 1 - i) * _rowSize],
+                        rows + static_cast<size_t>(i) * _width, static_cast<size_t>(_width) * 3);
         }
-        // Close file
-        outFile.close();
+
+        // Block lands above rows that are written later
+        std::streamoff offset = 54 + static_cast<std::streamoff>(_height - _nextRow - nRows) * _rowSize;
+        _outFile.seekp(offset);
+        _outFile.write(_block.data(), _block.size());
+        _nextRow += nRows;
+        return _outFile.good();
     }
 
     /**
-     * @brief Set pixel data to BMP object
+     * @brief Close file
      * 
-     * @param x Position in row
-     * @param y Position in column
-     * @param pixel RGBTRIPLE data (B, G, R) 0-255
-     * @return * void 
+     * @return true If every row was written
+     * @return false 
      */
-    void setPixel(int x, int y, RGBTRIPLE pixel) {
-        // Check inbounds
-        if (x >= 0 && x < InfoHeader.biWidth && y >= 0 && y < InfoHeader.biHeight) {
-            data[(y * InfoHeader.biWidth) + x] = pixel;
-        } else {
-            std::cerr << "Error: Pixel out of bounds (" << x << ", " << y << ")\n";
-        }
+    bool close(void) {
+        if (!_outFile.is_open()) return false;
+        _outFile.close();
+        return _nextRow == _height && !_outFile.fail();
     }
+
+private:
+    std::ofstream _outFile;
+    int32_t _width, _height;
+    uint32_t _rowSize;
+    int _nextRow;
+    std::vector<char> _block;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,539 @@
+/**
+ * @file Deflate.cpp
+ * @author Ollie
+ * @brief Self-contained deflate (RFC 1951) encoder and checksums for PNG output
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "Deflate.h"
+#include <algorithm>
+#include <queue>
+#include <utility>
+#include <cstring>
+
+// LZ77 parameters
+static const size_t WSIZE = 32768;     // Window size
+static const size_t WMASK = WSIZE - 1;
+static const int HASH_BITS = 15;
+static const int MIN_MATCH = 3;
+static const int MAX_MATCH = 258;
+static const int MAX_CHAIN = 32;       // Candidates tried per position
+static const int NICE_MATCH = 128;     // Stop searching at this length
+static const int LAZY_MATCH = 32;      // Only try a later match below this length
+static const int GOOD_MATCH = 8;       // Lazy search uses a quarter of the chain above this length
+static const size_t TOO_FAR = 4096;    // Length 3 matches further than this cost more than literals
+static const size_t BLOCK_SYMBOLS = 32768;
+
+// Length (257 - 285) and distance (0 - 29) code bases and extra bits
+static const int LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const int LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                     3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const int DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                  8193, 12289, 16385, 24577};
+static const int DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                   7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Order code length code lengths are sent in
+static const int CL_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+/**
+ * @brief Literal or match produced by LZ77. dist 0 for literals.
+ */
+struct Token {
+    uint16_t value; // Literal byte or match length
+    uint16_t dist;
+};
+
+/**
+ * @brief Lookup from match length and distance to code index
+ */
+struct CodeTables {
+    uint8_t lengthCode[MAX_MATCH + 1];
+    uint8_t distCode[512]; // First 256 by distance - 1, rest by (distance - 1) >> 7
+
+    CodeTables() {
+        for (int code = 0; code < 29; code++) {
+            for (int len = LENGTH_BASE[code]; len < LENGTH_BASE[code] + (1 << LENGTH_EXTRA[code]) && len <= MAX_MATCH; len++) {
+                lengthCode[len] = code; // 258 is overwritten by code 28
+            }
+        }
+        for (int code = 0; code < 30; code++) {
+            for (int d = DIST_BASE[code]; d < DIST_BASE[code] + (1 << DIST_EXTRA[code]); d++) {
+                if (d <= 256) distCode[d - 1] = code;
+                else distCode[256 + ((d - 1) >> 7)] = code;
+            }
+        }
+    }
+
+    int getDistCode(int dist) const {
+        return (dist <= 256) ? distCode[dist - 1] : distCode[256 + ((dist - 1) >> 7)];
+    }
+};
+
+static const CodeTables& getCodeTables(void) {
+    static const CodeTables tables;
+    return tables;
+}
+
+/**
+ * @brief LSB first bit packer
+ */
+struct BitWriter {
+    std::vector<uint8_t>& out;
+    uint64_t buffer = 0;
+    int count = 0;
+
+    explicit BitWriter(std::vector<uint8_t>& output) : out(output) {}
+
+    void put(uint32_t bits, int n) {
+        buffer |= static_cast<uint64_t>(bits) << count;
+        count += n;
+        while (count >= 8) {
+            out.push_back(buffer & 0xFF);
+            buffer >>= 8;
+            count -= 8;
+        }
+    }
+
+    void align(void) {
+        if (count > 0) {
+            out.push_back(buffer & 0xFF);
+            buffer = 0;
+            count = 0;
+        }
+    }
+};
+
+/**
+ * @brief Huffman code lengths limited to maxBits. Frequencies are halved until the tree fits.
+ * Trees are always complete, a lone symbol gets a partner so strict decoders accept it.
+ */
+static void buildLengths(const uint32_t* freq, int n, int maxBits, uint8_t* lengths) {
+    std::vector<uint32_t> f(freq, freq + n);
+    while (true) {
+        std::vector<int> symbols;
+        for (int i = 0; i < n; i++) {
+            lengths[i] = 0;
+            if (f[i] > 0) symbols.push_back(i);
+        }
+        if (symbols.empty()) return;
+        if (symbols.size() == 1) {
+            lengths[symbols[0]] = 1;
+            lengths[(symbols[0] == 0) ? 1 : 0] = 1;
+            return;
+        }
+
+        // Merge two lightest nodes until one remains. Leaves are 0..k-1
+        int k = symbols.size();
+        using Node = std::pair<uint64_t, int>;
+        std::priority_queue<Node, std::vector<Node>, std::greater<Node>> heap;
+        std::vector<int> parent(2 * k - 1, -1);
+        for (int j = 0; j < k; j++) {
+            heap.push({f[symbols[j]], j});
+        }
+        int next = k;
+        while (heap.size() > 1) {
+            Node a = heap.top(); heap.pop();
+            Node b = heap.top(); heap.pop();
+            parent[a.second] = next;
+            parent[b.second] = next;
+            heap.push({a.first + b.first, next});
+            next++;
+        }
+
+        // Parents always have higher indexes, so depths resolve from the root down
+        std::vector<int> depth(next, 0);
+        for (int i = next - 2; i >= 0; i--) {
+            depth[i] = depth[parent[i]] + 1;
+        }
+        int maxLength = 0;
+        for (int j = 0; j < k; j++) {
+            lengths[symbols[j]] = depth[j];
+            maxLength = std::max(maxLength, depth[j]);
+        }
+        if (maxLength <= maxBits) return;
+
+        for (auto& value : f) {
+            if (value > 0) value = (value + 1) / 2;
+        }
+    }
+}
+
+/**
+ * @brief Canonical codes from lengths, bit reversed for LSB first output
+ */
+static void buildCodes(const uint8_t* lengths, int n, uint16_t* codes) {
+    int blCount[16] = {0};
+    for (int i = 0; i < n; i++) {
+        if (lengths[i]) blCount[lengths[i]]++;
+    }
+    int nextCode[16] = {0};
+    int code = 0;
+    for (int bits = 1; bits < 16; bits++) {
+        code = (code + blCount[bits - 1]) << 1;
+        nextCode[bits] = code;
+    }
+    for (int i = 0; i < n; i++) {
+        int len = lengths[i];
+        codes[i] = 0;
+        if (len == 0) continue;
+        int c = nextCode[len]++;
+        int reversed = 0;
+        for (int b = 0; b < len; b++) {
+            reversed = (reversed << 1) | ((c >> b) & 1);
+        }
+        codes[i] = reversed;
+    }
+}
+
+/**
+ * @brief Write raw bytes as stored blocks
+ */
+static void writeStored(BitWriter& bw, const uint8_t* data, size_t size, bool final) {
+    size_t pos = 0;
+    do {
+        size_t n = std::min<size_t>(65535, size - pos);
+        bool last = (pos + n == size);
+        bw.put((final && last) ? 1 : 0, 1);
+        bw.put(0, 2);
+        bw.align();
+        bw.out.push_back(n & 0xFF);
+        bw.out.push_back(n >> 8);
+        bw.out.push_back(~n & 0xFF);
+        bw.out.push_back((~n >> 8) & 0xFF);
+        bw.out.insert(bw.out.end(), data + pos, data + pos + n);
+        pos += n;
+    } while (pos < size);
+}
+
+/**
+ * @brief Write tokens as a dynamic Huffman block, or the raw bytes they cover if that is smaller
+ */
+static void writeBlock(BitWriter& bw, const std::vector<Token>& tokens, const uint8_t* raw, size_t rawSize, bool final) {
+    const CodeTables& tables = getCodeTables();
+
+    // Symbol frequencies and extra bits
+    uint32_t litFreq[286] = {0};
+    uint32_t distFreq[30] = {0};
+    uint64_t extraBits = 0;
+    for (const Token& token : tokens) {
+        if (token.dist == 0) {
+            litFreq[token.value]++;
+        }
+        else {
+            int lc = tables.lengthCode[token.value];
+            int dc = tables.getDistCode(token.dist);
+            litFreq[257 + lc]++;
+            distFreq[dc]++;
+            extraBits += LENGTH_EXTRA[lc] + DIST_EXTRA[dc];
+        }
+    }
+    litFreq[256] = 1; // End of block
+
+    uint8_t litLengths[286];
+    uint8_t distLengths[30];
+    buildLengths(litFreq, 286, 15, litLengths);
+    buildLengths(distFreq, 30, 15, distLengths);
+    if (std::all_of(distLengths, distLengths + 30, [](uint8_t l) { return l == 0; })) {
+        distLengths[0] = 1; // At least one distance code must be sent
+        distLengths[1] = 1;
+    }
+
+    int hlit = 286;
+    while (hlit > 257 && litLengths[hlit - 1] == 0) hlit--;
+    int hdist = 30;
+    while (hdist > 1 && distLengths[hdist - 1] == 0) hdist--;
+
+    // Run length encode both length sets as one sequence
+    std::vector<uint8_t> all(litLengths, litLengths + hlit);
+    all.insert(all.end(), distLengths, distLengths + hdist);
+    std::vector<std::pair<uint8_t, uint8_t>> rle; // (symbol, extra value)
+    for (size_t i = 0; i < all.size();) {
+        uint8_t value = all[i];
+        size_t run = 1;
+        while (i + run < all.size() && all[i + run] == value) run++;
+        size_t remaining = run;
+        if (value == 0) {
+            while (remaining >= 11) {
+                size_t k = std::min<size_t>(remaining, 138);
+                rle.push_back({18, static_cast<uint8_t>(k - 11)});
+                remaining -= k;
+            }
+            if (remaining >= 3) {
+                rle.push_back({17, static_cast<uint8_t>(remaining - 3)});
+                remaining = 0;
+            }
+        }
+        else {
+            rle.push_back({value, 0});
+            remaining--;
+            while (remaining >= 3) {
+                size_t k = std::min<size_t>(remaining, 6);
+                rle.push_back({16, static_cast<uint8_t>(k - 3)});
+                remaining -= k;
+            }
+        }
+        while (remaining > 0) {
+            rle.push_back({value, 0});
+            remaining--;
+        }
+        i += run;
+    }
+
+    uint32_t clFreq[19] = {0};
+    for (const auto& [symbol, extra] : rle) clFreq[symbol]++;
+    uint8_t clLengths[19];
+    buildLengths(clFreq, 19, 7, clLengths);
+    int hclen = 19;
+    while (hclen > 4 && clLengths[CL_ORDER[hclen - 1]] == 0) hclen--;
+
+    // Compare exact dynamic size with storing
+    uint64_t bits = 3 + 14 + 3 * hclen + extraBits;
+    for (const auto& [symbol, extra] : rle) {
+        bits += clLengths[symbol] + ((symbol == 16) ? 2 : (symbol == 17) ? 3 : (symbol == 18) ? 7 : 0);
+    }
+    for (int i = 0; i < 286; i++) bits += static_cast<uint64_t>(litFreq[i]) * litLengths[i];
+    for (int i = 0; i < 30; i++) bits += static_cast<uint64_t>(distFreq[i]) * distLengths[i];
+    uint64_t storedBits = 8 * (rawSize + 5 * (rawSize / 65535 + 1)) + 8;
+    if (storedBits < bits) {
+        writeStored(bw, raw, rawSize, final);
+        return;
+    }
+
+    uint16_t clCodes[19], litCodes[286], distCodes[30];
+    buildCodes(clLengths, 19, clCodes);
+    buildCodes(litLengths, 286, litCodes);
+    buildCodes(distLengths, 30, distCodes);
+
+    // Header and code lengths
+    bw.put(final ? 1 : 0, 1);
+    bw.put(2, 2);
+    bw.put(hlit - 257, 5);
+    bw.put(hdist - 1, 5);
+    bw.put(hclen - 4, 4);
+    for (int i = 0; i < hclen; i++) {
+        bw.put(clLengths[CL_ORDER[i]], 3);
+    }
+    for (const auto& [symbol, extra] : rle) {
+        bw.put(clCodes[symbol], clLengths[symbol]);
+        if (symbol == 16) bw.put(extra, 2);
+        else if (symbol == 17) bw.put(extra, 3);
+        else if (symbol == 18) bw.put(extra, 7);
+    }
+
+    // Symbols
+    for (const Token& token : tokens) {
+        if (token.dist == 0) {
+            bw.put(litCodes[token.value], litLengths[token.value]);
+            continue;
+        }
+        int lc = tables.lengthCode[token.value];
+        bw.put(litCodes[257 + lc], litLengths[257 + lc]);
+        bw.put(token.value - LENGTH_BASE[lc], LENGTH_EXTRA[lc]);
+        int dc = tables.getDistCode(token.dist);
+        bw.put(distCodes[dc], distLengths[dc]);
+        bw.put(token.dist - DIST_BASE[dc], DIST_EXTRA[dc]);
+    }
+    bw.put(litCodes[256], litLengths[256]);
+}
+
+/**
+ * @brief Number of equal leading bytes, compared a word at a time
+ */
+static int matchLength(const uint8_t* a, const uint8_t* b, int maxLength) {
+    int len = 0;
+    while (len + 8 <= maxLength) {
+        uint64_t wordA, wordB;
+        std::memcpy(&wordA, a + len, 8);
+        std::memcpy(&wordB, b + len, 8);
+        if (wordA != wordB) break;
+        len += 8;
+    }
+    while (len < maxLength && a[len] == b[len]) len++;
+    return len;
+}
+
+/**
+ * @brief LZ77 over hash chains, then Huffman blocks
+ */
+void deflatePiece(const uint8_t* data, size_t dictSize, size_t size, bool final, std::vector<uint8_t>& out) {
+    BitWriter bw(out);
+    if (dictSize > WSIZE) {
+        data += dictSize - WSIZE;
+        dictSize = WSIZE;
+    }
+    const size_t end = dictSize + size;
+
+    std::vector<int32_t> head(1 << HASH_BITS, -1);
+    std::vector<int32_t> prev(WSIZE, -1);
+    size_t inserted = 0;
+
+    auto hashAt = [&](size_t p) {
+        uint32_t v = data[p] | (data[p + 1] << 8) | (data[p + 2] << 16);
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    };
+    // Add every position before p to the chains
+    auto insertUpTo = [&](size_t p) {
+        for (; inserted < p; inserted++) {
+            if (inserted + MIN_MATCH > end) continue;
+            uint32_t h = hashAt(inserted);
+            prev[inserted & WMASK] = head[h];
+            head[h] = inserted;
+        }
+    };
+    // Longest earlier match at p, length 0 if none
+    auto findMatch = [&](size_t p, int& bestDist, int maxChain) {
+        bestDist = 0;
+        if (p + MIN_MATCH > end) return 0;
+        int maxLength = std::min<size_t>(MAX_MATCH, end - p);
+        size_t limit = (p > WSIZE) ? p - WSIZE : 0;
+        int best = 0;
+        int32_t candidate = head[hashAt(p)];
+        for (int chain = 0; chain < maxChain && candidate >= 0 && static_cast<size_t>(candidate) >= limit; chain++) {
+            const uint8_t* a = data + candidate;
+            const uint8_t* b = data + p;
+            if (a[best] == b[best]) {
+                int len = matchLength(a, b, maxLength);
+                if (len > best) {
+                    best = len;
+                    bestDist = p - candidate;
+                    if (len >= maxLength || len >= NICE_MATCH) break;
+                }
+            }
+            int32_t next = prev[candidate & WMASK];
+            if (next >= candidate) break; // Slot reused by a newer position
+            candidate = next;
+        }
+        if (best < MIN_MATCH || (best == MIN_MATCH && static_cast<size_t>(bestDist) > TOO_FAR)) {
+            return 0;
+        }
+        return best;
+    };
+
+    std::vector<Token> tokens;
+    tokens.reserve(BLOCK_SYMBOLS);
+    size_t pos = dictSize;
+    size_t blockStart = dictSize;
+    // Match found one byte ahead by the lazy check, reused at the next position
+    bool havePending = false;
+    int pendingLen = 0, pendingDist = 0;
+    while (pos < end) {
+        insertUpTo(pos);
+        int dist;
+        int len;
+        if (havePending) {
+            len = pendingLen;
+            dist = pendingDist;
+            havePending = false;
+        }
+        else {
+            len = findMatch(pos, dist, MAX_CHAIN);
+        }
+
+        // Prefer a longer match starting one byte later
+        bool lazy = false;
+        if (len > 0 && len < LAZY_MATCH && pos + 1 < end) {
+            insertUpTo(pos + 1);
+            int nextDist;
+            int nextLen = findMatch(pos + 1, nextDist, (len >= GOOD_MATCH) ? MAX_CHAIN / 4 : MAX_CHAIN);
+            if (nextLen > len) {
+                lazy = true;
+                havePending = true;
+                pendingLen = nextLen;
+                pendingDist = nextDist;
+            }
+        }
+
+        if (len > 0 && !lazy) {
+            tokens.push_back({static_cast<uint16_t>(len), static_cast<uint16_t>(dist)});
+            pos += len;
+        }
+        else {
+            tokens.push_back({data[pos], 0});
+            pos++;
+        }
+
+        if (tokens.size() >= BLOCK_SYMBOLS) {
+            writeBlock(bw, tokens, data + blockStart, pos - blockStart, final && pos == end);
+            tokens.clear();
+            blockStart = pos;
+        }
+    }
+    if (!tokens.empty()) {
+        writeBlock(bw, tokens, data + blockStart, end - blockStart, final);
+    }
+    else if (final && size == 0) {
+        // Empty fixed Huffman block ends the stream
+        bw.put(1, 1);
+        bw.put(1, 2);
+        bw.put(0, 7);
+    }
+
+    if (!final) {
+        // Sync flush: empty stored block realigns to a byte boundary
+        bw.put(0, 3);
+        bw.align();
+        out.push_back(0x00);
+        out.push_back(0x00);
+        out.push_back(0xFF);
+        out.push_back(0xFF);
+    }
+    bw.align();
+}
+
+/**
+ * @brief Empty final fixed Huffman block
+ */
+void deflateFinish(std::vector<uint8_t>& out) {
+    out.push_back(0x03);
+    out.push_back(0x00);
+}
+
+/**
+ * @brief Adler-32, summed in runs short enough not to overflow
+ */
+uint32_t adler32(uint32_t adler, const uint8_t* data, size_t size) {
+    const uint32_t MOD = 65521;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (size > 0) {
+        size_t n = std::min<size_t>(size, 5552);
+        size -= n;
+        for (size_t i = 0; i < n; i++) {
+            a += data[i];
+            b += a;
+        }
+        data += n;
+        a %= MOD;
+        b %= MOD;
+    }
+    return (b << 16) | a;
+}
+
+/**
+ * @brief Table driven CRC-32
+ */
+uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size) {
+    static const std::vector<uint32_t> table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
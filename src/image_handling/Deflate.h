@@ -0,0 +1,64 @@
+/**
+ * @file Deflate.h
+ * @author Ollie
+ * @brief Self-contained deflate (RFC 1951) encoder and checksums for PNG output
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef DEFLATE_H
+#define DEFLATE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Update an Adler-32 checksum (zlib stream trailer)
+ *
+ * @param adler Running checksum, 1 to start
+ * @param data
+ * @param size Number of bytes
+ * @return uint32_t
+ */
+uint32_t adler32(uint32_t adler, const uint8_t* data, size_t size);
+
+/**
+ * @brief Update a CRC-32 checksum (PNG chunk trailer)
+ *
+ * @param crc Running checksum, 0 to start
+ * @param data
+ * @param size Number of bytes
+ * @return uint32_t
+ */
+uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size);
+
+/**
+ * @brief Compress a piece of a deflate stream.
+ * Bytes before data + dictSize are the preceding input of the stream and may be
+ * referenced by matches, so pieces compressed independently (e.g. in parallel) can be
+ * concatenated in order into one stream.
+ * Non-final pieces end on a byte boundary with an empty stored block (sync flush).
+ * The final piece ends with the last block of the stream.
+ *
+ * Matches use hash chains over a 32 KB window with one step lazy matching. Each block
+ * of up to 32K symbols gets its own dynamic Huffman codes, or is stored if smaller.
+ *
+ * @param data Start of dictionary
+ * @param dictSize Number of dictionary bytes, at most 32768 are used
+ * @param size Number of bytes to compress after the dictionary
+ * @param final If this piece ends the stream
+ * @param out Compressed bytes are appended
+ */
+void deflatePiece(const uint8_t* data, size_t dictSize, size_t size, bool final, std::vector<uint8_t>& out);
+
+/**
+ * @brief Append an empty final block, ending a stream of non-final pieces
+ *
+ * @param out Compressed bytes are appended
+ */
+void deflateFinish(std::vector<uint8_t>& out);
+
+#endif
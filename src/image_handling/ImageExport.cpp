@@ -1,7 +1,7 @@
 /**
  * @file ImageExport.cpp
  * @author Ollie
- * @brief Image exporter methods to save Maps as .bmp
+ * @brief Image exporter methods to save Maps as .bmp or .png
  * @version 1.1.0
  * @date 2025-03-13
  * 
@@ -13,70 +13,428 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include "../parallel/parallelFor.h"
+#include "../profiling/Profiler.h"
 
 /**
- * @brief  Export a Map object to a BMP image using the specified color map.
+ * @brief True if filename ends in .png
+ */
+static bool isPNGFile(const std::string& filename) {
+    return filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".png") == 0;
+}
+
+/**
+ * @brief  Export a Map object to a BMP or PNG image using the specified color map.
  */
 template <typename T>
 bool ImageExport<T>::exportMapToImage(const Map<T>& map, const std::string& filename,
-    const std::string& colourmapName, bool continuous) {
+    const std::string& colourmapName, bool continuous, const MapScaler<T>* scaler) {
+    ProfileScope scope("export_image", "kernel", static_cast<uint64_t>(map.getWidth()) * map.getHeight());
+
+    // Bake colourmap once
+    std::vector<RGBTRIPLE> lut = getColourLUT(colourmapName, continuous);
+    if (lut.empty()) {
+        return false;
+    }
+
+    int width = map.getWidth();
+    int height = map.getHeight();
+
+    // Find min and max values for scaling
+    T minValue, maxValue;
+    findRange(map, minValue, maxValue, scaler);
+
+    // PNG by extension
+    if (isPNGFile(filename)) {
+        return exportPNG(map, filename, lut, minValue, maxValue, scaler);
+    }
+
+    // Render and write BMP pixel data block by block
+    return writeRGBImage(filename, width, height, [&](int y0, int y1, RGBTRIPLE* pixels) {
+        renderRows(map, lut, minValue, maxValue, y0, y1, pixels, scaler);
+    });
+}
+
+/**
+ * @brief Export colourmapped Map blended over hillshade
+ */
+template <typename T>
+bool ImageExport<T>::exportBlendedImage(const Map<T>& map, const Map<T>& hillshade, const std::string& filename,
+    const std::string& colourmapName, bool continuous, double opacity, const MapScaler<T>* scaler) {
+    ProfileScope scope("export_image", "kernel", static_cast<uint64_t>(map.getWidth()) * map.getHeight());
+    if (hillshade.getWidth() != map.getWidth() || hillshade.getHeight() != map.getHeight()) {
+        std::cerr << "Error: Hillshade must be the same size as the map." << std::endl;
+        return false;
+    }
+
+    // Bake colourmap once
+    std::vector<RGBTRIPLE> lut = getColourLUT(colourmapName, continuous);
+    if (lut.empty()) {
+        return false;
+    }
+
+    // Find min and max values for scaling
+    T minValue, maxValue;
+    findRange(map, minValue, maxValue, scaler);
+
+    opacity = std::min(std::max(opacity, 0.0), 1.0);
+    return writeRGBImage(filename, map.getWidth(), map.getHeight(), [&](int y0, int y1, RGBTRIPLE* pixels) {
+        renderBlendRows(map, lut, minValue, maxValue, hillshade, opacity, y0, y1, pixels, scaler);
+    });
+}
+
+/**
+ * @brief Stream RGB blocks to BMP or PNG
+ */
+template <typename T>
+template <typename Render>
+bool ImageExport<T>::writeRGBImage(const std::string& filename, int width, int height, Render render) {
+    if (isPNGFile(filename)) {
+        PNGWriter image(filename.c_str(), width, height);
+        if (!image.isOpen()) {
+            return false;
+        }
+        int blockRows = image.rowsPerBlock();
+        std::vector<RGBTRIPLE> block(static_cast<size_t>(std::min(blockRows, height)) * width);
+        for (int y0 = 0; y0 < height; y0 += blockRows) {
+            int y1 = std::min(height, y0 + blockRows);
+            render(y0, y1, block.data());
+            image.writeRows(block.data(), y1 - y0);
+        }
+        return image.close();
+    }
+
+    // Stream BMP a block of rows at a time
+    BMPWriter image(filename.c_str(), width, height);
+    if (!image.isOpen()) {
+        return false;
+    }
+    int blockRows = image.rowsPerBlock();
+    std::vector<RGBTRIPLE> block(static_cast<size_t>(std::min(blockRows, height)) * width);
+    for (int y0 = 0; y0 < height; y0 += blockRows) {
+        int y1 = std::min(height, y0 + blockRows);
+        render(y0, y1, block.data());
+        image.writeRows(block.data(), y1 - y0);
+    }
+    return image.close();
+}
 
+/**
+ * @brief Stream rows to a PNG, indexed if the image has few enough colours
+ */
+template <typename T>
+bool ImageExport<T>::exportPNG(const Map<T>& map, const std::string& filename, const std::vector<RGBTRIPLE>& lut,
+    T minValue, T maxValue, const MapScaler<T>* scaler) {
     int width = map.getWidth();
     int height = map.getHeight();
-    // Create BMP object
-    BMP image(width, height);
+
+    // Palette for few distinct colours
+    std::vector<RGBTRIPLE> palette;
+    std::vector<uint8_t> indexes;
+    if (!buildColourPalette(lut, findUsedEntries(map, minValue, maxValue, scaler), palette, indexes)) {
+        // Too many colours for a palette
+        return writeRGBImage(filename, width, height, [&](int y0, int y1, RGBTRIPLE* pixels) {
+            renderRows(map, lut, minValue, maxValue, y0, y1, pixels, scaler);
+        });
+    }
+
+    PNGWriter image(filename.c_str(), width, height, &palette);
+    if (!image.isOpen()) {
+        return false;
+    }
+
+    int blockRows = image.rowsPerBlock();
+    std::vector<uint8_t> block(static_cast<size_t>(std::min(blockRows, height)) * width);
+    for (int y0 = 0; y0 < height; y0 += blockRows) {
+        int y1 = std::min(height, y0 + blockRows);
+        renderIndexRows(map, indexes, minValue, maxValue, y0, y1, block.data(), scaler);
+        image.writeIndexedRows(block.data(), y1 - y0);
+    }
+    return image.close();
+}
+
+// Baked tables by colourmap name and continuity, shared by every export in the process
+static std::map<std::pair<std::string, bool>, std::vector<RGBTRIPLE>> bakedLUTs;
+static std::mutex bakedLUTsMutex;
+
+/**
+ * @brief Load and bake colourmap, once per process
+ */
+template <typename T>
+std::vector<RGBTRIPLE> ImageExport<T>::getColourLUT(const std::string& colourmapName, bool continuous) {
+    std::lock_guard<std::mutex> lock(bakedLUTsMutex);
+    auto baked = bakedLUTs.find({colourmapName, continuous});
+    if (baked != bakedLUTs.end()) {
+        return baked->second;
+    }
 
     // Create colourmap filepath from colour code
     std::string colourmapFile = "../data/colourmaps/" + colourmapName + ".txt";
     // Load colourmap from file
     std::vector<RGBTRIPLE> colourmap = loadColourmap(colourmapFile);
 
-    // Bad map check
+    // Bad map check, not remembered so a later export retries
     if (colourmap.empty()) {
         std::cerr << "Failed to load colourmap: " << colourmapFile << std::endl;
-        return false;
+        return colourmap;
     }
+    std::vector<RGBTRIPLE> lut = buildColourLUT(colourmap, continuous);
+    bakedLUTs[{colourmapName, continuous}] = lut;
+    return lut;
+}
 
-    T minValue = std::numeric_limits<T>::max();
-    T maxValue = std::numeric_limits<T>::min();
+/**
+ * @brief Parallel min and max reduction of a Map or RasterView
+ */
+template <typename T, typename Grid>
+static void findRangeIn(const Grid& map, T& minValue, T& maxValue, const MapScaler<T>* scaler) {
+    int width = map.getWidth();
+    int height = map.getHeight();
 
-    // Find min and max values for scaling
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            T value = map.getData(j, i);
-            if (value < minValue) minValue = value;
-            if (value > maxValue) maxValue = value;
+    using Range = std::pair<T, T>;
+    Range identity(std::numeric_limits<T>::max(), std::numeric_limits<T>::lowest());
+    Range range = parallelReduce(0, height, getThreadCount(), identity, [&](int y0, int y1) {
+        T localMin = identity.first;
+        T localMax = identity.second;
+        for (int y = y0; y < y1; y++) {
+            const T* row = map.getRow(y);
+            // Branchless form so the compiler can vectorise
+            for (int x = 0; x < width; x++) {
+                localMin = (row[x] < localMin) ? row[x] : localMin;
+                localMax = (row[x] > localMax) ? row[x] : localMax;
+            }
         }
+        return Range(localMin, localMax);
+    }, [](const Range& a, const Range& b) {
+        return Range(std::min(a.first, b.first), std::max(a.second, b.second));
+    });
+    minValue = range.first;
+    maxValue = range.second;
+
+    // Scales never decrease, so the ends stay the ends
+    if (scaler) {
+        minValue = scaler->apply(minValue);
+        maxValue = scaler->apply(maxValue);
+    }
+}
+
+/**
+ * @brief Range of a Map
+ */
+template <typename T>
+void ImageExport<T>::findRange(const Map<T>& map, T& minValue, T& maxValue, const MapScaler<T>* scaler) {
+    findRangeIn(map, minValue, maxValue, scaler);
+}
+
+/**
+ * @brief Range of caller-owned values
+ */
+template <typename T>
+void ImageExport<T>::findRange(const RasterView<const T>& values, T& minValue, T& maxValue,
+    const MapScaler<T>* scaler) {
+    findRangeIn(values, minValue, maxValue, scaler);
+}
+
+/**
+ * @brief Colour caller-owned values into caller-owned RGB rows
+ */
+template <typename T>
+bool ImageExport<T>::renderRGB(const RasterView<const T>& values, const std::string& colourmapName, bool continuous,
+    const RasterView<uint8_t>& rgb, const MapScaler<T>* scaler) {
+    std::vector<RGBTRIPLE> lut = getColourLUT(colourmapName, continuous);
+    if (lut.empty()) {
+        return false;
+    }
+    return renderRGB(values, lut, rgb, scaler);
+}
+
+/**
+ * @brief Colour caller-owned values into caller-owned RGB rows from a baked table
+ */
+template <typename T>
+bool ImageExport<T>::renderRGB(const RasterView<const T>& values, const std::vector<RGBTRIPLE>& lut,
+    const RasterView<uint8_t>& rgb, const MapScaler<T>* scaler) {
+    if (!values.isValid() || !rgb.isValid() || rgb.width != 3 * values.width || rgb.height != values.height) {
+        std::cerr << "Error: RGB raster must be 3 bytes per cell of the values raster." << std::endl;
+        return false;
+    }
+    if (lut.size() != static_cast<size_t>(COLOUR_LUT_SIZE)) {
+        std::cerr << "Error: Colour table must have " << COLOUR_LUT_SIZE << " entries." << std::endl;
+        return false;
     }
+    ProfileScope scope("render_image", "kernel", static_cast<uint64_t>(values.width) * values.height);
+    T minValue, maxValue;
+    findRange(values, minValue, maxValue, scaler);
+
+    int width = values.width;
+    parallelFor(0, values.height, getThreadCount(), [&](int, int y0, int y1) {
+        std::vector<RGBTRIPLE> pixels(width);
+        for (int y = y0; y < y1; y++) {
+            renderSpan(values, lut, minValue, maxValue, 0, width, y, pixels.data(), scaler);
+            uint8_t* out = rgb.getRow(y);
+            for (int x = 0; x < width; x++) {
+                out[3 * x] = pixels[x].rgbtRed;
+                out[3 * x + 1] = pixels[x].rgbtGreen;
+                out[3 * x + 2] = pixels[x].rgbtBlue;
+            }
+        }
+    });
+    return true;
+}
+
+/**
+ * @brief Parallel scan of table entries in use
+ */
+template <typename T>
+std::vector<uint8_t> ImageExport<T>::findUsedEntries(const Map<T>& map, T minValue, T maxValue,
+    const MapScaler<T>* scaler) {
+    int width = map.getWidth();
+    int height = map.getHeight();
+    int nThreads = getThreadCount();
 
     double range;
     if (maxValue != minValue) {
-        range = maxValue - minValue;
+        range = static_cast<double>(maxValue) - static_cast<double>(minValue);
     } else {
         range = 1.0;
     }
+    double scale = 1.0 / range;
+    double offset = static_cast<double>(minValue);
+
+    std::vector<std::vector<uint8_t>> threadUsed(nThreads);
+    parallelFor(0, height, nThreads, [&](int t, int y0, int y1) {
+        std::vector<uint8_t>& used = threadUsed[t];
+        used.assign(COLOUR_LUT_SIZE, 0);
+        for (int y = y0; y < y1; y++) {
+            const T* row = map.getRow(y);
+            if (scaler) {
+                for (int x = 0; x < width; x++) {
+                    used[colourLUTIndex((scaler->apply(row[x]) - offset) * scale)] = 1;
+                }
+            }
+            else {
+                for (int x = 0; x < width; x++) {
+                    used[colourLUTIndex((row[x] - offset) * scale)] = 1;
+                }
+            }
+        }
+    });
+
+    // Merge, skipping threads that got no rows
+    std::vector<uint8_t> used(COLOUR_LUT_SIZE, 0);
+    for (const auto& local : threadUsed) {
+        for (size_t i = 0; i < local.size(); i++) {
+            used[i] |= local[i];
+        }
+    }
+    return used;
+}
+
+/**
+ * @brief Colour rows
+ */
+template <typename T>
+void ImageExport<T>::renderRows(const Map<T>& map, const std::vector<RGBTRIPLE>& lut, T minValue, T maxValue,
+    int y0, int y1, RGBTRIPLE* pixels, const MapScaler<T>* scaler) {
+    renderTable(map, lut, minValue, maxValue, y0, y1, pixels, scaler);
+}
+
+/**
+ * @brief Palette index rows
+ */
+template <typename T>
+void ImageExport<T>::renderIndexRows(const Map<T>& map, const std::vector<uint8_t>& indexes, T minValue, T maxValue,
+    int y0, int y1, uint8_t* pixels, const MapScaler<T>* scaler) {
+    renderTable(map, indexes, minValue, maxValue, y0, y1, pixels, scaler);
+}
 
-    // Write pixel data
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            T value = map.getData(j, i);
-            double normalizedValue = static_cast<double>(value - minValue) / range;
+/**
+ * @brief Parallel lookup table render
+ */
+template <typename T>
+template <typename Pixel>
+void ImageExport<T>::renderTable(const Map<T>& map, const std::vector<Pixel>& table, T minValue, T maxValue,
+    int y0, int y1, Pixel* pixels, const MapScaler<T>* scaler) {
+    int width = map.getWidth();
+    parallelFor(y0, y1, getThreadCount(), [&](int, int chunkBegin, int chunkEnd) {
+        for (int y = chunkBegin; y < chunkEnd; y++) {
+            renderSpan(map, table, minValue, maxValue, 0, width, y, pixels + static_cast<size_t>(y - y0) * width,
+                scaler);
+        }
+    });
+}
 
-            RGBTRIPLE pixel;
+/**
+ * @brief Colour rows blended over hillshade
+ */
+template <typename T>
+void ImageExport<T>::renderBlendRows(const Map<T>& map, const std::vector<RGBTRIPLE>& lut, T minValue, T maxValue,
+    const Map<T>& hillshade, double opacity, int y0, int y1, RGBTRIPLE* pixels, const MapScaler<T>* scaler) {
+    int width = map.getWidth();
+    parallelFor(y0, y1, getThreadCount(), [&](int, int chunkBegin, int chunkEnd) {
+        for (int y = chunkBegin; y < chunkEnd; y++) {
+            RGBTRIPLE* out = pixels + static_cast<size_t>(y - y0) * width;
+            renderSpan(map, lut, minValue, maxValue, 0, width, y, out, scaler);
 
-            // use discrete or continuous maps as specified
-            if (continuous) {
-                pixel = getColourFromColourmapContinuous(normalizedValue, colourmap);
-            } else {
-                pixel = getColourFromColourmapDiscrete(normalizedValue, colourmap);
+            // Colour layer over grey shade
+            const T* shade = hillshade.getRow(y);
+            for (int x = 0; x < width; x++) {
+                double grey = (1.0 - opacity) * std::min(std::max(static_cast<double>(shade[x]), 0.0), 255.0);
+                out[x].rgbtRed = static_cast<uint8_t>(opacity * out[x].rgbtRed + grey + 0.5);
+                out[x].rgbtGreen = static_cast<uint8_t>(opacity * out[x].rgbtGreen + grey + 0.5);
+                out[x].rgbtBlue = static_cast<uint8_t>(opacity * out[x].rgbtBlue + grey + 0.5);
             }
-            int row = height - 1 - i;
-            image.setPixel(j, row, pixel);
         }
+    });
+}
+
+/**
+ * @brief Colour part of a row
+ */
+template <typename T>
+void ImageExport<T>::renderRowSpan(const Map<T>& map, const std::vector<RGBTRIPLE>& lut, T minValue, T maxValue,
+    int x0, int x1, int y, RGBTRIPLE* pixels, const MapScaler<T>* scaler) {
+    renderSpan(map, lut, minValue, maxValue, x0, x1, y, pixels, scaler);
+}
+
+/**
+ * @brief Palette index part of a row
+ */
+template <typename T>
+void ImageExport<T>::renderIndexRowSpan(const Map<T>& map, const std::vector<uint8_t>& indexes, T minValue, T maxValue,
+    int x0, int x1, int y, uint8_t* pixels, const MapScaler<T>* scaler) {
+    renderSpan(map, indexes, minValue, maxValue, x0, x1, y, pixels, scaler);
+}
+
+/**
+ * @brief Lookup table render of part of a row
+ */
+template <typename T>
+template <typename Grid, typename Pixel>
+void ImageExport<T>::renderSpan(const Grid& map, const std::vector<Pixel>& table, T minValue, T maxValue,
+    int x0, int x1, int y, Pixel* pixels, const MapScaler<T>* scaler) {
+    double range;
+    if (maxValue != minValue) {
+        range = static_cast<double>(maxValue) - static_cast<double>(minValue);
+    } else {
+        range = 1.0;
     }
+    double scale = 1.0 / range;
+    double offset = static_cast<double>(minValue);
 
-    image.write(filename.c_str());
-    return true;
+    const T* row = map.getRow(y);
+    if (scaler) {
+        for (int x = x0; x < x1; x++) {
+            pixels[x - x0] = table[colourLUTIndex((scaler->apply(row[x]) - offset) * scale)];
+        }
+        return;
+    }
+    for (int x = x0; x < x1; x++) {
+        pixels[x - x0] = table[colourLUTIndex((row[x] - offset) * scale)];
+    }
 }
 
 /**
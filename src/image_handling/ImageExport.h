@@ -1,7 +1,7 @@
 /**
  * @file ImageExport.h
  * @author Ollie
- * @brief Image exporter class to save Maps as .bmp
+ * @brief Image exporter class to save Maps as .bmp or .png
  * @version 1.1.0
  * @date 2025-03-13
  * 
@@ -12,7 +12,10 @@
 #define IMAGE_EXPORT_H
 
 #include "../map_core/Map.h"
+#include "../map_core/MapScaler.h"
+#include "../map_core/RasterView.h"
 #include "BMP.h"
+#include "PNG.h"
 #include "colourUtils.h"
 #include <string>
 #include <vector>
@@ -21,17 +24,202 @@ template <typename T>
 class ImageExport {
 public:
     /**
-     * @brief Export a Map object to a BMP image using the specified color map.
+     * @brief Export a Map object to a BMP or PNG image using the specified color map.
+     * The image is rendered and written in blocks of rows, so memory use does not grow with image size.
+     * PNG output uses a palette when the image has at most 256 distinct colours (e.g. D8 or discrete colourmaps).
      * 
      * @param map The Map object to export.
-     * @param filename The output BMP file name.
+     * @param filename The output file name, .png gives a PNG, otherwise BMP.
      * @param format The color map format (e.g., "greyscale1", "drywet", "d8", etc.).
+     * @param scaler Scaling applied to each cell as it is rendered, so the map itself is not scaled.
+     * nullptr renders values as they are.
      * @return true if the export was successful, false otherwise.
      */
     static bool exportMapToImage(const Map<T>& map, const std::string& filename,
-        const std::string& colourmapName, bool continuous);
+        const std::string& colourmapName, bool continuous, const MapScaler<T>* scaler = nullptr);
+
+    /**
+     * @brief Export a Map colourmapped and blended over a hillshade, BMP or PNG (RGB).
+     * Colours, shading, and blending happen in one parallel pass per block of rows.
+     * 
+     * @param map The Map object to colour.
+     * @param hillshade Hillshade of the same size, 0 to 255, e.g. from SlopeAnalyser::computeHillshade().
+     * @param filename The output file name, .png gives a PNG, otherwise BMP.
+     * @param colourmapName Colour code of a file in ../data/colourmaps/
+     * @param continuous Interpolate between colours, otherwise discrete bands
+     * @param opacity Weight of the colour layer over the grey hillshade, 0 to 1
+     * @param scaler Scaling applied to each cell of map as it is rendered, nullptr for none
+     * @return true if the export was successful, false otherwise.
+     */
+    static bool exportBlendedImage(const Map<T>& map, const Map<T>& hillshade, const std::string& filename,
+        const std::string& colourmapName, bool continuous, double opacity = 0.6,
+        const MapScaler<T>* scaler = nullptr);
+
+    /**
+     * @brief Load a colourmap by name and bake it into a lookup table.
+     * Tables are baked once per process and reused by later exports, from any thread.
+     * 
+     * @param colourmapName Colour code of a file in ../data/colourmaps/
+     * @param continuous Interpolate between colours, otherwise discrete bands
+     * @return std::vector<RGBTRIPLE> COLOUR_LUT_SIZE entries, empty if loading failed
+     */
+    static std::vector<RGBTRIPLE> getColourLUT(const std::string& colourmapName, bool continuous);
+
+    /**
+     * @brief Find min and max of map. Rows are reduced in parallel.
+     * 
+     * @param map Map to scan
+     * @param minValue Output minimum
+     * @param maxValue Output maximum
+     * @param scaler Range of the scaled values instead, nullptr for none.
+     * Scales never decrease, so these are the scaled ends of the unscaled range.
+     */
+    static void findRange(const Map<T>& map, T& minValue, T& maxValue, const MapScaler<T>* scaler = nullptr);
+
+    /**
+     * @brief findRange() of caller-owned memory
+     */
+    static void findRange(const RasterView<const T>& values, T& minValue, T& maxValue,
+        const MapScaler<T>* scaler = nullptr);
+
+    /**
+     * @brief Colour caller-owned values into a caller-owned RGB image, rows in parallel,
+     * without copying either into a Map. Colours span the range of values, as in exportMapToImage().
+     * 
+     * @param values Values to colour
+     * @param colourmapName Colour code of a file in ../data/colourmaps/
+     * @param continuous Interpolate between colours, otherwise discrete bands
+     * @param rgb Output: red, green, blue bytes per cell, so rgb.width is 3 * values.width
+     * @param scaler Scaling applied to each cell first, nullptr for none
+     * @return true If the colourmap loaded and the rasters were valid
+     */
+    static bool renderRGB(const RasterView<const T>& values, const std::string& colourmapName, bool continuous,
+        const RasterView<uint8_t>& rgb, const MapScaler<T>* scaler = nullptr);
+
+    /**
+     * @brief renderRGB() with a table the caller has baked, e.g. with buildColourLUT() from a palette
+     * it supplies, so no colourmap file is read
+     * 
+     * @param lut Table of COLOUR_LUT_SIZE entries
+     */
+    static bool renderRGB(const RasterView<const T>& values, const std::vector<RGBTRIPLE>& lut,
+        const RasterView<uint8_t>& rgb, const MapScaler<T>* scaler = nullptr);
+
+    /**
+     * @brief Map cells of rows y0 to y1 to colours from a baked lookup table, rows in parallel.
+     * 
+     * @param map Map to render
+     * @param lut Table from getColourLUT()
+     * @param minValue Value given the first colour
+     * @param maxValue Value given the last colour
+     * @param y0 First row
+     * @param y1 One past last row
+     * @param pixels Output buffer of (y1 - y0) * width pixels, rows packed top down
+     * @param scaler Scaling applied to each cell first, nullptr for none. Range is of scaled values.
+     */
+    static void renderRows(const Map<T>& map, const std::vector<RGBTRIPLE>& lut, T minValue, T maxValue,
+        int y0, int y1, RGBTRIPLE* pixels, const MapScaler<T>* scaler = nullptr);
+
+    /**
+     * @brief Map cells of rows y0 to y1 to palette indexes, rows in parallel.
+     * 
+     * @param map Map to render
+     * @param indexes Palette index of each lookup table entry, from buildColourPalette()
+     * @param minValue Value given the first colour
+     * @param maxValue Value given the last colour
+     * @param y0 First row
+     * @param y1 One past last row
+     * @param pixels Output buffer of (y1 - y0) * width indexes, rows packed top down
+     * @param scaler Scaling applied to each cell first, nullptr for none. Range is of scaled values.
+     */
+    static void renderIndexRows(const Map<T>& map, const std::vector<uint8_t>& indexes, T minValue, T maxValue,
+        int y0, int y1, uint8_t* pixels, const MapScaler<T>* scaler = nullptr);
+
+    /**
+     * @brief Map cells of rows y0 to y1 to colours blended over a hillshade, rows in parallel.
+     * 
+     * @param map Map to render
+     * @param lut Table from getColourLUT()
+     * @param minValue Value given the first colour
+     * @param maxValue Value given the last colour
+     * @param hillshade Hillshade of the same size, 0 to 255
+     * @param opacity Weight of the colour layer, 0 to 1
+     * @param y0 First row
+     * @param y1 One past last row
+     * @param pixels Output buffer of (y1 - y0) * width pixels, rows packed top down
+     * @param scaler Scaling applied to each cell first, nullptr for none. Range is of scaled values.
+     */
+    static void renderBlendRows(const Map<T>& map, const std::vector<RGBTRIPLE>& lut, T minValue, T maxValue,
+        const Map<T>& hillshade, double opacity, int y0, int y1, RGBTRIPLE* pixels,
+        const MapScaler<T>* scaler = nullptr);
+
+    /**
+     * @brief Map cells x0 to x1 of row y to colours, on the calling thread.
+     * For callers that parallelise over many small images (e.g. tiles).
+     * 
+     * @param map Map to render
+     * @param lut Table from getColourLUT()
+     * @param minValue Value given the first colour
+     * @param maxValue Value given the last colour
+     * @param x0 First column
+     * @param x1 One past last column
+     * @param y Row
+     * @param pixels Output buffer of x1 - x0 pixels
+     * @param scaler Scaling applied to each cell first, nullptr for none. Range is of scaled values.
+     */
+    static void renderRowSpan(const Map<T>& map, const std::vector<RGBTRIPLE>& lut, T minValue, T maxValue,
+        int x0, int x1, int y, RGBTRIPLE* pixels, const MapScaler<T>* scaler = nullptr);
+
+    /**
+     * @brief Map cells x0 to x1 of row y to palette indexes, on the calling thread.
+     * 
+     * @see renderRowSpan()
+     */
+    static void renderIndexRowSpan(const Map<T>& map, const std::vector<uint8_t>& indexes, T minValue, T maxValue,
+        int x0, int x1, int y, uint8_t* pixels, const MapScaler<T>* scaler = nullptr);
+
+    /**
+     * @brief Mark lookup table entries that occur in map, rows in parallel
+     * 
+     * @param map Map to scan
+     * @param minValue Value given the first colour
+     * @param maxValue Value given the last colour
+     * @param scaler Scaling applied to each cell first, nullptr for none
+     * @return std::vector<uint8_t> COLOUR_LUT_SIZE flags, for buildColourPalette()
+     */
+    static std::vector<uint8_t> findUsedEntries(const Map<T>& map, T minValue, T maxValue,
+        const MapScaler<T>* scaler = nullptr);
 
 private:
+    /**
+     * @brief Shared renderer, maps each cell to an entry of a table of COLOUR_LUT_SIZE entries
+     */
+    template <typename Pixel>
+    static void renderTable(const Map<T>& map, const std::vector<Pixel>& table, T minValue, T maxValue,
+        int y0, int y1, Pixel* pixels, const MapScaler<T>* scaler);
+
+    /**
+     * @brief Shared renderer for part of one row, scaling each cell first if scaler is given.
+     * Grid is a Map or a RasterView.
+     */
+    template <typename Grid, typename Pixel>
+    static void renderSpan(const Grid& map, const std::vector<Pixel>& table, T minValue, T maxValue,
+        int x0, int x1, int y, Pixel* pixels, const MapScaler<T>* scaler = nullptr);
+
+    /**
+     * @brief Stream RGB rows to a BMP or PNG (by extension) a block at a time
+     * 
+     * @param render Called as render(y0, y1, pixels) to fill each block
+     */
+    template <typename Render>
+    static bool writeRGBImage(const std::string& filename, int width, int height, Render render);
+
+    /**
+     * @brief Stream rows to a PNG, indexed if the image has few enough colours
+     */
+    static bool exportPNG(const Map<T>& map, const std::string& filename, const std::vector<RGBTRIPLE>& lut,
+        T minValue, T maxValue, const MapScaler<T>* scaler);
+
     /**
      * @brief Loads colourmap from a file specified in ../data/colourmaps/
      * 
@@ -0,0 +1,298 @@
+/**
+ * @file PNG.cpp
+ * @author Ollie
+ * @brief Streaming PNG writer using the built-in deflate encoder
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "PNG.h"
+#include "Deflate.h"
+#include "../parallel/parallelFor.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// Deflate window kept between blocks
+static const size_t DICTIONARY_SIZE = 32768;
+// Smallest piece worth compressing on its own thread
+static const size_t MIN_PIECE_SIZE = 256 * 1024;
+
+/**
+ * @brief Store 32-bit value big endian
+ */
+static void putBigEndian(uint8_t* out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = (value >> 16) & 0xFF;
+    out[2] = (value >> 8) & 0xFF;
+    out[3] = value & 0xFF;
+}
+
+/**
+ * @brief Paeth predictor (PNG filter type 4)
+ */
+static uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    if (pb <= pc) return b;
+    return c;
+}
+
+/**
+ * @brief Sum of bytes read as signed, the usual estimate of how well a filtered row compresses
+ */
+static uint64_t filterCost(const uint8_t* row, size_t size) {
+    uint64_t cost = 0;
+    for (size_t i = 0; i < size; i++) {
+        cost += (row[i] < 128) ? row[i] : 256 - row[i];
+    }
+    return cost;
+}
+
+/**
+ * @brief Filter one row with the type giving the smallest sum of absolute (signed) bytes.
+ * Indexed rows are left unfiltered as recommended by the PNG specification.
+ */
+static void filterRow(const uint8_t* row, const uint8_t* prev, size_t stride, int bpp, bool indexed, uint8_t* out) {
+    out[0] = 0;
+    std::memcpy(out + 1, row, stride);
+    if (indexed) {
+        return;
+    }
+
+    // Try each other filter type in its own loop, keep the best
+    std::vector<uint8_t> candidate(stride);
+    uint64_t bestCost = filterCost(out + 1, stride);
+    for (int type = 1; type < 5; type++) {
+        uint8_t* c = candidate.data();
+        size_t b = static_cast<size_t>(bpp);
+        switch (type) {
+            case 1:
+                for (size_t i = 0; i < b; i++) c[i] = row[i];
+                for (size_t i = b; i < stride; i++) c[i] = row[i] - row[i - b];
+                break;
+            case 2:
+                for (size_t i = 0; i < stride; i++) c[i] = row[i] - prev[i];
+                break;
+            case 3:
+                for (size_t i = 0; i < b; i++) c[i] = row[i] - (prev[i] >> 1);
+                for (size_t i = b; i < stride; i++) c[i] = row[i] - ((row[i - b] + prev[i]) >> 1);
+                break;
+            default:
+                for (size_t i = 0; i < b; i++) c[i] = row[i] - prev[i];
+                for (size_t i = b; i < stride; i++) c[i] = row[i] - paeth(row[i - b], prev[i], prev[i - b]);
+                break;
+        }
+        uint64_t cost = filterCost(c, stride);
+        if (cost < bestCost) {
+            bestCost = cost;
+            out[0] = type;
+            std::memcpy(out + 1, c, stride);
+        }
+    }
+}
+
+/**
+ * @brief Construct a new PNGWriter object
+ */
+PNGWriter::PNGWriter(const char* filename, int32_t width, int32_t height, const std::vector<RGBTRIPLE>* palette)
+    : _width(width), _height(height), _nextRow(0), _nThreads(getThreadCount()), _adler(1) {
+    _bytesPerPixel = palette ? 1 : 3;
+    _stride = static_cast<size_t>(width) * _bytesPerPixel;
+    _prevRow.assign(_stride, 0);
+
+    if (palette && (palette->empty() || palette->size() > 256)) {
+        std::cerr << "Error: PNG palette must have 1 to 256 colours." << std::endl;
+        return;
+    }
+
+    _outFile.open(filename, std::ios::binary);
+    // Check is open
+    if (!_outFile.is_open()) {
+        std::cerr << "Could not open image file: " << filename << std::endl;
+        return;
+    }
+
+    // Signature
+    const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    _outFile.write(reinterpret_cast<const char*>(signature), 8);
+
+    // Header: size, 8 bit depth, RGB (2) or palette (3), no interlace
+    uint8_t header[13];
+    putBigEndian(header, width);
+    putBigEndian(header + 4, height);
+    header[8] = 8;
+    header[9] = palette ? 3 : 2;
+    header[10] = 0;
+    header[11] = 0;
+    header[12] = 0;
+    writeChunk("IHDR", header, 13);
+
+    if (palette) {
+        std::vector<uint8_t> colours;
+        for (const RGBTRIPLE& colour : *palette) {
+            colours.push_back(colour.rgbtRed);
+            colours.push_back(colour.rgbtGreen);
+            colours.push_back(colour.rgbtBlue);
+        }
+        writeChunk("PLTE", colours.data(), colours.size());
+    }
+
+    // zlib header: deflate, 32 KB window, default level
+    const uint8_t zlibHeader[2] = {0x78, 0x9C};
+    writeChunk("IDAT", zlibHeader, 2);
+}
+
+/**
+ * @brief Return if open
+ */
+bool PNGWriter::isOpen(void) const {
+    return _outFile.is_open();
+}
+
+/**
+ * @brief Return if indexed
+ */
+bool PNGWriter::isIndexed(void) const {
+    return _bytesPerPixel == 1;
+}
+
+/**
+ * @brief Rows per block
+ */
+int PNGWriter::rowsPerBlock(size_t blockBytes) const {
+    size_t rows = blockBytes / std::max<size_t>(_stride, 1);
+    return (rows == 0) ? 1 : static_cast<int>(rows);
+}
+
+/**
+ * @brief Set threads
+ */
+void PNGWriter::setThreadCount(int nThreads) {
+    _nThreads = std::max(1, nThreads);
+}
+
+/**
+ * @brief Write RGB rows, converting from BGR
+ */
+bool PNGWriter::writeRows(const RGBTRIPLE* rows, int nRows) {
+    if (isIndexed() || nRows <= 0) {
+        std::cerr << "Error: Invalid rows for image writer." << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> raw(static_cast<size_t>(nRows) * _stride);
+    parallelFor(0, nRows, _nThreads, [&](int, int r0, int r1) {
+        for (int r = r0; r < r1; r++) {
+            const RGBTRIPLE* in = rows + static_cast<size_t>(r) * _width;
+            uint8_t* out = raw.data() + static_cast<size_t>(r) * _stride;
+            for (int x = 0; x < _width; x++) {
+                out[3 * x] = in[x].rgbtRed;
+                out[3 * x + 1] = in[x].rgbtGreen;
+                out[3 * x + 2] = in[x].rgbtBlue;
+            }
+        }
+    });
+    return writeRawRows(raw.data(), nRows);
+}
+
+/**
+ * @brief Write index rows
+ */
+bool PNGWriter::writeIndexedRows(const uint8_t* rows, int nRows) {
+    if (!isIndexed()) {
+        std::cerr << "Error: Invalid rows for image writer." << std::endl;
+        return false;
+    }
+    return writeRawRows(rows, nRows);
+}
+
+/**
+ * @brief Filter rows and deflate pieces in parallel
+ */
+bool PNGWriter::writeRawRows(const uint8_t* raw, int nRows) {
+    if (!_outFile.is_open() || nRows <= 0 || _nextRow + nRows > _height) {
+        std::cerr << "Error: Invalid rows for image writer." << std::endl;
+        return false;
+    }
+    const size_t rowBytes = 1 + _stride;
+    const size_t total = static_cast<size_t>(nRows) * rowBytes;
+    const int nThreads = _nThreads;
+
+    // Dictionary followed by filtered rows
+    std::vector<uint8_t> buffer(_dictionary.size() + total);
+    std::copy(_dictionary.begin(), _dictionary.end(), buffer.begin());
+    uint8_t* filtered = buffer.data() + _dictionary.size();
+    parallelFor(0, nRows, nThreads, [&](int, int r0, int r1) {
+        for (int r = r0; r < r1; r++) {
+            const uint8_t* prev = (r == 0) ? _prevRow.data() : raw + static_cast<size_t>(r - 1) * _stride;
+            filterRow(raw + static_cast<size_t>(r) * _stride, prev, _stride, _bytesPerPixel, isIndexed(),
+                      filtered + static_cast<size_t>(r) * rowBytes);
+        }
+    });
+    _adler = adler32(_adler, filtered, total);
+
+    // Deflate pieces in parallel, each with the bytes before it as dictionary
+    int nPieces = static_cast<int>(std::max<size_t>(1, std::min<size_t>(nThreads, total / MIN_PIECE_SIZE)));
+    std::vector<std::vector<uint8_t>> pieces(nPieces);
+    parallelFor(0, nPieces, nPieces, [&](int, int p0, int p1) {
+        for (int p = p0; p < p1; p++) {
+            size_t start = _dictionary.size() + total * p / nPieces;
+            size_t end = _dictionary.size() + total * (p + 1) / nPieces;
+            size_t dictSize = std::min(start, DICTIONARY_SIZE);
+            deflatePiece(buffer.data() + start - dictSize, dictSize, end - start, false, pieces[p]);
+        }
+    });
+    for (const auto& piece : pieces) {
+        writeChunk("IDAT", piece.data(), piece.size());
+    }
+
+    // Keep state for next block
+    std::memcpy(_prevRow.data(), raw + static_cast<size_t>(nRows - 1) * _stride, _stride);
+    size_t keep = std::min(buffer.size(), DICTIONARY_SIZE);
+    _dictionary.assign(buffer.end() - keep, buffer.end());
+    _nextRow += nRows;
+    return _outFile.good();
+}
+
+/**
+ * @brief Finish stream and file
+ */
+bool PNGWriter::close(void) {
+    if (!_outFile.is_open()) return false;
+
+    std::vector<uint8_t> tail;
+    deflateFinish(tail);
+    uint8_t adler[4];
+    putBigEndian(adler, _adler);
+    tail.insert(tail.end(), adler, adler + 4);
+    writeChunk("IDAT", tail.data(), tail.size());
+    writeChunk("IEND", nullptr, 0);
+
+    _outFile.close();
+    return _nextRow == _height && !_outFile.fail();
+}
+
+/**
+ * @brief Write chunk length, type, data, and CRC of type and data
+ */
+void PNGWriter::writeChunk(const char* type, const uint8_t* data, size_t size) {
+    uint8_t length[4];
+    putBigEndian(length, size);
+    _outFile.write(reinterpret_cast<const char*>(length), 4);
+    _outFile.write(type, 4);
+    if (size > 0) {
+        _outFile.write(reinterpret_cast<const char*>(data), size);
+    }
+
+    uint32_t crc = crc32(0, reinterpret_cast<const uint8_t*>(type), 4);
+    crc = crc32(crc, data, size);
+    uint8_t trailer[4];
+    putBigEndian(trailer, crc);
+    _outFile.write(reinterpret_cast<const char*>(trailer), 4);
+}
@@ -0,0 +1,121 @@
+/**
+ * @file PNG.h
+ * @author Ollie
+ * @brief Streaming PNG writer using the built-in deflate encoder
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef PNG_H
+#define PNG_H
+
+#include "BMP.h"
+#include <fstream>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Streaming 8-bit PNG writer, RGB or palette (indexed) colour.
+ * Rows are given top down in blocks of any size, like BMPWriter. Each block is filtered
+ * and split into one piece per thread, which are deflated in parallel and written in
+ * order as IDAT chunks. Pieces use the preceding 32 KB as dictionary, so the result is a
+ * single zlib stream that compresses almost as well as a serial one.
+ *
+ * @see Deflate.h
+ * @see BMP.h
+ */
+class PNGWriter {
+public:
+    /**
+     * @brief Open file and write signature and headers
+     *
+     * @param filename Full file pathway and .png extension
+     * @param width
+     * @param height
+     * @param palette Colours for indexed output (at most 256), nullptr for RGB output
+     */
+    PNGWriter(const char* filename, int32_t width, int32_t height, const std::vector<RGBTRIPLE>* palette = nullptr);
+
+    /// @return true if file opened
+    bool isOpen(void) const;
+
+    /// @return true if rows are palette indexes
+    bool isIndexed(void) const;
+
+    /**
+     * @brief Number of rows per block that fits in blockBytes of raw pixels
+     *
+     * @param blockBytes Target block size
+     * @return int At least 1
+     */
+    int rowsPerBlock(size_t blockBytes = 4 << 20) const;
+
+    /**
+     * @brief Set threads used to filter and compress, e.g. 1 when writing many files in parallel
+     *
+     * @param nThreads Defaults to getThreadCount()
+     */
+    void setThreadCount(int nThreads);
+
+    /**
+     * @brief Write the next nRows RGB rows, top down
+     *
+     * @param rows nRows * width pixels, rows packed
+     * @param nRows Number of rows in block
+     * @return true
+     * @return false If file is not open, writer is indexed, or too many rows were given
+     */
+    bool writeRows(const RGBTRIPLE* rows, int nRows);
+
+    /**
+     * @brief Write the next nRows rows of palette indexes, top down
+     *
+     * @param rows nRows * width indexes, rows packed
+     * @param nRows Number of rows in block
+     * @return true
+     * @return false If file is not open, writer is not indexed, or too many rows were given
+     */
+    bool writeIndexedRows(const uint8_t* rows, int nRows);
+
+    /**
+     * @brief End zlib stream, write IEND, and close file
+     *
+     * @return true If every row was written
+     * @return false
+     */
+    bool close(void);
+
+private:
+    std::ofstream _outFile;
+    int32_t _width, _height;
+    int _bytesPerPixel;
+    size_t _stride;
+    int _nextRow;
+    int _nThreads;
+    uint32_t _adler;
+    std::vector<uint8_t> _prevRow;    // Last raw row, for filtering the next block
+    std::vector<uint8_t> _dictionary; // Last 32 KB of filtered data
+
+    /**
+     * @brief Filter, compress, and write a block of raw rows
+     *
+     * @param raw nRows * _stride bytes
+     * @param nRows Number of rows
+     * @return true
+     * @return false
+     */
+    bool writeRawRows(const uint8_t* raw, int nRows);
+
+    /**
+     * @brief Write a chunk with length and CRC
+     *
+     * @param type Four letter chunk type
+     * @param data Chunk data
+     * @param size Number of bytes
+     */
+    void writeChunk(const char* type, const uint8_t* data, size_t size);
+};
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * @file TileExport.cpp
+ * @author Ollie
+ * @brief Tile pyramid exporter to save Maps as z/x/y PNG tiles for web viewers
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "TileExport.h"
+#include "ImageExport.h"
+#include "PNG.h"
+#include "colourUtils.h"
+#include "../map_core/MapPyramid.h"
+#include "../parallel/parallelFor.h"
+#include "../profiling/Profiler.h"
+#include "../profiling/TraceRecorder.h"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <atomic>
+
+/**
+ * @brief One tile of the pyramid
+ */
+struct TileIndex {
+    int z, x, y;
+};
+
+/**
+ * @brief Export all zoom levels as PNG tiles
+ */
+template <typename T>
+bool TileExport<T>::exportTiles(const Map<T>& map, const std::string& directory,
+    const std::string& colourmapName, bool continuous, const std::string& method, const MapScaler<T>* scaler) {
+    ProfileScope scope("export_tiles", "kernel", static_cast<uint64_t>(map.getWidth()) * map.getHeight());
+
+    // Bake colourmap once
+    std::vector<RGBTRIPLE> lut = ImageExport<T>::getColourLUT(colourmapName, continuous);
+    if (lut.empty()) {
+        return false;
+    }
+    if (map.getWidth() <= 0 || map.getHeight() <= 0) {
+        std::cerr << "Error: Cannot export tiles of an empty map." << std::endl;
+        return false;
+    }
+
+    // Zoom z is pyramid level maxZoom - z
+    MapPyramid<T> pyramid(map, method, TILE_SIZE);
+    int maxZoom = pyramid.getLevelCount() - 1;
+    std::vector<const Map<T>*> levels(maxZoom + 1);
+    for (int z = 0; z <= maxZoom; z++) {
+        levels[z] = &pyramid.getLevel(maxZoom - z);
+    }
+
+    // One range for all levels, reductions stay inside it
+    T minValue, maxValue;
+    ImageExport<T>::findRange(map, minValue, maxValue, scaler);
+
+    // Palette if every level fits, keeping one entry for padding
+    std::vector<uint8_t> used(COLOUR_LUT_SIZE, 0);
+    for (const Map<T>* level : levels) {
+        std::vector<uint8_t> levelUsed = ImageExport<T>::findUsedEntries(*level, minValue, maxValue, scaler);
+        for (int i = 0; i < COLOUR_LUT_SIZE; i++) {
+            used[i] |= levelUsed[i];
+        }
+    }
+    std::vector<RGBTRIPLE> palette;
+    std::vector<uint8_t> indexes;
+    bool indexed = buildColourPalette(lut, used, palette, indexes, 255);
+    RGBTRIPLE padColour = {0, 0, 0};
+    uint8_t padIndex = palette.size();
+    if (indexed) {
+        palette.push_back(padColour);
+    }
+
+    // List tiles and create z/x directories up front
+    std::vector<TileIndex> tiles;
+    try {
+        for (int z = 0; z <= maxZoom; z++) {
+            int nx = (levels[z]->getWidth() + TILE_SIZE - 1) / TILE_SIZE;
+            int ny = (levels[z]->getHeight() + TILE_SIZE - 1) / TILE_SIZE;
+            for (int x = 0; x < nx; x++) {
+                std::filesystem::create_directories(directory + "/" + std::to_string(z) + "/" + std::to_string(x));
+                for (int y = 0; y < ny; y++) {
+                    tiles.push_back({z, x, y});
+                }
+            }
+        }
+    }
+    catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << "Could not create tile directory: " << e.what() << std::endl;
+        return false;
+    }
+
+    // Write tiles of every level in parallel, each tile on one thread
+    std::atomic<int> failed(0);
+    int nThreads = getThreadCount();
+    parallelFor(0, static_cast<int>(tiles.size()), nThreads, [&](int, int t0, int t1) {
+        std::vector<RGBTRIPLE> pixels(TILE_SIZE * TILE_SIZE);
+        std::vector<uint8_t> pixelIndexes(TILE_SIZE * TILE_SIZE);
+        for (int t = t0; t < t1; t++) {
+            const TileIndex& tile = tiles[t];
+            TraceScope scope("tile", "tile", "z", tile.z, "x", tile.x, "y", tile.y);
+            const Map<T>& level = *levels[tile.z];
+            int x0 = tile.x * TILE_SIZE;
+            int y0 = tile.y * TILE_SIZE;
+            int x1 = std::min(level.getWidth(), x0 + TILE_SIZE);
+            int y1 = std::min(level.getHeight(), y0 + TILE_SIZE);
+
+            // Render cells, pad the rest
+            std::fill(pixels.begin(), pixels.end(), padColour);
+            std::fill(pixelIndexes.begin(), pixelIndexes.end(), padIndex);
+            for (int y = y0; y < y1; y++) {
+                size_t offset = static_cast<size_t>(y - y0) * TILE_SIZE;
+                if (indexed) {
+                    ImageExport<T>::renderIndexRowSpan(level, indexes, minValue, maxValue, x0, x1, y,
+                        pixelIndexes.data() + offset, scaler);
+                }
+                else {
+                    ImageExport<T>::renderRowSpan(level, lut, minValue, maxValue, x0, x1, y, pixels.data() + offset,
+                        scaler);
+                }
+            }
+
+            std::string filename = directory + "/" + std::to_string(tile.z) + "/" + std::to_string(tile.x) +
+                "/" + std::to_string(tile.y) + ".png";
+            PNGWriter image(filename.c_str(), TILE_SIZE, TILE_SIZE, indexed ? &palette : nullptr);
+            image.setThreadCount(1);
+            bool written = image.isOpen() && (indexed ? image.writeIndexedRows(pixelIndexes.data(), TILE_SIZE)
+                                                      : image.writeRows(pixels.data(), TILE_SIZE));
+            if (!image.close() || !written) {
+                failed++;
+            }
+        }
+    });
+
+    if (failed > 0) {
+        std::cerr << "Failed to write " << failed << " of " << tiles.size() << " tiles." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Explicit template instantiation
+template class TileExport<int>;
+template class TileExport<float>;
+template class TileExport<double>;
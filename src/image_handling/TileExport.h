@@ -0,0 +1,56 @@
+/**
+ * @file TileExport.h
+ * @author Ollie
+ * @brief Tile pyramid exporter to save Maps as z/x/y PNG tiles for web viewers
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef TILE_EXPORT_H
+#define TILE_EXPORT_H
+
+#include "../map_core/Map.h"
+#include "../map_core/MapScaler.h"
+#include <string>
+
+/**
+ * @brief Exports a Map as an XYZ tile pyramid, <directory>/<z>/<x>/<y>.png.
+ * The deepest zoom level shows one cell per pixel. The levels above are the overview
+ * levels of a MapPyramid, each halving the resolution, until the whole map fits in one
+ * tile at zoom 0. The map is anchored at the top left and tiles past its edges are
+ * padded with black.
+ *
+ * Tiles are rendered through the same colourmap lookup table as ImageExport, using one
+ * range for every level so colours match between zooms. Tiles of all levels are written
+ * in parallel, one tile per thread at a time.
+ *
+ * @see ImageExport.h
+ * @see MapPyramid.h
+ */
+template <typename T>
+class TileExport {
+public:
+    // Tile width and height in pixels
+    static const int TILE_SIZE = 256;
+
+    /**
+     * @brief Export all zoom levels of a map as PNG tiles
+     *
+     * @param map Map to export
+     * @param directory Output directory, created if missing
+     * @param colourmapName Colour code of a file in ../data/colourmaps/
+     * @param continuous Interpolate between colours, otherwise discrete bands
+     * @param method Pyramid reduction, "mean", "min", "max", or "mode"
+     * @param scaler Scaling applied to each cell as tiles are rendered, nullptr for none.
+     * Levels are reduced before scaling, which gives the same tiles as scaling first for "min", "max", and "mode".
+     * @return true If every tile was written
+     * @return false
+     */
+    static bool exportTiles(const Map<T>& map, const std::string& directory,
+        const std::string& colourmapName, bool continuous, const std::string& method = "mean",
+        const MapScaler<T>* scaler = nullptr);
+};
+
+#endif // TILE_EXPORT_H
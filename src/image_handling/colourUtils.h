@@ -8,6 +8,9 @@
  * @copyright Copyright (c) 2025
  * 
  */
+#ifndef COLOUR_UTILS_H
+#define COLOUR_UTILS_H
+
 #include "BMP.h"
 #include <vector>
 
@@ -70,3 +73,73 @@ inline RGBTRIPLE getColourFromColourmapDiscrete(double value, const std::vector<
     // Return single colour
     return colourmap[index];
 }
+
+// Number of entries in a baked colourmap
+const int COLOUR_LUT_SIZE = 4096;
+
+/**
+ * @brief Bake a colourmap into a lookup table of COLOUR_LUT_SIZE entries.
+ * Entry i holds the colour of normalised value i / (COLOUR_LUT_SIZE - 1), so rendering
+ * a pixel is a multiply and a load instead of a divide and an interpolation.
+ * 
+ * @param colourmap vector of BGR RGBTRIPLE structs
+ * @param continuous Interpolate between colours, otherwise discrete bands
+ * @return std::vector<RGBTRIPLE> Lookup table
+ */
+inline std::vector<RGBTRIPLE> buildColourLUT(const std::vector<RGBTRIPLE>& colourmap, bool continuous) {
+    std::vector<RGBTRIPLE> lut(COLOUR_LUT_SIZE);
+    for (int i = 0; i < COLOUR_LUT_SIZE; i++) {
+        double value = static_cast<double>(i) / (COLOUR_LUT_SIZE - 1);
+        lut[i] = continuous ? getColourFromColourmapContinuous(value, colourmap)
+                            : getColourFromColourmapDiscrete(value, colourmap);
+    }
+    return lut;
+}
+
+/**
+ * @brief Index of a normalised value in a table made by buildColourLUT()
+ * 
+ * @param value Between 0 and 1, clamped. NaN gives the first entry
+ * @return int Between 0 and COLOUR_LUT_SIZE - 1
+ */
+inline int colourLUTIndex(double value) {
+    if (!(value > 0.0)) return 0;
+    if (value >= 1.0) return COLOUR_LUT_SIZE - 1;
+    return static_cast<int>(value * (COLOUR_LUT_SIZE - 1) + 0.5);
+}
+
+/**
+ * @brief Reduce a baked table to a palette if it has few enough distinct colours
+ * 
+ * @param lut Lookup table
+ * @param used Non-zero for entries that occur in the image, other entries are given index 0
+ * @param palette Output distinct colours in order of first use
+ * @param indexes Output palette index of each table entry
+ * @param maxColours Largest palette allowed
+ * @return true If the used entries fit in maxColours
+ */
+inline bool buildColourPalette(const std::vector<RGBTRIPLE>& lut, const std::vector<uint8_t>& used,
+    std::vector<RGBTRIPLE>& palette, std::vector<uint8_t>& indexes, size_t maxColours = 256) {
+    palette.clear();
+    indexes.assign(lut.size(), 0);
+    for (size_t i = 0; i < lut.size(); i++) {
+        if (!used[i]) continue;
+        size_t p = 0;
+        while (p < palette.size() && !(palette[p].rgbtRed == lut[i].rgbtRed &&
+               palette[p].rgbtGreen == lut[i].rgbtGreen && palette[p].rgbtBlue == lut[i].rgbtBlue)) {
+            p++;
+        }
+        if (p == palette.size()) {
+            if (palette.size() == maxColours) {
+                palette.clear();
+                indexes.clear();
+                return false;
+            }
+            palette.push_back(lut[i]);
+        }
+        indexes[i] = static_cast<uint8_t>(p);
+    }
+    return true;
+}
+
+#endif
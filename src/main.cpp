@@ -17,21 +17,29 @@
 #include "DEM_analysis/D8FlowAnalyser.h"
 #include "DEM_analysis/FlowAccumulation.h"
 #include "DEM_analysis/watershedAnalysis.h"
+#include "DEM_analysis/StreamNetwork.h"
 #include "image_handling/ImageExport.h"
 #include "CLI/REPL.h"
+#include "CLI/BatchProcessing.h"
+#include "CLI/CLIhelperFunctions.h"
+#include "parallel/ThreadPool.h"
+#include "profiling/Profiler.h"
+#include "sharding/ShardCoordinator.h"
+#include "sharding/ShardWorker.h"
 
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <cstdlib>
 
 /**
- * @brief 
+ * @brief Run one mode of the tool
  * 
  * @param argc Number of arguments passed with binary
  * @param argv Array of arguments passed with binary
  * @return int success or failure
  */
-int main(int argc, char* argv[]) {
+static int runMode(int argc, char* argv[]) {
     // Check if REPL mode was wanted
     if ((argc == 2) && (strcmp(argv[1], "-int") == 0 || strcmp(argv[1], "--interactive") == 0)) {
         // Run REPL if -int or --interactive flag is provided
@@ -43,90 +51,103 @@ int main(int argc, char* argv[]) {
         std::cerr << "Error: No other flags should be provided with -int or --interactive.\n";
         return 1;
     }
+    // Run many jobs from a manifest
+    else if ((argc >= 3) && strcmp(argv[1], "--batch") == 0) {
+        uint64_t memoryMB = DEFAULT_BATCH_MEMORY_MB;
+        if (argc == 4 && isValidInteger(argv[3]) && std::atoi(argv[3]) > 0) {
+            memoryMB = std::atoi(argv[3]);
+        }
+        else if (argc != 3) {
+            std::cerr << "Error: Usage - --batch <manifest> [memoryMB]\n";
+            return 1;
+        }
+        return runBatch(argv[2], memoryMB) ? 0 : 1;
+    }
+    // Split fill, D8 and flow accumulation across worker processes
+    else if ((argc >= 2) && strcmp(argv[1], "--shard") == 0) {
+        if ((argc != 5 && argc != 6) || !isValidInteger(argv[4]) || std::atoi(argv[4]) < 1) {
+            std::cerr << "Error: Usage - --shard <input.bin> <output_prefix> <shards> [address]\n";
+            return 1;
+        }
+        ShardOptions options;
+        options.inputFile = argv[2];
+        options.outputPrefix = argv[3];
+        options.nShards = std::atoi(argv[4]);
+        if (argc == 6) options.address = argv[5];
+        return runSharded(options) ? 0 : 1;
+    }
+    // One strip of a sharded run
+    else if ((argc >= 2) && strcmp(argv[1], "--shard-worker") == 0) {
+        if (argc != 3) {
+            std::cerr << "Error: Usage - --shard-worker <address>\n";
+            return 1;
+        }
+        return runShardWorker(argv[2]) ? 0 : 1;
+    }
+    // Write a synthetic DEM
+    else if ((argc >= 2) && (strcmp(argv[1], "-gen") == 0 || strcmp(argv[1], "--generate") == 0)) {
+        std::string output_file;
+        int width = 0;
+        int height = 0;
+        TerrainOptions options;
+        if (!parseGenerateArguments(argc, argv, output_file, width, height, options)) {
+            return 1;
+        }
+        return generateTerrainFile(output_file, width, height, options) ? 0 : 1;
+    }
     else { // Run CLI version
-    // Manually allocate memory for strings and flags
-    char* input_file = nullptr;
-    char* input_file_type = nullptr;
-    char* output_file = nullptr;
-    char* image_file = nullptr;
-    bool colour = false;
-    char* colour_type = nullptr;
-    bool totalFlow = false;
-    bool watershed = false;
-    int nPourPoints = 0;
-    char* watershed_directory;
-    char* watershed_colour;
-    bool verbose = false;
-    char* process = nullptr;
-
-    // Check all arguments from argv
-    if (!parseArguments(argc, argv, input_file, input_file_type, output_file, image_file, colour, colour_type, totalFlow, watershed, nPourPoints, watershed_directory, watershed_colour, verbose, process)) {
-        delete[] input_file;
-        delete[] input_file_type;
-        delete[] output_file;
-        delete[] image_file;
-        delete[] colour_type;
-        delete[] process;
+    // Check all flags, then compute each product once, independent steps in parallel
+    ProcessOptions options;
+    if (!parseProcessOptions(argc, argv, options)) {
         return 1;
     }
-
-    // Check all arguments are valid and do not conflict
-    if (!validateArguments(input_file, input_file_type, output_file, image_file, colour, colour_type, totalFlow, watershed, nPourPoints, process)) {
-        delete[] input_file;
-        delete[] input_file_type;
-        delete[] output_file;
-        delete[] image_file;
-        delete[] colour_type;
-        delete[] process;
-        return 1;
+    return runProcess(options) ? 0 : 1;
     }
+    return 0;
+}
 
-    // Print verbose output if specified
-    printVerboseOutput(input_file, process, output_file, image_file, colour_type, verbose, watershed, nPourPoints, watershed_directory, watershed_colour, totalFlow);
-
-
-    // Create elevationMap (DEM) and load it
-    Map<double> elevationMap;
-    if (!elevationMap.loadFromFile(input_file, input_file_type)) {
-        std::cerr << "File: " << input_file << " does not exist." << std::endl;
-        delete[] input_file;
-        delete[] input_file_type;
-        delete[] output_file;
-        delete[] image_file;
-        delete[] colour_type;
-        delete[] process;
+/**
+ * @brief 
+ * 
+ * @param argc Number of arguments passed with binary
+ * @param argv Array of arguments passed with binary
+ * @return int success or failure
+ */
+int main(int argc, char* argv[]) {
+    // --threads, --profile and --trace work with every mode
+    bool profile = false;
+    std::string profileFile = "profile.json";
+    std::string traceFile;
+    int threads = 0;
+    extractProfileFlag(argc, argv, profile, profileFile);
+    if (!extractTraceFlag(argc, argv, traceFile) || !extractThreadsFlag(argc, argv, threads)) {
         return 1;
     }
+    if (threads > 0) {
+        ThreadPool::setThreadCount(threads);
+    }
+    if (!profile && traceFile.empty()) {
+        return runMode(argc, argv);
+    }
 
-    // Fill sinks in DEM
-    elevationMap.fillSinks();
-
-    // Init output / processing maps
-    Map<int> D8Map;
-    Map<double> flowMap;
-    Map<double> GMap;
-    Map<double> aspectMap;
-    std::string flowType;
-
-    // Create processing maps from -p process
-    processMap(elevationMap, process, D8Map, flowMap, GMap, aspectMap, flowType);
-
-    // Run flow accumulation for -p if -fa specified
-    handleFlowAccumulation(elevationMap, D8Map, flowMap, GMap, aspectMap, flowType, totalFlow);
-
-    // Run watershed delineation for -p if -w specified
-    handleWatershed(elevationMap, D8Map, flowMap, GMap, aspectMap, flowType, watershed, nPourPoints, watershed_directory, watershed_colour);
-
-    // Output all necessary types for either -o or -img as specified
-    handleOutput(flowMap, D8Map, aspectMap, GMap, output_file, image_file, input_file_type, colour_type, process, totalFlow, watershed);
-
-    // Delete mem.
-    delete[] input_file;
-    delete[] input_file_type;
-    delete[] output_file;
-    delete[] image_file;
-    delete[] colour_type;
-    delete[] process;
-    return 0;
+    if (profile) Profiler::enable();
+    if (!traceFile.empty()) {
+        TraceRecorder::enable();
+        TraceRecorder::setThreadName("main");
+    }
+    int status;
+    {
+        ProfileScope scope("total", "stage");
+        status = runMode(argc, argv);
+    }
+    if (profile) {
+        Profiler::disable();
+        Profiler::writeSummary(std::cout);
+        Profiler::writeJSON(profileFile);
+    }
+    if (!traceFile.empty()) {
+        TraceRecorder::disable();
+        TraceRecorder::writeJSON(traceFile);
     }
-}
\ No newline at end of file
+    return status;
+}
@@ -11,6 +11,8 @@
 #ifndef MAP_H
 #define MAP_H
 
+#include "RasterView.h"
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -35,6 +37,15 @@ public:
      * @param h Height
      */
     Map(int w, int h);
+
+    /**
+     * @brief Create new Map object of specified size with every cell set to value
+     * 
+     * @param w Width
+     * @param h Height
+     * @param value Initial value of all cells
+     */
+    Map(int w, int h, T value);
     
     // Methods
     /**
@@ -75,6 +86,22 @@ public:
      */
     void setData(int x, int y, T value);
 
+    /**
+     * @brief Direct read access to a row of the Map, for sweeps that avoid per-cell bounds checks
+     * 
+     * @param y Corresponds to column index
+     * @return const T* Pointer to _width contiguous values, nullptr if out of bounds
+     */
+    const T* getRow(int y) const;
+
+    /**
+     * @brief Direct write access to a row of the Map, for in-place sweeps
+     * 
+     * @param y Corresponds to column index
+     * @return T* Pointer to _width contiguous values, nullptr if out of bounds
+     */
+    T* getRow(int y);
+
     /**
      * @brief Return private member _width of Map
      * 
@@ -97,12 +124,60 @@ public:
      */
     void fillSinks(void);
 
+    /**
+     * @brief fillSinks() in place on caller-owned memory, without copying it into a Map
+     * 
+     * @param dem Elevations, raised where sinks are filled
+     * @return true If dem was a valid raster
+     */
+    static bool fillSinks(const RasterView<T>& dem);
+
+    /**
+     * @brief Method that fills sinks created by an edit to a region of the Map.
+     * Only the region, its 1 cell halo, and cells whose neighbours were raised are visited.
+     * Region bounds are grown to include every modified cell.
+     * 
+     * @param x0 Lowest row index of edited region
+     * @param y0 Lowest column index of edited region
+     * @param x1 Highest row index of edited region
+     * @param y1 Highest column index of edited region
+     */
+    void fillSinks(int& x0, int& y0, int& x1, int& y1);
+
+    /**
+     * @brief Cells in rows [y0, y1) that the next fillSinks() sweep would raise if nothing
+     * else changed first. Border cells are never included. Found in parallel tiles.
+     * 
+     * @param y0 First row to search
+     * @param y1 One past the last row
+     * @return std::vector<int64_t> Row-major indices (y * width + x), ascending
+     */
+    std::vector<int64_t> findSinks(int y0, int y1) const;
+
+    /**
+     * @brief One row-major fillSinks() sweep over rows [y0, y1) that tests only candidates.
+     * A raised cell's later neighbours are tested in this sweep, and the cell and its earlier
+     * neighbours are queued for the next one, so repeating sweeps from findSinks() until
+     * none raises a cell gives the same Map as fillSinks(). Rows just outside [y0, y1) are
+     * read but not changed, which lets a strip of a larger grid (a shard) be swept alone.
+     * 
+     * @param candidates Cells to test, as row-major indices, ascending
+     * @param y0 First row to sweep, at least 1
+     * @param y1 One past the last row, at most height - 1
+     * @param nextSweep Output: cells to test in the next sweep, appended unsorted
+     * @param outside Output: neighbours of raised cells in rows outside [y0, y1), nullptr to drop
+     * @return int Number of cells raised
+     */
+    int fillSinksSweep(const std::vector<int64_t>& candidates, int y0, int y1,
+        std::vector<int64_t>& nextSweep, std::vector<int64_t>* outside = nullptr);
+
     /**
      * @brief Apply scaling to all values in a Map
      * 
      * @param scale Options: "log" and "log-filter"
      * @param percentile Set to 0.5 as default
      * For "log-filter" option, removes all values below specified percentile
+     * Runs in place through MapScaler, which can also scale while rendering instead.
      */
     void applyScaling(const std::string& scale, double percentile = 0.5);
 
@@ -177,6 +252,16 @@ private:
      * @return false 
      */
     bool isSink(int x, int y);
+
+    /**
+     * @brief Fill cell (x, y) if it is a sink
+     * 
+     * @param x Corresponds to row index
+     * @param y Corresponds to column index
+     * @return true If the cell was raised
+     * @return false 
+     */
+    bool fillSinkAt(int x, int y);
 };
 
 #endif
\ No newline at end of file
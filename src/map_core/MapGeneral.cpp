@@ -1,6 +1,8 @@
 #include "Map.h"
+#include "MapScaler.h"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 
 /**
  * @brief Construct a new Map<T> object with 0,0 dimensions
@@ -20,6 +22,14 @@ Map<T>::Map(int w, int h) : _width(w), _height(h) {
     _mapData.resize(_height, std::vector<T>(_width));
 }
 
+/**
+ * @brief Construct a new Map<T> object with _width, _height dimensions filled with value
+ */
+template <typename T>
+Map<T>::Map(int w, int h, T value) : _width(w), _height(h) {
+    _mapData.resize(_height, std::vector<T>(_width, value));
+}
+
 /**
  * @brief Get data from Map object at position x, y
  */
@@ -33,6 +43,30 @@ T Map<T>::getData(int x, int y) const {
     return _mapData[y][x];
 }
 
+/**
+ * @brief Get pointer to row y of Map object
+ */
+template <typename T>
+const T* Map<T>::getRow(int y) const {
+    if (y < 0 || y >= _height) {
+        std::cerr << "Error: Row out of bounds (" << y << ")" << std::endl;
+        return nullptr;
+    }
+    return _mapData[y].data();
+}
+
+/**
+ * @brief Get writable pointer to row y of Map object
+ */
+template <typename T>
+T* Map<T>::getRow(int y) {
+    if (y < 0 || y >= _height) {
+        std::cerr << "Error: Row out of bounds (" << y << ")" << std::endl;
+        return nullptr;
+    }
+    return _mapData[y].data();
+}
+
 /**
  * @brief Set data at position x, y of Map object with value
  */
@@ -67,55 +101,9 @@ int Map<T>::getHeight(void) const{
  */
 template <typename T>
 void Map<T>::applyScaling(const std::string& scale, double percentile) {
-    if (scale == "log") {
-        // Apply simple log scaling
-        for (int y = 0; y < _height; y++) {
-            for (int x = 0; x < _width; x++) {
-                T val = _mapData[y][x];
-                if (val > 0) { 
-                    _mapData[y][x] = std::log1p(val);
-                } else {
-                    _mapData[y][x] = 0; // Keep zero for non-positive values
-                }
-            }
-        }
-    } 
-    else if (scale == "log-filter") {
-        // Ensure percentile is between 0 and 1
-        percentile = std::clamp(percentile, 0.0, 1.0);
-
-        // Store log values for filtering
-        std::vector<T> logValues;
-
-        for (int y = 0; y < _height; y++) {
-            for (int x = 0; x < _width; x++) {
-                T val = _mapData[y][x];
-                if (val > 0) {  
-                    logValues.push_back(std::log1p(val));
-                }
-            }
-        }
-
-        // Determine the threshold based on the percentile
-        if (!logValues.empty()) {
-            size_t index = static_cast<size_t>(percentile * logValues.size());
-            std::nth_element(logValues.begin(), logValues.begin() + index, logValues.end());
-            T threshold = logValues[index];  
-
-            // Apply log transformation and filtering
-            for (int y = 0; y < _height; y++) {
-                for (int x = 0; x < _width; x++) {
-                    T val = _mapData[y][x];
-                    if (val > 0) {
-                        T logVal = std::log1p(val);
-                        _mapData[y][x] = (logVal >= threshold) ? logVal : 0;  // Keep values above threshold
-                    } else {
-                        _mapData[y][x] = 0;
-                    }
-                }
-            }
-        }
-    }
+    // Threshold from a histogram pass, then one log per cell in place
+    MapScaler<T> scaler(*this, scale, percentile);
+    scaler.applyInPlace(*this);
 }
 
 
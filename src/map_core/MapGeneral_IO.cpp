@@ -9,6 +9,7 @@
  * 
  */
 #include "Map.h"
+#include "../profiling/Profiler.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -19,19 +20,23 @@
  */
 template <typename T>
 bool Map<T>::loadFromFile(const std::string& filename, const std::string& format) {
+    ProfileScope scope("load_map");
+    bool loaded = false;
     if (format == "txt") {
-        return loadFromTXT(filename);
+        loaded = loadFromTXT(filename);
     }
     else if (format == "csv") {
-        return loadFromCSV(filename);
+        loaded = loadFromCSV(filename);
     }
     else if (format == "bin") {
-        return loadFromBin(filename);
+        loaded = loadFromBin(filename);
     }
     else {
         std::cerr << "Unsupported file format: " << format << std::endl;
         return false;
     }
+    scope.addCells(static_cast<uint64_t>(_width) * _height);
+    return loaded;
 }
 
 /**
@@ -39,6 +44,7 @@ bool Map<T>::loadFromFile(const std::string& filename, const std::string& format
  */
 template <typename T>
 bool Map<T>::saveToFile(const std::string& filename, const std::string& format) const {
+    ProfileScope scope("save_map", "kernel", static_cast<uint64_t>(_width) * _height);
     if (format == "txt") {
         return saveToTXT(filename);
     }
@@ -0,0 +1,154 @@
+/**
+ * @file MapPyramid.cpp
+ * @author Ollie
+ * @brief Multi-resolution overview levels of a Map for previews and tiles
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "MapPyramid.h"
+#include "../parallel/parallelFor.h"
+#include <iostream>
+#include <algorithm>
+
+/**
+ * @brief Construct a new Map Pyramid<T>:: Map Pyramid object
+ */
+template <typename T>
+MapPyramid<T>::MapPyramid(const Map<T>& map, const std::string& method, int minSize)
+    : _source(map), _method(method) {
+
+    if (_method != "mean" && _method != "min" && _method != "max" && _method != "mode") {
+        std::cerr << "Unknown pyramid method: " << _method << ", using mean." << std::endl;
+        _method = "mean";
+    }
+    minSize = std::max(1, minSize);
+
+    // Count levels first so levels are never moved while being built
+    int nLevels = 0;
+    for (int w = map.getWidth(), h = map.getHeight(); std::max(w, h) > minSize; w = (w + 1) / 2, h = (h + 1) / 2) {
+        nLevels++;
+    }
+    _levels.reserve(nLevels);
+    for (int level = 0; level < nLevels; level++) {
+        _levels.push_back(reduce(level == 0 ? map : _levels.back(), _method));
+    }
+}
+
+/**
+ * @brief Number of levels
+ */
+template <typename T>
+int MapPyramid<T>::getLevelCount(void) const {
+    return _levels.size() + 1;
+}
+
+/**
+ * @brief Level getter
+ */
+template <typename T>
+const Map<T>& MapPyramid<T>::getLevel(int level) const {
+    if (level <= 0) return _source;
+    return _levels[std::min<size_t>(level, _levels.size()) - 1];
+}
+
+/**
+ * @brief Finest level that fits in size
+ */
+template <typename T>
+int MapPyramid<T>::findLevel(int size) const {
+    int level = 0;
+    while (level + 1 < getLevelCount()) {
+        const Map<T>& current = getLevel(level);
+        if (std::max(current.getWidth(), current.getHeight()) <= size) break;
+        level++;
+    }
+    return level;
+}
+
+/**
+ * @brief Source getter
+ */
+template <typename T>
+const Map<T>& MapPyramid<T>::getSource(void) const {
+    return _source;
+}
+
+/**
+ * @brief Method getter
+ */
+template <typename T>
+const std::string& MapPyramid<T>::getMethod(void) const {
+    return _method;
+}
+
+/**
+ * @brief Halve map by reducing 2x2 cells
+ */
+template <typename T>
+Map<T> MapPyramid<T>::reduce(const Map<T>& map, const std::string& method) {
+    int width = map.getWidth();
+    int height = map.getHeight();
+    int outWidth = (width + 1) / 2;
+    int outHeight = (height + 1) / 2;
+    Map<T> reduced(outWidth, outHeight);
+
+    // Choose once per level, not per cell
+    const bool isMean = (method == "mean");
+    const bool isMin = (method == "min");
+    const bool isMax = (method == "max");
+
+    parallelFor(0, outHeight, getThreadCount(), [&](int, int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            const T* top = map.getRow(2 * y);
+            const T* bottom = (2 * y + 1 < height) ? map.getRow(2 * y + 1) : nullptr;
+            for (int x = 0; x < outWidth; x++) {
+                // Gather up to 4 cells
+                T cells[4]{};
+                int count = 0;
+                for (int dx = 0; dx < 2 && 2 * x + dx < width; dx++) {
+                    cells[count++] = top[2 * x + dx];
+                    if (bottom) {
+                        cells[count++] = bottom[2 * x + dx];
+                    }
+                }
+
+                T value;
+                if (isMean) {
+                    double sum = 0.0;
+                    for (int i = 0; i < count; i++) {
+                        sum += cells[i];
+                    }
+                    value = static_cast<T>(sum / count);
+                }
+                else if (isMin) {
+                    value = *std::min_element(cells, cells + count);
+                }
+                else if (isMax) {
+                    value = *std::max_element(cells, cells + count);
+                }
+                else {
+                    // Mode, ties go to the first cell
+                    value = cells[0];
+                    int best = 0;
+                    for (int i = 0; i < count; i++) {
+                        int matches = std::count(cells, cells + count, cells[i]);
+                        if (matches > best) {
+                            best = matches;
+                            value = cells[i];
+                        }
+                    }
+                }
+                reduced.setData(x, y, value);
+            }
+        }
+    });
+    return reduced;
+}
+
+// Explicit template instantiation
+template class MapPyramid<double>;
+template class MapPyramid<float>;
+template class MapPyramid<int>;
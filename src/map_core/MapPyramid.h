@@ -0,0 +1,86 @@
+/**
+ * @file MapPyramid.h
+ * @author Ollie
+ * @brief Multi-resolution overview levels of a Map for previews and tiles
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef MAP_PYRAMID_H
+#define MAP_PYRAMID_H
+
+#include "Map.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Overview pyramid of a Map. Level 0 is the source map, each level above halves
+ * the width and height by reducing 2x2 cells to one, until the longer side fits in minSize.
+ * Levels are built once, rows in parallel, and kept so repeated previews cost only a
+ * render of a small level.
+ *
+ * Reduction methods:
+ * - "mean": average, for continuous values (elevation, slope)
+ * - "min" / "max": keep extremes, e.g. "max" keeps channels visible in flow accumulation
+ * - "mode": most common value, for categories (D8 directions, basin labels)
+ *
+ * The source map is referenced, not copied, and must outlive the pyramid.
+ *
+ * @tparam T Numeric types: double, float, int
+ */
+template <typename T>
+class MapPyramid {
+public:
+    /**
+     * @brief Build all levels
+     *
+     * @param map Source map, level 0
+     * @param method "mean", "min", "max", or "mode", unknown methods use "mean"
+     * @param minSize Stop once the longer side of a level is at most this
+     */
+    MapPyramid(const Map<T>& map, const std::string& method, int minSize = 1);
+
+    /// @return int Number of levels including the source
+    int getLevelCount(void) const;
+
+    /**
+     * @brief Get a level
+     *
+     * @param level 0 for the source map, clamped to the coarsest level
+     * @return const Map<T>&
+     */
+    const Map<T>& getLevel(int level) const;
+
+    /**
+     * @brief Finest level whose longer side fits in size, so rendering it gives an image of
+     * at most size pixels. Level 0 if the map itself fits, the coarsest level if none do.
+     *
+     * @param size Requested output size in pixels
+     * @return int
+     */
+    int findLevel(int size) const;
+
+    /// @return const Map<T>& Source map
+    const Map<T>& getSource(void) const;
+
+    /// @return const std::string& Reduction method
+    const std::string& getMethod(void) const;
+
+    /**
+     * @brief Halve a map by reducing 2x2 cells, rows in parallel. Odd edges reduce fewer cells.
+     *
+     * @param map Map to reduce
+     * @param method "mean", "min", "max", or "mode"
+     * @return Map<T> (width + 1) / 2 by (height + 1) / 2
+     */
+    static Map<T> reduce(const Map<T>& map, const std::string& method);
+
+private:
+    const Map<T>& _source;
+    std::string _method;
+    std::vector<Map<T>> _levels; // Levels 1 and up
+};
+
+#endif // MAP_PYRAMID_H
@@ -0,0 +1,221 @@
+/**
+ * @file MapScaler.cpp
+ * @author Ollie
+ * @brief Value scaling for Maps, in place or applied per cell while rendering
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "MapScaler.h"
+#include "../parallel/parallelFor.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <type_traits>
+
+// Bits of the value resolved per histogram pass
+const int RADIX_BITS = 16;
+// Candidates left that are selected directly instead of another pass
+const size_t SELECT_LIMIT = 4096;
+
+/**
+ * @brief Bit pattern of a positive value, ordered the same way as the values
+ */
+template <typename T>
+static uint64_t orderKey(T value) {
+    if constexpr (std::is_same<T, double>::value) {
+        uint64_t key;
+        std::memcpy(&key, &value, sizeof(key));
+        return key;
+    }
+    else if constexpr (std::is_same<T, float>::value) {
+        uint32_t key;
+        std::memcpy(&key, &value, sizeof(key));
+        return key;
+    }
+    else {
+        return static_cast<uint64_t>(value);
+    }
+}
+
+/**
+ * @brief Value of a bit pattern from orderKey()
+ */
+template <typename T>
+static T fromOrderKey(uint64_t key) {
+    if constexpr (std::is_same<T, double>::value) {
+        T value;
+        std::memcpy(&value, &key, sizeof(value));
+        return value;
+    }
+    else if constexpr (std::is_same<T, float>::value) {
+        uint32_t bits = static_cast<uint32_t>(key);
+        T value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    else {
+        return static_cast<T>(key);
+    }
+}
+
+/**
+ * @brief Construct a new Map Scaler< T>:: Map Scaler object
+ */
+template <typename T>
+MapScaler<T>::MapScaler(const Map<T>& map, const std::string& scale, double percentile)
+    : _scale(scale), _valid(true), _filter(false), _threshold(0) {
+
+    if (scale == "log-filter") {
+        _filter = true;
+        // Log never decreases, so the percentile of log values is the log of the percentile
+        T value;
+        if (findPercentile(map, std::clamp(percentile, 0.0, 1.0), value)) {
+            _threshold = static_cast<T>(std::log1p(value));
+        }
+    }
+    else if (scale != "log") {
+        std::cerr << "Scale: " << scale << " not recognised." << std::endl;
+        _valid = false;
+    }
+}
+
+/**
+ * @brief Valid getter
+ */
+template <typename T>
+bool MapScaler<T>::isValid(void) const {
+    return _valid;
+}
+
+/**
+ * @brief Scale getter
+ */
+template <typename T>
+const std::string& MapScaler<T>::getScale(void) const {
+    return _scale;
+}
+
+/**
+ * @brief Threshold getter
+ */
+template <typename T>
+T MapScaler<T>::getThreshold(void) const {
+    return _threshold;
+}
+
+/**
+ * @brief Scale map in place
+ */
+template <typename T>
+void MapScaler<T>::applyInPlace(Map<T>& map) const {
+    if (!_valid) return;
+    int width = map.getWidth();
+    parallelFor(0, map.getHeight(), getThreadCount(), [&](int, int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            T* row = map.getRow(y);
+            for (int x = 0; x < width; x++) {
+                row[x] = apply(row[x]);
+            }
+        }
+    });
+}
+
+/**
+ * @brief Radix select percentile of positive cells
+ */
+template <typename T>
+bool MapScaler<T>::findPercentile(const Map<T>& map, double percentile, T& value) {
+    const int keyBits = 8 * sizeof(T);
+    int width = map.getWidth();
+    int height = map.getHeight();
+    int nThreads = getThreadCount();
+
+    // Bits found so far, and how many bits are still unknown below them
+    uint64_t prefix = 0;
+    int shift = keyBits;
+    size_t rank = 0;
+    bool first = true;
+
+    while (shift > 0) {
+        int digitBits = std::min(RADIX_BITS, shift);
+        int prefixShift = shift;
+        shift -= digitBits;
+        uint64_t digitMask = (uint64_t(1) << digitBits) - 1;
+
+        // Histogram of the next digit of positive cells matching the prefix
+        std::vector<std::vector<size_t>> threadCounts(nThreads);
+        parallelFor(0, height, nThreads, [&](int t, int y0, int y1) {
+            std::vector<size_t>& counts = threadCounts[t];
+            counts.assign(digitMask + 1, 0);
+            for (int y = y0; y < y1; y++) {
+                const T* row = map.getRow(y);
+                for (int x = 0; x < width; x++) {
+                    if (!(row[x] > 0)) continue;
+                    uint64_t key = orderKey(row[x]);
+                    if (first || (key >> prefixShift) == prefix) {
+                        counts[(key >> shift) & digitMask]++;
+                    }
+                }
+            }
+        });
+
+        // Merge, skipping threads that got no rows
+        std::vector<size_t> counts(digitMask + 1, 0);
+        for (const auto& local : threadCounts) {
+            for (size_t i = 0; i < local.size(); i++) {
+                counts[i] += local[i];
+            }
+        }
+
+        // Rank of the percentile among all positive cells
+        if (first) {
+            size_t total = 0;
+            for (size_t count : counts) {
+                total += count;
+            }
+            if (total == 0) {
+                return false;
+            }
+            rank = std::min(static_cast<size_t>(percentile * total), total - 1);
+            first = false;
+        }
+
+        // Digit holding the rank
+        uint64_t digit = 0;
+        while (rank >= counts[digit]) {
+            rank -= counts[digit];
+            digit++;
+        }
+        prefix = (prefix << digitBits) | digit;
+
+        // Few candidates left, select among them directly
+        if (shift > 0 && counts[digit] <= SELECT_LIMIT) {
+            std::vector<T> candidates;
+            candidates.reserve(counts[digit]);
+            for (int y = 0; y < height; y++) {
+                const T* row = map.getRow(y);
+                for (int x = 0; x < width; x++) {
+                    if (row[x] > 0 && (orderKey(row[x]) >> shift) == prefix) {
+                        candidates.push_back(row[x]);
+                    }
+                }
+            }
+            std::nth_element(candidates.begin(), candidates.begin() + rank, candidates.end());
+            value = candidates[rank];
+            return true;
+        }
+    }
+
+    value = fromOrderKey<T>(prefix);
+    return true;
+}
+
+// Explicit template instantiation
+template class MapScaler<double>;
+template class MapScaler<float>;
+template class MapScaler<int>;
@@ -0,0 +1,93 @@
+/**
+ * @file MapScaler.h
+ * @author Ollie
+ * @brief Value scaling for Maps, in place or applied per cell while rendering
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef MAP_SCALER_H
+#define MAP_SCALER_H
+
+#include "Map.h"
+#include <string>
+#include <cmath>
+
+/**
+ * @brief Scaling of Map values, as in Map::applyScaling().
+ * The constructor fits the scaling to a map (e.g. finds the "log-filter" threshold), after which
+ * apply() maps single values and applyInPlace() rewrites a map. Image export can take a scaler and
+ * apply it per cell, so the scaled map is never stored.
+ *
+ * Scales:
+ * - "log": log(1 + value), 0 for non-positive values
+ * - "log-filter": as "log", but values below the percentile of positive cells are set to 0
+ *
+ * Both scales never decrease, so the scaled range of a map is apply(min) to apply(max).
+ *
+ * @tparam T Numeric types: double, float, int
+ */
+template <typename T>
+class MapScaler {
+public:
+    /**
+     * @brief Fit a scaling to a map
+     *
+     * @param map Map whose values will be scaled
+     * @param scale "log" or "log-filter"
+     * @param percentile For "log-filter", positive cells below this fraction (0 to 1) are set to 0
+     */
+    MapScaler(const Map<T>& map, const std::string& scale, double percentile = 0.5);
+
+    /// @return true if scale was recognised
+    bool isValid(void) const;
+
+    /// @return const std::string& Scale name
+    const std::string& getScale(void) const;
+
+    /// @return T Scaled values below this become 0 ("log-filter" only)
+    T getThreshold(void) const;
+
+    /**
+     * @brief Scale a single value
+     *
+     * @param value Unscaled value
+     * @return T Scaled value
+     */
+    T apply(T value) const {
+        if (!_valid) return value;
+        if (value <= 0) return 0;
+        T logValue = static_cast<T>(std::log1p(value));
+        return (_filter && logValue < _threshold) ? 0 : logValue;
+    }
+
+    /**
+     * @brief Scale every cell of a map, rows in parallel
+     *
+     * @param map Map to rewrite, usually the one fitted
+     */
+    void applyInPlace(Map<T>& map) const;
+
+    /**
+     * @brief Exact percentile of the positive cells, without copying them.
+     * Radix select on the bit patterns of values: each parallel pass histograms the next 16 bits
+     * of cells that share the bits found so far, until the value is pinned down or few enough
+     * candidates are left to select directly.
+     *
+     * @param map Map to search
+     * @param percentile Fraction from 0 to 1, the value at index percentile * count in sorted order
+     * @param value Output percentile value
+     * @return true If the map has positive cells
+     */
+    static bool findPercentile(const Map<T>& map, double percentile, T& value);
+
+private:
+    std::string _scale;
+    bool _valid;
+    bool _filter;
+    T _threshold;
+};
+
+#endif // MAP_SCALER_H
@@ -0,0 +1,233 @@
+/**
+ * @file MapTiles.cpp
+ * @author Ollie
+ * @brief Rectangular block access to maps held in memory or in .bin files, for tiled kernels
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "MapTiles.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+// Bytes before the first cell of a .bin map: int height, int width
+static const std::streamoff BIN_HEADER_BYTES = 2 * sizeof(int);
+
+/**
+ * @brief Map row holding grid row y, nullptr outside the strip
+ */
+template <typename T>
+const T* MapTileSource<T>::getRow(int y) const {
+    if (y < _firstRow || y >= _firstRow + _map.getHeight()) return nullptr;
+    return _map.getRow(y - _firstRow);
+}
+
+/**
+ * @brief Copy block out of the map rows
+ */
+template <typename T>
+bool MapTileSource<T>::readBlock(int x0, int y0, int x1, int y1, T* out, size_t stride) const {
+    for (int y = y0; y < y1; y++) {
+        const T* row = getRow(y);
+        if (!row) {
+            std::cerr << "Error: Row " << y << " is not held in this map." << std::endl;
+            return false;
+        }
+        std::copy(row + x0, row + x1, out + static_cast<size_t>(y - y0) * stride);
+    }
+    return true;
+}
+
+/**
+ * @brief Map row holding grid row y, nullptr outside the strip
+ */
+template <typename T>
+T* MapTileSink<T>::getRow(int y) {
+    if (y < _firstRow || y >= _firstRow + _map.getHeight()) return nullptr;
+    return _map.getRow(y - _firstRow);
+}
+
+/**
+ * @brief Copy block into the map rows
+ */
+template <typename T>
+bool MapTileSink<T>::writeBlock(int x0, int y0, int x1, int y1, const T* data, size_t stride) {
+    for (int y = y0; y < y1; y++) {
+        T* row = getRow(y);
+        if (!row) {
+            std::cerr << "Error: Row " << y << " is not held in this map." << std::endl;
+            return false;
+        }
+        const T* in = data + static_cast<size_t>(y - y0) * stride;
+        std::copy(in, in + (x1 - x0), row + x0);
+    }
+    return true;
+}
+
+/**
+ * @brief Caller's row y, nullptr outside the view
+ */
+template <typename T>
+const T* RasterTileSource<T>::getRow(int y) const {
+    if (y < 0 || y >= _view.height) return nullptr;
+    return _view.getRow(y);
+}
+
+/**
+ * @brief Copy block out of the caller's rows
+ */
+template <typename T>
+bool RasterTileSource<T>::readBlock(int x0, int y0, int x1, int y1, T* out, size_t stride) const {
+    for (int y = y0; y < y1; y++) {
+        const T* row = _view.getRow(y);
+        std::copy(row + x0, row + x1, out + static_cast<size_t>(y - y0) * stride);
+    }
+    return true;
+}
+
+/**
+ * @brief Caller's row y, nullptr outside the view
+ */
+template <typename T>
+T* RasterTileSink<T>::getRow(int y) {
+    if (y < 0 || y >= _view.height) return nullptr;
+    return _view.getRow(y);
+}
+
+/**
+ * @brief Copy block into the caller's rows
+ */
+template <typename T>
+bool RasterTileSink<T>::writeBlock(int x0, int y0, int x1, int y1, const T* data, size_t stride) {
+    for (int y = y0; y < y1; y++) {
+        const T* in = data + static_cast<size_t>(y - y0) * stride;
+        std::copy(in, in + (x1 - x0), _view.getRow(y) + x0);
+    }
+    return true;
+}
+
+/**
+ * @brief Construct a new Binary Tile Source:: Binary Tile Source object
+ */
+template <typename T>
+BinaryTileSource<T>::BinaryTileSource(const std::string& filename) : _filename(filename) {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return;
+    }
+    int height = 0, width = 0;
+    file.read(reinterpret_cast<char*>(&height), sizeof(height));
+    file.read(reinterpret_cast<char*>(&width), sizeof(width));
+    if (!file || height <= 0 || width <= 0) {
+        std::cerr << "Invalid height or width from the binary file." << std::endl;
+        return;
+    }
+
+    // File must hold every cell
+    file.seekg(0, std::ios::end);
+    std::streamoff expected = BIN_HEADER_BYTES + static_cast<std::streamoff>(width) * height * sizeof(T);
+    if (static_cast<std::streamoff>(file.tellg()) < expected) {
+        std::cerr << "Binary file is shorter than its " << width << "x" << height << " header: " << filename << std::endl;
+        return;
+    }
+    _width = width;
+    _height = height;
+}
+
+/**
+ * @brief Read block a row segment at a time, own stream per call so threads do not share one
+ */
+template <typename T>
+bool BinaryTileSource<T>::readBlock(int x0, int y0, int x1, int y1, T* out, size_t stride) const {
+    std::ifstream file(_filename.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << _filename << std::endl;
+        return false;
+    }
+    for (int y = y0; y < y1; y++) {
+        std::streamoff cell = static_cast<std::streamoff>(y) * _width + x0;
+        file.seekg(BIN_HEADER_BYTES + cell * static_cast<std::streamoff>(sizeof(T)));
+        file.read(reinterpret_cast<char*>(out + static_cast<size_t>(y - y0) * stride), (x1 - x0) * sizeof(T));
+    }
+    if (!file) {
+        std::cerr << "Failed to read block from binary file: " << _filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Construct a new Binary Tile Sink:: Binary Tile Sink object
+ */
+template <typename T>
+BinaryTileSink<T>::BinaryTileSink(const std::string& filename, int width, int height)
+    : _filename(filename), _width(width), _height(height) {
+    if (width <= 0 || height <= 0) {
+        std::cerr << "Invalid height or width for binary file." << std::endl;
+        return;
+    }
+    std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&_height), sizeof(_height));
+    file.write(reinterpret_cast<const char*>(&_width), sizeof(_width));
+
+    // Extend to full size (sparse where the file system allows) by writing the last cell
+    T zero = T();
+    std::streamoff last = static_cast<std::streamoff>(width) * height - 1;
+    file.seekp(BIN_HEADER_BYTES + last * static_cast<std::streamoff>(sizeof(T)));
+    file.write(reinterpret_cast<const char*>(&zero), sizeof(zero));
+    _valid = static_cast<bool>(file);
+    if (!_valid) {
+        std::cerr << "Failed to size binary file: " << filename << std::endl;
+    }
+}
+
+/**
+ * @brief Write block a row segment at a time into the sized file
+ */
+template <typename T>
+bool BinaryTileSink<T>::writeBlock(int x0, int y0, int x1, int y1, const T* data, size_t stride) {
+    if (!_valid) return false;
+    std::fstream file(_filename.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << _filename << std::endl;
+        return false;
+    }
+    for (int y = y0; y < y1; y++) {
+        std::streamoff cell = static_cast<std::streamoff>(y) * _width + x0;
+        file.seekp(BIN_HEADER_BYTES + cell * static_cast<std::streamoff>(sizeof(T)));
+        file.write(reinterpret_cast<const char*>(data + static_cast<size_t>(y - y0) * stride), (x1 - x0) * sizeof(T));
+    }
+    if (!file) {
+        std::cerr << "Failed to write block to binary file: " << _filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Instantiation for numeric map types
+template class MapTileSource<int>;
+template class MapTileSource<float>;
+template class MapTileSource<double>;
+template class MapTileSink<int>;
+template class MapTileSink<float>;
+template class MapTileSink<double>;
+template class RasterTileSource<int>;
+template class RasterTileSource<float>;
+template class RasterTileSource<double>;
+template class RasterTileSink<int>;
+template class RasterTileSink<float>;
+template class RasterTileSink<double>;
+template class BinaryTileSource<int>;
+template class BinaryTileSource<float>;
+template class BinaryTileSource<double>;
+template class BinaryTileSink<int>;
+template class BinaryTileSink<float>;
+template class BinaryTileSink<double>;
@@ -0,0 +1,201 @@
+/**
+ * @file MapTiles.h
+ * @author Ollie
+ * @brief Rectangular block access to maps held in memory or in .bin files, for tiled kernels
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef MAP_TILES_H
+#define MAP_TILES_H
+
+#include "Map.h"
+#include "RasterView.h"
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Read-only grid that tiled kernels take their input from.
+ * readBlock() may be called from several threads at once.
+ */
+template <typename T>
+class TileSource {
+public:
+    virtual ~TileSource() {}
+
+    /// @return int Grid width
+    virtual int getWidth(void) const = 0;
+
+    /// @return int Grid height
+    virtual int getHeight(void) const = 0;
+
+    /**
+     * @brief Copy cells [x0, x1) x [y0, y1), which must lie inside the grid
+     *
+     * @param out Row y0 is written at out, row y0 + 1 at out + stride, ...
+     * @param stride Values between rows of out
+     * @return true If the cells were read
+     */
+    virtual bool readBlock(int x0, int y0, int x1, int y1, T* out, size_t stride) const = 0;
+
+    /**
+     * @brief Row held in memory, so tiles away from the grid edge can be used without copying
+     *
+     * @return const T* Pointer to the row, nullptr if rows have to be read with readBlock()
+     */
+    virtual const T* getRow(int y) const { (void)y; return nullptr; }
+};
+
+/**
+ * @brief Grid that tiled kernels write their output to.
+ * writeBlock() may be called from several threads at once for different tiles.
+ */
+template <typename T>
+class TileSink {
+public:
+    virtual ~TileSink() {}
+
+    /**
+     * @brief Store cells [x0, x1) x [y0, y1), which must lie inside the grid
+     *
+     * @param data Row y0 at data, row y0 + 1 at data + stride, ...
+     * @param stride Values between rows of data
+     * @return true If the cells were written
+     */
+    virtual bool writeBlock(int x0, int y0, int x1, int y1, const T* data, size_t stride) = 0;
+
+    /**
+     * @brief Row held in memory, so kernels can write into it directly
+     *
+     * @return T* Pointer to the row, nullptr if output has to go through writeBlock()
+     */
+    virtual T* getRow(int y) { (void)y; return nullptr; }
+};
+
+/**
+ * @brief TileSource over a Map in memory. The Map may hold only a strip of rows of a taller
+ * grid (e.g. one shard), in which case only those rows can be read.
+ */
+template <typename T>
+class MapTileSource : public TileSource<T> {
+public:
+    /**
+     * @brief Source over map
+     *
+     * @param map Rows firstRow onwards of the grid
+     * @param firstRow Grid row of the first row of map
+     * @param gridHeight Height of the whole grid, -1 if map ends the grid
+     */
+    explicit MapTileSource(const Map<T>& map, int firstRow = 0, int gridHeight = -1)
+        : _map(map), _firstRow(firstRow),
+          _gridHeight(gridHeight < 0 ? firstRow + map.getHeight() : gridHeight) {}
+    int getWidth(void) const override { return _map.getWidth(); }
+    int getHeight(void) const override { return _gridHeight; }
+    bool readBlock(int x0, int y0, int x1, int y1, T* out, size_t stride) const override;
+    const T* getRow(int y) const override;
+
+private:
+    const Map<T>& _map;
+    int _firstRow;
+    int _gridHeight;
+};
+
+/**
+ * @brief TileSink into a Map in memory, which must already have the grid width. As with
+ * MapTileSource, the Map may hold a strip of rows starting at grid row firstRow.
+ */
+template <typename T>
+class MapTileSink : public TileSink<T> {
+public:
+    explicit MapTileSink(Map<T>& map, int firstRow = 0) : _map(map), _firstRow(firstRow) {}
+    bool writeBlock(int x0, int y0, int x1, int y1, const T* data, size_t stride) override;
+    T* getRow(int y) override;
+
+private:
+    Map<T>& _map;
+    int _firstRow;
+};
+
+/**
+ * @brief TileSource over caller-owned memory. Every row is in memory, so tiles are read in
+ * place and only tiles at the grid edge are copied to fill their halo.
+ */
+template <typename T>
+class RasterTileSource : public TileSource<T> {
+public:
+    explicit RasterTileSource(const RasterView<const T>& view) : _view(view) {}
+    int getWidth(void) const override { return _view.width; }
+    int getHeight(void) const override { return _view.height; }
+    bool readBlock(int x0, int y0, int x1, int y1, T* out, size_t stride) const override;
+    const T* getRow(int y) const override;
+
+private:
+    RasterView<const T> _view;
+};
+
+/**
+ * @brief TileSink into caller-owned memory, written in place
+ */
+template <typename T>
+class RasterTileSink : public TileSink<T> {
+public:
+    explicit RasterTileSink(const RasterView<T>& view) : _view(view) {}
+    bool writeBlock(int x0, int y0, int x1, int y1, const T* data, size_t stride) override;
+    T* getRow(int y) override;
+
+private:
+    RasterView<T> _view;
+};
+
+/**
+ * @brief TileSource over a .bin map file (int height, int width, then rows of T), read a
+ * block at a time so grids larger than memory can be processed
+ */
+template <typename T>
+class BinaryTileSource : public TileSource<T> {
+public:
+    /**
+     * @brief Read the header of filename
+     */
+    explicit BinaryTileSource(const std::string& filename);
+
+    /// @return true If the header was read and the file is large enough
+    bool isValid(void) const { return _width > 0 && _height > 0; }
+
+    int getWidth(void) const override { return _width; }
+    int getHeight(void) const override { return _height; }
+    bool readBlock(int x0, int y0, int x1, int y1, T* out, size_t stride) const override;
+
+private:
+    std::string _filename;
+    int _width = 0;
+    int _height = 0;
+};
+
+/**
+ * @brief TileSink into a .bin map file, created with its header and full size up front so
+ * tiles can be written in any order
+ */
+template <typename T>
+class BinaryTileSink : public TileSink<T> {
+public:
+    /**
+     * @brief Create filename for a width x height grid
+     */
+    BinaryTileSink(const std::string& filename, int width, int height);
+
+    /// @return true If the file was created
+    bool isValid(void) const { return _valid; }
+
+    bool writeBlock(int x0, int y0, int x1, int y1, const T* data, size_t stride) override;
+
+private:
+    std::string _filename;
+    int _width;
+    int _height;
+    bool _valid = false;
+};
+
+#endif // MAP_TILES_H
@@ -0,0 +1,63 @@
+/**
+ * @file RasterView.h
+ * @author Ollie
+ * @brief 2D array in caller-owned memory, viewed in place
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef RASTER_VIEW_H
+#define RASTER_VIEW_H
+
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * @brief Rows of a 2D array held by the caller (e.g. a numpy array or a frame of a larger
+ * image): cell (x, y) is data[y * stride + x]. Nothing is copied or freed, so the memory must
+ * outlive the view. Use RasterView<const T> for inputs.
+ * Has Map's getWidth(), getHeight(), getRow(), getData() and setData().
+ *
+ * @tparam T Cell type, const for read-only views
+ */
+template <typename T>
+struct RasterView {
+    T* data = nullptr;
+    int width = 0;
+    int height = 0;
+    std::ptrdiff_t stride = 0;  // Cells from the start of one row to the next, at least width
+
+    RasterView() {}
+
+    /**
+     * @brief View width x height cells starting at data
+     *
+     * @param stride Cells between row starts, 0 for rows packed one after another
+     */
+    RasterView(T* data, int width, int height, std::ptrdiff_t stride = 0)
+        : data(data), width(width), height(height), stride(stride > 0 ? stride : width) {}
+
+    /// @brief Read-only view of the same cells
+    template <typename U = T, typename = typename std::enable_if<!std::is_const<U>::value>::type>
+    operator RasterView<const U>() const { return RasterView<const U>(data, width, height, stride); }
+
+    /// @return true If there is memory for every row
+    bool isValid(void) const { return data != nullptr && width > 0 && height > 0 && stride >= width; }
+
+    int getWidth(void) const { return width; }
+    int getHeight(void) const { return height; }
+
+    /// @return T* Row y, not bounds checked
+    T* getRow(int y) const { return data + y * stride; }
+
+    /// @return Cell (x, y), not bounds checked
+    T getData(int x, int y) const { return getRow(y)[x]; }
+
+    /// @brief Set cell (x, y), not bounds checked
+    template <typename U = T, typename = typename std::enable_if<!std::is_const<U>::value>::type>
+    void setData(int x, int y, U value) const { getRow(y)[x] = value; }
+};
+
+#endif // RASTER_VIEW_H
@@ -0,0 +1,276 @@
+/**
+ * @file TerrainGenerator.cpp
+ * @author Ollie
+ * @brief Seeded fractal terrain for scaling tests, into a Map or straight to a .bin file
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "TerrainGenerator.h"
+#include "../parallel/parallelFor.h"
+#include "../profiling/Profiler.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+// Memory for one block of rows written by generateToFile()
+const size_t FILE_BLOCK_BYTES = size_t(64) << 20;
+
+/**
+ * @brief splitmix64 finaliser, a well mixed 64 bit hash
+ */
+static uint64_t mix(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief Uniform value in [0, 1) for a lattice point of one octave
+ */
+static double latticeValue(uint64_t octaveSeed, int64_t ix, int64_t iy) {
+    uint64_t hash = mix(octaveSeed ^ mix(static_cast<uint64_t>(ix) * 0x9e3779b97f4a7c15ULL ^
+        static_cast<uint64_t>(iy) * 0xc2b2ae3d27d4eb4fULL));
+    return static_cast<double>(hash >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Quintic fade, smooth slopes across lattice cells
+ */
+static double fade(double t) {
+    return t * t * t * (t * (t * 6.0 - 15.0) + 10.0);
+}
+
+/**
+ * @brief Add amplitude times one octave of value noise along a row.
+ * Lattice values are shared by every cell between two lattice columns, so only
+ * two are hashed per lattice step instead of four per cell.
+ */
+static void addNoiseRow(uint64_t octaveSeed, double frequency, double offset, double amplitude, int y,
+    int width, double* row) {
+    double ly = y * frequency + offset;
+    double fy = std::floor(ly);
+    int64_t iy = static_cast<int64_t>(fy);
+    double ty = fade(ly - fy);
+
+    int64_t ix = INT64_MIN;
+    double top0 = 0, bottom0 = 0, top1 = 0, bottom1 = 0;
+    for (int x = 0; x < width; x++) {
+        double lx = x * frequency + offset;
+        double fx = std::floor(lx);
+        int64_t cellX = static_cast<int64_t>(fx);
+        if (cellX != ix) {
+            // Step right by one lattice column, or jump
+            if (cellX == ix + 1) {
+                top0 = top1;
+                bottom0 = bottom1;
+            }
+            else {
+                top0 = latticeValue(octaveSeed, cellX, iy);
+                bottom0 = latticeValue(octaveSeed, cellX, iy + 1);
+            }
+            top1 = latticeValue(octaveSeed, cellX + 1, iy);
+            bottom1 = latticeValue(octaveSeed, cellX + 1, iy + 1);
+            ix = cellX;
+        }
+        double tx = fade(lx - fx);
+        double top = top0 + (top1 - top0) * tx;
+        double bottom = bottom0 + (bottom1 - bottom0) * tx;
+        row[x] += amplitude * (top + (bottom - top) * ty);
+    }
+}
+
+/**
+ * @brief Construct a new Terrain Generator< T>:: Terrain Generator object
+ */
+template <typename T>
+TerrainGenerator<T>::TerrainGenerator(const TerrainOptions& options) : _options(options) {
+    _options.octaves = std::max(1, _options.octaves);
+    _options.featureSize = std::max(1.0, _options.featureSize);
+}
+
+/**
+ * @brief Noise, base, and tilt along a row
+ */
+template <typename T>
+void TerrainGenerator<T>::surfaceRow(int y, int width, int height, double* row) const {
+    std::fill(row, row + width, 0.0);
+    double amplitude = 1.0;
+    double totalAmplitude = 0.0;
+    double frequency = 1.0 / _options.featureSize;
+    for (int octave = 0; octave < _options.octaves; octave++) {
+        // Offset layers so their lattice points do not line up
+        double offset = 0.618 * octave * 1013.0;
+        addNoiseRow(mix(_options.seed ^ mix(static_cast<uint64_t>(octave))), frequency, offset, amplitude, y,
+            width, row);
+        totalAmplitude += amplitude;
+        amplitude *= _options.persistence;
+        frequency *= _options.lacunarity;
+    }
+
+    // Tilt lowers the bottom right corner to the base
+    double scale = _options.relief / totalAmplitude;
+    for (int x = 0; x < width; x++) {
+        double drop = _options.tilt * ((width - 1 - x) + (height - 1 - y));
+        row[x] = _options.baseElevation + scale * row[x] + drop;
+    }
+}
+
+/**
+ * @brief Seeded feature centres
+ */
+template <typename T>
+std::vector<typename TerrainGenerator<T>::Feature> TerrainGenerator<T>::placeFeatures(int width, int height) const {
+    std::vector<Feature> features;
+    uint64_t state = mix(_options.seed ^ 0x5eedf00dULL);
+    auto next = [&state]() {
+        state = mix(state);
+        return static_cast<double>(state >> 11) * (1.0 / 9007199254740992.0);
+    };
+
+    for (int i = 0; i < _options.nPits; i++) {
+        Feature pit;
+        pit.x = next() * width;
+        pit.y = next() * height;
+        pit.radius = _options.pitRadius;
+        pit.level = _options.pitDepth;
+        pit.flat = false;
+        features.push_back(pit);
+    }
+    for (int i = 0; i < _options.nFlats; i++) {
+        Feature flat;
+        flat.x = next() * width;
+        flat.y = next() * height;
+        flat.radius = _options.flatRadius;
+        flat.level = 0;
+        flat.flat = true;
+        features.push_back(flat);
+    }
+
+    // Flats sit at the surface height of their centre cell
+    std::vector<double> row(width);
+    for (Feature& flat : features) {
+        if (!flat.flat) continue;
+        int cx = std::min(width - 1, static_cast<int>(flat.x));
+        surfaceRow(std::min(height - 1, static_cast<int>(flat.y)), width, height, row.data());
+        flat.level = row[cx];
+    }
+    // Pits first, flats last so they stay flat
+    return features;
+}
+
+/**
+ * @brief Parallel rows
+ */
+template <typename T>
+void TerrainGenerator<T>::generateRows(int width, int height, int y0, int y1, const std::vector<Feature>& features,
+    const std::vector<T*>& rows) const {
+    parallelFor(y0, y1, getThreadCount(), [&](int, int b, int e) {
+        std::vector<const Feature*> rowFeatures;
+        std::vector<double> surface(width);
+        for (int y = b; y < e; y++) {
+            surfaceRow(y, width, height, surface.data());
+
+            // Features crossing this row
+            rowFeatures.clear();
+            for (const Feature& feature : features) {
+                if (std::abs(y - feature.y) < feature.radius) {
+                    rowFeatures.push_back(&feature);
+                }
+            }
+
+            T* row = rows[y - y0];
+            for (int x = 0; x < width; x++) {
+                double z = surface[x];
+                for (const Feature* feature : rowFeatures) {
+                    double dx = x - feature->x;
+                    double dy = y - feature->y;
+                    double d2 = (dx * dx + dy * dy) / (feature->radius * feature->radius);
+                    if (d2 >= 1.0) continue;
+                    if (feature->flat) {
+                        z = feature->level;
+                    }
+                    else {
+                        z -= feature->level * (1.0 - d2) * (1.0 - d2);
+                    }
+                }
+                z = std::max(1.0, z);
+                if constexpr (std::is_integral<T>::value) {
+                    row[x] = static_cast<T>(std::lround(z));
+                }
+                else {
+                    row[x] = static_cast<T>(z);
+                }
+            }
+        }
+    });
+}
+
+/**
+ * @brief Generate in memory
+ */
+template <typename T>
+Map<T> TerrainGenerator<T>::generate(int width, int height) const {
+    ProfileScope scope("generate_terrain", "kernel", static_cast<uint64_t>(width) * height);
+    Map<T> map(width, height);
+    std::vector<T*> rows(height);
+    for (int y = 0; y < height; y++) {
+        rows[y] = map.getRow(y);
+    }
+    generateRows(width, height, 0, height, placeFeatures(width, height), rows);
+    return map;
+}
+
+/**
+ * @brief Generate to .bin in blocks of rows
+ */
+template <typename T>
+bool TerrainGenerator<T>::generateToFile(const std::string& filename, int width, int height) const {
+    if (width <= 0 || height <= 0) {
+        std::cerr << "Invalid height or width for generated terrain." << std::endl;
+        return false;
+    }
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    ProfileScope scope("generate_terrain", "kernel", static_cast<uint64_t>(width) * height);
+
+    // Same header as Map::saveToBin()
+    file.write(reinterpret_cast<const char*>(&height), sizeof(height));
+    file.write(reinterpret_cast<const char*>(&width), sizeof(width));
+
+    std::vector<Feature> features = placeFeatures(width, height);
+    int blockRows = static_cast<int>(std::max<size_t>(1, FILE_BLOCK_BYTES / (sizeof(T) * width)));
+    blockRows = std::min(blockRows, height);
+    std::vector<T> block(static_cast<size_t>(blockRows) * width);
+    std::vector<T*> rows(blockRows);
+    for (int i = 0; i < blockRows; i++) {
+        rows[i] = block.data() + static_cast<size_t>(i) * width;
+    }
+
+    for (int y0 = 0; y0 < height; y0 += blockRows) {
+        int y1 = std::min(height, y0 + blockRows);
+        generateRows(width, height, y0, y1, features, rows);
+        std::streamsize bytes = static_cast<std::streamsize>(y1 - y0) * width * sizeof(T);
+        file.write(reinterpret_cast<const char*>(block.data()), bytes);
+        if (!file) {
+            std::cerr << "Failed to write file: " << filename << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Explicit template instantiation
+template class TerrainGenerator<double>;
+template class TerrainGenerator<float>;
+template class TerrainGenerator<int>;
@@ -0,0 +1,119 @@
+/**
+ * @file TerrainGenerator.h
+ * @author Ollie
+ * @brief Seeded fractal terrain for scaling tests, into a Map or straight to a .bin file
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef TERRAIN_GENERATOR_H
+#define TERRAIN_GENERATOR_H
+
+#include "Map.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Shape of generated terrain. Defaults give rolling hills about 400 units high.
+ */
+struct TerrainOptions {
+    uint64_t seed = 1;
+    int octaves = 8;                // Noise layers, each finer than the last
+    double featureSize = 256.0;     // Cells between lattice points of the coarsest layer
+    double persistence = 0.5;       // Height of each layer relative to the one before
+    double lacunarity = 2.0;        // Frequency of each layer relative to the one before
+    double relief = 400.0;          // Height range of the noise
+    double baseElevation = 100.0;   // Lowest noise height, keeps cells above 0 (no data)
+    double tilt = 0.0;              // Drop per cell towards the bottom right corner
+    int nPits = 0;                  // Embedded bowl shaped depressions
+    double pitDepth = 50.0;
+    double pitRadius = 20.0;
+    int nFlats = 0;                 // Embedded discs of one elevation
+    double flatRadius = 30.0;
+};
+
+/**
+ * @brief Multi-octave value noise terrain with optional pits and flats.
+ * Every cell is a pure function of the seed, options, grid size, and position, so rows are
+ * generated in parallel and the result does not depend on the thread count. Grids too large
+ * for memory (e.g. 50k x 50k) are written to the binary Map format in blocks of rows.
+ *
+ * Pits are smooth bowls of pitDepth subtracted from the terrain, so fillSinks has closed
+ * basins to fill. Flats hold every cell of a disc at the elevation of its centre, giving
+ * flat areas for flow routing to resolve. Cells are kept at 1 or above.
+ *
+ * Example:
+ * @code
+ * TerrainOptions options;
+ * options.seed = 42;
+ * options.nPits = 20;
+ * Map<double> dem = TerrainGenerator<double>(options).generate(4096, 4096);
+ * @endcode
+ *
+ * @tparam T Numeric types: double, float, int
+ */
+template <typename T>
+class TerrainGenerator {
+public:
+    /**
+     * @brief Construct a new Terrain Generator object
+     *
+     * @param options Terrain shape and seed
+     */
+    TerrainGenerator(const TerrainOptions& options = TerrainOptions());
+
+    /**
+     * @brief Generate a grid in memory
+     *
+     * @param width Grid width
+     * @param height Grid height
+     * @return Map<T> Generated terrain
+     */
+    Map<T> generate(int width, int height) const;
+
+    /**
+     * @brief Generate a grid straight into the binary Map format without holding it all.
+     * The file loads with Map::loadFromFile(filename, "bin") and matches generate().
+     *
+     * @param filename Output .bin pathway
+     * @param width Grid width
+     * @param height Grid height
+     * @return true If written
+     */
+    bool generateToFile(const std::string& filename, int width, int height) const;
+
+private:
+    /**
+     * @brief Pit or flat disc
+     */
+    struct Feature {
+        double x;
+        double y;
+        double radius;
+        double level;   // Pit depth, or elevation of a flat
+        bool flat;
+    };
+
+    TerrainOptions _options;
+
+    /**
+     * @brief Place pits and flats for a grid size
+     */
+    std::vector<Feature> placeFeatures(int width, int height) const;
+
+    /**
+     * @brief Noise and tilt along row y, before pits and flats
+     */
+    void surfaceRow(int y, int width, int height, double* row) const;
+
+    /**
+     * @brief Generate rows [y0, y1) into rows[y - y0], in parallel
+     */
+    void generateRows(int width, int height, int y0, int y1, const std::vector<Feature>& features,
+        const std::vector<T*>& rows) const;
+};
+
+#endif // TERRAIN_GENERATOR_H
@@ -10,46 +10,284 @@
  */
 #include <limits>
 #include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <vector>
+#include <utility>
 #include "Map.h"
+#include "MapTiles.h"
+#include "../parallel/StencilExecutor.h"
+#include "../profiling/Profiler.h"
 
 /**
- * @brief Method to remove sinks from DEM data
+ * @brief Value sink cell x of row is raised to, from the rows above and below.
+ * Same test as isSink() and fillSinkAt() on an interior cell, without bounds checks.
+ *
+ * @return true If the cell would be raised
+ */
+template <typename T>
+static bool sinkFillValue(const T* above, const T* row, const T* below, int x, T& raised) {
+    const int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    const int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+    const T* rows[3] = {above, row, below};
+
+    T current_value = row[x];
+    for (int direction = 0; direction < 8; direction++) {
+        if (rows[dy[direction] + 1][x + dx[direction]] < current_value) {
+            return false;
+        }
+    }
+
+    T min_neighbor_value = std::numeric_limits<T>::infinity();
+    bool has_lower_neighbor = false;
+    for (int direction = 0; direction < 8; direction++) {
+        if (rows[dy[direction] + 1][x] > 0) {
+            min_neighbor_value = std::min(min_neighbor_value, rows[dy[direction] + 1][x + dx[direction]]);
+            has_lower_neighbor = true;
+        }
+    }
+    if (has_lower_neighbor && current_value < min_neighbor_value) {
+        raised = min_neighbor_value + 1;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Raisable sinks of rows [y0, y1) of source, in parallel tiles.
+ * Interior cells only, so the halo always lies inside the grid and is read in place.
+ */
+template <typename T>
+static std::vector<int64_t> findSinksIn(const TileSource<T>& source, int y0, int y1) {
+    int gridWidth = source.getWidth();
+    y0 = std::max(y0, 1);
+    y1 = std::min(y1, source.getHeight() - 1);
+    std::vector<int64_t> candidates;
+    if (gridWidth < 3 || y0 >= y1) return candidates;
+    const int64_t width = gridWidth;
+
+    StencilOptions<T> stencil;
+    stencil.halo = 1;
+    stencil.policy = HaloPolicy::CLAMP;
+
+    std::mutex candidatesMutex;
+    runStencil(source, 1, y0, gridWidth - 1, y1, stencil, [&](const StencilTile<T>& tile) {
+        std::vector<int64_t> found;
+        for (int j = 0; j < tile.height(); j++) {
+            for (int i = 0; i < tile.width(); i++) {
+                T raised;
+                if (sinkFillValue(tile.row(j - 1), tile.row(j), tile.row(j + 1), i, raised)) {
+                    found.push_back((tile.y0 + j) * width + tile.x0 + i);
+                }
+            }
+        }
+        if (!found.empty()) {
+            std::lock_guard<std::mutex> lock(candidatesMutex);
+            candidates.insert(candidates.end(), found.begin(), found.end());
+        }
+        return true;
+    });
+    parallelSort(candidates, std::less<int64_t>());
+    return candidates;
+}
+
+/**
+ * @brief Replay one sweep over candidates in row-major order.
+ * rowOf(y) gives a pointer to row y, so Maps and caller-owned memory share this sweep.
+ */
+template <typename T, typename Rows>
+static int fillSinksSweepIn(Rows rowOf, int gridWidth, const std::vector<int64_t>& candidates, int y0, int y1,
+    std::vector<int64_t>& nextSweep, std::vector<int64_t>* outside) {
+    const int64_t width = gridWidth;
+    // Later neighbours of raised cells, tested in this sweep
+    std::priority_queue<int64_t, std::vector<int64_t>, std::greater<int64_t>> later;
+    size_t next = 0;
+    int64_t last = -1;
+    int raisedCount = 0;
+
+    while (next < candidates.size() || !later.empty()) {
+        int64_t index;
+        if (later.empty() || (next < candidates.size() && candidates[next] <= later.top())) {
+            index = candidates[next++];
+        }
+        else {
+            index = later.top();
+            later.pop();
+        }
+        // Each cell is tested once per sweep
+        if (index <= last) continue;
+        last = index;
+
+        int x = static_cast<int>(index % width);
+        int y = static_cast<int>(index / width);
+        if (y < y0 || y >= y1 || x < 1 || x >= gridWidth - 1) continue;
+        T raised;
+        T* row = rowOf(y);
+        if (!sinkFillValue<T>(rowOf(y - 1), row, rowOf(y + 1), x, raised)) {
+            continue;
+        }
+        row[x] = raised;
+        raisedCount++;
+
+        for (int ny = y - 1; ny <= y + 1; ny++) {
+            for (int nx = x - 1; nx <= x + 1; nx++) {
+                if (nx < 1 || nx >= gridWidth - 1) continue;
+                int64_t neighbour = ny * width + nx;
+                if (ny < y0 || ny >= y1) {
+                    if (outside) outside->push_back(neighbour);
+                }
+                else if (neighbour > index) {
+                    later.push(neighbour);
+                }
+                else {
+                    nextSweep.push_back(neighbour);
+                }
+            }
+        }
+    }
+    return raisedCount;
+}
+
+/**
+ * @brief Sweeps from the first sinks until none raises a cell
+ */
+template <typename T, typename Rows>
+static void fillSinksIn(const TileSource<T>& source, Rows rowOf) {
+    int width = source.getWidth();
+    int height = source.getHeight();
+    if (width < 3 || height < 3) return;
+
+    std::vector<int64_t> candidates = findSinksIn(source, 1, height - 1);
+    std::vector<int64_t> nextSweep;
+    while (!candidates.empty()) {
+        nextSweep.clear();
+        fillSinksSweepIn<T>(rowOf, width, candidates, 1, height - 1, nextSweep, nullptr);
+        std::sort(nextSweep.begin(), nextSweep.end());
+        nextSweep.erase(std::unique(nextSweep.begin(), nextSweep.end()), nextSweep.end());
+        candidates.swap(nextSweep);
+    }
+}
+
+/**
+ * @brief Method to remove sinks from DEM data.
+ * Gives the same result as repeating row-major sweeps of fillSinkAt() over the interior
+ * until nothing changes. Cells the first sweep would raise are found in parallel tiles;
+ * the sweeps are then replayed over those cells only, since a cell's test can only change
+ * once a neighbour is raised.
  */
 template <typename T>
 void Map<T>::fillSinks(void) {
+    ProfileScope scope("fill_sinks", "kernel", static_cast<uint64_t>(_width) * _height);
+    fillSinksIn(MapTileSource<T>(*this), [this](int y) { return _mapData[y].data(); });
+}
+
+/**
+ * @brief fillSinks() in place on caller-owned rows
+ */
+template <typename T>
+bool Map<T>::fillSinks(const RasterView<T>& dem) {
+    if (!dem.isValid()) {
+        std::cerr << "Error: Invalid raster for fillSinks." << std::endl;
+        return false;
+    }
+    ProfileScope scope("fill_sinks", "kernel", static_cast<uint64_t>(dem.width) * dem.height);
+    fillSinksIn(RasterTileSource<T>(dem), [&dem](int y) { return dem.getRow(y); });
+    return true;
+}
+
+/**
+ * @brief Raisable sinks of rows [y0, y1)
+ */
+template <typename T>
+std::vector<int64_t> Map<T>::findSinks(int y0, int y1) const {
+    return findSinksIn(MapTileSource<T>(*this), y0, y1);
+}
+
+/**
+ * @brief One sweep over candidates
+ */
+template <typename T>
+int Map<T>::fillSinksSweep(const std::vector<int64_t>& candidates, int y0, int y1,
+    std::vector<int64_t>& nextSweep, std::vector<int64_t>* outside) {
+    return fillSinksSweepIn<T>([this](int y) { return _mapData[y].data(); }, _width, candidates, y0, y1,
+        nextSweep, outside);
+}
+
+/**
+ * @brief Fill sinks around an edited region.
+ * Worklist version of fillSinks(): raising a cell can only create new sinks in its
+ * neighbours, so only those are revisited.
+ */
+template <typename T>
+void Map<T>::fillSinks(int& x0, int& y0, int& x1, int& y1) {
     int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
     int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
 
-    bool modified;
-    do {
-        modified = false;
-        for (int y = 1; y < _height - 1; y++) {
-            for (int x = 1; x < _width - 1; x++) {
-                if (isSink(x, y)) {
-                    // Find the lowest neighbour elevation to fill the sink
-                    T min_neighbor_value = std::numeric_limits<T>::infinity();
-                    bool has_lower_neighbor = false;
-                    for (int direction = 0; direction < 8; direction++) {
-                        int nx = x + dx[direction];
-                        int ny = y + dy[direction];
-                        if (nx >= 0 && nx < _width && ny >= 0 && ny < _height) {
-                            // Consider values greater than 0
-                            if (_mapData[ny][x] > 0) {
-                                min_neighbor_value = std::min(min_neighbor_value, _mapData[ny][nx]);
-                                has_lower_neighbor = true;
-                            }
-                        }
-                    }
-
-                    // Raise sink cell to slightly greater than lowest neighbour
-                    if (has_lower_neighbor && _mapData[y][x] < min_neighbor_value) {
-                        _mapData[y][x] = min_neighbor_value + 1;
-                        modified = true;
-                    }
-                }
+    // Start with edited region and a 1 cell halo
+    std::vector<std::pair<int, int>> worklist;
+    for (int y = std::max(1, y0 - 1); y <= std::min(_height - 2, y1 + 1); y++) {
+        for (int x = std::max(1, x0 - 1); x <= std::min(_width - 2, x1 + 1); x++) {
+            worklist.push_back({x, y});
+        }
+    }
+
+    while (!worklist.empty()) {
+        auto [x, y] = worklist.back();
+        worklist.pop_back();
+        if (!fillSinkAt(x, y)) continue;
+
+        // Grow region to cover modified cells
+        x0 = std::min(x0, x);
+        y0 = std::min(y0, y);
+        x1 = std::max(x1, x);
+        y1 = std::max(y1, y);
+
+        for (int direction = 0; direction < 8; direction++) {
+            int nx = x + dx[direction];
+            int ny = y + dy[direction];
+            if (nx >= 1 && nx < _width - 1 && ny >= 1 && ny < _height - 1) {
+                worklist.push_back({nx, ny});
             }
         }
-    } while (modified);
+    }
+}
+
+/**
+ * @brief Raise cell (x, y) above its lowest neighbour if it is a sink
+ */
+template <typename T>
+bool Map<T>::fillSinkAt(int x, int y) {
+    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    if (!isSink(x, y)) {
+        return false;
+    }
+
+    // Find the lowest neighbour elevation to fill the sink
+    T min_neighbor_value = std::numeric_limits<T>::infinity();
+    bool has_lower_neighbor = false;
+    for (int direction = 0; direction < 8; direction++) {
+        int nx = x + dx[direction];
+        int ny = y + dy[direction];
+        if (nx >= 0 && nx < _width && ny >= 0 && ny < _height) {
+            // Consider values greater than 0
+            if (_mapData[ny][x] > 0) {
+                min_neighbor_value = std::min(min_neighbor_value, _mapData[ny][nx]);
+                has_lower_neighbor = true;
+            }
+        }
+    }
+
+    // Raise sink cell to slightly greater than lowest neighbour
+    if (has_lower_neighbor && _mapData[y][x] < min_neighbor_value) {
+        _mapData[y][x] = min_neighbor_value + 1;
+        return true;
+    }
+    return false;
 }
 
 
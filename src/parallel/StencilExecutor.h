@@ -0,0 +1,231 @@
+/**
+ * @file StencilExecutor.h
+ * @author Ollie
+ * @brief Tiled neighbourhood (stencil) execution with ready-made halos, in parallel on the ThreadPool
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef STENCIL_EXECUTOR_H
+#define STENCIL_EXECUTOR_H
+
+#include "parallelFor.h"
+#include "../map_core/MapTiles.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Values given to halo cells that lie outside the grid
+ */
+enum class HaloPolicy {
+    REFLECT, // Mirror about the edge cell (-1 reads 1), as the Sobel kernels always have
+    CLAMP,   // Repeat the edge cell
+    NODATA   // StencilOptions::nodata, for kernels that must ignore cells beyond the edge
+};
+
+/**
+ * @brief Halo and tiling for runStencil()
+ */
+template <typename T>
+struct StencilOptions {
+    int halo = 1;                            // Cells of neighbourhood around each tile
+    HaloPolicy policy = HaloPolicy::REFLECT; // Fill for halo cells outside the grid
+    T nodata = T();                          // Fill value for HaloPolicy::NODATA
+    int tileSize = 256;                      // Tile edge in cells
+};
+
+/**
+ * @brief Input tile handed to a kernel. Cell (x0 + i, y0 + j) is row(j)[i], valid for
+ * i in [-halo, width() + halo) and j in [-halo, height() + halo), so kernels index
+ * neighbours without bounds checks.
+ */
+template <typename T>
+struct StencilTile {
+    int x0 = 0, y0 = 0;       // First cell of the tile in the grid
+    int x1 = 0, y1 = 0;       // One past the last cell
+    int halo = 0;
+    std::vector<const T*> rows; // Row j starts at rows[j + halo]
+    std::vector<T> buffer;      // Padded copy for tiles not read in place
+
+    int width(void) const { return x1 - x0; }
+    int height(void) const { return y1 - y0; }
+    const T* row(int j) const { return rows[j + halo]; }
+};
+
+/**
+ * @brief Output rows of one tile: straight into the sink's rows when it holds them in
+ * memory, otherwise into a buffer passed to TileSink::writeBlock() by flush().
+ */
+template <typename U>
+class TileWriter {
+public:
+    /**
+     * @brief Writer for the cells [x0, x1) x [y0, y1) of sink
+     */
+    TileWriter(TileSink<U>& sink, int x0, int y0, int x1, int y1)
+        : _sink(sink), _x0(x0), _y0(y0), _x1(x1), _y1(y1), _rows(y1 - y0) {
+        if (y1 > y0 && sink.getRow(y0) != nullptr && sink.getRow(y1 - 1) != nullptr) {
+            for (int j = 0; j < y1 - y0; j++) {
+                _rows[j] = sink.getRow(y0 + j) + x0;
+            }
+            return;
+        }
+        _buffer.resize(static_cast<size_t>(x1 - x0) * (y1 - y0));
+        for (int j = 0; j < y1 - y0; j++) {
+            _rows[j] = _buffer.data() + static_cast<size_t>(j) * (x1 - x0);
+        }
+    }
+
+    /**
+     * @brief Writer covering a whole input tile
+     */
+    template <typename T>
+    TileWriter(TileSink<U>& sink, const StencilTile<T>& tile)
+        : TileWriter(sink, tile.x0, tile.y0, tile.x1, tile.y1) {}
+
+    /// @return U* Output for row j of the tile, width() values
+    U* row(int j) { return _rows[j]; }
+
+    /**
+     * @brief Store buffered output in the sink
+     *
+     * @return true If nothing was buffered or the block was written
+     */
+    bool flush(void) {
+        if (_buffer.empty()) return true;
+        return _sink.writeBlock(_x0, _y0, _x1, _y1, _buffer.data(), static_cast<size_t>(_x1 - _x0));
+    }
+
+private:
+    TileSink<U>& _sink;
+    int _x0, _y0, _x1, _y1;
+    std::vector<U*> _rows;
+    std::vector<U> _buffer;
+};
+
+/**
+ * @brief Grid index used for halo coordinate n of a grid of size cells
+ */
+inline int haloIndex(int n, int size, HaloPolicy policy) {
+    if (policy == HaloPolicy::REFLECT) {
+        if (n < 0) n = -n;
+        if (n >= size) n = 2 * size - n - 2;
+    }
+    // Clamp, and keep reflections of halos wider than the grid inside it
+    return std::min(std::max(n, 0), size - 1);
+}
+
+/**
+ * @brief Point tile.rows at the tile and its halo. Tiles clear of the grid edge are used in
+ * place when the source holds rows in memory; others are read once into a padded buffer
+ * and the halo beyond the grid filled by policy.
+ *
+ * @return true If the source was read
+ */
+template <typename T>
+bool loadStencilTile(const TileSource<T>& source, const StencilOptions<T>& options, StencilTile<T>& tile) {
+    int gridWidth = source.getWidth();
+    int gridHeight = source.getHeight();
+    int halo = tile.halo;
+    int paddedHeight = tile.height() + 2 * halo;
+    tile.rows.assign(paddedHeight, nullptr);
+
+    bool inside = tile.x0 - halo >= 0 && tile.y0 - halo >= 0 &&
+        tile.x1 + halo <= gridWidth && tile.y1 + halo <= gridHeight;
+    if (inside) {
+        for (int j = 0; j < paddedHeight; j++) {
+            const T* row = source.getRow(tile.y0 - halo + j);
+            if (!row) break;
+            tile.rows[j] = row + tile.x0;
+        }
+        if (tile.rows[paddedHeight - 1] != nullptr) return true;
+    }
+
+    // Padded tile starts at grid cell (left, top)
+    int left = tile.x0 - halo;
+    int top = tile.y0 - halo;
+    size_t stride = static_cast<size_t>(tile.width() + 2 * halo);
+    tile.buffer.resize(stride * paddedHeight);
+    T* buffer = tile.buffer.data();
+
+    // Part of the padded tile inside the grid
+    int cx0 = std::max(0, left);
+    int cy0 = std::max(0, top);
+    int cx1 = std::min(gridWidth, tile.x1 + halo);
+    int cy1 = std::min(gridHeight, tile.y1 + halo);
+    if (!source.readBlock(cx0, cy0, cx1, cy1, buffer + (cy0 - top) * stride + (cx0 - left), stride)) {
+        return false;
+    }
+
+    // Halo columns beyond the left and right edges, from cells already in the row
+    for (int j = cy0 - top; j < cy1 - top; j++) {
+        T* row = buffer + j * stride;
+        for (int i = 0; i < static_cast<int>(stride); i++) {
+            if (i == cx0 - left) i = cx1 - left;
+            if (i >= static_cast<int>(stride)) break;
+            row[i] = (options.policy == HaloPolicy::NODATA) ? options.nodata :
+                row[haloIndex(left + i, gridWidth, options.policy) - left];
+        }
+    }
+
+    // Halo rows beyond the top and bottom edges, copied from completed rows
+    for (int j = 0; j < paddedHeight; j++) {
+        if (j == cy0 - top) j = cy1 - top;
+        if (j >= paddedHeight) break;
+        T* row = buffer + j * stride;
+        if (options.policy == HaloPolicy::NODATA) {
+            std::fill(row, row + stride, options.nodata);
+        }
+        else {
+            const T* from = buffer + (haloIndex(top + j, gridHeight, options.policy) - top) * stride;
+            std::copy(from, from + stride, row);
+        }
+    }
+
+    for (int j = 0; j < paddedHeight; j++) {
+        tile.rows[j] = buffer + j * stride + halo;
+    }
+    return true;
+}
+
+/**
+ * @brief Run kernel on every tile of the cells [x0, x1) x [y0, y1) of source, tiles in parallel.
+ * Each tile arrives with options.halo cells of neighbourhood, so the kernel's loops need no
+ * edge handling. Sources only read a tile and its halo at a time, so a BinaryTileSource
+ * and BinaryTileSink process grids that do not fit in memory.
+ *
+ * @tparam Kernel Callable as bool kernel(const StencilTile<T>& tile), false on failure
+ * @return true If every tile was read and every kernel succeeded
+ */
+template <typename T, typename Kernel>
+bool runStencil(const TileSource<T>& source, int x0, int y0, int x1, int y1,
+                const StencilOptions<T>& options, Kernel kernel) {
+    std::atomic<bool> ok(true);
+    parallelForTiles(x1 - x0, y1 - y0, options.tileSize, [&](int tx0, int ty0, int tx1, int ty1) {
+        if (!ok.load()) return;
+        StencilTile<T> tile;
+        tile.x0 = x0 + tx0;
+        tile.y0 = y0 + ty0;
+        tile.x1 = x0 + tx1;
+        tile.y1 = y0 + ty1;
+        tile.halo = std::max(0, options.halo);
+        if (!loadStencilTile(source, options, tile) || !kernel(tile)) {
+            ok.store(false);
+        }
+    });
+    return ok.load();
+}
+
+/**
+ * @brief Run kernel over the whole of source
+ */
+template <typename T, typename Kernel>
+bool runStencil(const TileSource<T>& source, const StencilOptions<T>& options, Kernel kernel) {
+    return runStencil(source, 0, 0, source.getWidth(), source.getHeight(), options, kernel);
+}
+
+#endif
@@ -0,0 +1,241 @@
+/**
+ * @file ThreadPool.cpp
+ * @author Ollie
+ * @brief Project-wide work-stealing thread pool and task groups
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "ThreadPool.h"
+#include "../profiling/PerfCounters.h"
+#include "../profiling/Profiler.h"
+#include "../profiling/TraceRecorder.h"
+#include <algorithm>
+#include <chrono>
+
+// Pool of the process and the size asked for, 0 for the hardware concurrency
+static std::mutex poolMutex;
+static std::unique_ptr<ThreadPool> pool;
+static int requestedThreads = 0;
+// Pool once created, read without the mutex by every task submitted and waited for
+static std::atomic<ThreadPool*> currentPool(nullptr);
+
+// Index of the calling thread's deque in its pool, -1 outside the pool
+thread_local int workerIndex = -1;
+thread_local ThreadPool* workerPool = nullptr;
+
+/**
+ * @brief Pool getter
+ */
+ThreadPool& ThreadPool::instance(void) {
+    ThreadPool* existing = currentPool.load(std::memory_order_acquire);
+    if (existing) return *existing;
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (!pool) {
+        int nThreads = requestedThreads;
+        if (nThreads <= 0) {
+            unsigned int hardware = std::thread::hardware_concurrency();
+            nThreads = (hardware == 0) ? 1 : static_cast<int>(hardware);
+        }
+        pool.reset(new ThreadPool(nThreads));
+        currentPool.store(pool.get(), std::memory_order_release);
+    }
+    return *pool;
+}
+
+/**
+ * @brief Thread count setter
+ */
+void ThreadPool::setThreadCount(int nThreads) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    requestedThreads = std::max(0, nThreads);
+    currentPool.store(nullptr, std::memory_order_release);
+    pool.reset();
+}
+
+/**
+ * @brief Construct a new Thread Pool:: Thread Pool object
+ */
+ThreadPool::ThreadPool(int nThreads) : _nThreads(std::max(1, nThreads)), _queued(0) {
+    int nWorkers = _nThreads - 1;
+    for (int i = 0; i <= nWorkers; i++) {
+        _queues.emplace_back(new Queue());
+    }
+    for (int i = 0; i < nWorkers; i++) {
+        _workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+/**
+ * @brief Destroy the Thread Pool:: Thread Pool object
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Queue a task on the caller's deque, or the shared queue
+ */
+void ThreadPool::submit(std::function<void()> task, TaskGroup* group) {
+    int index = (workerPool == this && workerIndex >= 0) ? workerIndex : static_cast<int>(_queues.size()) - 1;
+    {
+        std::lock_guard<std::mutex> lock(_queues[index]->mutex);
+        _queues[index]->tasks.push_back({std::move(task), group});
+    }
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _queued.fetch_add(1);
+    }
+    _wake.notify_one();
+}
+
+/**
+ * @brief Remove a task of group (any group if nullptr) from queue, from the back or the front
+ */
+static bool popTask(std::deque<ThreadPool::Task>& tasks, const TaskGroup* group, bool back, ThreadPool::Task& task) {
+    if (tasks.empty()) return false;
+    if (!group) {
+        if (back) {
+            task = std::move(tasks.back());
+            tasks.pop_back();
+        }
+        else {
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        return true;
+    }
+    int n = static_cast<int>(tasks.size());
+    for (int i = 0; i < n; i++) {
+        int index = back ? n - 1 - i : i;
+        if (tasks[index].group != group) continue;
+        task = std::move(tasks[index]);
+        tasks.erase(tasks.begin() + index);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Take a task for thread self (-1 outside the pool)
+ */
+bool ThreadPool::take(int self, const TaskGroup* group, Task& task) {
+    if (_queued.load() == 0) return false;
+    int nQueues = static_cast<int>(_queues.size());
+
+    // Own deque, newest first
+    if (self >= 0) {
+        Queue& own = *_queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (popTask(own.tasks, group, true, task)) {
+            _queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Shared queue, then the other workers starting after self, oldest first
+    int nWorkers = nQueues - 1;
+    for (int i = 0; i <= nWorkers; i++) {
+        int index = (i == 0) ? nWorkers : (self + i) % nWorkers;
+        if (index == self || index < 0) continue;
+        Queue& victim = *_queues[index];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (popTask(victim.tasks, group, false, task)) {
+            _queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Run a task, passing any exception to its group
+ */
+void ThreadPool::execute(Task& task) {
+    std::exception_ptr error;
+    try {
+        task.run();
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+    task.group->finish(error);
+}
+
+/**
+ * @brief Run one task on the calling thread
+ */
+bool ThreadPool::runOne(const TaskGroup* group) {
+    int self = (workerPool == this) ? workerIndex : -1;
+    Task task;
+    if (!take(self, group, task)) return false;
+    execute(task);
+    return true;
+}
+
+/**
+ * @brief Worker: run tasks, sleep when there are none
+ */
+void ThreadPool::workerLoop(int index) {
+    workerIndex = index;
+    workerPool = this;
+    TraceRecorder::setThreadName("pool worker");
+    if (Profiler::isEnabled()) {
+        PerfCounters::attach();
+    }
+    while (true) {
+        Task task;
+        if (take(index, nullptr, task)) {
+            execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wake.wait(lock, [this]() { return _stop || _queued.load() > 0; });
+        if (_stop && _queued.load() == 0) return;
+    }
+}
+
+/**
+ * @brief Count a finished task, waking waiters on the last one
+ */
+void TaskGroup::finish(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (error && !_error) _error = error;
+    if (_pending.fetch_sub(1) == 1) {
+        _done.notify_all();
+    }
+}
+
+/**
+ * @brief Wait, running queued tasks of this group meanwhile
+ */
+void TaskGroup::wait(void) {
+    ThreadPool& threadPool = ThreadPool::instance();
+    while (_pending.load() > 0) {
+        if (threadPool.runOne(this)) continue;
+        // Tasks of this group are running elsewhere; look for new ones now and then
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait_for(lock, std::chrono::microseconds(200), [this]() { return _pending.load() == 0; });
+    }
+
+    // The last finish() may still hold the mutex
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        error = _error;
+        _error = nullptr;
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,170 @@
+/**
+ * @file ThreadPool.h
+ * @author Ollie
+ * @brief Project-wide work-stealing thread pool and task groups
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskGroup;
+
+/**
+ * @brief One pool of worker threads shared by every parallel loop, pipeline node, and batch job.
+ * Each worker owns a deque: it pushes and pops its own tasks at the back (newest first, still
+ * in cache) and steals from the front of other deques when it runs dry. Threads outside the
+ * pool submit to a shared queue. Threads waiting on a TaskGroup run its queued tasks
+ * meanwhile, so nested parallel work (a parallelFor inside a pipeline node inside a batch job)
+ * shares the same threads instead of starting more. Waiters only run tasks of the group they
+ * wait for, so a short wait never ends up underneath an unrelated long task.
+ *
+ * The pool has getThreadCount() - 1 workers; the thread waiting for the work is the last one.
+ * It is created on first use, sized by setThreadCount() or the hardware concurrency.
+ *
+ * Example:
+ * @code
+ * ThreadPool::setThreadCount(8);
+ * TaskGroup group;
+ * group.run([&]() { slope = analyser.computeSlope("combined"); });
+ * group.run([&]() { aspect = analyser.computeDirection(); });
+ * group.wait();
+ * @endcode
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Pool of the process, created on first use. Later calls read it without locking.
+     */
+    static ThreadPool& instance(void);
+
+    /**
+     * @brief Set the number of threads used for parallel work. Only call while no work is
+     * running (e.g. from the CLI or REPL between commands); the pool is rebuilt on next use.
+     *
+     * @param nThreads Threads including the waiting thread, 0 for the hardware concurrency
+     */
+    static void setThreadCount(int nThreads);
+
+    /// @return int Threads taking part in parallel work, at least 1
+    int getThreadCount(void) const { return _nThreads; }
+
+    /**
+     * @brief Queue a task. Use TaskGroup::run() rather than calling this directly.
+     *
+     * @param task Work to run
+     * @param group Group told when the task finishes
+     */
+    void submit(std::function<void()> task, TaskGroup* group);
+
+    /**
+     * @brief Run one queued task on the calling thread, if any
+     *
+     * @param group Only take tasks of this group, any task if nullptr
+     * @return true If a task was run
+     */
+    bool runOne(const TaskGroup* group = nullptr);
+
+    ~ThreadPool();
+
+    /// Queued work and the group told when it finishes
+    struct Task {
+        std::function<void()> run;
+        TaskGroup* group;
+    };
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    int _nThreads;
+    std::vector<std::unique_ptr<Queue>> _queues;  // One per worker, then the shared queue
+    std::vector<std::thread> _workers;
+    std::atomic<int> _queued;
+    std::mutex _sleepMutex;
+    std::condition_variable _wake;
+    bool _stop = false;
+
+    explicit ThreadPool(int nThreads);
+
+    /**
+     * @brief Take a task of group (any if nullptr): own deque (back), shared queue, then steal (front)
+     */
+    bool take(int self, const TaskGroup* group, Task& task);
+
+    /**
+     * @brief Run a task and tell its group
+     */
+    static void execute(Task& task);
+
+    /**
+     * @brief Worker thread body
+     */
+    void workerLoop(int index);
+};
+
+/**
+ * @brief Tasks that are waited for together. wait() runs the group's queued tasks while it
+ * waits, so waiting inside a task does not leave the group's work to other threads alone. The first exception thrown by a task is
+ * rethrown by wait(). The destructor waits.
+ */
+class TaskGroup {
+public:
+    TaskGroup() : _pending(0) {}
+
+    ~TaskGroup() {
+        try {
+            wait();
+        }
+        catch (...) {
+        }
+    }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /**
+     * @brief Run task on the pool
+     *
+     * @param task Work to run
+     */
+    void run(std::function<void()> task) {
+        _pending.fetch_add(1);
+        ThreadPool::instance().submit(std::move(task), this);
+    }
+
+    /**
+     * @brief Wait for every task run so far, helping with queued tasks meanwhile
+     */
+    void wait(void);
+
+private:
+    friend class ThreadPool;
+
+    std::atomic<int> _pending;
+    std::mutex _mutex;
+    std::condition_variable _done;
+    std::exception_ptr _error;
+
+    /**
+     * @brief Count a finished task
+     */
+    void finish(std::exception_ptr error);
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,185 @@
+/**
+ * @file parallelFor.h
+ * @author Ollie
+ * @brief Fork-join loops, tiles, reductions and sorts on the shared ThreadPool
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include "ThreadPool.h"
+#include "../profiling/TraceRecorder.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Number of threads taking part in parallel work, set with --threads or the REPL
+ *
+ * @return int At least 1
+ */
+inline int getThreadCount(void) {
+    return ThreadPool::instance().getThreadCount();
+}
+
+/**
+ * @brief Split [begin, end) into nThreads contiguous chunks and run body on each.
+ * Chunks are ThreadPool tasks and the calling thread takes the first one, so a parallelFor
+ * nested inside other pool work uses idle workers rather than starting threads.
+ * Returns once every chunk is done. The chunk index lets callers keep per-chunk
+ * accumulators that are merged afterwards without locking.
+ *
+ * @tparam Body Callable as body(int chunk, int chunkBegin, int chunkEnd)
+ * @param begin First index (e.g. row)
+ * @param end One past last index
+ * @param nThreads Number of chunks, usually getThreadCount()
+ * @param body Work for one chunk
+ */
+template <typename Body>
+void parallelFor(int begin, int end, int nThreads, Body body) {
+    int n = end - begin;
+    if (n <= 0) return;
+    nThreads = std::max(1, std::min(nThreads, n));
+
+    // Each chunk is a span in a trace, to show imbalance between threads
+    auto run = [&body](int thread, int chunkBegin, int chunkEnd) {
+        TraceScope scope("parallel_chunk", "worker", "begin", chunkBegin, "end", chunkEnd);
+        body(thread, chunkBegin, chunkEnd);
+    };
+
+    if (nThreads == 1) {
+        run(0, begin, end);
+        return;
+    }
+
+    TaskGroup group;
+    int chunk = (n + nThreads - 1) / nThreads;
+    for (int t = 1; t < nThreads; t++) {
+        int chunkBegin = begin + t * chunk;
+        int chunkEnd = std::min(end, chunkBegin + chunk);
+        if (chunkBegin >= chunkEnd) break;
+        group.run([&run, t, chunkBegin, chunkEnd]() {
+            run(t, chunkBegin, chunkEnd);
+        });
+    }
+    // Calling thread takes the first chunk
+    run(0, begin, std::min(end, begin + chunk));
+    group.wait();
+}
+
+/**
+ * @brief Run body on every tileSize x tileSize tile of a width x height grid.
+ * Tiles are handed out row-major, several per thread so uneven tiles balance out.
+ *
+ * @tparam Body Callable as body(int x0, int y0, int x1, int y1) for the half-open tile
+ * @param width Grid width
+ * @param height Grid height
+ * @param tileSize Tile edge in cells
+ * @param body Work for one tile
+ */
+template <typename Body>
+void parallelForTiles(int width, int height, int tileSize, Body body) {
+    if (width <= 0 || height <= 0) return;
+    tileSize = std::max(1, tileSize);
+    int tilesX = (width + tileSize - 1) / tileSize;
+    int tilesY = (height + tileSize - 1) / tileSize;
+    int nTiles = tilesX * tilesY;
+
+    parallelFor(0, nTiles, getThreadCount() * 4, [&](int, int t0, int t1) {
+        for (int t = t0; t < t1; t++) {
+            int x0 = (t % tilesX) * tileSize;
+            int y0 = (t / tilesX) * tileSize;
+            body(x0, y0, std::min(width, x0 + tileSize), std::min(height, y0 + tileSize));
+        }
+    });
+}
+
+/**
+ * @brief Reduce [begin, end) in nChunks pieces. Pieces are combined in index order, so the
+ * result does not depend on which thread ran which piece.
+ *
+ * @tparam R Result type
+ * @tparam Map Callable as R map(int chunkBegin, int chunkEnd)
+ * @tparam Combine Callable as R combine(const R& left, const R& right)
+ * @param begin First index
+ * @param end One past last index
+ * @param nChunks Number of pieces, usually getThreadCount()
+ * @param identity Result of an empty range
+ * @param map Reduce one piece
+ * @param combine Join two adjacent results
+ * @return R Result over the whole range
+ */
+template <typename R, typename Map, typename Combine>
+R parallelReduce(int begin, int end, int nChunks, R identity, Map map, Combine combine) {
+    int n = end - begin;
+    if (n <= 0) return identity;
+    nChunks = std::max(1, std::min(nChunks, n));
+
+    std::vector<R> partial(nChunks, identity);
+    int chunk = (n + nChunks - 1) / nChunks;
+    parallelFor(0, nChunks, nChunks, [&](int, int c0, int c1) {
+        for (int c = c0; c < c1; c++) {
+            int chunkBegin = begin + c * chunk;
+            int chunkEnd = std::min(end, chunkBegin + chunk);
+            if (chunkBegin < chunkEnd) {
+                partial[c] = map(chunkBegin, chunkEnd);
+            }
+        }
+    });
+
+    R result = identity;
+    for (const R& value : partial) {
+        result = combine(result, value);
+    }
+    return result;
+}
+
+/**
+ * @brief Sort values: pieces are sorted in parallel, then merged pairwise in parallel rounds.
+ * Use a comparator that is a total order if the result must not depend on the thread count.
+ *
+ * @tparam T Element type
+ * @tparam Compare Strict weak ordering
+ * @param values Values to sort in place
+ * @param compare Ordering
+ */
+template <typename T, typename Compare>
+void parallelSort(std::vector<T>& values, Compare compare) {
+    int n = static_cast<int>(values.size());
+    int nChunks = std::min(getThreadCount(), n / 4096);
+    if (nChunks <= 1) {
+        std::sort(values.begin(), values.end(), compare);
+        return;
+    }
+
+    std::vector<int> bounds(nChunks + 1);
+    for (int c = 0; c <= nChunks; c++) {
+        bounds[c] = static_cast<int>(static_cast<int64_t>(n) * c / nChunks);
+    }
+    parallelFor(0, nChunks, nChunks, [&](int, int c0, int c1) {
+        for (int c = c0; c < c1; c++) {
+            std::sort(values.begin() + bounds[c], values.begin() + bounds[c + 1], compare);
+        }
+    });
+
+    // Merge neighbouring sorted runs until one is left
+    for (int width = 1; width < nChunks; width *= 2) {
+        int nMerges = (nChunks + 2 * width - 1) / (2 * width);
+        parallelFor(0, nMerges, nMerges, [&](int, int m0, int m1) {
+            for (int m = m0; m < m1; m++) {
+                int first = m * 2 * width;
+                int middle = std::min(nChunks, first + width);
+                int last = std::min(nChunks, first + 2 * width);
+                if (middle >= last) continue;
+                std::inplace_merge(values.begin() + bounds[first], values.begin() + bounds[middle],
+                                   values.begin() + bounds[last], compare);
+            }
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ * @file Pipeline.cpp
+ * @author Ollie
+ * @brief Dependency graph of products (maps, trees, files) computed once each, in parallel
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "Pipeline.h"
+#include "../parallel/ThreadPool.h"
+#include "../profiling/Profiler.h"
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+/**
+ * @brief Keep product after run
+ */
+void Pipeline::keep(const std::string& name) {
+    auto it = _nodes.find(name);
+    if (it == _nodes.end()) {
+        std::cerr << "Error: Unknown pipeline node: " << name << std::endl;
+        return;
+    }
+    it->second.keep = true;
+}
+
+/**
+ * @brief Node lookup
+ */
+const Pipeline::Node* Pipeline::findNode(const std::string& name) const {
+    auto it = _nodes.find(name);
+    return (it == _nodes.end()) ? nullptr : &it->second;
+}
+
+/**
+ * @brief Product check
+ */
+bool Pipeline::has(const std::string& name) const {
+    const Node* node = findNode(name);
+    return node && node->product;
+}
+
+/**
+ * @brief Compute count getter
+ */
+int Pipeline::getComputeCount(const std::string& name) const {
+    const Node* node = findNode(name);
+    return node ? node->computeCount : 0;
+}
+
+/**
+ * @brief Compute targets, independent nodes in parallel
+ */
+bool Pipeline::run(const std::vector<std::string>& targets, int nThreads) {
+    // Nodes needed by the targets, depth first
+    std::unordered_map<std::string, bool> needed;
+    std::vector<std::string> stack(targets.begin(), targets.end());
+    while (!stack.empty()) {
+        std::string name = stack.back();
+        stack.pop_back();
+        if (needed.count(name)) continue;
+
+        auto it = _nodes.find(name);
+        if (it == _nodes.end()) {
+            std::cerr << "Error: Unknown pipeline node: " << name << std::endl;
+            return false;
+        }
+        needed[name] = true;
+        // Products still held from an earlier run are not recomputed
+        if (it->second.done) continue;
+        for (const std::string& dependency : it->second.dependencies) {
+            stack.push_back(dependency);
+        }
+    }
+    // Targets outlive this run only, a later run may free them like any other product
+    std::unordered_set<std::string> runTargets(targets.begin(), targets.end());
+    auto retained = [&](const std::string& name, const Node& node) {
+        return node.keep || runTargets.count(name) > 0;
+    };
+
+    // Unfinished dependencies of each node, and readers left of each product
+    std::unordered_map<std::string, int> waiting;
+    std::unordered_map<std::string, int> readers;
+    std::unordered_map<std::string, std::vector<std::string>> consumers;
+    std::deque<std::string> ready;
+    int pending = 0;
+    for (const auto& entry : needed) {
+        const std::string& name = entry.first;
+        Node& node = _nodes[name];
+        if (node.done) continue;
+        pending++;
+        waiting[name] = 0;
+        for (const std::string& dependency : node.dependencies) {
+            readers[dependency]++;
+            consumers[dependency].push_back(name);
+            if (!_nodes[dependency].done) {
+                waiting[name]++;
+            }
+        }
+        if (waiting[name] == 0) {
+            ready.push_back(name);
+        }
+    }
+
+    std::mutex mutex;
+    int running = 0;
+    bool failed = false;
+    nThreads = std::max(1, nThreads);
+    TaskGroup group;
+
+    // Start ready nodes as pool tasks, at most nThreads at a time. Called with mutex held,
+    // first here and then by each node as it finishes
+    std::function<void()> launch = [&]() {
+        while (!failed && !ready.empty() && running < nThreads) {
+            std::string name = ready.front();
+            ready.pop_front();
+            Node* node = &_nodes[name];
+            running++;
+
+            group.run([&, name, node]() {
+                std::shared_ptr<void> product;
+                bool success;
+                {
+                    ProfileScope scope(name.c_str(), "stage");
+                    success = node->compute(*this, product);
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+
+                running--;
+                pending--;
+                node->computeCount++;
+                if (!success) {
+                    failed = true;
+                    return;
+                }
+                node->product = std::move(product);
+                node->done = true;
+
+                // Free products this node was the last reader of
+                for (const std::string& dependency : node->dependencies) {
+                    Node& input = _nodes[dependency];
+                    if (--readers[dependency] == 0 && !retained(dependency, input)) {
+                        input.product.reset();
+                        input.done = false;
+                    }
+                }
+                // Start consumers with nothing left to wait for
+                for (const std::string& consumer : consumers[name]) {
+                    if (--waiting[consumer] == 0) {
+                        ready.push_back(consumer);
+                    }
+                }
+                if (readers[name] == 0 && !retained(name, *node)) {
+                    node->product.reset();
+                    node->done = false;
+                }
+                launch();
+            });
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        launch();
+    }
+    // Nothing left to launch and nothing running means done, failed, or a cycle
+    group.wait();
+
+    if (!failed && pending > 0) {
+        std::cerr << "Error: Pipeline has a dependency cycle." << std::endl;
+        return false;
+    }
+    return !failed;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file Pipeline.h
+ * @author Ollie
+ * @brief Dependency graph of products (maps, trees, files) computed once each, in parallel
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "../parallel/parallelFor.h"
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Runs named products as nodes of a dependency graph.
+ * Each node declares the nodes it reads and a function that fills its product.
+ * run() computes only what the targets need, each node at most once, starting every node
+ * whose dependencies are done as a task on the shared ThreadPool. A product is freed as soon as the
+ * last node reading it finishes, unless it is a target of that run or kept with keep().
+ *
+ * Node functions report failure by returning false (after printing why). Nodes already
+ * running finish, no new nodes start, and run() returns false.
+ *
+ * Nodes may use parallelFor themselves. Their chunks go to the same pool, so independent
+ * nodes running at the same time share its threads rather than oversubscribing the cores.
+ *
+ * Example:
+ * @code
+ * Pipeline pipeline;
+ * pipeline.addNode<Map<double>>("dem", {}, [&](const Pipeline&, Map<double>& dem) {
+ *     return dem.loadFromFile(filename, "txt");
+ * });
+ * pipeline.addNode<Map<int>>("d8", {"dem"}, [](const Pipeline& p, Map<int>& d8) {
+ *     D8FlowAnalyser analyser(p.get<Map<double>>("dem"));
+ *     analyser.analyseFlow();
+ *     d8 = analyser.getMap();
+ *     return true;
+ * });
+ * pipeline.run({"d8"});
+ * @endcode
+ */
+class Pipeline {
+public:
+    /**
+     * @brief Fills a product, reading dependencies with get(). Returns false on failure.
+     */
+    template <typename Product>
+    using Compute = std::function<bool(const Pipeline&, Product&)>;
+
+    /**
+     * @brief Add a node. Replaces any node of the same name.
+     *
+     * @tparam Product Type of the product, default constructible
+     * @param name Unique node name
+     * @param dependencies Names of nodes read by compute
+     * @param compute Function filling the product
+     */
+    template <typename Product>
+    void addNode(const std::string& name, const std::vector<std::string>& dependencies, Compute<Product> compute);
+
+    /**
+     * @brief Keep a product after run() even when it is not a target
+     *
+     * @param name Node name
+     */
+    void keep(const std::string& name);
+
+    /**
+     * @brief Compute targets and everything they depend on
+     *
+     * @param targets Node names wanted
+     * @param nThreads Nodes run at the same time at most
+     * @return true If every node needed succeeded
+     */
+    bool run(const std::vector<std::string>& targets, int nThreads = getThreadCount());
+
+    /**
+     * @brief Product of a node. Valid inside a node for its dependencies, and after run()
+     * for targets and kept nodes.
+     *
+     * @tparam Product Type given to addNode()
+     * @param name Node name
+     * @return const Product& Empty product (and an error) if missing or of another type
+     */
+    template <typename Product>
+    const Product& get(const std::string& name) const;
+
+    /**
+     * @brief Check a product is held
+     *
+     * @param name Node name
+     * @return true If computed and not freed
+     */
+    bool has(const std::string& name) const;
+
+    /**
+     * @brief Times a node was computed, for checking nothing ran twice
+     *
+     * @param name Node name
+     * @return int 0 if never run or unknown
+     */
+    int getComputeCount(const std::string& name) const;
+
+private:
+    struct Node {
+        std::vector<std::string> dependencies;
+        std::function<bool(const Pipeline&, std::shared_ptr<void>&)> compute;
+        const std::type_info* type = nullptr;
+        std::shared_ptr<void> product;
+        bool keep = false;
+        bool done = false;
+        int computeCount = 0;
+    };
+
+    std::unordered_map<std::string, Node> _nodes;
+
+    /**
+     * @brief Node by name, nullptr if unknown
+     */
+    const Node* findNode(const std::string& name) const;
+};
+
+/**
+ * @brief Add a node
+ */
+template <typename Product>
+void Pipeline::addNode(const std::string& name, const std::vector<std::string>& dependencies,
+    Compute<Product> compute) {
+    Node node;
+    node.dependencies = dependencies;
+    node.type = &typeid(Product);
+    // Product only becomes visible once complete
+    node.compute = [compute](const Pipeline& pipeline, std::shared_ptr<void>& slot) {
+        std::shared_ptr<Product> product = std::make_shared<Product>();
+        if (!compute(pipeline, *product)) {
+            return false;
+        }
+        slot = product;
+        return true;
+    };
+    _nodes[name] = std::move(node);
+}
+
+/**
+ * @brief Product getter
+ */
+template <typename Product>
+const Product& Pipeline::get(const std::string& name) const {
+    static const Product empty{};
+    const Node* node = findNode(name);
+    if (!node || !node->product) {
+        std::cerr << "Error: Pipeline product " << name << " is not available." << std::endl;
+        return empty;
+    }
+    if (*node->type != typeid(Product)) {
+        std::cerr << "Error: Pipeline product " << name << " read as the wrong type." << std::endl;
+        return empty;
+    }
+    return *static_cast<const Product*>(node->product.get());
+}
+
+#endif // PIPELINE_H
@@ -0,0 +1,275 @@
+/**
+ * @file ProductCache.cpp
+ * @author Ollie
+ * @brief On-disk cache of derived maps keyed by input, algorithm, parameters, and tool version
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "ProductCache.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// FNV-1a 64 bit constants
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+// Bytes read from a file at a time while hashing
+const size_t HASH_BUFFER_SIZE = 1 << 20;
+
+/**
+ * @brief Continue an FNV-1a hash over bytes
+ */
+static uint64_t hashBytes(const void* data, size_t size, uint64_t hash) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief Check a file name is a cache entry: 16 hex digits then .bin
+ */
+static bool isEntryName(const std::string& name) {
+    if (name.size() != 20 || name.compare(16, 4, ".bin") != 0) return false;
+    return std::all_of(name.begin(), name.begin() + 16, [](char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+    });
+}
+
+/**
+ * @brief Construct a new Product Cache:: Product Cache object
+ */
+ProductCache::ProductCache(const std::string& directory, uint64_t maxMB)
+    : _directory(directory), _maxBytes(maxMB * 1024 * 1024), _valid(true) {
+    std::error_code error;
+    fs::create_directories(_directory, error);
+    if (error || !fs::is_directory(_directory)) {
+        std::cerr << "Error: Cannot create cache directory: " << _directory << std::endl;
+        _valid = false;
+    }
+}
+
+/**
+ * @brief Valid getter
+ */
+bool ProductCache::isValid(void) const {
+    return _valid;
+}
+
+/**
+ * @brief Hash file bytes
+ */
+bool ProductCache::hashFile(const std::string& filename, uint64_t& hash) {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return false;
+    }
+
+    hash = FNV_OFFSET;
+    std::vector<char> buffer(HASH_BUFFER_SIZE);
+    while (file) {
+        file.read(buffer.data(), buffer.size());
+        hash = hashBytes(buffer.data(), static_cast<size_t>(file.gcount()), hash);
+    }
+    return true;
+}
+
+/**
+ * @brief Hash map size and cells
+ */
+template <typename T>
+uint64_t ProductCache::hashMap(const Map<T>& map) {
+    int width = map.getWidth();
+    int height = map.getHeight();
+    uint64_t hash = hashBytes(&width, sizeof(width), FNV_OFFSET);
+    hash = hashBytes(&height, sizeof(height), hash);
+    for (int y = 0; y < height; y++) {
+        hash = hashBytes(map.getRow(y), width * sizeof(T), hash);
+    }
+    return hash;
+}
+
+/**
+ * @brief Key from source, algorithm, parameters, and version
+ */
+std::string ProductCache::makeKey(const std::string& source, const std::string& algorithm,
+    const std::string& parameters) {
+    // Separators keep ("ab", "c") and ("a", "bc") apart
+    std::string description = source + '\n' + algorithm + '\n' + parameters + '\n' + TOOL_VERSION;
+    return toHex(hashBytes(description.data(), description.size(), FNV_OFFSET));
+}
+
+/**
+ * @brief Hash to 16 hex digits
+ */
+std::string ProductCache::toHex(uint64_t hash) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; i--) {
+        hex[i] = digits[hash & 0xf];
+        hash >>= 4;
+    }
+    return hex;
+}
+
+/**
+ * @brief Entry pathway
+ */
+std::string ProductCache::entryPath(const std::string& key) const {
+    return (fs::path(_directory) / (key + ".bin")).string();
+}
+
+/**
+ * @brief Complete entry check
+ */
+template <typename T>
+bool ProductCache::contains(const std::string& key) const {
+    if (!_valid) return false;
+    std::string path = entryPath(key);
+    std::error_code error;
+    uintmax_t size = fs::file_size(path, error);
+    if (error) return false;
+
+    // Header is height and width, then the cells
+    int dimensions[2] = {0, 0};
+    std::ifstream file(path.c_str(), std::ios::binary);
+    file.read(reinterpret_cast<char*>(dimensions), sizeof(dimensions));
+    if (!file || dimensions[0] <= 0 || dimensions[1] <= 0) return false;
+
+    // Entries cut short (e.g. by a killed run) are ignored
+    uintmax_t expected = sizeof(dimensions) + uintmax_t(dimensions[0]) * dimensions[1] * sizeof(T);
+    if (size != expected) {
+        std::cerr << "Warning: Ignoring incomplete cache entry: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Load entry and mark it recently used
+ */
+template <typename T>
+bool ProductCache::load(const std::string& key, Map<T>& map) {
+    if (!contains<T>(key)) return false;
+    std::string path = entryPath(key);
+    Map<T> loaded;
+    if (!loaded.loadFromFile(path, "bin")) return false;
+    map = std::move(loaded);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _used.insert(key);
+    std::error_code error;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    return true;
+}
+
+/**
+ * @brief Write entry then trim
+ */
+template <typename T>
+bool ProductCache::store(const std::string& key, const Map<T>& map) {
+    if (!_valid) return false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _used.insert(key);
+    }
+
+    // Written under a unique temporary name so readers never see half an entry
+    std::string path = entryPath(key);
+    std::string temporary = path + "." + toHex(std::random_device{}()) + ".tmp";
+    if (!map.saveToFile(temporary, "bin")) {
+        return false;
+    }
+    std::error_code error;
+    fs::rename(temporary, path, error);
+    if (error) {
+        std::cerr << "Error: Cannot write cache entry: " << path << std::endl;
+        fs::remove(temporary, error);
+        return false;
+    }
+    trim();
+    return true;
+}
+
+/**
+ * @brief Count a run in progress
+ */
+void ProductCache::beginRun(void) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _activeRuns++;
+}
+
+/**
+ * @brief Release the last run's entries and trim
+ */
+void ProductCache::endRun(void) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_activeRuns == 0 || --_activeRuns > 0) return;
+        _used.clear();
+    }
+    trim();
+}
+
+/**
+ * @brief Evict least recently used entries over the limit
+ */
+void ProductCache::trim(void) {
+    if (!_valid) return;
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    struct Entry {
+        fs::path path;
+        uintmax_t size;
+        fs::file_time_type time;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    std::error_code error;
+    for (const auto& item : fs::directory_iterator(_directory, error)) {
+        std::string name = item.path().filename().string();
+        if (!isEntryName(name)) continue;
+        Entry entry{item.path(), item.file_size(error), item.last_write_time(error)};
+        if (error) continue;
+        total += entry.size;
+        // Entries this cache is using are kept
+        if (_used.count(name.substr(0, 16)) == 0) {
+            entries.push_back(entry);
+        }
+    }
+
+    // Oldest first
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    for (const Entry& entry : entries) {
+        if (total <= _maxBytes) break;
+        if (fs::remove(entry.path, error)) {
+            total -= entry.size;
+        }
+    }
+}
+
+// Explicit template instantiation
+template bool ProductCache::contains<double>(const std::string&) const;
+template bool ProductCache::contains<float>(const std::string&) const;
+template bool ProductCache::contains<int>(const std::string&) const;
+template uint64_t ProductCache::hashMap<double>(const Map<double>&);
+template uint64_t ProductCache::hashMap<float>(const Map<float>&);
+template uint64_t ProductCache::hashMap<int>(const Map<int>&);
+template bool ProductCache::load<double>(const std::string&, Map<double>&);
+template bool ProductCache::load<float>(const std::string&, Map<float>&);
+template bool ProductCache::load<int>(const std::string&, Map<int>&);
+template bool ProductCache::store<double>(const std::string&, const Map<double>&);
+template bool ProductCache::store<float>(const std::string&, const Map<float>&);
+template bool ProductCache::store<int>(const std::string&, const Map<int>&);
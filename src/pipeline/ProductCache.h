@@ -0,0 +1,152 @@
+/**
+ * @file ProductCache.h
+ * @author Ollie
+ * @brief On-disk cache of derived maps keyed by input, algorithm, parameters, and tool version
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef PRODUCT_CACHE_H
+#define PRODUCT_CACHE_H
+
+#include "../map_core/Map.h"
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+
+// Set by CMake from the project version, bumping it invalidates every cached product
+#ifndef TOOL_VERSION
+#define TOOL_VERSION "unknown"
+#endif
+
+// Cache size limit when none is given
+const uint64_t DEFAULT_CACHE_MB = 1024;
+
+/**
+ * @brief Directory of derived maps (D8, flow, slope, ...) stored in the binary Map format.
+ * A product's key is a hash of the source DEM bytes, the algorithm, its parameters, and
+ * TOOL_VERSION, so a product is only reused when all of them match. Entries are named
+ * <16 hex digits>.bin; other files in the directory are never touched.
+ *
+ * Loading an entry marks it recently used. After each store, least recently used entries
+ * are removed until the directory fits in the size limit. Entries loaded or stored during a
+ * run are not removed until every run started with beginRun() has ended, so a run cannot
+ * evict products it still reads. A cache used without beginRun() keeps them for its lifetime,
+ * as a one-off CLI run does.
+ *
+ * Methods may be called from several threads at once.
+ */
+class ProductCache {
+public:
+    /**
+     * @brief Open (and create) a cache directory
+     *
+     * @param directory Cache directory
+     * @param maxMB Size limit in megabytes
+     */
+    ProductCache(const std::string& directory, uint64_t maxMB = DEFAULT_CACHE_MB);
+
+    /// @return true if the directory could be created
+    bool isValid(void) const;
+
+    /**
+     * @brief Hash the bytes of a file
+     *
+     * @param filename File pathway
+     * @param hash Output: 64 bit hash
+     * @return true If the file could be read
+     */
+    static bool hashFile(const std::string& filename, uint64_t& hash);
+
+    /**
+     * @brief Hash the size and cells of a map
+     *
+     * @tparam T Numeric types: double, float, int
+     * @param map Map to hash
+     * @return uint64_t 64 bit hash
+     */
+    template <typename T>
+    static uint64_t hashMap(const Map<T>& map);
+
+    /**
+     * @brief Key of a product
+     *
+     * @param source Description of the input, e.g. "file:" + hex hash
+     * @param algorithm Product name, e.g. "flow-d8"
+     * @param parameters Parameters changing the result, empty if none
+     * @return std::string Key for load() and store()
+     */
+    static std::string makeKey(const std::string& source, const std::string& algorithm,
+        const std::string& parameters = "");
+
+    /**
+     * @brief Hex form of a hash, for building source descriptions
+     */
+    static std::string toHex(uint64_t hash);
+
+    /**
+     * @brief Check a complete product of cell type T is cached
+     *
+     * @tparam T Numeric types: double, float, int
+     * @param key Product key
+     * @return true If an entry exists and its size matches its header
+     */
+    template <typename T>
+    bool contains(const std::string& key) const;
+
+    /**
+     * @brief Load a cached product
+     *
+     * @tparam T Numeric types: double, float, int
+     * @param key Product key
+     * @param map Output map
+     * @return true If the entry existed and was complete
+     */
+    template <typename T>
+    bool load(const std::string& key, Map<T>& map);
+
+    /**
+     * @brief Store a product, then evict least recently used entries over the size limit
+     *
+     * @tparam T Numeric types: double, float, int
+     * @param key Product key
+     * @param map Product
+     * @return true If written
+     */
+    template <typename T>
+    bool store(const std::string& key, const Map<T>& map);
+
+    /**
+     * @brief Remove least recently used entries until the directory fits the size limit
+     */
+    void trim(void);
+
+    /**
+     * @brief Start a run (a batch job or REPL command) on a long-lived cache
+     */
+    void beginRun(void);
+
+    /**
+     * @brief End a run. Once no run is left, the entries they used may be evicted again and
+     * the directory is trimmed to the size limit.
+     */
+    void endRun(void);
+
+private:
+    std::string _directory;
+    uint64_t _maxBytes;
+    bool _valid;
+    std::mutex _mutex;
+    std::set<std::string> _used;   // Keys loaded or stored by the runs in progress
+    int _activeRuns = 0;
+
+    /**
+     * @brief Entry pathway of a key
+     */
+    std::string entryPath(const std::string& key) const;
+};
+
+#endif // PRODUCT_CACHE_H
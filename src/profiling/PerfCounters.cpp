@@ -0,0 +1,208 @@
+/**
+ * @file PerfCounters.cpp
+ * @author Ollie
+ * @brief Hardware performance counters (cycles, instructions, LLC and branch misses) via perf_event_open
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "PerfCounters.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+/**
+ * @brief Open one user space counter for the calling thread
+ */
+static int openCounter(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+/**
+ * @brief Read one counter, scaled if the kernel multiplexed it
+ *
+ * @return int64_t Count, -1 if it could not be read
+ */
+static int64_t readCounter(int fd) {
+    if (fd < 0) return -1;
+
+    // value, time enabled, time running
+    uint64_t data[3];
+    if (::read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) return -1;
+    if (data[2] == 0) return 0;
+    if (data[2] < data[1]) {
+        // Multiplexed, scale to the whole time enabled
+        return static_cast<int64_t>(static_cast<double>(data[0]) * data[1] / data[2]);
+    }
+    return static_cast<int64_t>(data[0]);
+}
+
+struct ThreadCounters;
+
+// Threads with open counters, and the final counts of threads that have exited
+static std::mutex registryMutex;
+static std::vector<ThreadCounters*> registry;
+static int64_t retired[PerfSample::COUNT] = {-1, -1, -1, -1};
+
+/**
+ * @brief Add count to total, where -1 means unknown
+ */
+static void addCount(int64_t& total, int64_t count) {
+    if (count < 0) return;
+    total = (total < 0) ? count : total + count;
+}
+
+/**
+ * @brief Counters of one thread, closed when the thread exits
+ */
+struct ThreadCounters {
+    int fds[PerfSample::COUNT] = {-1, -1, -1, -1};
+    int error = 0;  // errno of the first counter that failed
+
+    ThreadCounters() {
+        const uint64_t configs[PerfSample::COUNT] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+        for (int i = 0; i < PerfSample::COUNT; i++) {
+            fds[i] = openCounter(PERF_TYPE_HARDWARE, configs[i]);
+            if (fds[i] < 0 && error == 0) error = errno;
+        }
+        if (any()) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            registry.push_back(this);
+        }
+    }
+
+    ~ThreadCounters() {
+        if (any()) {
+            // Keep the counts of this thread in the process totals
+            std::lock_guard<std::mutex> lock(registryMutex);
+            for (int i = 0; i < PerfSample::COUNT; i++) {
+                addCount(retired[i], readCounter(fds[i]));
+            }
+            registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+        }
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    bool any(void) const {
+        for (int fd : fds) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief Counters of the calling thread
+ */
+static ThreadCounters& threadCounters(void) {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+#endif
+
+/**
+ * @brief Probe counters
+ */
+bool PerfCounters::available(std::string& reason) {
+#ifdef __linux__
+    ThreadCounters& counters = threadCounters();
+    if (counters.any()) return true;
+    if (counters.error == EACCES || counters.error == EPERM) {
+        reason = "no permission, lower /proc/sys/kernel/perf_event_paranoid to 2 or less";
+    }
+    else if (counters.error == ENOENT || counters.error == EOPNOTSUPP) {
+        reason = "no hardware counters on this CPU or virtual machine";
+    }
+    else if (counters.error == ENOSYS) {
+        reason = "kernel built without perf events";
+    }
+    else {
+        reason = std::strerror(counters.error);
+    }
+    return false;
+#else
+    reason = "only supported on Linux";
+    return false;
+#endif
+}
+
+/**
+ * @brief Read scaled counts
+ */
+void PerfCounters::read(PerfSample& sample) {
+#ifdef __linux__
+    ThreadCounters& counters = threadCounters();
+    for (int i = 0; i < PerfSample::COUNT; i++) {
+        sample.values[i] = readCounter(counters.fds[i]);
+    }
+#else
+    for (int i = 0; i < PerfSample::COUNT; i++) {
+        sample.values[i] = -1;
+    }
+#endif
+}
+
+/**
+ * @brief Open counters for the calling thread
+ */
+void PerfCounters::attach(void) {
+#ifdef __linux__
+    threadCounters();
+#endif
+}
+
+/**
+ * @brief Read scaled counts summed over threads
+ */
+void PerfCounters::readProcess(PerfSample& sample) {
+#ifdef __linux__
+    threadCounters();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (int i = 0; i < PerfSample::COUNT; i++) {
+        sample.values[i] = retired[i];
+        for (const ThreadCounters* counters : registry) {
+            addCount(sample.values[i], readCounter(counters->fds[i]));
+        }
+    }
+#else
+    for (int i = 0; i < PerfSample::COUNT; i++) {
+        sample.values[i] = -1;
+    }
+#endif
+}
+
+/**
+ * @brief Counter names
+ */
+const char* PerfCounters::name(int counter) {
+    switch (counter) {
+        case CYCLES: return "cycles";
+        case INSTRUCTIONS: return "instructions";
+        case LLC_MISSES: return "llc_misses";
+        case BRANCH_MISSES: return "branch_misses";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ * @file PerfCounters.h
+ * @author Ollie
+ * @brief Hardware performance counters (cycles, instructions, LLC and branch misses) via perf_event_open
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Counter values of the calling thread, -1 where a counter is unavailable
+ */
+struct PerfSample {
+    static const int COUNT = 4;
+    int64_t values[COUNT] = {-1, -1, -1, -1};
+};
+
+/**
+ * @brief Per-thread hardware counters on Linux.
+ * Each thread opens its own counters on first use (or attach()). read() gives the counts of
+ * the calling thread; readProcess() sums every thread that opened counters, including ones that
+ * have exited, so the difference of two reads covers work handed to ThreadPool workers too.
+ * Only user space is counted, which perf_event_paranoid levels up to 2 allow.
+ *
+ * Counters that cannot be opened (no permission, a virtual machine without a PMU, not Linux)
+ * read as -1 and the rest still work. available() says whether any can be opened at all.
+ *
+ * Example:
+ * @code
+ * PerfSample before, after;
+ * PerfCounters::readProcess(before);
+ * analyser.analyseFlow();
+ * PerfCounters::readProcess(after);
+ * int64_t cycles = after.values[PerfCounters::CYCLES] - before.values[PerfCounters::CYCLES];
+ * @endcode
+ */
+class PerfCounters {
+public:
+    enum Counter { CYCLES = 0, INSTRUCTIONS = 1, LLC_MISSES = 2, BRANCH_MISSES = 3 };
+
+    /**
+     * @brief Check counters can be opened on the calling thread
+     *
+     * @param reason Output: why not, if unavailable
+     * @return true If at least one counter opened
+     */
+    static bool available(std::string& reason);
+
+    /**
+     * @brief Read counters of the calling thread, opening them on first use.
+     * Counts are scaled up if the kernel multiplexed the counters.
+     *
+     * @param sample Output: current counts
+     */
+    static void read(PerfSample& sample);
+
+    /**
+     * @brief Read counters summed over every thread that opened them, live or exited
+     *
+     * @param sample Output: current process counts
+     */
+    static void readProcess(PerfSample& sample);
+
+    /**
+     * @brief Open counters for the calling thread so readProcess() includes it
+     */
+    static void attach(void);
+
+    /// @return const char* Name of a counter for reports
+    static const char* name(int counter);
+};
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,417 @@
+/**
+ * @file Profiler.cpp
+ * @author Ollie
+ * @brief Scoped stage timers, cell throughput, and peak RSS sampling behind --profile
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+std::atomic<bool> Profiler::_enabled(false);
+
+// Everything below is only touched while enabled, or under the mutex
+static std::mutex profileMutex;
+static std::vector<ProfileRecord> records;
+static std::vector<std::pair<double, uint64_t>> rssSamples;  // (seconds, bytes), in time order
+static std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+static double stopTime = 0;
+static std::thread sampler;
+static std::condition_variable samplerWake;
+static bool samplerStop = false;
+static std::atomic<int> nextThreadId(0);
+static bool countersEnabled = false;
+static std::string countersNote;  // Why hardware counters are off
+
+/**
+ * @brief Totals of one scope name
+ */
+struct ProfileTotals {
+    std::string name;
+    std::string category;
+    int calls = 0;
+    double seconds = 0;
+    uint64_t cells = 0;
+    uint64_t rssPeak = 0;
+    int64_t counters[PerfSample::COUNT] = {0, 0, 0, 0};  // -1 if any record lacks the counter
+    size_t firstSeen = 0;
+};
+
+/**
+ * @brief Counter per cell, or -1 if not known
+ */
+static double perCell(int64_t count, uint64_t cells) {
+    return (count >= 0 && cells > 0) ? static_cast<double>(count) / cells : -1.0;
+}
+
+/**
+ * @brief Instructions per cycle, or -1 if not known
+ */
+static double instructionsPerCycle(const int64_t* counters) {
+    int64_t cycles = counters[PerfCounters::CYCLES];
+    int64_t instructions = counters[PerfCounters::INSTRUCTIONS];
+    return (cycles > 0 && instructions >= 0) ? static_cast<double>(instructions) / cycles : -1.0;
+}
+
+/**
+ * @brief Fixed width number, "-" if not known
+ */
+static void writeColumn(std::ostream& out, int width, int precision, double value) {
+    if (value < 0) {
+        out << std::setw(width) << "-";
+    }
+    else {
+        out << std::setw(width) << std::setprecision(precision) << value;
+    }
+}
+
+/**
+ * @brief JSON counter fields, null if not known
+ */
+static void writeCountersJSON(std::ostream& out, const int64_t* counters, uint64_t cells) {
+    for (int i = 0; i < PerfSample::COUNT; i++) {
+        out << ", \"" << PerfCounters::name(i) << "\": ";
+        if (counters[i] < 0) out << "null";
+        else out << counters[i];
+    }
+    double ipc = instructionsPerCycle(counters);
+    double llc = perCell(counters[PerfCounters::LLC_MISSES], cells);
+    double branches = perCell(counters[PerfCounters::BRANCH_MISSES], cells);
+    out << ", \"ipc\": ";
+    if (ipc < 0) out << "null";
+    else out << ipc;
+    out << ", \"llc_misses_per_cell\": ";
+    if (llc < 0) out << "null";
+    else out << llc;
+    out << ", \"branch_misses_per_cell\": ";
+    if (branches < 0) out << "null";
+    else out << branches;
+}
+
+/**
+ * @brief Records grouped by category and name, in order of first appearance
+ */
+static std::vector<ProfileTotals> totals(void) {
+    std::map<std::pair<std::string, std::string>, ProfileTotals> grouped;
+    for (size_t i = 0; i < records.size(); i++) {
+        const ProfileRecord& record = records[i];
+        auto key = std::make_pair(record.category, record.name);
+        auto it = grouped.find(key);
+        if (it == grouped.end()) {
+            ProfileTotals entry;
+            entry.name = record.name;
+            entry.category = record.category;
+            entry.firstSeen = i;
+            it = grouped.emplace(key, entry).first;
+        }
+        it->second.calls++;
+        it->second.seconds += record.end - record.start;
+        it->second.cells += record.cells;
+        it->second.rssPeak = std::max(it->second.rssPeak, record.rssPeak);
+        for (int c = 0; c < PerfSample::COUNT; c++) {
+            int64_t& total = it->second.counters[c];
+            total = (total < 0 || record.counters[c] < 0) ? -1 : total + record.counters[c];
+        }
+    }
+
+    std::vector<ProfileTotals> result;
+    for (auto& entry : grouped) {
+        result.push_back(entry.second);
+    }
+    std::sort(result.begin(), result.end(), [](const ProfileTotals& a, const ProfileTotals& b) {
+        return a.firstSeen < b.firstSeen;
+    });
+    return result;
+}
+
+/**
+ * @brief Records sorted by start time, for stable reports
+ */
+static void sortRecords(void) {
+    std::stable_sort(records.begin(), records.end(), [](const ProfileRecord& a, const ProfileRecord& b) {
+        return a.start < b.start;
+    });
+}
+
+/**
+ * @brief Start recording
+ */
+void Profiler::enable(int sampleMilliseconds, bool hardwareCounters) {
+    if (isEnabled()) return;
+    countersEnabled = false;
+    countersNote = "not requested";
+    if (hardwareCounters) {
+        countersEnabled = PerfCounters::available(countersNote);
+    }
+    {
+        std::lock_guard<std::mutex> lock(profileMutex);
+        records.clear();
+        rssSamples.clear();
+        startTime = std::chrono::steady_clock::now();
+        samplerStop = false;
+    }
+    _enabled.store(true, std::memory_order_relaxed);
+
+    // RSS between scope boundaries, so short allocation spikes inside a kernel are seen
+    sampleMilliseconds = std::max(1, sampleMilliseconds);
+    sampler = std::thread([sampleMilliseconds]() {
+        std::unique_lock<std::mutex> lock(profileMutex);
+        while (!samplerStop) {
+            lock.unlock();
+            uint64_t rss = currentRSS();
+            double t = now();
+            lock.lock();
+            rssSamples.emplace_back(t, rss);
+            samplerWake.wait_for(lock, std::chrono::milliseconds(sampleMilliseconds));
+        }
+    });
+}
+
+/**
+ * @brief Stop recording
+ */
+void Profiler::disable(void) {
+    if (!isEnabled()) return;
+    _enabled.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(profileMutex);
+        samplerStop = true;
+        stopTime = now();
+    }
+    samplerWake.notify_all();
+    if (sampler.joinable()) {
+        sampler.join();
+    }
+}
+
+/**
+ * @brief Seconds since enable
+ */
+double Profiler::now(void) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+/**
+ * @brief Thread id, assigned on first use
+ */
+int Profiler::threadId(void) {
+    thread_local int id = nextThreadId.fetch_add(1);
+    return id;
+}
+
+/**
+ * @brief Resident set size from /proc/self/statm
+ */
+uint64_t Profiler::currentRSS(void) {
+#ifdef __linux__
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    unsigned long long pages = 0;
+    unsigned long long resident = 0;
+    int read = std::fscanf(file, "%llu %llu", &pages, &resident);
+    std::fclose(file);
+    if (read != 2) return 0;
+    return static_cast<uint64_t>(resident) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief High water mark of resident set size
+ */
+uint64_t Profiler::peakRSS(void) {
+#ifdef __linux__
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;  // Kilobytes on Linux
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Hardware counters in use
+ */
+bool Profiler::hasCounters(void) {
+    return countersEnabled;
+}
+
+/**
+ * @brief Keep a record, with the highest RSS sampled while it was open
+ */
+void Profiler::record(ProfileRecord&& record) {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    record.rssPeak = std::max(record.rssStart, record.rssEnd);
+    auto first = std::lower_bound(rssSamples.begin(), rssSamples.end(), std::make_pair(record.start, uint64_t(0)));
+    for (auto it = first; it != rssSamples.end() && it->first <= record.end; ++it) {
+        record.rssPeak = std::max(record.rssPeak, it->second);
+    }
+    records.push_back(std::move(record));
+}
+
+/**
+ * @brief Start a scope
+ */
+void ProfileScope::begin(void) {
+    if (_traced) {
+        _traceName = TraceRecorder::intern(_name);
+        TraceRecorder::begin(_traceName, _category);
+    }
+    if (!_active) return;
+    _rssStart = Profiler::currentRSS();
+    if (countersEnabled) {
+        PerfCounters::readProcess(_countersStart);
+    }
+    _start = Profiler::now();
+}
+
+/**
+ * @brief Finish a scope
+ */
+void ProfileScope::end(void) {
+    if (_traced) {
+        TraceRecorder::end(_traceName, _category);
+    }
+    if (!_active) return;
+
+    ProfileRecord record;
+    record.end = Profiler::now();
+    if (countersEnabled) {
+        PerfSample countersEnd;
+        PerfCounters::readProcess(countersEnd);
+        for (int i = 0; i < PerfSample::COUNT; i++) {
+            bool known = _countersStart.values[i] >= 0 && countersEnd.values[i] >= 0;
+            record.counters[i] = known ? countersEnd.values[i] - _countersStart.values[i] : -1;
+        }
+    }
+    record.rssEnd = Profiler::currentRSS();
+    record.name = _name;
+    record.category = _category;
+    record.thread = Profiler::threadId();
+    record.start = _start;
+    record.cells = _cells;
+    record.rssStart = _rssStart;
+    Profiler::record(std::move(record));
+}
+
+/**
+ * @brief Summary table
+ */
+void Profiler::writeSummary(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    sortRecords();
+    std::vector<ProfileTotals> entries = totals();
+    double wall = isEnabled() ? now() : stopTime;
+
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed;
+    out << "\nProfile (" << std::setprecision(3) << wall << " s wall, peak RSS "
+        << std::setprecision(1) << peakRSS() / 1048576.0 << " MB)\n";
+    out << std::left << std::setw(8) << "type" << std::setw(28) << "name" << std::right
+        << std::setw(7) << "calls" << std::setw(12) << "seconds" << std::setw(9) << "wall %"
+        << std::setw(12) << "Mcells/s" << std::setw(14) << "peak RSS MB";
+    if (countersEnabled) {
+        out << std::setw(7) << "IPC" << std::setw(11) << "LLC/cell" << std::setw(13) << "brmiss/cell";
+    }
+    out << "\n";
+    for (const ProfileTotals& entry : entries) {
+        out << std::left << std::setw(8) << entry.category << std::setw(28) << entry.name << std::right
+            << std::setw(7) << entry.calls
+            << std::setw(12) << std::setprecision(4) << entry.seconds
+            << std::setw(9) << std::setprecision(1) << (wall > 0 ? 100.0 * entry.seconds / wall : 0.0);
+        if (entry.cells > 0 && entry.seconds > 0) {
+            out << std::setw(12) << std::setprecision(2) << entry.cells / entry.seconds / 1e6;
+        }
+        else {
+            out << std::setw(12) << "-";
+        }
+        out << std::setw(14) << std::setprecision(1) << entry.rssPeak / 1048576.0;
+        if (countersEnabled) {
+            writeColumn(out, 7, 2, instructionsPerCycle(entry.counters));
+            writeColumn(out, 11, 4, perCell(entry.counters[PerfCounters::LLC_MISSES], entry.cells));
+            writeColumn(out, 13, 4, perCell(entry.counters[PerfCounters::BRANCH_MISSES], entry.cells));
+        }
+        out << "\n";
+    }
+    if (!countersEnabled) {
+        out << "Hardware counters off: " << countersNote << "\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+/**
+ * @brief JSON report
+ */
+bool Profiler::writeJSON(const std::string& filename) {
+    std::ofstream file(filename.c_str());
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(profileMutex);
+    sortRecords();
+    std::vector<ProfileTotals> entries = totals();
+    double wall = isEnabled() ? now() : stopTime;
+
+    file << std::setprecision(9);
+    file << "{\n";
+    file << "  \"wall_seconds\": " << wall << ",\n";
+    file << "  \"peak_rss_bytes\": " << peakRSS() << ",\n";
+    file << "  \"hardware_counters\": " << (countersEnabled ? "true" : "false") << ",\n";
+    if (!countersEnabled) {
+        file << "  \"hardware_counters_note\": \"" << countersNote << "\",\n";
+    }
+    file << "  \"totals\": [";
+    for (size_t i = 0; i < entries.size(); i++) {
+        const ProfileTotals& e = entries[i];
+        file << (i ? ",\n" : "\n");
+        file << "    {\"name\": \"" << e.name << "\", \"category\": \"" << e.category << "\", \"calls\": " << e.calls
+             << ", \"seconds\": " << e.seconds << ", \"cells\": " << e.cells
+             << ", \"cells_per_second\": " << (e.seconds > 0 ? e.cells / e.seconds : 0.0)
+             << ", \"peak_rss_bytes\": " << e.rssPeak;
+        writeCountersJSON(file, e.counters, e.cells);
+        file << "}";
+    }
+    file << "\n  ],\n";
+    file << "  \"records\": [";
+    for (size_t i = 0; i < records.size(); i++) {
+        const ProfileRecord& r = records[i];
+        file << (i ? ",\n" : "\n");
+        file << "    {\"name\": \"" << r.name << "\", \"category\": \"" << r.category << "\", \"thread\": " << r.thread
+             << ", \"start\": " << r.start << ", \"end\": " << r.end << ", \"cells\": " << r.cells
+             << ", \"rss_start_bytes\": " << r.rssStart << ", \"rss_end_bytes\": " << r.rssEnd
+             << ", \"peak_rss_bytes\": " << r.rssPeak;
+        writeCountersJSON(file, r.counters, r.cells);
+        file << "}";
+    }
+    file << "\n  ]\n}\n";
+
+    if (!file) {
+        std::cerr << "Failed to write file: " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Saved profile to: " << filename << std::endl;
+    return true;
+}
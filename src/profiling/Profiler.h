@@ -0,0 +1,167 @@
+/**
+ * @file Profiler.h
+ * @author Ollie
+ * @brief Scoped stage timers, cell throughput, and peak RSS sampling behind --profile
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "PerfCounters.h"
+#include "TraceRecorder.h"
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief One finished scope
+ */
+struct ProfileRecord {
+    std::string name;
+    std::string category;   // "stage" for pipeline nodes, "kernel" for analysis calls
+    int thread = 0;         // Small id in order of first use
+    double start = 0;       // Seconds since enable()
+    double end = 0;
+    uint64_t cells = 0;
+    uint64_t rssStart = 0;  // Bytes
+    uint64_t rssEnd = 0;
+    uint64_t rssPeak = 0;   // Highest RSS seen while the scope was open
+    int64_t counters[PerfSample::COUNT] = {-1, -1, -1, -1};  // PerfCounters deltas, -1 if unavailable
+};
+
+/**
+ * @brief Process-wide collector of ProfileScope records.
+ * Disabled by default. While disabled a ProfileScope costs one relaxed atomic load, so
+ * scopes are left in production builds. enable() starts a thread sampling the resident set
+ * size every few milliseconds, so each scope also gets the peak RSS while it was open.
+ * If hardware counters can be opened (see PerfCounters), each scope also gets cycles,
+ * instructions, and LLC and branch misses, reported as IPC and misses per cell. Counts are
+ * for the whole process, so scopes running at the same time share them.
+ *
+ * Example:
+ * @code
+ * Profiler::enable();
+ * {
+ *     ProfileScope scope("fill_sinks", "kernel", dem.getWidth() * dem.getHeight());
+ *     dem.fillSinks();
+ * }
+ * Profiler::disable();
+ * Profiler::writeSummary(std::cerr);
+ * Profiler::writeJSON("profile.json");
+ * @endcode
+ */
+class Profiler {
+public:
+    /**
+     * @brief Start recording and RSS sampling. Clears earlier records.
+     *
+     * @param sampleMilliseconds Interval between RSS samples
+     * @param hardwareCounters Also read hardware counters per scope, where the kernel allows
+     */
+    static void enable(int sampleMilliseconds = 10, bool hardwareCounters = true);
+
+    /**
+     * @brief Stop recording and RSS sampling. Records are kept for the reports.
+     */
+    static void disable(void);
+
+    /// @return true If scopes are being recorded
+    static bool isEnabled(void) { return _enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Human readable table of stages and kernels: calls, time, throughput, peak RSS
+     *
+     * @param out Stream to write to
+     */
+    static void writeSummary(std::ostream& out);
+
+    /**
+     * @brief JSON report of totals per scope name and every record
+     *
+     * @param filename Output .json pathway
+     * @return true If written
+     */
+    static bool writeJSON(const std::string& filename);
+
+    /// @return uint64_t Resident set size of the process in bytes, 0 if unknown
+    static uint64_t currentRSS(void);
+
+    /// @return uint64_t Highest resident set size of the process so far in bytes, 0 if unknown
+    static uint64_t peakRSS(void);
+
+    /// @return true If scopes are reading hardware counters
+    static bool hasCounters(void);
+
+private:
+    friend class ProfileScope;
+
+    static std::atomic<bool> _enabled;
+
+    /// @return double Seconds since enable()
+    static double now(void);
+
+    /// @return int Id of the calling thread
+    static int threadId(void);
+
+    /**
+     * @brief Keep a finished scope
+     */
+    static void record(ProfileRecord&& record);
+};
+
+/**
+ * @brief Times the enclosing block as a named stage while the Profiler is enabled, and
+ * records it as a trace span while the TraceRecorder is enabled.
+ * Cells processed may be given up front or added once known (e.g. after loading a file).
+ * Names must outlive the scope; they are only copied when the scope is recorded.
+ */
+class ProfileScope {
+public:
+    /**
+     * @brief Open a scope
+     *
+     * @param name Stage or kernel name
+     * @param category "stage" or "kernel"
+     * @param cells Cells processed, for throughput
+     */
+    ProfileScope(const char* name, const char* category = "kernel", uint64_t cells = 0)
+        : _name(name), _category(category), _cells(cells), _active(Profiler::isEnabled()),
+          _traced(TraceRecorder::isEnabled()) {
+        if (_active || _traced) begin();
+    }
+
+    ~ProfileScope() {
+        if (_active || _traced) end();
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    /**
+     * @brief Count more cells towards this scope
+     *
+     * @param cells Cells processed
+     */
+    void addCells(uint64_t cells) { _cells += cells; }
+
+private:
+    const char* _name;
+    const char* _category;
+    uint64_t _cells;
+    bool _active;
+    bool _traced;
+    const char* _traceName = nullptr;
+    double _start = 0;
+    uint64_t _rssStart = 0;
+    PerfSample _countersStart;
+
+    void begin(void);
+    void end(void);
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,230 @@
+/**
+ * @file TraceRecorder.cpp
+ * @author Ollie
+ * @brief Begin/end events per stage, tile, and worker thread, saved as Chrome trace-event JSON
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+// Events per buffer chunk, chunks are never moved so appends stay cheap
+const size_t TRACE_CHUNK_EVENTS = 4096;
+
+/**
+ * @brief Events of one thread, only appended to by that thread
+ */
+struct TraceBuffer {
+    int thread = 0;
+    const char* threadName = nullptr;
+    std::vector<std::unique_ptr<TraceEvent[]>> chunks;
+    size_t count = 0;
+};
+
+std::atomic<bool> TraceRecorder::_enabled(false);
+
+// Registry, locked only when a thread records its first event, and for reports
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<TraceBuffer>> buffers;
+static std::unordered_set<std::string> internedNames;
+static std::chrono::steady_clock::time_point traceStart = std::chrono::steady_clock::now();
+
+/**
+ * @brief Buffer of the calling thread, registered on first use
+ */
+static TraceBuffer& threadBuffer(void) {
+    thread_local TraceBuffer* buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers.emplace_back(new TraceBuffer());
+        buffer = buffers.back().get();
+        buffer->thread = static_cast<int>(buffers.size());
+    }
+    return *buffer;
+}
+
+/**
+ * @brief Append without locking
+ */
+static void append(const TraceEvent& event) {
+    TraceBuffer& buffer = threadBuffer();
+    size_t chunk = buffer.count / TRACE_CHUNK_EVENTS;
+    if (chunk == buffer.chunks.size()) {
+        buffer.chunks.emplace_back(new TraceEvent[TRACE_CHUNK_EVENTS]);
+    }
+    buffer.chunks[chunk][buffer.count % TRACE_CHUNK_EVENTS] = event;
+    buffer.count++;
+}
+
+/**
+ * @brief Nanoseconds since enable
+ */
+static int64_t traceNow(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceStart).count();
+}
+
+/**
+ * @brief Quote and backslash escaping for names
+ */
+static void writeString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text ? text : ""; *c; c++) {
+        if (*c == '"' || *c == '\\') out << '\\';
+        out << *c;
+    }
+    out << '"';
+}
+
+/**
+ * @brief Start recording
+ */
+void TraceRecorder::enable(void) {
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto& buffer : buffers) {
+            buffer->count = 0;
+        }
+        traceStart = std::chrono::steady_clock::now();
+    }
+    _enabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Stop recording
+ */
+void TraceRecorder::disable(void) {
+    _enabled.store(false, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Begin event
+ */
+void TraceRecorder::begin(const char* name, const char* category, int nArgs,
+    const char* argName0, int64_t argValue0, const char* argName1, int64_t argValue1,
+    const char* argName2, int64_t argValue2) {
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.phase = 'B';
+    event.nArgs = std::min(3, std::max(0, nArgs));
+    event.argNames[0] = argName0;
+    event.argNames[1] = argName1;
+    event.argNames[2] = argName2;
+    event.argValues[0] = argValue0;
+    event.argValues[1] = argValue1;
+    event.argValues[2] = argValue2;
+    event.timestamp = traceNow();
+    append(event);
+}
+
+/**
+ * @brief End event, recorded even if disabled since its begin so spans stay matched
+ */
+void TraceRecorder::end(const char* name, const char* category) {
+    TraceEvent event;
+    event.timestamp = traceNow();
+    event.name = name;
+    event.category = category;
+    event.phase = 'E';
+    event.nArgs = 0;
+    append(event);
+}
+
+/**
+ * @brief Thread name
+ */
+void TraceRecorder::setThreadName(const char* name) {
+    if (isEnabled()) {
+        threadBuffer().threadName = name;
+    }
+}
+
+/**
+ * @brief Stable name copy
+ */
+const char* TraceRecorder::intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return internedNames.insert(name).first->c_str();
+}
+
+/**
+ * @brief Event count
+ */
+size_t TraceRecorder::getEventCount(void) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t count = 0;
+    for (const auto& buffer : buffers) {
+        count += buffer->count;
+    }
+    return count;
+}
+
+/**
+ * @brief Chrome trace-event JSON
+ */
+bool TraceRecorder::writeJSON(const std::string& filename) {
+    std::ofstream file(filename.c_str());
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (const auto& buffer : buffers) {
+        if (buffer->count == 0) continue;
+
+        // Thread names, "thread N" for threads that never set one
+        file << (first ? "\n" : ",\n");
+        first = false;
+        std::string threadName = buffer->threadName ? buffer->threadName : "thread";
+        if (!buffer->threadName || threadName != "main") {
+            threadName += " " + std::to_string(buffer->thread);
+        }
+        file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->thread
+             << ", \"args\": {\"name\": ";
+        writeString(file, threadName.c_str());
+        file << "}}";
+
+        for (size_t i = 0; i < buffer->count; i++) {
+            const TraceEvent& event = buffer->chunks[i / TRACE_CHUNK_EVENTS][i % TRACE_CHUNK_EVENTS];
+            file << ",\n{\"name\": ";
+            writeString(file, event.name);
+            file << ", \"cat\": ";
+            writeString(file, event.category);
+            file << ", \"ph\": \"" << event.phase << "\", \"ts\": " << event.timestamp / 1000.0
+                 << ", \"pid\": 1, \"tid\": " << buffer->thread;
+            if (event.nArgs > 0) {
+                file << ", \"args\": {";
+                for (int a = 0; a < event.nArgs; a++) {
+                    file << (a ? ", " : "");
+                    writeString(file, event.argNames[a]);
+                    file << ": " << event.argValues[a];
+                }
+                file << "}";
+            }
+            file << "}";
+        }
+    }
+    file << "\n]}\n";
+
+    if (!file) {
+        std::cerr << "Failed to write file: " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Saved trace to: " << filename << std::endl;
+    return true;
+}
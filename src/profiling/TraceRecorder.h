@@ -0,0 +1,147 @@
+/**
+ * @file TraceRecorder.h
+ * @author Ollie
+ * @brief Begin/end events per stage, tile, and worker thread, saved as Chrome trace-event JSON
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief One begin ('B') or end ('E') event. Names point at string literals or intern() strings.
+ */
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    char phase;
+    int64_t timestamp;          // Nanoseconds since enable()
+    int nArgs;
+    const char* argNames[3];
+    int64_t argValues[3];
+};
+
+/**
+ * @brief Process-wide recorder of trace events for chrome://tracing or Perfetto.
+ * Every thread appends to its own buffer, so recording takes no lock; a thread only locks
+ * once to register its buffer on its first event. Buffers outlive their threads and are
+ * written by writeJSON() once the traced work has finished.
+ *
+ * Disabled by default, when a TraceScope costs one relaxed atomic load.
+ *
+ * Example:
+ * @code
+ * TraceRecorder::enable();
+ * parallelFor(0, height, getThreadCount(), [&](int, int y0, int y1) {
+ *     TraceScope scope("rows", "worker", "y0", y0, "y1", y1);
+ *     ...
+ * });
+ * TraceRecorder::disable();
+ * TraceRecorder::writeJSON("trace.json");
+ * @endcode
+ */
+class TraceRecorder {
+public:
+    /**
+     * @brief Start recording. Clears earlier events.
+     */
+    static void enable(void);
+
+    /**
+     * @brief Stop recording. Events are kept for writeJSON().
+     */
+    static void disable(void);
+
+    /// @return true If events are being recorded
+    static bool isEnabled(void) { return _enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Record the start of a span on the calling thread
+     *
+     * @param name Span name, a literal or from intern()
+     * @param category "stage", "kernel", "tile", "worker", or "job"
+     * @param nArgs Number of integer arguments given below, up to 3
+     */
+    static void begin(const char* name, const char* category, int nArgs = 0,
+        const char* argName0 = nullptr, int64_t argValue0 = 0,
+        const char* argName1 = nullptr, int64_t argValue1 = 0,
+        const char* argName2 = nullptr, int64_t argValue2 = 0);
+
+    /**
+     * @brief Record the end of the innermost open span on the calling thread
+     */
+    static void end(const char* name, const char* category);
+
+    /**
+     * @brief Name the calling thread in the trace (e.g. "pool worker")
+     *
+     * @param name Literal thread name
+     */
+    static void setThreadName(const char* name);
+
+    /**
+     * @brief Stable copy of a name that may not outlive the trace (e.g. a pipeline node name)
+     *
+     * @param name Name to keep
+     * @return const char* Pointer valid until exit
+     */
+    static const char* intern(const std::string& name);
+
+    /// @return size_t Events recorded over all threads
+    static size_t getEventCount(void);
+
+    /**
+     * @brief Write all events in Chrome trace-event JSON. Call once traced threads are idle.
+     *
+     * @param filename Output .json pathway
+     * @return true If written
+     */
+    static bool writeJSON(const std::string& filename);
+
+private:
+    static std::atomic<bool> _enabled;
+};
+
+/**
+ * @brief Records the enclosing block as a span while the TraceRecorder is enabled
+ */
+class TraceScope {
+public:
+    /**
+     * @brief Open a span with up to three integer arguments
+     *
+     * @param name Literal span name
+     * @param category Literal category
+     */
+    TraceScope(const char* name, const char* category,
+        const char* argName0 = nullptr, int64_t argValue0 = 0,
+        const char* argName1 = nullptr, int64_t argValue1 = 0,
+        const char* argName2 = nullptr, int64_t argValue2 = 0)
+        : _name(name), _category(category), _active(TraceRecorder::isEnabled()) {
+        if (_active) {
+            int nArgs = argName2 ? 3 : argName1 ? 2 : argName0 ? 1 : 0;
+            TraceRecorder::begin(name, category, nArgs, argName0, argValue0, argName1, argValue1, argName2, argValue2);
+        }
+    }
+
+    ~TraceScope() {
+        if (_active) TraceRecorder::end(_name, _category);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* _name;
+    const char* _category;
+    bool _active;
+};
+
+#endif // TRACE_RECORDER_H
@@ -0,0 +1,423 @@
+/**
+ * @file ShardCoordinator.cpp
+ * @author Ollie
+ * @brief Split a DEM into strips of rows across worker processes and stitch their results
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "ShardCoordinator.h"
+#include "ShardProtocol.h"
+#include "../map_core/MapTiles.h"
+#include "../parallel/parallelFor.h"
+#include "../profiling/Profiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Time local workers have to start and connect
+static const int LOCAL_CONNECT_TIMEOUT_MS = 30000;
+
+/**
+ * @brief Coordinator's view of one worker and its strip
+ */
+struct ShardStrip {
+    int firstRow = 0, lastRow = 0;        // Rows [firstRow, lastRow) of the grid
+    ShardConnection connection;
+    std::vector<double> firstValues;      // Current first and last rows, halos for the neighbours
+    std::vector<double> lastValues;
+    std::vector<int64_t> incoming;        // Cells for the strip's next sweep from its neighbours
+    int sweepsDone = 0;
+    bool busy = false;
+    std::vector<int64_t> firstLinks;      // Exit reached from each first and last row cell, -1 for none
+    std::vector<int64_t> lastLinks;
+};
+
+/**
+ * @brief Receive a reply of the expected type from strip k
+ */
+static bool receiveReply(ShardStrip& strip, int k, ShardMessageType expected, ShardMessage& reply) {
+    if (!strip.connection.receive(reply)) {
+        std::cerr << "Error: Lost connection to shard " << k << "." << std::endl;
+        return false;
+    }
+    if (reply.type != expected) {
+        std::cerr << "Error: Shard " << k << " failed (rows " << strip.firstRow << "-" << strip.lastRow - 1 << ")." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Send a request to strip k
+ */
+static bool sendRequest(ShardStrip& strip, int k, const ShardMessage& request) {
+    if (!strip.connection.send(request)) {
+        std::cerr << "Error: Could not send to shard " << k << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Append the halo rows of strip k: the last row of the strip above and the first row
+ * of the strip below, where they exist
+ */
+static void putHaloRows(const std::vector<ShardStrip>& strips, int k, ShardMessage& message) {
+    bool hasAbove = k > 0;
+    bool hasBelow = k + 1 < static_cast<int>(strips.size());
+    message.put<uint8_t>(hasAbove ? 1 : 0);
+    if (hasAbove) message.putArray(strips[k - 1].lastValues.data(), strips[k - 1].lastValues.size());
+    message.put<uint8_t>(hasBelow ? 1 : 0);
+    if (hasBelow) message.putArray(strips[k + 1].firstValues.data(), strips[k + 1].firstValues.size());
+}
+
+/**
+ * @brief Tell each worker the grid size and its strip's rows, then send it the strip and
+ * halo rows. Replies from then on are bounded by the strip's size.
+ */
+static bool loadStrips(const BinaryTileSource<double>& source, std::vector<ShardStrip>& strips) {
+    ProfileScope scope("shard_load", "stage");
+    int width = source.getWidth();
+    int height = source.getHeight();
+    for (size_t k = 0; k < strips.size(); k++) {
+        ShardStrip& strip = strips[k];
+        ShardMessage request(ShardMessageType::SHAPE);
+        int32_t header[6] = {width, height, strip.firstRow, strip.lastRow,
+                             std::max(0, strip.firstRow - 1), std::min(height, strip.lastRow + 1)};
+        request.putArray(header, 6);
+        strip.connection.setPayloadLimit(shardPayloadLimit(width, strip.lastRow - strip.firstRow));
+        if (!sendRequest(strip, static_cast<int>(k), request)) return false;
+    }
+    for (size_t k = 0; k < strips.size(); k++) {
+        ShardMessage reply;
+        if (!receiveReply(strips[k], static_cast<int>(k), ShardMessageType::SHAPED, reply)) return false;
+    }
+
+    std::vector<double> rows;
+    for (size_t k = 0; k < strips.size(); k++) {
+        ShardStrip& strip = strips[k];
+        int haloFirst = std::max(0, strip.firstRow - 1);
+        int haloLast = std::min(height, strip.lastRow + 1);
+        rows.resize(static_cast<size_t>(width) * (haloLast - haloFirst));
+        if (!source.readBlock(0, haloFirst, width, haloLast, rows.data(), static_cast<size_t>(width))) {
+            return false;
+        }
+        strip.firstValues.assign(rows.begin() + static_cast<size_t>(strip.firstRow - haloFirst) * width,
+                                 rows.begin() + static_cast<size_t>(strip.firstRow - haloFirst + 1) * width);
+        strip.lastValues.assign(rows.begin() + static_cast<size_t>(strip.lastRow - 1 - haloFirst) * width,
+                                rows.begin() + static_cast<size_t>(strip.lastRow - haloFirst) * width);
+
+        ShardMessage request(ShardMessageType::LOAD);
+        request.putArray(rows.data(), rows.size());
+        scope.addCells(rows.size());
+        if (!sendRequest(strip, static_cast<int>(k), request)) return false;
+    }
+
+    // Workers find their first sinks in parallel
+    for (size_t k = 0; k < strips.size(); k++) {
+        ShardMessage reply;
+        if (!receiveReply(strips[k], static_cast<int>(k), ShardMessageType::LOADED, reply)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief fillSinks() across the strips. Sweep s of a strip needs the strip above to have
+ * finished sweep s and the strip below sweep s - 1, as a whole-grid row-major sweep would
+ * see them, so strips run as a pipeline: each runs its next sweep as soon as its neighbours
+ * allow. Filling is complete once every strip has run some sweep that raised no cell.
+ */
+static bool fillStrips(std::vector<ShardStrip>& strips, int width) {
+    ProfileScope scope("shard_fill", "stage");
+    int n = static_cast<int>(strips.size());
+    std::vector<int> stripsDone;   // Per sweep: strips that have run it
+    std::vector<int64_t> raised;   // Per sweep: cells raised
+    bool finished = false;
+    int running = 0;
+
+    auto ready = [&](int k) {
+        int sweep = strips[k].sweepsDone + 1;
+        if (k > 0 && strips[k - 1].sweepsDone < sweep) return false;
+        if (k + 1 < n && strips[k + 1].sweepsDone < sweep - 1) return false;
+        return true;
+    };
+
+    while (true) {
+        if (!finished) {
+            for (int k = 0; k < n; k++) {
+                if (strips[k].busy || !ready(k)) continue;
+                ShardMessage request(ShardMessageType::SWEEP);
+                putHaloRows(strips, k, request);
+                // Cells queued by more than one neighbouring sweep are sent once
+                std::vector<int64_t>& incoming = strips[k].incoming;
+                std::sort(incoming.begin(), incoming.end());
+                incoming.erase(std::unique(incoming.begin(), incoming.end()), incoming.end());
+                request.putVector(incoming);
+                strips[k].incoming.clear();
+                if (!sendRequest(strips[k], k, request)) return false;
+                strips[k].busy = true;
+                running++;
+            }
+        }
+        if (running == 0) break;
+
+        std::vector<pollfd> waiting;
+        std::vector<int> waitingStrips;
+        for (int k = 0; k < n; k++) {
+            if (!strips[k].busy) continue;
+            waiting.push_back({strips[k].connection.getFd(), POLLIN, 0});
+            waitingStrips.push_back(k);
+        }
+        if (::poll(waiting.data(), waiting.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Error: Waiting for shards failed." << std::endl;
+            return false;
+        }
+
+        for (size_t i = 0; i < waiting.size(); i++) {
+            if (waiting[i].revents == 0) continue;
+            int k = waitingStrips[i];
+            ShardStrip& strip = strips[k];
+            ShardMessage reply;
+            int32_t count = 0;
+            std::vector<int64_t> above, below;
+            if (!receiveReply(strip, k, ShardMessageType::SWEPT, reply) || !reply.get(count) ||
+                !reply.getArray(strip.firstValues.data(), width) || !reply.getArray(strip.lastValues.data(), width) ||
+                !reply.getVector(above) || !reply.getVector(below)) {
+                std::cerr << "Error: Invalid sweep reply from shard " << k << "." << std::endl;
+                return false;
+            }
+            strip.busy = false;
+            running--;
+
+            // Raised cells' neighbours in the strips either side
+            if (k > 0) strips[k - 1].incoming.insert(strips[k - 1].incoming.end(), above.begin(), above.end());
+            if (k + 1 < n) strips[k + 1].incoming.insert(strips[k + 1].incoming.end(), below.begin(), below.end());
+
+            int sweep = ++strip.sweepsDone;
+            if (static_cast<int>(stripsDone.size()) <= sweep) {
+                stripsDone.resize(sweep + 1, 0);
+                raised.resize(sweep + 1, 0);
+            }
+            stripsDone[sweep]++;
+            raised[sweep] += count;
+            if (stripsDone[sweep] == n && raised[sweep] == 0) finished = true;
+        }
+    }
+
+    if (!finished) {
+        std::cerr << "Error: Sharded sink filling stopped before converging." << std::endl;
+        return false;
+    }
+    int sweeps = 0;
+    for (const ShardStrip& strip : strips) {
+        sweeps = std::max(sweeps, strip.sweepsDone);
+    }
+    std::cout << "Filled sinks in " << sweeps << " sweeps across " << n << " shards." << std::endl;
+    return true;
+}
+
+/**
+ * @brief D8 directions and flow accumulation. Each worker accumulates its strip alone; flow
+ * leaving through exits is then passed to the strips it enters in the order the whole-grid
+ * accumulation visits cells, following each target to the exit its flow next reaches, and
+ * the workers accumulate again with that inflow.
+ */
+static bool accumulateStrips(std::vector<ShardStrip>& strips, int width) {
+    ProfileScope scope("shard_flow", "stage");
+    int n = static_cast<int>(strips.size());
+    for (int k = 0; k < n; k++) {
+        ShardMessage request(ShardMessageType::ANALYSE);
+        putHaloRows(strips, k, request);
+        if (!sendRequest(strips[k], k, request)) return false;
+    }
+
+    // Exits of every strip, with the strip they leave
+    std::vector<std::pair<ShardExit, int>> exits;
+    for (int k = 0; k < n; k++) {
+        ShardMessage reply;
+        std::vector<ShardExit> stripExits;
+        if (!receiveReply(strips[k], k, ShardMessageType::ANALYSED, reply) || !reply.getVector(stripExits) ||
+            !reply.getVector(strips[k].firstLinks) || !reply.getVector(strips[k].lastLinks) ||
+            static_cast<int>(strips[k].firstLinks.size()) != width ||
+            static_cast<int>(strips[k].lastLinks.size()) != width) {
+            std::cerr << "Error: Invalid flow reply from shard " << k << "." << std::endl;
+            return false;
+        }
+        for (const ShardExit& exit : stripExits) {
+            exits.emplace_back(exit, k);
+        }
+    }
+    std::sort(exits.begin(), exits.end(), [](const auto& a, const auto& b) {
+        return accumulatedBefore(a.first.elevation, a.first.cell, b.first.elevation, b.first.cell);
+    });
+
+    // Flow reaching each exit from exits earlier in the order
+    std::unordered_map<int64_t, double> extra;
+    std::vector<std::vector<int64_t>> seedCells(n), addCells(n);
+    std::vector<std::vector<double>> seedFlow(n), addFlow(n);
+    for (const auto& [exit, from] : exits) {
+        auto found = extra.find(exit.cell);
+        double flow = exit.outflow + (found == extra.end() ? 0.0 : found->second);
+        int targetRow = static_cast<int>(exit.target / width);
+        int to = (targetRow < strips[from].firstRow) ? from - 1 : from + 1;
+        if (!exit.propagates) {
+            addCells[to].push_back(exit.target);
+            addFlow[to].push_back(flow);
+            continue;
+        }
+        seedCells[to].push_back(exit.target);
+        seedFlow[to].push_back(flow);
+        int x = static_cast<int>(exit.target % width);
+        int64_t link = (targetRow == strips[to].firstRow) ? strips[to].firstLinks[x] : strips[to].lastLinks[x];
+        if (link >= 0) extra[link] += flow;
+    }
+
+    for (int k = 0; k < n; k++) {
+        ShardMessage request(ShardMessageType::SEED);
+        request.putVector(seedCells[k]);
+        request.putVector(seedFlow[k]);
+        request.putVector(addCells[k]);
+        request.putVector(addFlow[k]);
+        if (!sendRequest(strips[k], k, request)) return false;
+    }
+    for (int k = 0; k < n; k++) {
+        ShardMessage reply;
+        if (!receiveReply(strips[k], k, ShardMessageType::SEEDED, reply)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Collect each strip's rows into the output files, a strip at a time
+ */
+static bool writeStrips(std::vector<ShardStrip>& strips, int width, int height, const std::string& prefix) {
+    ProfileScope scope("shard_write", "stage", static_cast<uint64_t>(width) * height);
+    BinaryTileSink<double> filled(prefix + "_filled.bin", width, height);
+    BinaryTileSink<int> directions(prefix + "_d8.bin", width, height);
+    BinaryTileSink<double> flow(prefix + "_flow.bin", width, height);
+    if (!filled.isValid() || !directions.isValid() || !flow.isValid()) return false;
+
+    std::vector<double> values;
+    std::vector<int> codes;
+    for (size_t k = 0; k < strips.size(); k++) {
+        ShardStrip& strip = strips[k];
+        size_t cells = static_cast<size_t>(width) * (strip.lastRow - strip.firstRow);
+        ShardMessage reply;
+        if (!sendRequest(strip, static_cast<int>(k), ShardMessage(ShardMessageType::RESULT)) ||
+            !receiveReply(strip, static_cast<int>(k), ShardMessageType::STRIP, reply)) {
+            return false;
+        }
+        values.resize(cells);
+        codes.resize(cells);
+        size_t stride = static_cast<size_t>(width);
+        if (!reply.getArray(values.data(), cells) ||
+            !filled.writeBlock(0, strip.firstRow, width, strip.lastRow, values.data(), stride) ||
+            !reply.getArray(codes.data(), cells) ||
+            !directions.writeBlock(0, strip.firstRow, width, strip.lastRow, codes.data(), stride) ||
+            !reply.getArray(values.data(), cells) ||
+            !flow.writeBlock(0, strip.firstRow, width, strip.lastRow, values.data(), stride)) {
+            std::cerr << "Error: Could not write the rows of shard " << k << "." << std::endl;
+            return false;
+        }
+    }
+    std::cout << "Saved " << prefix << "_filled.bin, " << prefix << "_d8.bin and " << prefix << "_flow.bin" << std::endl;
+    return true;
+}
+
+/**
+ * @brief Accept the workers, then run every stage
+ */
+static bool coordinate(ShardListener& listener, const BinaryTileSource<double>& source, int nShards,
+                       int timeoutMs, const std::string& prefix) {
+    int width = source.getWidth();
+    int height = source.getHeight();
+    std::vector<ShardStrip> strips(nShards);
+    for (int k = 0; k < nShards; k++) {
+        strips[k].firstRow = static_cast<int>(static_cast<int64_t>(height) * k / nShards);
+        strips[k].lastRow = static_cast<int>(static_cast<int64_t>(height) * (k + 1) / nShards);
+        strips[k].connection = listener.accept(timeoutMs);
+        if (!strips[k].connection.isOpen()) {
+            std::cerr << "Error: Only " << k << " of " << nShards << " shard workers connected." << std::endl;
+            return false;
+        }
+    }
+
+    bool ok = loadStrips(source, strips) && fillStrips(strips, width) &&
+              accumulateStrips(strips, width) && writeStrips(strips, width, height, prefix);
+    if (ok) {
+        for (ShardStrip& strip : strips) {
+            strip.connection.send(ShardMessage(ShardMessageType::QUIT));
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief Sharded run
+ */
+bool runSharded(const ShardOptions& options) {
+    BinaryTileSource<double> source(options.inputFile);
+    if (!source.isValid()) return false;
+    if (options.nShards < 1) {
+        std::cerr << "Error: Number of shards must be at least 1." << std::endl;
+        return false;
+    }
+    int nShards = std::min(options.nShards, source.getHeight());
+
+    bool local = options.address.empty();
+    std::string address = local ? "unix:/tmp/drainage-shard-" + std::to_string(::getpid()) + ".sock" : options.address;
+    ShardListener listener;
+    if (!listener.listenOn(address)) return false;
+
+    // Local workers: this binary with --shard-worker, sharing the machine's threads
+    std::vector<pid_t> workers;
+    if (local) {
+        std::string threads = std::to_string(std::max(1, getThreadCount() / nShards));
+        for (int k = 0; k < nShards; k++) {
+            pid_t pid = ::fork();
+            if (pid == 0) {
+                const char* args[] = {"drainage-analysis", "--shard-worker", address.c_str(),
+                                      "--threads", threads.c_str(), nullptr};
+                ::execv("/proc/self/exe", const_cast<char* const*>(args));
+                std::cerr << "Error: Could not start shard worker." << std::endl;
+                ::_exit(127);
+            }
+            if (pid < 0) {
+                std::cerr << "Error: Could not start shard worker." << std::endl;
+                break;
+            }
+            workers.push_back(pid);
+        }
+    }
+    else {
+        std::cout << "Waiting for " << nShards << " workers on " << address << std::endl;
+    }
+
+    bool ok = static_cast<int>(workers.size()) == nShards || !local;
+    if (ok) {
+        ok = coordinate(listener, source, nShards, local ? LOCAL_CONNECT_TIMEOUT_MS : -1, options.outputPrefix);
+    }
+
+    // Connections are closed, so workers still running after a failure stop on their own
+    if (!ok) {
+        for (pid_t pid : workers) {
+            ::kill(pid, SIGTERM);
+        }
+    }
+    for (pid_t pid : workers) {
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+    }
+    return ok;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file ShardCoordinator.h
+ * @author Ollie
+ * @brief Split a DEM into strips of rows across worker processes and stitch their results
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef SHARD_COORDINATOR_H
+#define SHARD_COORDINATOR_H
+
+#include <string>
+
+/**
+ * @brief Inputs and outputs of a sharded run
+ */
+struct ShardOptions {
+    std::string inputFile;     // DEM of doubles in the .bin format
+    std::string outputPrefix;  // Writes <prefix>_filled.bin, <prefix>_d8.bin and <prefix>_flow.bin
+    int nShards = 2;           // Worker processes, one strip of rows each
+    std::string address;       // Empty: spawn local workers on a Unix socket.
+                               // Otherwise listen here for workers started with --shard-worker
+};
+
+/**
+ * @brief Fill sinks, find D8 directions and accumulate D8 flow over a DEM split into strips of
+ * rows, each held by one worker process. Only the rows either side of each strip boundary,
+ * raised cells next to a boundary, and flow crossing a boundary pass between processes, so
+ * the coordinator never holds the whole grid. Results equal fillSinks(), D8FlowAnalyser and
+ * FlowAccumulator run on the whole DEM in memory.
+ *
+ * @param options Input, output and workers
+ * @return true If every product was written
+ */
+bool runSharded(const ShardOptions& options);
+
+#endif // SHARD_COORDINATOR_H
@@ -0,0 +1,255 @@
+/**
+ * @file ShardProtocol.cpp
+ * @author Ollie
+ * @brief Messages and sockets between the shard coordinator and its worker processes
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "ShardProtocol.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief Address parser
+ */
+bool parseShardAddress(const std::string& address, bool& isUnix, std::string& path, int& port) {
+    if (address.compare(0, 5, "unix:") == 0 && address.size() > 5) {
+        isUnix = true;
+        path = address.substr(5);
+        port = 0;
+        return true;
+    }
+    if (address.compare(0, 4, "tcp:") == 0) {
+        size_t colon = address.rfind(':');
+        if (colon <= 4 || colon + 1 >= address.size()) return false;
+        char* end = nullptr;
+        long value = std::strtol(address.c_str() + colon + 1, &end, 10);
+        if (*end != '\0' || value < 0 || value > 65535) return false;
+        isUnix = false;
+        path = address.substr(4, colon - 4);
+        port = static_cast<int>(value);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Open a socket to address, connected (connect) or bound (listen)
+ */
+static int openSocket(const std::string& address, bool bindIt, std::string* unixPath) {
+    bool isUnix = false;
+    std::string path;
+    int port = 0;
+    if (!parseShardAddress(address, isUnix, path, port)) {
+        std::cerr << "Error: Invalid shard address " << address << " (expected unix:<path> or tcp:<host>:<port>)" << std::endl;
+        return -1;
+    }
+
+    if (isUnix) {
+        sockaddr_un socketAddress = {};
+        socketAddress.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(socketAddress.sun_path)) {
+            std::cerr << "Error: Unix socket path too long: " << path << std::endl;
+            return -1;
+        }
+        std::strncpy(socketAddress.sun_path, path.c_str(), sizeof(socketAddress.sun_path) - 1);
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        int status;
+        if (bindIt) {
+            ::unlink(path.c_str());
+            status = ::bind(fd, reinterpret_cast<sockaddr*>(&socketAddress), sizeof(socketAddress));
+            if (status == 0 && unixPath) *unixPath = path;
+        }
+        else {
+            status = ::connect(fd, reinterpret_cast<sockaddr*>(&socketAddress), sizeof(socketAddress));
+        }
+        if (status != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (bindIt) hints.ai_flags = AI_PASSIVE;
+    addrinfo* results = nullptr;
+    std::string service = std::to_string(port);
+    if (::getaddrinfo(path.empty() ? nullptr : path.c_str(), service.c_str(), &hints, &results) != 0) {
+        std::cerr << "Error: Cannot resolve host " << path << std::endl;
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo* result = results; result; result = result->ai_next) {
+        fd = ::socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        int status;
+        if (bindIt) {
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            status = ::bind(fd, result->ai_addr, result->ai_addrlen);
+        }
+        else {
+            status = ::connect(fd, result->ai_addr, result->ai_addrlen);
+            // Boundary rows are small messages; send them without delay
+            if (status == 0) ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        if (status == 0) break;
+        ::close(fd);
+        fd = -1;
+    }
+    ::freeaddrinfo(results);
+    return fd;
+}
+
+/**
+ * @brief Destroy the Shard Connection:: Shard Connection object
+ */
+ShardConnection::~ShardConnection() {
+    if (_fd >= 0) ::close(_fd);
+}
+
+/**
+ * @brief Move assignment, closing the current socket
+ */
+ShardConnection& ShardConnection::operator=(ShardConnection&& other) noexcept {
+    if (this != &other) {
+        if (_fd >= 0) ::close(_fd);
+        _fd = other._fd;
+        _payloadLimit = other._payloadLimit;
+        other._fd = -1;
+    }
+    return *this;
+}
+
+/**
+ * @brief Connect with retries while the coordinator starts
+ */
+ShardConnection ShardConnection::connectTo(const std::string& address, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true) {
+        int fd = openSocket(address, false, nullptr);
+        if (fd >= 0) return ShardConnection(fd);
+        if (std::chrono::steady_clock::now() >= deadline) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    std::cerr << "Error: Could not connect to coordinator at " << address << std::endl;
+    return ShardConnection();
+}
+
+/**
+ * @brief Write all of data, retrying short writes
+ */
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+/**
+ * @brief Read exactly size bytes
+ */
+static bool readAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t got = ::recv(fd, data, size, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+/**
+ * @brief Send header and payload
+ */
+bool ShardConnection::send(const ShardMessage& message) {
+    if (_fd < 0) return false;
+    uint32_t type = static_cast<uint32_t>(message.type);
+    uint64_t length = message.getPayload().size();
+    char header[sizeof(type) + sizeof(length)];
+    std::memcpy(header, &type, sizeof(type));
+    std::memcpy(header + sizeof(type), &length, sizeof(length));
+    return writeAll(_fd, header, sizeof(header)) && writeAll(_fd, message.getPayload().data(), length);
+}
+
+/**
+ * @brief Receive header and payload
+ */
+bool ShardConnection::receive(ShardMessage& message) {
+    if (_fd < 0) return false;
+    uint32_t type = 0;
+    uint64_t length = 0;
+    char header[sizeof(type) + sizeof(length)];
+    if (!readAll(_fd, header, sizeof(header))) return false;
+    std::memcpy(&type, header, sizeof(type));
+    std::memcpy(&length, header + sizeof(type), sizeof(length));
+    if (length > _payloadLimit) {
+        std::cerr << "Error: Shard message of " << length << " bytes is over the limit of " << _payloadLimit
+                  << "." << std::endl;
+        return false;
+    }
+    message = ShardMessage(static_cast<ShardMessageType>(type));
+    message.getPayload().resize(length);
+    return readAll(_fd, message.getPayload().data(), length);
+}
+
+/**
+ * @brief Destroy the Shard Listener:: Shard Listener object
+ */
+ShardListener::~ShardListener() {
+    if (_fd >= 0) ::close(_fd);
+    if (!_unixPath.empty()) ::unlink(_unixPath.c_str());
+}
+
+/**
+ * @brief Bind and listen on address
+ */
+bool ShardListener::listenOn(const std::string& address) {
+    _fd = openSocket(address, true, &_unixPath);
+    if (_fd < 0 || ::listen(_fd, 64) != 0) {
+        std::cerr << "Error: Could not listen on " << address << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Accept one worker within the timeout
+ */
+ShardConnection ShardListener::accept(int timeoutMs) {
+    if (_fd < 0) return ShardConnection();
+    pollfd waitFor = {_fd, POLLIN, 0};
+    int ready;
+    do {
+        ready = ::poll(&waitFor, 1, timeoutMs);
+    } while (ready < 0 && errno == EINTR);
+    if (ready <= 0) return ShardConnection();
+
+    int fd = ::accept(_fd, nullptr, nullptr);
+    if (fd < 0) return ShardConnection();
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // Fails harmlessly on Unix sockets
+    return ShardConnection(fd);
+}
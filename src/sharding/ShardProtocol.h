@@ -0,0 +1,243 @@
+/**
+ * @file ShardProtocol.h
+ * @author Ollie
+ * @brief Messages and sockets between the shard coordinator and its worker processes
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef SHARD_PROTOCOL_H
+#define SHARD_PROTOCOL_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Kinds of message. Each request from the coordinator gets one reply.
+ */
+enum class ShardMessageType : uint32_t {
+    SHAPE = 1,   // Grid size and the strip's rows, so the worker can bound later messages
+    SHAPED,
+    LOAD,        // Strip of the DEM with its halo rows
+    LOADED,
+    SWEEP,       // One fillSinks() sweep, with the neighbours' boundary rows and cells to test
+    SWEPT,
+    ANALYSE,     // D8 directions and local flow accumulation of the filled strip
+    ANALYSED,
+    SEED,        // Flow entering the strip from the other shards
+    SEEDED,
+    RESULT,      // Send the filled DEM, D8 and flow accumulation rows back
+    STRIP,
+    QUIT,
+    FAILED       // Reply from a worker that could not handle a request
+};
+
+/**
+ * @brief Cell on a strip's first or last row whose D8 direction leads into another strip.
+ * Sent by workers so the coordinator can pass flow between strips.
+ */
+struct ShardExit {
+    int64_t cell;        // Grid index (y * width + x)
+    int64_t target;      // Grid index of the downstream cell in the other strip
+    double elevation;    // Filled elevation, for ordering exits as the accumulation does
+    double outflow;      // Flow passed on with no inflow from other strips
+    int32_t propagates;  // 1 if target is accumulated after cell, so the flow travels on
+    int32_t padding;
+};
+
+/// Payload bytes of a message besides its rows and boundary cells: counts, flags, strip shape
+const uint64_t SHARD_HEADER_BYTES = 64;
+
+/**
+ * @brief Largest payload any message about a strip can have. The strip's reply of every
+ * product is the largest per cell (two doubles and a direction over rows plus halo rows),
+ * and exits and cell lists are at most two rows' worth.
+ *
+ * @param width Grid width
+ * @param rows Rows of the strip, without its halo
+ * @return uint64_t Payload bytes, 0 if the strip is empty
+ */
+inline uint64_t shardPayloadLimit(int64_t width, int64_t rows) {
+    const int64_t haloRows = 1;
+    if (width <= 0 || rows <= 0) return 0;
+    uint64_t cells = static_cast<uint64_t>(width) * static_cast<uint64_t>(rows + 2 * haloRows);
+    uint64_t boundary = 2 * static_cast<uint64_t>(width) * (sizeof(ShardExit) + 2 * sizeof(int64_t));
+    return SHARD_HEADER_BYTES + cells * (2 * sizeof(double) + sizeof(int32_t)) + boundary;
+}
+
+/**
+ * @brief Order FlowAccumulator visits cells in: higher elevation first, then row-major.
+ * Flow into a cell from one visited before it is passed on; from one after, it is not.
+ *
+ * @return true If cell A is visited before cell B
+ */
+inline bool accumulatedBefore(double elevationA, int64_t cellA, double elevationB, int64_t cellB) {
+    if (elevationA != elevationB) return elevationA > elevationB;
+    return cellA < cellB;
+}
+
+/**
+ * @brief Typed message with a binary payload. Values are written in host byte order, so the
+ * coordinator and workers must run on machines of the same endianness.
+ */
+class ShardMessage {
+public:
+    ShardMessageType type = ShardMessageType::FAILED;
+
+    ShardMessage() {}
+    explicit ShardMessage(ShardMessageType messageType) : type(messageType) {}
+
+    /// @brief Append a plain value
+    template <typename V>
+    void put(const V& value) {
+        putArray(&value, 1);
+    }
+
+    /// @brief Append n plain values
+    template <typename V>
+    void putArray(const V* values, size_t n) {
+        size_t offset = _payload.size();
+        _payload.resize(offset + n * sizeof(V));
+        if (n > 0) std::memcpy(_payload.data() + offset, values, n * sizeof(V));
+    }
+
+    /// @brief Append a count, then the values
+    template <typename V>
+    void putVector(const std::vector<V>& values) {
+        put<uint64_t>(values.size());
+        putArray(values.data(), values.size());
+    }
+
+    /// @return true If a plain value was left to read
+    template <typename V>
+    bool get(V& value) {
+        return getArray(&value, 1);
+    }
+
+    /// @return true If n plain values were left to read
+    template <typename V>
+    bool getArray(V* values, size_t n) {
+        if (_payload.size() - _readOffset < n * sizeof(V)) return false;
+        if (n > 0) std::memcpy(values, _payload.data() + _readOffset, n * sizeof(V));
+        _readOffset += n * sizeof(V);
+        return true;
+    }
+
+    /// @return true If a count and that many values were left to read
+    template <typename V>
+    bool getVector(std::vector<V>& values) {
+        uint64_t n = 0;
+        if (!get(n) || (_payload.size() - _readOffset) / sizeof(V) < n) return false;
+        values.resize(n);
+        return getArray(values.data(), n);
+    }
+
+    /// @return std::vector<char>& Encoded values, for sending and receiving
+    std::vector<char>& getPayload(void) { return _payload; }
+    const std::vector<char>& getPayload(void) const { return _payload; }
+
+private:
+    std::vector<char> _payload;
+    size_t _readOffset = 0;
+};
+
+/**
+ * @brief Connected stream socket (Unix domain or TCP). Closed on destruction.
+ */
+class ShardConnection {
+public:
+    explicit ShardConnection(int fd = -1) : _fd(fd) {}
+    ~ShardConnection();
+    ShardConnection(ShardConnection&& other) noexcept : _fd(other._fd), _payloadLimit(other._payloadLimit) {
+        other._fd = -1;
+    }
+    ShardConnection& operator=(ShardConnection&& other) noexcept;
+    ShardConnection(const ShardConnection&) = delete;
+    ShardConnection& operator=(const ShardConnection&) = delete;
+
+    /**
+     * @brief Connect to a coordinator, retrying until it listens or timeoutMs passes
+     *
+     * @param address "unix:<path>" or "tcp:<host>:<port>"
+     * @param timeoutMs Time to keep retrying
+     * @return ShardConnection Open if connected
+     */
+    static ShardConnection connectTo(const std::string& address, int timeoutMs = 10000);
+
+    /// @return true If the socket is open
+    bool isOpen(void) const { return _fd >= 0; }
+
+    /// @return int Socket descriptor, for poll()
+    int getFd(void) const { return _fd; }
+
+    /**
+     * @brief Write message as a type, a payload length, then the payload
+     *
+     * @return true If the whole message was written
+     */
+    bool send(const ShardMessage& message);
+
+    /**
+     * @brief Read one whole message. A payload longer than the limit fails before anything
+     * is allocated for it.
+     *
+     * @return true If a message was read, false on error or when the peer closed
+     */
+    bool receive(ShardMessage& message);
+
+    /// @brief Largest payload receive() accepts, shardPayloadLimit() of the strip once known
+    void setPayloadLimit(uint64_t bytes) { _payloadLimit = bytes; }
+
+private:
+    int _fd;
+    uint64_t _payloadLimit = SHARD_HEADER_BYTES;
+};
+
+/**
+ * @brief Listening socket the coordinator accepts workers on. Unix socket files are removed
+ * on destruction.
+ */
+class ShardListener {
+public:
+    ShardListener() {}
+    ~ShardListener();
+    ShardListener(const ShardListener&) = delete;
+    ShardListener& operator=(const ShardListener&) = delete;
+
+    /**
+     * @brief Bind and listen
+     *
+     * @param address "unix:<path>" or "tcp:<host>:<port>" (host 0.0.0.0 for every interface)
+     * @return true If listening
+     */
+    bool listenOn(const std::string& address);
+
+    /**
+     * @brief Wait for the next worker
+     *
+     * @param timeoutMs Time to wait, -1 for no limit
+     * @return ShardConnection Open if a worker connected in time
+     */
+    ShardConnection accept(int timeoutMs = -1);
+
+private:
+    int _fd = -1;
+    std::string _unixPath;
+};
+
+/**
+ * @brief Split "unix:<path>" or "tcp:<host>:<port>"
+ *
+ * @param address Address to split
+ * @param isUnix Output: true for a Unix domain socket
+ * @param path Output: socket path or host
+ * @param port Output: TCP port
+ * @return true If the address was valid
+ */
+bool parseShardAddress(const std::string& address, bool& isUnix, std::string& path, int& port);
+
+#endif // SHARD_PROTOCOL_H
@@ -0,0 +1,360 @@
+/**
+ * @file ShardWorker.cpp
+ * @author Ollie
+ * @brief Worker process holding one strip of a sharded DEM
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "ShardWorker.h"
+#include "../DEM_analysis/D8FlowAnalyser.h"
+#include "../DEM_analysis/FlowAccumulation.h"
+#include "../map_core/MapTiles.h"
+#include "../profiling/Profiler.h"
+#include "../profiling/TraceRecorder.h"
+#include <algorithm>
+#include <iostream>
+
+// Link of a cell not worked out yet
+static const int64_t UNKNOWN_LINK = -2;
+
+/**
+ * @brief Dispatch on request type
+ */
+bool ShardWorker::handle(ShardMessage& request, ShardMessage& reply) {
+    bool handled = false;
+    switch (request.type) {
+        case ShardMessageType::SHAPE: handled = shape(request, reply); break;
+        case ShardMessageType::LOAD: handled = load(request, reply); break;
+        case ShardMessageType::SWEEP: handled = sweep(request, reply); break;
+        case ShardMessageType::ANALYSE: handled = analyse(request, reply); break;
+        case ShardMessageType::SEED: handled = seed(request, reply); break;
+        case ShardMessageType::RESULT: handled = result(reply); break;
+        default:
+            std::cerr << "Error: Unexpected shard message " << static_cast<uint32_t>(request.type) << std::endl;
+    }
+    if (!handled) reply = ShardMessage(ShardMessageType::FAILED);
+    return handled;
+}
+
+/**
+ * @brief Largest payload for the strip, or only a shape before one is known
+ */
+uint64_t ShardWorker::getPayloadLimit(void) const {
+    if (_elevation.getHeight() == 0) return SHARD_HEADER_BYTES;
+    return shardPayloadLimit(_gridWidth, _lastRow - _firstRow);
+}
+
+/**
+ * @brief Check and store grid size and strip rows
+ */
+bool ShardWorker::shape(ShardMessage& request, ShardMessage& reply) {
+    int32_t header[6];
+    if (!request.getArray(header, 6)) return false;
+    _gridWidth = header[0];
+    _gridHeight = header[1];
+    _firstRow = header[2];
+    _lastRow = header[3];
+    _haloFirst = header[4];
+    int haloLast = header[5];
+    // At most one halo row either side, as shardPayloadLimit() allows for
+    if (_gridWidth <= 0 || _firstRow < 0 || _firstRow >= _lastRow || _lastRow > _gridHeight ||
+        _haloFirst > _firstRow || haloLast < _lastRow || _haloFirst < _firstRow - 1 || haloLast > _lastRow + 1 ||
+        _haloFirst < 0 || haloLast > _gridHeight) {
+        std::cerr << "Error: Invalid shard strip." << std::endl;
+        return false;
+    }
+
+    _elevation = Map<double>(_gridWidth, haloLast - _haloFirst);
+    reply = ShardMessage(ShardMessageType::SHAPED);
+    return true;
+}
+
+/**
+ * @brief Store strip and halo, then find raisable sinks
+ */
+bool ShardWorker::load(ShardMessage& request, ShardMessage& reply) {
+    if (_elevation.getHeight() == 0) {
+        std::cerr << "Error: Shard strip loaded before its shape." << std::endl;
+        return false;
+    }
+    for (int y = 0; y < _elevation.getHeight(); y++) {
+        if (!request.getArray(_elevation.getRow(y), _gridWidth)) return false;
+    }
+
+    // Border rows of the grid are never filled
+    int y0 = localRow(std::max(_firstRow, 1));
+    int y1 = localRow(std::min(_lastRow, _gridHeight - 1));
+    _pending = _elevation.findSinks(y0, y1);
+    const int64_t offset = static_cast<int64_t>(_haloFirst) * _gridWidth;
+    for (int64_t& cell : _pending) {
+        cell += offset;
+    }
+
+    reply = ShardMessage(ShardMessageType::LOADED);
+    reply.put<uint64_t>(_pending.size());
+    return true;
+}
+
+/**
+ * @brief Halo rows: a flag for the row above, the row, then the same for the row below
+ */
+bool ShardWorker::readHaloRows(ShardMessage& request) {
+    uint8_t hasAbove = 0, hasBelow = 0;
+    if (!request.get(hasAbove)) return false;
+    if (hasAbove) {
+        if (_firstRow == 0 || !request.getArray(_elevation.getRow(localRow(_firstRow - 1)), _gridWidth)) return false;
+    }
+    if (!request.get(hasBelow)) return false;
+    if (hasBelow) {
+        if (_lastRow == _gridHeight || !request.getArray(_elevation.getRow(localRow(_lastRow)), _gridWidth)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief One fill sweep over the strip
+ */
+bool ShardWorker::sweep(ShardMessage& request, ShardMessage& reply) {
+    ProfileScope scope("shard_sweep");
+    std::vector<int64_t> incoming;
+    if (!readHaloRows(request) || !request.getVector(incoming)) return false;
+
+    // Cells queued by this strip's last sweep and by the neighbours' raised cells
+    std::vector<int64_t> candidates;
+    candidates.swap(_pending);
+    candidates.insert(candidates.end(), incoming.begin(), incoming.end());
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    const int64_t offset = static_cast<int64_t>(_haloFirst) * _gridWidth;
+    for (int64_t& cell : candidates) {
+        cell -= offset;
+    }
+
+    std::vector<int64_t> nextSweep, outside;
+    int y0 = localRow(std::max(_firstRow, 1));
+    int y1 = localRow(std::min(_lastRow, _gridHeight - 1));
+    int raised = (y0 < y1) ? _elevation.fillSinksSweep(candidates, y0, y1, nextSweep, &outside) : 0;
+    for (int64_t cell : nextSweep) {
+        _pending.push_back(cell + offset);
+    }
+
+    // Interior neighbours in other strips: tested by the strip above in its next sweep, and
+    // by the strip below in the sweep it runs next
+    std::vector<int64_t> above, below;
+    for (int64_t cell : outside) {
+        int64_t gridCell = cell + offset;
+        int64_t y = gridCell / _gridWidth;
+        if (y < 1 || y >= _gridHeight - 1) continue;
+        if (y < _firstRow) above.push_back(gridCell);
+        else below.push_back(gridCell);
+    }
+    // A neighbour of several raised cells is sent once, so each list is at most a row
+    for (std::vector<int64_t>* cells : {&above, &below}) {
+        std::sort(cells->begin(), cells->end());
+        cells->erase(std::unique(cells->begin(), cells->end()), cells->end());
+    }
+
+    reply = ShardMessage(ShardMessageType::SWEPT);
+    reply.put<int32_t>(raised);
+    reply.putArray(_elevation.getRow(localRow(_firstRow)), _gridWidth);
+    reply.putArray(_elevation.getRow(localRow(_lastRow - 1)), _gridWidth);
+    reply.putVector(above);
+    reply.putVector(below);
+    return true;
+}
+
+/**
+ * @brief D8 and local accumulation of the filled strip
+ */
+bool ShardWorker::analyse(ShardMessage& request, ShardMessage& reply) {
+    ProfileScope scope("shard_analyse");
+    if (!readHaloRows(request)) return false;
+    int stripHeight = _lastRow - _firstRow;
+    const int width = _gridWidth;
+
+    // Directions from grid coordinates, so ties break as they would on the whole grid
+    _directions = Map<int>(width, stripHeight);
+    MapTileSource<double> source(_elevation, _haloFirst, _gridHeight);
+    MapTileSink<int> sink(_directions, _firstRow);
+    if (!D8FlowAnalyser<double>::analyseFlow(source, sink, _firstRow, _lastRow)) return false;
+
+    _stripElevation = Map<double>(width, stripHeight);
+    for (int y = 0; y < stripHeight; y++) {
+        const double* row = _elevation.getRow(localRow(_firstRow + y));
+        std::copy(row, row + width, _stripElevation.getRow(y));
+    }
+
+    // Flow with nothing entering from other strips
+    Map<double> outflow;
+    FlowAccumulator<double, int, double> accumulator(_stripElevation, nullptr, nullptr, &_directions);
+    accumulator.accumulateD8From(Map<double>(width, stripHeight), &outflow);
+
+    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+    const int64_t offset = static_cast<int64_t>(_firstRow) * width;
+
+    // Cells whose direction crosses into another strip
+    std::vector<ShardExit> exits;
+    std::vector<int> boundaryRows = {0};
+    if (stripHeight > 1) boundaryRows.push_back(stripHeight - 1);
+    for (int y : boundaryRows) {
+        for (int x = 0; x < width; x++) {
+            int direction = _directions.getData(x, y);
+            if (direction < 0) continue;
+            int nx = x + dx[direction];
+            int gridY = _firstRow + y + dy[direction];
+            if (nx < 0 || nx >= width || gridY < 0 || gridY >= _gridHeight) continue;
+            if (gridY >= _firstRow && gridY < _lastRow) continue;
+
+            ShardExit exit = {};
+            exit.cell = offset + static_cast<int64_t>(y) * width + x;
+            exit.target = static_cast<int64_t>(gridY) * width + nx;
+            exit.elevation = _stripElevation.getData(x, y);
+            exit.outflow = outflow.getData(x, y);
+            double targetElevation = _elevation.getData(nx, localRow(gridY));
+            exit.propagates = accumulatedBefore(exit.elevation, exit.cell, targetElevation, exit.target) ? 1 : 0;
+            exits.push_back(exit);
+        }
+    }
+
+    // For each cell, the exit that flow added to it reaches before it stops passing on,
+    // followed along directions with memoised paths
+    std::vector<int64_t> links(static_cast<size_t>(width) * stripHeight, UNKNOWN_LINK);
+    std::vector<int64_t> path;
+    auto linkOf = [&](int64_t start) {
+        int64_t cell = start;
+        int64_t link;
+        path.clear();
+        while (true) {
+            if (links[cell] != UNKNOWN_LINK) {
+                link = links[cell];
+                break;
+            }
+            path.push_back(cell);
+            int x = static_cast<int>(cell % width);
+            int y = static_cast<int>(cell / width);
+            int direction = _directions.getData(x, y);
+            if (direction < 0) {
+                link = -1;
+                break;
+            }
+            int nx = x + dx[direction];
+            int ny = y + dy[direction];
+            int gridY = _firstRow + ny;
+            if (nx < 0 || nx >= width || gridY < 0 || gridY >= _gridHeight) {
+                link = -1;  // Flow leaves the grid
+                break;
+            }
+            if (ny < 0 || ny >= stripHeight) {
+                link = offset + cell;  // This cell is an exit
+                break;
+            }
+            int64_t next = static_cast<int64_t>(ny) * width + nx;
+            if (!accumulatedBefore(_stripElevation.getData(x, y), offset + cell,
+                                   _stripElevation.getData(nx, ny), offset + next)) {
+                link = -1;  // Downstream cell already passed its flow on
+                break;
+            }
+            cell = next;
+        }
+        for (int64_t visited : path) {
+            links[visited] = link;
+        }
+        return link;
+    };
+    std::vector<int64_t> firstLinks(width), lastLinks(width);
+    for (int x = 0; x < width; x++) {
+        firstLinks[x] = linkOf(x);
+        lastLinks[x] = linkOf(static_cast<int64_t>(stripHeight - 1) * width + x);
+    }
+
+    reply = ShardMessage(ShardMessageType::ANALYSED);
+    reply.putVector(exits);
+    reply.putVector(firstLinks);
+    reply.putVector(lastLinks);
+    return true;
+}
+
+/**
+ * @brief Final accumulation with inflow from other strips
+ */
+bool ShardWorker::seed(ShardMessage& request, ShardMessage& reply) {
+    ProfileScope scope("shard_seed");
+    std::vector<int64_t> seedCells, addCells;
+    std::vector<double> seedFlow, addFlow;
+    if (!request.getVector(seedCells) || !request.getVector(seedFlow) ||
+        !request.getVector(addCells) || !request.getVector(addFlow) ||
+        seedCells.size() != seedFlow.size() || addCells.size() != addFlow.size()) {
+        return false;
+    }
+
+    int width = _gridWidth;
+    int stripHeight = _lastRow - _firstRow;
+    const int64_t offset = static_cast<int64_t>(_firstRow) * width;
+    auto inStrip = [&](int64_t cell) { return cell >= offset && cell < offset + static_cast<int64_t>(width) * stripHeight; };
+
+    // Flow from cells accumulated earlier is passed on; from later ones it is only added
+    Map<double> inflow(width, stripHeight);
+    for (size_t i = 0; i < seedCells.size(); i++) {
+        if (!inStrip(seedCells[i])) return false;
+        int64_t cell = seedCells[i] - offset;
+        int x = static_cast<int>(cell % width);
+        int y = static_cast<int>(cell / width);
+        inflow.setData(x, y, inflow.getData(x, y) + seedFlow[i]);
+    }
+    FlowAccumulator<double, int, double> accumulator(_stripElevation, nullptr, nullptr, &_directions);
+    _flow = accumulator.accumulateD8From(inflow);
+    for (size_t i = 0; i < addCells.size(); i++) {
+        if (!inStrip(addCells[i])) return false;
+        int64_t cell = addCells[i] - offset;
+        int x = static_cast<int>(cell % width);
+        int y = static_cast<int>(cell / width);
+        _flow.setData(x, y, _flow.getData(x, y) + addFlow[i]);
+    }
+
+    reply = ShardMessage(ShardMessageType::SEEDED);
+    return true;
+}
+
+/**
+ * @brief Strip rows of the filled DEM, D8, and flow accumulation
+ */
+bool ShardWorker::result(ShardMessage& reply) {
+    int stripHeight = _lastRow - _firstRow;
+    if (_flow.getHeight() != stripHeight) return false;
+    reply = ShardMessage(ShardMessageType::STRIP);
+    for (int y = 0; y < stripHeight; y++) {
+        reply.putArray(_stripElevation.getRow(y), _gridWidth);
+    }
+    for (int y = 0; y < stripHeight; y++) {
+        reply.putArray(_directions.getRow(y), _gridWidth);
+    }
+    for (int y = 0; y < stripHeight; y++) {
+        reply.putArray(_flow.getRow(y), _gridWidth);
+    }
+    return true;
+}
+
+/**
+ * @brief Worker loop
+ */
+bool runShardWorker(const std::string& address) {
+    TraceRecorder::setThreadName("shard worker");
+    ShardConnection connection = ShardConnection::connectTo(address);
+    if (!connection.isOpen()) return false;
+
+    ShardWorker worker;
+    ShardMessage request;
+    while (connection.receive(request)) {
+        if (request.type == ShardMessageType::QUIT) return true;
+        ShardMessage reply;
+        worker.handle(request, reply);
+        connection.setPayloadLimit(worker.getPayloadLimit());
+        if (!connection.send(reply)) break;
+    }
+    std::cerr << "Error: Lost connection to coordinator at " << address << std::endl;
+    return false;
+}
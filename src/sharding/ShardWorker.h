@@ -0,0 +1,85 @@
+/**
+ * @file ShardWorker.h
+ * @author Ollie
+ * @brief Worker process holding one strip of a sharded DEM
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef SHARD_WORKER_H
+#define SHARD_WORKER_H
+
+#include "ShardProtocol.h"
+#include "../map_core/Map.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One strip of rows of the grid, plus the row either side of it (its halo), worked on
+ * with the in-memory Map, D8FlowAnalyser and FlowAccumulator code. The coordinator keeps the
+ * halo rows current and passes cells and flow that cross between strips.
+ */
+class ShardWorker {
+public:
+    /**
+     * @brief Answer one request from the coordinator
+     *
+     * @param request Message received
+     * @param reply Output: message to send back
+     * @return true If the request was handled (reply is FAILED otherwise)
+     */
+    bool handle(ShardMessage& request, ShardMessage& reply);
+
+    /// @return uint64_t Largest payload a message about this worker's strip can have
+    uint64_t getPayloadLimit(void) const;
+
+private:
+    int _gridWidth = 0, _gridHeight = 0;
+    int _firstRow = 0, _lastRow = 0;   // Rows [_firstRow, _lastRow) belong to this strip
+    int _haloFirst = 0;                // Grid row of _elevation's first row
+    Map<double> _elevation;            // Strip and halo rows, filled in place
+    std::vector<int64_t> _pending;     // Grid indices to test in the next fill sweep
+    Map<double> _stripElevation;       // Filled strip rows only, for flow accumulation
+    Map<int> _directions;              // D8 directions of the strip rows
+    Map<double> _flow;                 // Flow accumulation of the strip rows
+
+    /// @brief Take the grid size and the strip's rows
+    bool shape(ShardMessage& request, ShardMessage& reply);
+
+    /// @brief Take the strip and its halo rows, and find the first sweep's sinks
+    bool load(ShardMessage& request, ShardMessage& reply);
+
+    /// @brief Run one fill sweep
+    bool sweep(ShardMessage& request, ShardMessage& reply);
+
+    /// @brief D8 directions, local flow accumulation, exits and links between boundary cells
+    bool analyse(ShardMessage& request, ShardMessage& reply);
+
+    /// @brief Accumulate again with the flow entering from other strips
+    bool seed(ShardMessage& request, ShardMessage& reply);
+
+    /// @brief Send the strip's rows of every product
+    bool result(ShardMessage& reply);
+
+    /**
+     * @brief Copy halo rows sent by the coordinator into _elevation
+     */
+    bool readHaloRows(ShardMessage& request);
+
+    /// @return int Row of _elevation holding grid row y
+    int localRow(int y) const { return y - _haloFirst; }
+};
+
+/**
+ * @brief Worker process: connect to the coordinator at address and answer requests until
+ * it says to quit
+ *
+ * @param address "unix:<path>" or "tcp:<host>:<port>"
+ * @return true If the coordinator finished with this worker normally
+ */
+bool runShardWorker(const std::string& address);
+
+#endif // SHARD_WORKER_H
@@ -0,0 +1,128 @@
+/**
+ * @file IncrementalAnalyserTest.cpp
+ * @author Ollie
+ * @brief Incremental flow and basin updates against full recomputes on a DEM with flats
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "DEM_analysis/IncrementalAnalyser.h"
+#include "DEM_analysis/FlowAccumulation.h"
+#include "DEM_analysis/StreamNetwork.h"
+#include "map_core/TerrainGenerator.h"
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+static int failures = 0;
+
+/**
+ * @brief Report a failed condition
+ */
+static void check(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << std::endl;
+        failures++;
+    }
+}
+
+int main(void) {
+    const int width = 160;
+    const int height = 120;
+    const double threshold = 40;
+
+    TerrainOptions options;
+    options.seed = 7;
+    options.featureSize = 64.0;
+    options.nPits = 6;
+    options.nFlats = 8;
+    options.flatRadius = 12.0;
+    Map<double> dem = TerrainGenerator<double>(options).generate(width, height);
+    dem.fillSinks();
+
+    D8FlowAnalyser<double> d8Analyser(dem);
+    d8Analyser.analyseFlow();
+    Map<int> D8 = d8Analyser.getMap();
+    Map<double> flow = FlowAccumulator<double, int, double>(dem, nullptr, nullptr, &D8).accumulateFlow("d8");
+    StreamNetwork<double> network(flow, D8);
+    network.extractStreams(threshold);
+    BasinTree basins(D8, network.getLinkMap(), network.getLinks(), threshold);
+
+    // Edits that cut, raise and flatten terrain, including values equal to neighbours
+    std::mt19937 random(11);
+    int cycleEdits = 0;
+    for (int edit = 0; edit < 60; edit++) {
+        int x0 = random() % (width - 6);
+        int y0 = random() % (height - 6);
+        int x1 = x0 + random() % 5;
+        int y1 = y0 + random() % 5;
+        double value;
+        switch (edit % 3) {
+            case 0: value = dem.getData(x0, y0); break;             // Flat patch
+            case 1: value = dem.getData(x0, y0) - 5.0; break;       // Cut
+            default: value = dem.getData(x0, y0) + 20.0; break;     // Raise
+        }
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                dem.setData(x, y, value);
+            }
+        }
+
+        IncrementalAnalyser<double> analyser(dem, &D8, &flow, nullptr, nullptr, &basins);
+        analyser.update(x0, y0, x1, y1);
+
+        // Flow equals a full run over the same directions
+        Map<double> expected = FlowAccumulator<double, int, double>(dem, nullptr, nullptr, &D8).accumulateFlow("d8");
+        int wrong = 0;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                wrong += (flow.getData(x, y) != expected.getData(x, y));
+            }
+        }
+        check(wrong == 0, "edit " + std::to_string(edit) + ": " + std::to_string(wrong) + " flow cells differ");
+
+        // Labels equal a tree built from scratch
+        StreamNetwork<double> fresh(expected, D8);
+        fresh.extractStreams(threshold);
+        BasinTree freshBasins(D8, fresh.getLinkMap(), fresh.getLinks(), threshold);
+        int relabelled = 0;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                relabelled += (basins.getBasinAt(x, y) != freshBasins.getBasinAt(x, y));
+            }
+        }
+        check(relabelled == 0, "edit " + std::to_string(edit) + ": " + std::to_string(relabelled) +
+            " basin labels differ");
+
+        // Areas and bounding boxes equal it too, including boxes of basins that lost cells
+        int staleNodes = 0;
+        for (int id = 0; id < basins.getNodeCount() && id < freshBasins.getNodeCount(); id++) {
+            const BasinNode& a = basins.getNode(id);
+            const BasinNode& b = freshBasins.getNode(id);
+            staleNodes += (a.totalCells != b.totalCells || a.minX != b.minX || a.minY != b.minY ||
+                           a.maxX != b.maxX || a.maxY != b.maxY);
+        }
+        check(basins.getNodeCount() == freshBasins.getNodeCount() && staleNodes == 0, "edit " +
+            std::to_string(edit) + ": " + std::to_string(staleNodes) + " basin nodes differ");
+
+        // Count edits whose directions close a D8 cycle, so the flat case is exercised
+        int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+        int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+        bool cycle = false;
+        for (int y = 1; y < height - 1 && !cycle; y++) {
+            for (int x = 1; x < width - 1 && !cycle; x++) {
+                int d = D8.getData(x, y);
+                if (d < 0) continue;
+                int e = D8.getData(x + dx[d], y + dy[d]);
+                cycle = (e >= 0 && x + dx[d] + dx[e] == x && y + dy[d] + dy[e] == y);
+            }
+        }
+        cycleEdits += cycle;
+    }
+    check(cycleEdits > 0, "no edit left a D8 cycle");
+
+    std::cout << "60 edits, " << cycleEdits << " with D8 cycles" << std::endl;
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file StreamNetworkTest.cpp
+ * @author Ollie
+ * @brief Stream ordering on a DEM whose channels end in a flat
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "DEM_analysis/D8FlowAnalyser.h"
+#include "DEM_analysis/FlowAccumulation.h"
+#include "DEM_analysis/StreamNetwork.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static int failures = 0;
+
+/**
+ * @brief Report a failed condition
+ */
+static void check(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "FAIL: " << message << std::endl;
+        failures++;
+    }
+}
+
+/**
+ * @brief Closed bowl draining to a flat floor: every channel ends in the flat, where D8
+ * receivers point at each other
+ */
+static Map<double> flatFloorDEM(int size, int floor) {
+    Map<double> dem(size, size);
+    int c0 = (size - floor) / 2;
+    int c1 = c0 + floor - 1;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            int dx = std::max({c0 - x, x - c1, 0});
+            int dy = std::max({c0 - y, y - c1, 0});
+            dem.setData(x, y, dx + dy + 0.01 * ((x * 7 + y * 3) % 5) * (dx + dy > 0));
+        }
+    }
+    return dem;
+}
+
+int main(void) {
+    const int size = 21;
+    Map<double> dem = flatFloorDEM(size, 5);
+    D8FlowAnalyser<double> d8Analyser(dem);
+    d8Analyser.analyseFlow();
+    Map<int> D8 = d8Analyser.getMap();
+    FlowAccumulator<double, int, double> accumulator(dem, nullptr, nullptr, &D8);
+    Map<double> flow = accumulator.accumulateFlow("d8");
+
+    const double threshold = 3;
+    StreamNetwork<double> network(flow, D8);
+    network.extractStreams(threshold);
+    Map<int> strahler = network.getStrahlerMap();
+    Map<int> shreve = network.getShreveMap();
+    Map<int> links = network.getLinkMap();
+
+    // The DEM must exercise a D8 cycle among channel cells
+    int dx[] = {1, 1, 0, -1, -1, -1, 0, 1};
+    int dy[] = {0, 1, 1, 1, 0, -1, -1, -1};
+    auto receiver = [&](int cell) {
+        int d = D8.getData(cell % size, cell / size);
+        if (d < 0) return -1;
+        int nx = cell % size + dx[d];
+        int ny = cell / size + dy[d];
+        return (nx < 0 || ny < 0 || nx >= size || ny >= size) ? -1 : ny * size + nx;
+    };
+    int cycleCells = 0;
+    for (int cell = 0; cell < size * size; cell++) {
+        int r = receiver(cell);
+        if (r != -1 && receiver(r) == cell && flow.getData(cell % size, cell / size) >= threshold) cycleCells++;
+    }
+    check(cycleCells > 0, "test DEM has no channel D8 cycle");
+
+    // Every channel cell is ordered and belongs to a link
+    int channelCells = 0;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            if (flow.getData(x, y) < threshold) continue;
+            channelCells++;
+            check(strahler.getData(x, y) >= 1, "channel cell without Strahler order");
+            check(shreve.getData(x, y) >= 1, "channel cell without Shreve magnitude");
+            check(links.getData(x, y) >= 0, "channel cell without link");
+        }
+    }
+
+    // Everything drains into the flat, so outlet magnitudes add up to the number of sources
+    const std::vector<StreamLink>& allLinks = network.getLinks();
+    int sourceLinks = 0;
+    std::vector<bool> isSource(allLinks.size());
+    for (const auto& link : allLinks) {
+        bool hasDonor = false;
+        for (const auto& other : allLinks) hasDonor |= (other.downstreamLink == link.id);
+        isSource[link.id] = !hasDonor;
+        if (!hasDonor) sourceLinks++;
+    }
+    int outletMagnitude = 0;
+    for (int id : network.getOutlets()) {
+        outletMagnitude += allLinks[id].shreve;
+        check(allLinks[id].downstreamLink == -1, "outlet link has a downstream link");
+    }
+    check(outletMagnitude == sourceLinks, "outlet Shreve magnitudes " + std::to_string(outletMagnitude) +
+        " do not add up to " + std::to_string(sourceLinks) + " sources");
+
+    // Head type follows the link graph: sources have no links draining into them
+    std::string csv = (std::filesystem::temp_directory_path() / "stream_network_test_links.csv").string();
+    check(network.saveLinksToCSV(csv), "links csv not saved");
+    std::ifstream file(csv.c_str());
+    std::string line;
+    std::getline(file, line);
+    int rows = 0;
+    while (std::getline(file, line)) {
+        std::stringstream row(line);
+        std::string id, headType;
+        std::getline(row, id, ',');
+        while (std::getline(row, headType, ',')) {
+        }
+        int link = std::stoi(id);
+        check(headType == (isSource[link] ? "source" : "junction"), "link " + id + " has head type " + headType);
+        rows++;
+    }
+    check(rows == static_cast<int>(allLinks.size()), "links csv has " + std::to_string(rows) + " rows");
+    std::filesystem::remove(csv);
+
+    std::cout << channelCells << " channel cells, " << cycleCells << " on D8 cycles, " << allLinks.size()
+              << " links" << std::endl;
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}